@@ -0,0 +1,26 @@
+# Find the liburing include file and library.
+
+find_package(PkgConfig)
+pkg_check_modules(PC_URING liburing)
+
+find_path (URING_INCLUDE_DIR
+    NAMES liburing.h
+    HINTS ${URING_INCLUDE_DIR_HINT} ${PC_URING_INCLUDEDIR} ${PC_URING_INCLUDE_DIRS}
+)
+
+find_library(URING_LIBRARY
+    NAMES uring
+    HINTS ${URING_LIBRARIES_DIR_HINT} ${PC_URING_LIBDIR} ${PC_URING_LIBRARY_DIRS}
+)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(
+    URING
+    REQUIRED_VARS
+        URING_INCLUDE_DIR URING_LIBRARY
+)
+
+mark_as_advanced(
+    URING_INCLUDE_DIR
+    URING_LIBRARY
+)
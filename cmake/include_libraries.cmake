@@ -27,4 +27,5 @@ endif (ENABLE_SAFEC)
 find_package(Flatbuffers QUIET)
 find_package(ICONV QUIET)
 find_package(UUID QUIET)
+find_package(URING QUIET)
 find_package(Libunwind)
@@ -163,3 +163,7 @@ endif()
 if (UUID_FOUND)
     check_library_exists ("${UUID_LIBRARY}" uuid_parse "" HAVE_UUID)
 endif()
+
+if (URING_FOUND)
+    check_library_exists ("${URING_LIBRARY}" io_uring_queue_init "" HAVE_LIBURING)
+endif()
@@ -126,6 +126,10 @@ Optional Packages:
                             libuuid include directory
     --with-uuid-libraries=DIR
                             libuuid library directory
+    --with-uring-includes=DIR
+                            liburing include directory
+    --with-uring-libraries=DIR
+                            liburing library directory
 
 Some influential variable definitions:
     SIGNAL_SNORT_RELOAD=<int>
@@ -476,6 +480,12 @@ while [ $# -ne 0 ]; do
         --with-uuid-libraries=*)
             append_cache_entry UUID_LIBRARIES_DIR_HINT PATH $optarg
             ;;
+        --with-uring-includes=*)
+            append_cache_entry URING_INCLUDE_DIR_HINT PATH $optarg
+            ;;
+        --with-uring-libraries=*)
+            append_cache_entry URING_LIBRARIES_DIR_HINT PATH $optarg
+            ;;
         SIGNAL_SNORT_RELOAD=*)
             append_cache_entry SIGNAL_SNORT_RELOAD STRING $optarg
             ;;
@@ -21,6 +21,12 @@
 #define CODECS_CHECKSUM_H
 
 #include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHECKSUM_X86
+#include <immintrin.h>
+#endif
 
 #include <protocols/protocol_ids.h>
 
@@ -79,7 +85,105 @@ inline uint16_t ip_cksum(const uint16_t* buf, std::size_t len);
  */
 namespace detail
 {
-inline uint16_t cksum_add(const uint16_t* buf, std::size_t len, uint32_t cksum)
+// the one's complement sum doesn't depend on the order the words are added
+// so whole vectors of words are widened into 32 bit lanes and summed.  the
+// lanes are spilled to a 64 bit total every 64K bytes, well before they can
+// overflow, and the total is folded back to 16 bits which preserves the sum.
+// only the longest multiple of the vector size is consumed here.
+
+constexpr std::size_t cksum_block = 65536;
+
+#ifdef CHECKSUM_X86
+__attribute__((target("avx2")))
+inline uint64_t sum_avx2(const uint8_t*& p, std::size_t& len)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t total = 0;
+
+    while ( len >= 32 )
+    {
+        std::size_t n = len < cksum_block ? len : cksum_block;
+        const uint8_t* end = p + (n & ~(std::size_t)31);
+        __m256i acc = zero;
+
+        for ( ; p < end; p += 32 )
+        {
+            __m256i v = _mm256_loadu_si256((const __m256i*)p);
+            acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(v, zero));
+            acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(v, zero));
+        }
+        len -= n & ~(std::size_t)31;
+
+        uint32_t lanes[8];
+        _mm256_storeu_si256((__m256i*)lanes, acc);
+
+        for ( auto l : lanes )
+            total += l;
+    }
+    return total;
+}
+
+inline uint64_t sum_sse2(const uint8_t*& p, std::size_t& len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t total = 0;
+
+    while ( len >= 16 )
+    {
+        std::size_t n = len < cksum_block ? len : cksum_block;
+        const uint8_t* end = p + (n & ~(std::size_t)15);
+        __m128i acc = zero;
+
+        for ( ; p < end; p += 16 )
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)p);
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+            acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+        }
+        len -= n & ~(std::size_t)15;
+
+        uint32_t lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+
+        for ( auto l : lanes )
+            total += l;
+    }
+    return total;
+}
+
+// sse2 is baseline on x86_64; avx2 is checked once
+inline bool use_avx2()
+{
+    static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    return avx2;
+}
+#endif
+
+// below this the scalar loop is as fast
+constexpr std::size_t cksum_simd_min = 128;
+
+inline void add_simd(const uint16_t*& sp, std::size_t& len, uint32_t& cksum)
+{
+#ifdef CHECKSUM_X86
+    if ( len < cksum_simd_min )
+        return;
+
+    const uint8_t* p = (const uint8_t*)sp;
+    uint64_t sum = use_avx2() ? sum_avx2(p, len) : sum_sse2(p, len);
+    sp = (const uint16_t*)p;
+
+    while ( sum >> 16 )
+        sum = (sum & 0xffff) + (sum >> 16);
+
+    cksum += (uint32_t)sum;
+#else
+    (void)sp;
+    (void)len;
+    (void)cksum;
+#endif
+}
+
+inline uint16_t cksum_add_scalar(const uint16_t* buf, std::size_t len, uint32_t cksum)
 {
     const uint16_t* sp = buf;
 
@@ -169,6 +273,12 @@ inline uint16_t cksum_add(const uint16_t* buf, std::size_t len, uint32_t cksum)
     return (uint16_t)(~cksum);
 }
 
+inline uint16_t cksum_add(const uint16_t* buf, std::size_t len, uint32_t cksum)
+{
+    add_simd(buf, len, cksum);
+    return cksum_add_scalar(buf, len, cksum);
+}
+
 inline void add_ipv4_pseudoheader(const Pseudoheader& ph4, uint32_t& cksum)
 {
     const uint16_t* h = ph4.arr;
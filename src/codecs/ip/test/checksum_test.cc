@@ -0,0 +1,157 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// checksum_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "../checksum.h"
+
+// rfc 1071 reference
+static uint16_t ref_cksum(const uint8_t* p, std::size_t len, uint32_t sum)
+{
+    uint64_t s = sum;
+
+    for ( ; len > 1; p += 2, len -= 2 )
+    {
+        uint16_t w;
+        memcpy(&w, p, 2);
+        s += w;
+    }
+    if ( len )
+        s += *p;
+
+    while ( s >> 16 )
+        s = (s & 0xffff) + (s >> 16);
+
+    return (uint16_t)~s;
+}
+
+static std::vector<uint8_t> make_data(std::size_t len, unsigned seed)
+{
+    std::vector<uint8_t> v(len + 1);
+    srand(seed);
+
+    for ( auto& b : v )
+        b = rand();
+
+    return v;
+}
+
+TEST_CASE("checksum matches reference", "[checksum]")
+{
+    std::vector<uint8_t> data = make_data(2048 + 64, 7);
+
+    // both the aligned and odd address paths with every tail length
+    for ( unsigned off = 0; off < 2; ++off )
+    {
+        for ( std::size_t len = 0; len <= 2048; ++len )
+        {
+            const uint8_t* p = data.data() + off;
+            uint16_t ref = ref_cksum(p, len, 0x1234);
+
+            INFO("off " << off << " len " << len);
+            CHECK(checksum::detail::cksum_add((const uint16_t*)p, len, 0x1234) == ref);
+            CHECK(checksum::detail::cksum_add_scalar((const uint16_t*)p, len, 0x1234) == ref);
+        }
+    }
+}
+
+TEST_CASE("checksum saturated words", "[checksum]")
+{
+    // all ones stresses the lane sums and the final fold
+    std::vector<uint8_t> data(65535 + 1, 0xff);
+
+    for ( std::size_t len : { 64, 1500, 65534, 65535 } )
+    {
+        INFO("len " << len);
+        CHECK(checksum::cksum_add((const uint16_t*)data.data(), len) ==
+            ref_cksum(data.data(), len, 0));
+    }
+
+    std::vector<uint8_t> zeros(1500, 0);
+    CHECK(checksum::cksum_add((const uint16_t*)zeros.data(), zeros.size()) == 0xffff);
+}
+
+TEST_CASE("checksum larger than a block", "[checksum]")
+{
+    std::vector<uint8_t> data = make_data(3 * checksum::detail::cksum_block + 17, 11);
+
+    CHECK(checksum::cksum_add((const uint16_t*)data.data(), data.size() - 1) ==
+        ref_cksum(data.data(), data.size() - 1, 0));
+}
+
+TEST_CASE("checksum ip header", "[checksum]")
+{
+    // example from rfc 1071 section 3 style header with a valid checksum
+    const uint8_t ip4[] =
+    {
+        0x45, 0x00, 0x00, 0x73, 0x00, 0x00, 0x40, 0x00, 0x40, 0x11,
+        0xb8, 0x61, 0xc0, 0xa8, 0x00, 0x01, 0xc0, 0xa8, 0x00, 0xc7
+    };
+    uint16_t hdr[sizeof(ip4) / 2];
+    memcpy(hdr, ip4, sizeof(ip4));
+
+    CHECK(checksum::ip_cksum(hdr, sizeof(ip4)) == 0);
+}
+
+#ifdef BENCHMARK_TEST
+TEST_CASE("checksum benchmark", "[checksum]")
+{
+    std::vector<uint8_t> data = make_data(9000, 3);
+    const uint16_t* p = (const uint16_t*)data.data();
+
+    BENCHMARK("scalar 64")
+    { return checksum::detail::cksum_add_scalar(p, 64, 0); };
+
+    BENCHMARK("simd 64")
+    { return checksum::detail::cksum_add(p, 64, 0); };
+
+    BENCHMARK("scalar 128")
+    { return checksum::detail::cksum_add_scalar(p, 128, 0); };
+
+    BENCHMARK("simd 128")
+    { return checksum::detail::cksum_add(p, 128, 0); };
+
+    BENCHMARK("scalar 576")
+    { return checksum::detail::cksum_add_scalar(p, 576, 0); };
+
+    BENCHMARK("simd 576")
+    { return checksum::detail::cksum_add(p, 576, 0); };
+
+    BENCHMARK("scalar 1500")
+    { return checksum::detail::cksum_add_scalar(p, 1500, 0); };
+
+    BENCHMARK("simd 1500")
+    { return checksum::detail::cksum_add(p, 1500, 0); };
+
+    BENCHMARK("scalar 9000")
+    { return checksum::detail::cksum_add_scalar(p, 9000, 0); };
+
+    BENCHMARK("simd 9000")
+    { return checksum::detail::cksum_add(p, 9000, 0); };
+}
+#endif
+
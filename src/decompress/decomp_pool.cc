@@ -0,0 +1,304 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// decomp_pool.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "decomp_pool.h"
+
+#include <cstring>
+
+#include "main/thread.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+const unsigned DecompPool::max_pooled;
+
+static THREAD_LOCAL z_stream* inflate_pool[DecompPool::max_pooled];
+static THREAD_LOCAL unsigned inflate_count = 0;
+
+#ifdef HAVE_LZMA
+static THREAD_LOCAL lzma_stream* lzma_pool[DecompPool::max_pooled];
+static THREAD_LOCAL unsigned lzma_count = 0;
+#endif
+
+static THREAD_LOCAL bool pool_closed = false;
+
+//--------------------------------------------------------------------------
+// zlib
+//--------------------------------------------------------------------------
+
+static void free_inflate(z_stream* zs)
+{
+    inflateEnd(zs);
+    delete zs;
+}
+
+z_stream* DecompPool::get_inflate(int window_bits, bool* reused)
+{
+    while ( inflate_count )
+    {
+        z_stream* zs = inflate_pool[--inflate_count];
+
+        // keeps the window unless its size changes
+        if ( inflateReset2(zs, window_bits) == Z_OK )
+        {
+            zs->next_in = Z_NULL;
+            zs->avail_in = 0;
+
+            if ( reused )
+                *reused = true;
+
+            return zs;
+        }
+        free_inflate(zs);
+    }
+
+    z_stream* zs = new z_stream;
+    memset(zs, 0, sizeof(*zs));
+
+    zs->zalloc = Z_NULL;
+    zs->zfree = Z_NULL;
+    zs->next_in = Z_NULL;
+    zs->avail_in = 0;
+
+    if ( inflateInit2(zs, window_bits) != Z_OK )
+    {
+        delete zs;
+        return nullptr;
+    }
+
+    if ( reused )
+        *reused = false;
+
+    return zs;
+}
+
+void DecompPool::put_inflate(z_stream* zs)
+{
+    if ( !zs )
+        return;
+
+    if ( pool_closed or inflate_count == max_pooled )
+        free_inflate(zs);
+    else
+        inflate_pool[inflate_count++] = zs;
+}
+
+//--------------------------------------------------------------------------
+// lzma
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_LZMA
+static void free_lzma(lzma_stream* ls)
+{
+    lzma_end(ls);
+    delete ls;
+}
+
+lzma_stream* DecompPool::get_lzma_alone(uint64_t memlimit, bool* reused)
+{
+    lzma_stream* ls;
+    bool pooled = lzma_count > 0;
+
+    if ( pooled )
+        ls = lzma_pool[--lzma_count];
+    else
+    {
+        ls = new lzma_stream;
+        *ls = LZMA_STREAM_INIT;
+    }
+
+    // an existing decoder of the same type is reinitialized in place
+    if ( lzma_alone_decoder(ls, memlimit) != LZMA_OK )
+    {
+        free_lzma(ls);
+        return nullptr;
+    }
+
+    ls->next_in = nullptr;
+    ls->avail_in = 0;
+    ls->total_in = 0;
+    ls->total_out = 0;
+
+    if ( reused )
+        *reused = pooled;
+
+    return ls;
+}
+
+void DecompPool::put_lzma(lzma_stream* ls)
+{
+    if ( !ls )
+        return;
+
+    if ( pool_closed or lzma_count == max_pooled )
+        free_lzma(ls);
+    else
+        lzma_pool[lzma_count++] = ls;
+}
+#endif
+
+void DecompPool::thread_term()
+{
+    while ( inflate_count )
+        free_inflate(inflate_pool[--inflate_count]);
+
+#ifdef HAVE_LZMA
+    while ( lzma_count )
+        free_lzma(lzma_pool[--lzma_count]);
+#endif
+
+    pool_closed = true;
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static int inflate_all(z_stream* zs, const uint8_t* in, unsigned in_len, uint8_t* out,
+    unsigned out_len)
+{
+    zs->next_in = const_cast<Bytef*>(in);
+    zs->avail_in = in_len;
+    zs->next_out = out;
+    zs->avail_out = out_len;
+
+    return inflate(zs, Z_SYNC_FLUSH);
+}
+
+static unsigned deflate_all(int window_bits, const uint8_t* in, unsigned in_len, uint8_t* out,
+    unsigned out_len)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY);
+
+    zs.next_in = const_cast<Bytef*>(in);
+    zs.avail_in = in_len;
+    zs.next_out = out;
+    zs.avail_out = out_len;
+    deflate(&zs, Z_FINISH);
+
+    unsigned len = out_len - zs.avail_out;
+    deflateEnd(&zs);
+    return len;
+}
+
+TEST_CASE("decomp pool inflate reuse", "[decomp_pool]")
+{
+    uint8_t text[4000];
+
+    for ( unsigned i = 0; i < sizeof(text); ++i )
+        text[i] = "abcdefghij"[i % 10] + (i / 500);
+
+    uint8_t zipped[sizeof(text) + 100];
+    uint8_t out[sizeof(text)];
+
+    // gzip, zlib, and raw deflate share one pooled stream in turn
+    const int window_bits[] = { 31, 15, -15, 47 };
+    z_stream* first = nullptr;
+
+    for ( unsigned k = 0; k < 2 * sizeof(window_bits) / sizeof(window_bits[0]); ++k )
+    {
+        const int wbits = window_bits[k % 4];
+        const unsigned zipped_len =
+            deflate_all(wbits == 47 ? 31 : wbits, text, sizeof(text), zipped, sizeof(zipped));
+
+        bool reused = true;
+        z_stream* zs = DecompPool::get_inflate(wbits, &reused);
+        REQUIRE(zs != nullptr);
+
+        if ( !first )
+        {
+            CHECK(!reused);
+            first = zs;
+        }
+        else
+        {
+            CHECK(reused);
+            CHECK(zs == first);
+        }
+
+        // start mid stream and abandon it before the end
+        if ( k == 0 )
+            CHECK(inflate_all(zs, zipped, zipped_len / 2, out, sizeof(out)) == Z_OK);
+        else
+        {
+            CHECK(inflate_all(zs, zipped, zipped_len, out, sizeof(out)) == Z_STREAM_END);
+            CHECK(zs->total_out == sizeof(text));
+            CHECK(!memcmp(out, text, sizeof(text)));
+        }
+        DecompPool::put_inflate(zs);
+    }
+}
+
+TEST_CASE("decomp pool limit", "[decomp_pool]")
+{
+    z_stream* zs[DecompPool::max_pooled + 2];
+
+    for ( auto& z : zs )
+    {
+        z = DecompPool::get_inflate(15);
+        REQUIRE(z != nullptr);
+    }
+
+    for ( auto& z : zs )
+        DecompPool::put_inflate(z);
+
+    bool reused = false;
+    unsigned num_reused = 0;
+
+    for ( auto& z : zs )
+    {
+        z = DecompPool::get_inflate(15, &reused);
+        num_reused += reused ? 1 : 0;
+    }
+    CHECK(num_reused == DecompPool::max_pooled);
+
+    for ( auto& z : zs )
+        DecompPool::put_inflate(z);
+
+    DecompPool::put_inflate(nullptr);
+}
+
+#ifdef HAVE_LZMA
+TEST_CASE("decomp pool lzma reuse", "[decomp_pool]")
+{
+    bool reused = true;
+    lzma_stream* ls = DecompPool::get_lzma_alone(UINT64_MAX, &reused);
+    REQUIRE(ls != nullptr);
+    CHECK(!reused);
+    DecompPool::put_lzma(ls);
+
+    lzma_stream* again = DecompPool::get_lzma_alone(UINT64_MAX, &reused);
+    CHECK(reused);
+    CHECK(again == ls);
+    DecompPool::put_lzma(again);
+}
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// decomp_pool.h
+
+#ifndef DECOMP_POOL_H
+#define DECOMP_POOL_H
+
+// DecompPool recycles zlib inflate and lzma decoder state within a packet
+// thread.  Initializing a decoder allocates its internal state and sliding
+// window; a stream returned to the pool keeps those allocations so the next
+// user only pays for a reset.  Streams must be returned on the thread that
+// got them.
+
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+#include <zlib.h>
+
+#include "main/snort_types.h"
+
+namespace snort
+{
+class SO_PUBLIC DecompPool
+{
+public:
+    // returns a stream ready for inflate() with the given window bits or
+    // nullptr if zlib fails.  reused is set if the state came from the pool.
+    static z_stream* get_inflate(int window_bits, bool* reused = nullptr);
+    static void put_inflate(z_stream*);
+
+#ifdef HAVE_LZMA
+    // returns a stream set up as by lzma_alone_decoder() or nullptr
+    static lzma_stream* get_lzma_alone(uint64_t memlimit, bool* reused = nullptr);
+    static void put_lzma(lzma_stream*);
+#endif
+
+    // free the streams pooled by this thread; streams put afterwards are
+    // freed immediately
+    static void thread_term();
+
+    // per thread and per decoder type
+    static const unsigned max_pooled = 16;
+};
+}
+
+#endif
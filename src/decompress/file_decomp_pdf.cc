@@ -26,6 +26,7 @@
 
 #include <cassert>
 
+#include "decomp_pool.h"
 #include "main/thread.h"
 #include "utils/util.h"
 
@@ -902,24 +903,17 @@ static fd_status_t Init_Stream(fd_session_t* SessionPtr)
     {
     case FILE_COMPRESSION_TYPE_DEFLATE:
     {
-        int z_ret;
-
-        z_stream* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
-
-        memset( (char*)z_s, 0, sizeof(z_stream));
-
-        z_s->zalloc = (alloc_func)nullptr;
-        z_s->zfree = (free_func)nullptr;
-        SYNC_IN(z_s)
+        z_stream* z_s = DecompPool::get_inflate(47);
 
-        z_ret = inflateInit2(z_s, 47);
-
-        if ( z_ret != Z_OK )
+        if ( z_s == nullptr )
         {
             File_Decomp_Alert(SessionPtr, FILE_DECOMP_ERR_PDF_DEFL_FAILURE);
             return File_Decomp_Error;
         }
 
+        SYNC_IN(z_s)
+        StPtr->PDF_Decomp_State.Deflate.StreamDeflate = z_s;
+
         break;
     }
     default:
@@ -945,7 +939,7 @@ static fd_status_t Decomp_Stream(fd_session_t* SessionPtr)
     case FILE_COMPRESSION_TYPE_DEFLATE:
     {
         int z_ret;
-        z_stream* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
+        z_stream* z_s = StPtr->PDF_Decomp_State.Deflate.StreamDeflate;
 
         SYNC_IN(z_s)
 
@@ -1002,16 +996,9 @@ fd_status_t File_Decomp_End_PDF(fd_session_t* SessionPtr)
     {
     case FILE_COMPRESSION_TYPE_DEFLATE:
     {
-        int z_ret;
-        z_stream* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
-
-        z_ret = inflateEnd(z_s);
-
-        if ( z_ret != Z_OK )
-        {
-            File_Decomp_Alert(SessionPtr, FILE_DECOMP_ERR_PDF_DEFL_FAILURE);
-            return File_Decomp_Error;
-        }
+        // the stream goes back to the pool for the next one
+        DecompPool::put_inflate(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
+        StPtr->PDF_Decomp_State.Deflate.StreamDeflate = nullptr;
 
         break;
     }
@@ -23,6 +23,7 @@
 
 #include "file_decomp_zip.h"
 
+#include "decomp_pool.h"
 #include "helpers/boyer_moore_search.h"
 #include "utils/util.h"
 
@@ -31,19 +32,14 @@ using namespace snort;
 // initialize zlib decompression
 static fd_status_t Inflate_Init(fd_session_t* SessionPtr)
 {
-    z_stream* z_s = &(SessionPtr->ZIP->Stream);
+    // each entry of an archive reuses the stream of the one before it
+    z_stream* z_s = DecompPool::get_inflate(-MAX_WBITS);
 
-    memset((char*)z_s, 0, sizeof(z_stream));
-
-    z_s->zalloc = (alloc_func)nullptr;
-    z_s->zfree = (free_func)nullptr;
+    if ( z_s == nullptr )
+        return File_Decomp_Error;
 
     SYNC_IN(z_s)
-
-    int z_ret = inflateInit2(z_s, -MAX_WBITS);
-
-    if ( z_ret != Z_OK )
-        return File_Decomp_Error;
+    SessionPtr->ZIP->Stream = z_s;
 
     return File_Decomp_OK;
 }
@@ -51,9 +47,8 @@ static fd_status_t Inflate_Init(fd_session_t* SessionPtr)
 // end zlib decompression
 static fd_status_t Inflate_End(fd_session_t* SessionPtr)
 {
-    z_stream* z_s = &(SessionPtr->ZIP->Stream);
-
-    inflateEnd(z_s);
+    DecompPool::put_inflate(SessionPtr->ZIP->Stream);
+    SessionPtr->ZIP->Stream = nullptr;
 
     return File_Decomp_OK;
 }
@@ -63,7 +58,7 @@ static fd_status_t Inflate(fd_session_t* SessionPtr)
 {
     const uint8_t *zlib_start, *zlib_end;
 
-    z_stream* z_s = &(SessionPtr->ZIP->Stream);
+    z_stream* z_s = SessionPtr->ZIP->Stream;
 
     zlib_start = SessionPtr->Next_In;
 
@@ -65,6 +65,14 @@ using namespace snort;
 void DetectionEngine::thread_init()
 {
     const SnortConfig* sc = SnortConfig::get_conf();
+
+    if ( sc->mpse_batch_size )
+    {
+        // searches are deferred and combined on the packet thread
+        offloader = new BatchRegexOffload(sc->mpse_batch_size, sc->mpse_batch_latency);
+        return;
+    }
+
     FastPatternConfig* fp = sc->fast_pattern_config;
     const MpseApi* offload_search_api = fp->get_offload_search_api();
 
@@ -87,6 +95,11 @@ void DetectionEngine::thread_init()
             assert(MpseManager::is_poll_capable(search_api));
             offloader = RegexOffload::get_offloader(sc->offload_threads, false);
         }
+        else if ( sc->offload_pool and sc->offload_threads )
+        {
+            // Offloaded searches are performed by threads shared with all packet threads.
+            offloader = new PooledRegexOffload(sc->offload_threads, sc->offload_pool);
+        }
         else
         {
             // If the search method is not async capable then offloaded searches will be performed
@@ -406,6 +419,7 @@ bool DetectionEngine::do_offload(Packet* p)
     pc.offloads++;
 
 #ifdef REG_TEST
+    offloader->flush();
     onload();
     return false;
 #else
@@ -418,7 +432,7 @@ bool DetectionEngine::offload(Packet* p)
     ContextSwitcher* sw = Analyzer::get_switcher();
     fp_partial(p);
 
-    if ( p->dsize >= p->context->conf->offload_limit and
+    if ( (p->dsize >= p->context->conf->offload_limit or p->context->conf->mpse_batch_size) and
         p->context->searches.items.size() > 0 )
     {
         if ( offloader->available() )
@@ -450,6 +464,7 @@ void DetectionEngine::idle()
             debug_logf(detection_trace, TRACE_DETECTION_ENGINE, nullptr,
                 "(wire) %" PRIu64 " de::sleep\n", get_packet_number());
 
+            offloader->flush();
             onload();
         }
         debug_logf(detection_trace, TRACE_DETECTION_ENGINE, nullptr,
@@ -470,6 +485,7 @@ void DetectionEngine::onload(Flow* flow)
         debug_logf(detection_trace, TRACE_DETECTION_ENGINE, nullptr,
             "(wire) %" PRIu64 " de::sleep\n", get_packet_number());
 
+        offloader->flush();
         resume_ready_suspends(flow->context_chain); // FIXIT-M makes onload reentrant-safe
         onload();
     }
@@ -546,6 +562,7 @@ void DetectionEngine::wait_for_context()
         pc.context_stalls++;
         do
         {
+            offloader->flush();
             onload();
         } while ( !sw->idle_count() );
     }
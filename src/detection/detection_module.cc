@@ -78,6 +78,15 @@ static const Parameter detection_params[] =
     { "offload_threads", Parameter::PT_INT, "0:max32", "0",
       "maximum number of simultaneous offloads (defaults to disabled)" },
 
+    { "offload_pool", Parameter::PT_INT, "0:max32", "0",
+      "number of offload threads shared by all packet threads (defaults to offload_threads per packet thread)" },
+
+    { "mpse_batch_size", Parameter::PT_INT, "0:64", "0",
+      "maximum number of packets to combine in one fast pattern search per engine (defaults to disabled)" },
+
+    { "mpse_batch_latency", Parameter::PT_INT, "1:max32", "1000",
+      "maximum microseconds a packet waits for its combined fast pattern search" },
+
     { "pcre_enable", Parameter::PT_BOOL, nullptr, "true",
       "enable pcre pattern matching" },
 
@@ -124,8 +133,12 @@ const TraceOption* DetectionModule::get_trace_options() const
 
 bool DetectionModule::end(const char*, int, SnortConfig* sc)
 {
-    if ( sc->offload_threads and ThreadConfig::get_instance_max() != 1 )
-        ParseError("You can not enable experimental offload with more than one packet thread.");
+    if ( sc->offload_threads and !sc->offload_pool and ThreadConfig::get_instance_max() != 1 )
+        ParseError("You can not enable experimental offload with more than one packet thread "
+            "unless offload_pool is set.");
+
+    if ( sc->offload_threads and sc->mpse_batch_size )
+        ParseError("You can not enable both offload and mpse batching.");
 
     return true;
 }
@@ -155,6 +168,15 @@ bool DetectionModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("offload_threads") )
         sc->offload_threads = v.get_uint32();
 
+    else if ( v.is("offload_pool") )
+        sc->offload_pool = v.get_uint32();
+
+    else if ( v.is("mpse_batch_size") )
+        sc->mpse_batch_size = v.get_uint32();
+
+    else if ( v.is("mpse_batch_latency") )
+        sc->mpse_batch_latency = v.get_uint32();
+
     else if ( v.is("pcre_enable") )
         v.update_mask(sc->run_flags, RUN_FLAG__NO_PCRE, true);
 
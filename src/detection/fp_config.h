@@ -124,6 +124,18 @@ public:
     const std::string& get_rule_db_dir() const
     { return rule_db_dir; }
 
+    void set_mpse_cache_dir(const char* s)
+    { mpse_cache_dir = s; }
+
+    const std::string& get_mpse_cache_dir() const
+    { return mpse_cache_dir; }
+
+    void set_build_threads(unsigned n)
+    { build_threads = n; }
+
+    unsigned get_build_threads() const
+    { return build_threads; }
+
     bool set_search_method(const char*);
     const char* get_search_method();
 
@@ -163,11 +175,13 @@ private:
     unsigned max_pattern_len = 0;
 
     unsigned queue_limit = 0;
+    unsigned build_threads = 0;  // 0 means default
 
     int portlists_flags = 0;
     unsigned num_patterns_truncated = 0;  // due to max_pattern_len
 
     std::string rule_db_dir;
+    std::string mpse_cache_dir;
 };
 
 #endif
@@ -396,6 +396,9 @@ static int pmx_create_tree(SnortConfig* sc, void* id, void** existing_tree, Mpse
             return -1;
 
         /* null input id (PMX *), last call for this pattern state */
+        if ( defer_tree(*existing_tree) )
+            return 0;
+
         return finalize_detection_option_tree(sc, (detection_option_tree_root_t*)*existing_tree);
     }
 
@@ -1521,23 +1524,27 @@ static void fpCreateServiceRuleGroups(SnortConfig* sc)
     sc->srmmTable = nullptr;
 }
 
-static unsigned can_build_mt(FastPatternConfig* fp)
+static unsigned get_build_threads(SnortConfig* sc, FastPatternConfig* fp)
 {
-    if ( Snort::is_reloading() )
-        return false;
-
     const MpseApi* search_api = fp->get_search_api();
     assert(search_api);
 
     if ( !MpseManager::parallel_compiles(search_api) )
-        return false;
+        return 1;
 
     const MpseApi* offload_search_api = fp->get_offload_search_api();
 
     if ( offload_search_api and !MpseManager::parallel_compiles(offload_search_api) )
-        return false;
+        return 1;
 
-    return true;
+    if ( unsigned n = fp->get_build_threads() )
+        return n;
+
+    // don't take cores from the packet threads by default
+    if ( Snort::is_reloading() )
+        return 1;
+
+    return sc->num_slots;
 }
 
 /*
@@ -1571,7 +1578,10 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
     if ( log_rule_group_details )
         LogMessage("Creating Port Groups....\n");
 
-    fpCreateRuleGroups(sc, port_tables);
+    {
+        BuildTimer t("port groups");
+        fpCreateRuleGroups(sc, port_tables);
+    }
 
     if ( log_rule_group_details )
     {
@@ -1579,7 +1589,10 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
         LogMessage("Creating Rule Maps....\n");
     }
 
-    fpCreateRuleMaps(sc, port_tables);
+    {
+        BuildTimer t("rule maps");
+        fpCreateRuleMaps(sc, port_tables);
+    }
 
     if ( log_rule_group_details )
     {
@@ -1587,24 +1600,53 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
         LogMessage("Creating Service Based Rule Maps....\n");
     }
 
-    fpCreateServiceRuleGroups(sc);
+    {
+        BuildTimer t("service groups");
+        fpCreateServiceRuleGroups(sc);
+    }
 
     if ( log_rule_group_details )
         LogMessage("Service Based Rule Maps Done....\n");
 
     unsigned mpse_loaded = 0;
     unsigned mpse_dumped = 0;
+    unsigned mpse_cached = 0;
+    unsigned mpse_added = 0;
 
     if ( !sc->test_mode() or sc->mem_check() )
     {
         if ( !fp->get_rule_db_dir().empty() )
             mpse_loaded = fp_deserialize(sc, fp->get_rule_db_dir());
 
-        unsigned c = compile_mpses(sc, can_build_mt(fp));
+        if ( !fp->get_mpse_cache_dir().empty() )
+            mpse_cached = fp_cache_load(sc, fp->get_mpse_cache_dir());
+
+        std::vector<void*> trees;
+        CompileTimes times;
+        unsigned c;
+        {
+            BuildTimer t("mpse compile");
+            c = compile_mpses(sc, get_build_threads(sc, fp), trees, times);
+        }
+
+        // per method times are summed across threads
+        for ( const auto& ct : times )
+            SetBuildTime(("mpse " + ct.first).c_str(), ct.second);
+
+        {
+            BuildTimer t("option trees");
+
+            for ( auto* root : trees )
+                finalize_detection_option_tree(sc, (detection_option_tree_root_t*)root);
+        }
+
         unsigned expected = mpse_count + offload_mpse_count;
 
         if ( c != expected )
             ParseError("Failed to compile %u search engines", expected - c);
+
+        else if ( !fp->get_mpse_cache_dir().empty() )
+            mpse_added = fp_cache_store(sc, fp->get_mpse_cache_dir());
     }
 
     fp_print_port_groups(port_tables);
@@ -1629,6 +1671,8 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
     LogCount("fast pattern only", fp_only);
     LogCount("mpse_loaded", mpse_loaded);
     LogCount("mpse_dumped", mpse_dumped);
+    LogCount("mpse_cached", mpse_cached);
+    LogCount("mpse_added", mpse_added);
 
     MpseManager::setup_search_engine(fp->get_search_api(), sc);
 
@@ -22,15 +22,19 @@
 
 #include "fp_utils.h"
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <list>
-#include <mutex>
 #include <sstream>
 #include <thread>
 
+#include <unistd.h>
+
 #include "framework/mpse.h"
 #include "framework/mpse_batch.h"
 #include "hash/ghash.h"
@@ -246,12 +250,14 @@ bool FpSelector::is_better_than(
 //--------------------------------------------------------------------------
 
 static unsigned mpse_loaded, mpse_dumped;
+static unsigned mpse_cache_hits, mpse_cache_adds;
 
 static bool store(const std::string& s, const uint8_t* data, size_t len)
 {
     std::ofstream out(s.c_str(), std::ofstream::binary);
     out.write((const char*)data, len);
-    return true;
+    out.close();
+    return !out.fail();
 }
 
 static bool fetch(const std::string& s, uint8_t*& data, size_t& len)
@@ -352,6 +358,98 @@ static bool db_load(const std::string& path, const char* proto, const char* dir,
     return true;
 }
 
+
+//--------------------------------------------------------------------------
+// compiled mpse cache
+//
+// unlike the rule db dir above, cache entries are named only by search
+// method and pattern set hash so that any group with the same patterns can
+// use them, regardless of where it lives in the port or service tables.
+// missing entries are not an error; they are compiled and added after.
+//--------------------------------------------------------------------------
+
+static std::string make_cache_name(const std::string& path, Mpse* mpse)
+{
+    std::string id;
+    mpse->get_hash(id);
+
+    if ( id.empty() )
+        return id;
+
+    std::stringstream ss;
+
+    ss << path << "/" << mpse->get_method() << "_";
+    ss << std::hex << std::setfill('0');
+
+    for ( auto c : id )
+        ss << std::setw(2) << (unsigned)(uint8_t)c;
+
+    ss << ".mpdb";
+
+    return ss.str();
+}
+
+static bool cache_load(const std::string& path, const char*, const char*, RuleGroup* g)
+{
+    for ( auto i = 0; i < PM_TYPE_MAX; ++i )
+    {
+        if ( !g->mpsegrp[i] or !g->mpsegrp[i]->normal_mpse )
+            continue;
+
+        Mpse* mpse = g->mpsegrp[i]->normal_mpse;
+        std::string file = make_cache_name(path, mpse);
+
+        uint8_t* db = nullptr;
+        size_t len = 0;
+
+        if ( file.empty() or !fetch(file, db, len) )
+            continue;
+
+        if ( mpse->deserialize(db, len) )
+            ++mpse_cache_hits;
+        else
+            ParseWarning(WARN_RULES, "Ignoring stale mpse cache entry %s", file.c_str());
+
+        delete[] db;
+    }
+    return true;
+}
+
+static bool cache_store(const std::string& path, const char*, const char*, RuleGroup* g)
+{
+    for ( auto i = 0; i < PM_TYPE_MAX; ++i )
+    {
+        if ( !g->mpsegrp[i] or !g->mpsegrp[i]->normal_mpse )
+            continue;
+
+        Mpse* mpse = g->mpsegrp[i]->normal_mpse;
+        std::string file = make_cache_name(path, mpse);
+
+        if ( file.empty() or !access(file.c_str(), F_OK) )
+            continue;
+
+        uint8_t* db = nullptr;
+        size_t len = 0;
+
+        if ( !mpse->serialize(db, len) or !db or !len )
+            continue;
+
+        // write then rename so that readers never see a partial entry
+        std::string tmp = file + "." + std::to_string(getpid());
+        bool stored = store(tmp, db, len);
+        free(db);
+
+        if ( !stored or rename(tmp.c_str(), file.c_str()) )
+        {
+            ParseWarning(WARN_RULES, "Failed to add mpse cache entry %s", file.c_str());
+            remove(tmp.c_str());
+            continue;
+        }
+        ++mpse_cache_adds;
+    }
+    return true;
+}
+
 typedef bool (*db_io)(const std::string&, const char*, const char*, RuleGroup*);
 
 static void port_io(
@@ -429,6 +527,20 @@ unsigned fp_deserialize(const SnortConfig* sc, const std::string& dir)
     return mpse_loaded;
 }
 
+unsigned fp_cache_load(const SnortConfig* sc, const std::string& dir)
+{
+    mpse_cache_hits = 0;
+    fp_io(sc, dir, cache_load);
+    return mpse_cache_hits;
+}
+
+unsigned fp_cache_store(const SnortConfig* sc, const std::string& dir)
+{
+    mpse_cache_adds = 0;
+    fp_io(sc, dir, cache_store);
+    return mpse_cache_adds;
+}
+
 void validate_services(SnortConfig* sc, OptTreeNode* otn)
 {
     std::string svc;
@@ -566,68 +678,93 @@ bool is_fast_pattern_only(const OptTreeNode* otn, const OptFpList* ofp, Mpse::Mp
 
 //--------------------------------------------------------------------------
 // mpse compile threads
+//
+// engines are compiled in queue order by the first free thread.  option
+// trees finished by compile threads are handed back and finalized in queue
+// order afterwards so the shared trees don't depend on thread timing.
 //--------------------------------------------------------------------------
 
-static std::list<Mpse*> s_tbd;
-static std::mutex s_mutex;
-
-static Mpse* get_mpse()
+struct MpseJob
 {
-    std::lock_guard<std::mutex> lock(s_mutex);
+    Mpse* mpse;
+    std::vector<void*> trees;
+    double secs = 0.0;
+    bool ok = false;
 
-    if ( s_tbd.empty() )
-        return nullptr;
-
-    Mpse* m = s_tbd.front();
-    s_tbd.pop_front();
+    MpseJob(Mpse* m) : mpse(m) { }
+};
 
-    return m;
-}
+static std::vector<MpseJob> s_tbd;
+static std::atomic<unsigned> s_next { 0 };
+static THREAD_LOCAL std::vector<void*>* s_trees = nullptr;
 
-static void compile_mpse(SnortConfig* sc, unsigned id, unsigned* count)
+static void compile_mpse(SnortConfig* sc, unsigned id, bool defer)
 {
     set_instance_id(id);
-    unsigned c = 0;
+    unsigned i;
 
-    while ( Mpse* m = get_mpse() )
+    while ( (i = s_next++) < s_tbd.size() )
     {
-        if ( !m->prep_patterns(sc) )
-        {
-            if ( sc->fast_pattern_config->get_debug_mode() )
-                m->print_info();
+        MpseJob& job = s_tbd[i];
+        s_trees = defer ? &job.trees : nullptr;
 
-            c++;
-        }
+        auto start = std::chrono::steady_clock::now();
+        job.ok = !job.mpse->prep_patterns(sc);
+        job.secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
     }
-    std::lock_guard<std::mutex> lock(s_mutex);
-    *count += c;
+    s_trees = nullptr;
+}
+
+bool defer_tree(void* root)
+{
+    if ( !s_trees )
+        return false;
+
+    s_trees->emplace_back(root);
+    return true;
 }
 
 void queue_mpse(Mpse* m)
 {
-    s_tbd.push_back(m);
+    s_tbd.emplace_back(m);
 }
 
-unsigned compile_mpses(struct SnortConfig* sc, bool parallel)
+unsigned compile_mpses(
+    SnortConfig* sc, unsigned max, std::vector<void*>& trees, CompileTimes& times)
 {
     std::list<std::thread*> workers;
-    unsigned max = parallel ? sc->num_slots : 1;
-    unsigned count = 0;
+    s_next = 0;
+
+    if ( max <= 1 )
+        compile_mpse(sc, get_instance_id(), false);
 
-    if ( max == 1 )
+    else
     {
-        compile_mpse(sc, get_instance_id(), &count);
-        return count;
+        for ( unsigned i = 0; i < max; ++i )
+            workers.push_back(new std::thread(compile_mpse, sc, i, true));
+
+        for ( auto* w : workers )
+        {
+            w->join();
+            delete w;
+        }
     }
 
-    for ( unsigned i = 0; i < max; ++i )
-        workers.push_back(new std::thread(compile_mpse, sc, i, &count));
+    unsigned count = 0;
 
-    for ( auto* w : workers )
+    for ( auto& job : s_tbd )
     {
-        w->join();
-        delete w;
+        if ( job.ok )
+        {
+            if ( sc->fast_pattern_config->get_debug_mode() )
+                job.mpse->print_info();
+
+            count++;
+        }
+        trees.insert(trees.end(), job.trees.begin(), job.trees.end());
+        times[job.mpse->get_method()] += job.secs;
     }
+    s_tbd.clear();
     return count;
 }
 
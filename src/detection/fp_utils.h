@@ -23,6 +23,7 @@
 
 // fast pattern utilities
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -45,13 +46,27 @@ bool set_fp_content(OptTreeNode*);
 std::vector <PatternMatchData*> get_fp_content(
     OptTreeNode*, OptFpList*&, bool srvc, bool only_literals, bool& exclude);
 
+// compile seconds per search method
+typedef std::map<std::string, double> CompileTimes;
+
 void queue_mpse(snort::Mpse*);
-unsigned compile_mpses(struct snort::SnortConfig*, bool parallel = false);
+
+// compile the queued engines with up to max threads; trees deferred
+// with defer_tree() are returned in queue order for finalizing
+unsigned compile_mpses(
+    struct snort::SnortConfig*, unsigned max, std::vector<void*>& trees, CompileTimes&);
+
+// called from the build_tree agent; true if the tree is left for the
+// caller of compile_mpses() to finalize
+bool defer_tree(void* root);
 
 void validate_services(struct snort::SnortConfig*, OptTreeNode*);
 
 unsigned fp_serialize(const struct snort::SnortConfig*, const std::string& dir);
 unsigned fp_deserialize(const struct snort::SnortConfig*, const std::string& dir);
 
+unsigned fp_cache_load(const struct snort::SnortConfig*, const std::string& dir);
+unsigned fp_cache_store(const struct snort::SnortConfig*, const std::string& dir);
+
 #endif
 
@@ -32,6 +32,7 @@
 #include "events/event_queue.h"
 #include "events/sfeventq.h"
 #include "main/snort_config.h"
+#include "memory/huge_page_pool.h"
 #include "stream/stream.h"
 
 #ifdef UNIT_TEST
@@ -47,6 +48,13 @@ using namespace snort;
 IpsContext::IpsContext(unsigned size) :
     data(size ? size : max_ips_id, nullptr)
 {
+    // preallocate registered types; others are allocated on first use
+    for ( unsigned id = 1; id < data.size(); ++id )
+    {
+        if ( (data[id] = IpsContextData::create(id)) )
+            ids_in_use.emplace_back(id);
+    }
+
     depends_on = nullptr;
     next_to_process = nullptr;
 
@@ -56,7 +64,7 @@ IpsContext::IpsContext(unsigned size) :
     encode_packet = nullptr;
 
     pkth = new DAQ_PktHdr_t;
-    buf = new uint8_t[buf_size];
+    buf = memory::HugePagePool::alloc(buf_size);
 
     conf = SnortConfig::get_conf();
     const EventQueueConfig* qc = conf->event_queue_config;
@@ -85,7 +93,7 @@ IpsContext::~IpsContext()
     sfeventq_free(equeue);
     fp_clear_context(*this);
 
-    delete[] buf;
+    memory::HugePagePool::dealloc(buf);
     delete pkth;
     delete packet;
 }
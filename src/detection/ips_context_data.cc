@@ -26,6 +26,7 @@
 
 #include <cassert>
 #include "detection/ips_context.h"
+#include "utils/stats.h"
 
 #ifdef UNIT_TEST
 #include "catch/snort_catch.h"
@@ -38,6 +39,7 @@ using namespace snort;
 //--------------------------------------------------------------------------
 
 unsigned IpsContextData::ips_id = 0;
+static IpsContextData::Factory factories[IpsContext::max_ips_id] = { };
 
 unsigned IpsContextData::get_ips_id()
 {
@@ -46,9 +48,31 @@ unsigned IpsContextData::get_ips_id()
     return ips_id;
 }
 
+unsigned IpsContextData::get_ips_id(Factory f)
+{
+    unsigned id = get_ips_id();
+    factories[id] = f;
+    return id;
+}
+
+IpsContextData* IpsContextData::create(unsigned id)
+{
+    assert(id < IpsContext::max_ips_id);
+    return factories[id] ? factories[id]() : nullptr;
+}
+
+void IpsContextData::set_allocated(unsigned id, IpsContextData* p)
+{
+    DetectionEngine::set_data(id, p);
+    pc.context_data_allocs++;
+}
+
 void IpsContextData::clear_ips_id()
 {
     ips_id = 0;
+
+    for ( auto& f : factories )
+        f = nullptr;
 }
 
 //--------------------------------------------------------------------------
@@ -65,6 +89,31 @@ TEST_CASE("IpsContextData id", "[IpsContextData]")
     auto id2 = IpsContextData::get_ips_id();
 
     CHECK(id1 != id2);
+    CHECK(IpsContextData::create(id1) == nullptr);
+}
+
+class PoolData : public IpsContextData
+{
+public:
+    void clear() override
+    { ++clears; }
+
+    unsigned clears = 0;
+};
+
+TEST_CASE("IpsContextData factory", "[IpsContextData]")
+{
+    IpsContextData::clear_ips_id();
+
+    auto id = IpsContextData::get_ips_id<PoolData>();
+    IpsContextData* p = IpsContextData::create(id);
+
+    REQUIRE(p != nullptr);
+    CHECK(dynamic_cast<PoolData*>(p) != nullptr);
+    delete p;
+
+    IpsContextData::clear_ips_id();
+    CHECK(IpsContextData::create(id) == nullptr);
 }
 
 #endif
@@ -32,7 +32,21 @@ class SO_PUBLIC IpsContextData
 public:
     virtual ~IpsContextData() = default;
 
+    using Factory = IpsContextData* (*)();
+
     static unsigned get_ips_id();
+
+    // get an id for type T which is preallocated in each new context
+    // and reset with clear() instead of being allocated per packet
+    template<typename T>
+    static unsigned get_ips_id()
+    { return get_ips_id(create<T>); }
+
+    static unsigned get_ips_id(Factory);
+
+    // returns nullptr if no factory was registered for the id
+    static IpsContextData* create(unsigned ips_id);
+
     // Only unit tests can call this function to clear the id
     static void clear_ips_id();
 
@@ -43,16 +57,23 @@ public:
         if ( ! data )
         {
             data = new T;
-            DetectionEngine::set_data(ips_id, data);
+            set_allocated(ips_id, data);
         }
         return data;
     }
+
+    // install data allocated on first use in the current context
+    static void set_allocated(unsigned ips_id, IpsContextData*);
     virtual void clear() {}
 
 protected:
     IpsContextData() = default;
 
 private:
+    template<typename T>
+    static IpsContextData* create()
+    { return new T; }
+
     static unsigned ips_id;
 };
 }
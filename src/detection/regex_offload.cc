@@ -26,10 +26,15 @@
 
 #include <cassert>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 #include <thread>
 
@@ -43,6 +48,10 @@
 #include "managers/module_manager.h"
 #include "utils/stats.h"
 
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
 // FIXIT-L this could be offloader specific
@@ -60,6 +69,7 @@ struct RegexRequest
     std::condition_variable sync_cond;
 #endif
 
+    std::chrono::steady_clock::time_point start;
     std::atomic<bool> offload { false };
 
     bool go = true;
@@ -179,6 +189,66 @@ bool MpseRegexOffload::get(Packet*& p)
 // async (threads) offload implementation
 //--------------------------------------------------------------------------
 
+static void sync_search(RegexRequest* req)
+{
+#ifdef REG_TEST
+    std::unique_lock<std::mutex> sync_lock(req->sync_mutex);
+    while ( req->offload and req->sync_cond.wait_for(sync_lock, std::chrono::seconds(1))
+        == std::cv_status::timeout );
+#else
+    UNUSED(req);
+#endif
+}
+
+static void offload_search(RegexRequest* req)
+{
+    assert(req->packet);
+    assert(req->packet->is_offloaded());
+    assert(req->packet->context->searches.items.size() > 0);
+
+    SnortConfig::set_conf(req->packet->context->conf);
+    IpsContext* c = req->packet->context;
+    Mpse::MpseRespType resp_ret;
+
+    c->searches.offload_search();
+
+    do
+    {
+        resp_ret = c->searches.receive_offload_responses();
+    }
+    while (resp_ret == Mpse::MPSE_RESP_NOT_COMPLETE);
+
+    if (resp_ret == Mpse::MPSE_RESP_COMPLETE_FAIL)
+    {
+        if (c->searches.can_fallback())
+        {
+            c->searches.search_sync();
+            pc.offload_fallback++;
+        }
+        pc.offload_failures++;
+    }
+
+    c->searches.items.clear();
+    req->offload = false;
+
+#ifdef REG_TEST
+    {
+        std::unique_lock<std::mutex> lock(req->sync_mutex);
+        req->sync_cond.notify_one();
+    }
+#endif
+}
+
+static void offload_term()
+{
+    ModuleManager::accumulate_module("search_engine");
+    ModuleManager::accumulate_module("detection");
+
+    // FIXIT-M break this over-coupling. In reality we shouldn't be evaluating latency in offload.
+    PacketLatency::tterm();
+    RuleLatency::tterm();
+}
+
 ThreadRegexOffload::ThreadRegexOffload(unsigned max) : RegexOffload(max)
 {
     unsigned i = ThreadConfig::get_instance_max();
@@ -231,13 +301,7 @@ void ThreadRegexOffload::put(Packet* p)
         req->cond.notify_one();
     }
 
-#ifdef REG_TEST
-    {
-        std::unique_lock<std::mutex> sync_lock(req->sync_mutex);
-        while ( req->offload and req->sync_cond.wait_for(sync_lock, std::chrono::seconds(1))
-            == std::cv_status::timeout );
-    }
-#endif
+    sync_search(req);
 }
 
 bool ThreadRegexOffload::get(Packet*& p)
@@ -285,47 +349,534 @@ void ThreadRegexOffload::worker(
                 continue;
         }
 
-        assert(req->packet);
-        assert(req->packet->is_offloaded());
-        assert(req->packet->context->searches.items.size() > 0);
+        offload_search(req);
+    }
+    offload_term();
+}
+
+//--------------------------------------------------------------------------
+// shared (work stealing) threads offload implementation
+//--------------------------------------------------------------------------
+
+// each packet thread submits to its own queue, bounded by the number of
+// requests it owns.  each pool thread has one or more home queues; when
+// those are empty it takes work from the other queues, first those of
+// packet threads on the same NUMA node.
+
+struct OffloadQueue
+{
+    std::mutex mutex;
+    std::deque<RegexRequest*> reqs;
+};
 
-        SnortConfig::set_conf(req->packet->context->conf);
-        IpsContext* c = req->packet->context;
-        Mpse::MpseRespType resp_ret;
+class OffloadPool
+{
+public:
+    OffloadPool(const SnortConfig*, unsigned threads);
+    ~OffloadPool();
+
+    unsigned put(unsigned queue, RegexRequest*);
+
+private:
+    RegexRequest* take(const std::vector<unsigned>& order, unsigned homes, bool& stolen);
+    void worker(const SnortConfig*, unsigned id, std::vector<unsigned> order, unsigned homes);
+
+private:
+    std::unique_ptr<OffloadQueue[]> queues;
+    std::vector<std::thread*> threads;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::atomic<unsigned> pending { 0 };
+    bool go = true;
+};
 
-        c->searches.offload_search();
+OffloadPool::OffloadPool(const SnortConfig* sc, unsigned num)
+{
+    unsigned max = ThreadConfig::get_instance_max();
+    queues.reset(new OffloadQueue[max]);
 
-        do
+    std::vector<int> nodes;
+
+    for ( unsigned q = 0; q < max; ++q )
+        nodes.emplace_back(sc->thread_config->get_numa_node(STHREAD_TYPE_PACKET, q));
+
+    for ( unsigned t = 0; t < num; ++t )
+    {
+        // home queues first, then same node, then the rest
+        std::vector<unsigned> order;
+
+        for ( unsigned q = 0; q < max; ++q )
         {
-            resp_ret = c->searches.receive_offload_responses();
+            if ( q % num == t or (num > max and q == t % max) )
+                order.emplace_back(q);
         }
-        while (resp_ret == Mpse::MPSE_RESP_NOT_COMPLETE);
+        unsigned homes = order.size();
+        int node = nodes[order[0]];
 
-        if (resp_ret == Mpse::MPSE_RESP_COMPLETE_FAIL)
+        for ( unsigned q = 0; q < max; ++q )
+        {
+            if ( nodes[q] == node and std::find(order.begin(), order.end(), q) == order.end() )
+                order.emplace_back(q);
+        }
+        for ( unsigned q = 0; q < max; ++q )
+        {
+            if ( std::find(order.begin(), order.end(), q) == order.end() )
+                order.emplace_back(q);
+        }
+        threads.emplace_back(
+            new std::thread(&OffloadPool::worker, this, sc, max + t, order, homes));
+    }
+}
+
+OffloadPool::~OffloadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        go = false;
+        cond.notify_all();
+    }
+    for ( auto* t : threads )
+    {
+        t->join();
+        delete t;
+    }
+}
+
+unsigned OffloadPool::put(unsigned queue, RegexRequest* req)
+{
+    unsigned depth;
+    {
+        OffloadQueue& oq = queues[queue];
+        std::lock_guard<std::mutex> lock(oq.mutex);
+        oq.reqs.emplace_back(req);
+        depth = oq.reqs.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++pending;
+    }
+    cond.notify_one();
+    return depth;
+}
+
+RegexRequest* OffloadPool::take(const std::vector<unsigned>& order, unsigned homes, bool& stolen)
+{
+    for ( unsigned i = 0; i < order.size() and pending; ++i )
+    {
+        OffloadQueue& oq = queues[order[i]];
+        std::lock_guard<std::mutex> lock(oq.mutex);
+
+        if ( oq.reqs.empty() )
+            continue;
+
+        RegexRequest* req = oq.reqs.front();
+        oq.reqs.pop_front();
+        --pending;
+
+        stolen = (i >= homes);
+        return req;
+    }
+    return nullptr;
+}
+
+void OffloadPool::worker(
+    const SnortConfig* initial_config, unsigned id, std::vector<unsigned> order, unsigned homes)
+{
+    set_instance_id(id);
+    SnortConfig::set_conf(initial_config);
+
+    initial_config->thread_config->implement_numa_affinity(
+        initial_config->thread_config->get_numa_node(STHREAD_TYPE_PACKET, order[0]));
+
+    while ( true )
+    {
+        bool stolen;
+        RegexRequest* req = take(order, homes, stolen);
+
+        if ( !req )
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            if ( !go )
+                break;
+
+            if ( !pending )
+                cond.wait_for(lock, std::chrono::seconds(1));
+
+            continue;
+        }
+
+        if ( stolen )
+            pc.offload_steals++;
+
+        offload_search(req);
+    }
+    offload_term();
+}
+
+static OffloadPool* pool = nullptr;
+static unsigned pool_users = 0;
+static std::mutex pool_mutex;
+
+PooledRegexOffload::PooledRegexOffload(unsigned max, unsigned threads) : RegexOffload(max)
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+
+    if ( !pool_users++ )
+        pool = new OffloadPool(SnortConfig::get_conf(), threads);
+}
+
+PooledRegexOffload::~PooledRegexOffload()
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+
+    if ( !--pool_users )
+    {
+        delete pool;
+        pool = nullptr;
+    }
+}
+
+void PooledRegexOffload::put(Packet* p)
+{
+    Profile profile(mpsePerfStats);
+
+    assert(p);
+    assert(!idle.empty());
+    assert(p->context->searches.items.size() > 0);
+
+    RegexRequest* req = idle.front();
+    idle.pop_front();
+
+    busy.emplace_back(req);
+    p->context->regex_req_it = std::prev(busy.end());
+
+    req->packet = p;
+    req->start = std::chrono::steady_clock::now();
+    req->offload = true;
+
+    unsigned depth = pool->put(get_instance_id(), req);
+
+    if ( depth > pc.offload_queue_max )
+        pc.offload_queue_max = depth;
+
+    sync_search(req);
+}
+
+bool PooledRegexOffload::get(Packet*& p)
+{
+    Profile profile(mpsePerfStats);
+    assert(!busy.empty());
+
+    for ( auto i = busy.begin(); i != busy.end(); i++ )
+    {
+        RegexRequest* req = *i;
+
+        if ( req->offload )
+            continue;
+
+        auto usec = std::chrono::duration_cast<std::chrono::microseconds>
+            (std::chrono::steady_clock::now() - req->start).count();
+
+        pc.offload_latency += usec;
+
+        if ( (PegCount)usec > pc.offload_latency_max )
+            pc.offload_latency_max = usec;
+
+        p = req->packet;
+        assert(p->context->regex_req_it == i);
+        req->packet = nullptr;
+
+        busy.erase(i);
+        idle.emplace_back(req);
+
+        return true;
+    }
+
+    p = nullptr;
+    return false;
+}
+
+
+//--------------------------------------------------------------------------
+// batched (cross packet) implementation
+//--------------------------------------------------------------------------
+
+BatchRegexOffload::BatchRegexOffload(unsigned max, unsigned max_usec) :
+    RegexOffload(max), max_latency(max_usec) { }
+
+void BatchRegexOffload::put(Packet* p)
+{
+    assert(p);
+    assert(!idle.empty());
+    assert(p->context->searches.items.size() > 0);
+
+    RegexRequest* req = idle.front();
+    idle.pop_front();
+
+    busy.emplace_back(req);
+    p->context->regex_req_it = std::prev(busy.end());
+
+    req->packet = p;
+    req->offload = true;
+
+    if ( !pending++ )
+        oldest = std::chrono::steady_clock::now();
+
+    if ( idle.empty() )
+        search();
+}
+
+bool BatchRegexOffload::get(Packet*& p)
+{
+    assert(!busy.empty());
+
+    if ( pending and std::chrono::steady_clock::now() - oldest >= max_latency )
+    {
+        pc.mpse_batch_timeouts++;
+        search();
+    }
+
+    RegexRequest* req = busy.front();
+
+    if ( req->offload )
+    {
+        p = nullptr;
+        return false;
+    }
+
+    p = req->packet;
+    assert(p->context->regex_req_it == busy.begin());
+    req->packet = nullptr;
+
+    busy.pop_front();
+    idle.emplace_back(req);
+
+    return true;
+}
+
+void BatchRegexOffload::flush()
+{
+    if ( pending )
+        search();
+}
+
+void BatchSearcher::add(MpseBatch& batch)
+{
+    for ( auto& item : batch.items )
+    {
+        item.second.matches = 0;
+
+        for ( auto* so : item.second.so )
+        {
+            engines[so->get_normal_mpse()].push_back(
+                { &batch, item.first.buf, item.first.len, &item.second });
+        }
+    }
+}
+
+void BatchSearcher::search()
+{
+    for ( auto it = engines.begin(); it != engines.end(); )
+    {
+        // drop engines idle for a whole batch, such as those of a previous config
+        if ( it->second.empty() )
+        {
+            it = engines.erase(it);
+            continue;
+        }
+
+        for ( auto& bs : it->second )
+        {
+            int start_state = 0;
+
+            bs.item->matches += it->first->search(
+                bs.buf, bs.len, bs.batch->mf, bs.batch->context, &start_state);
+        }
+        it->second.clear();
+        ++it;
+    }
+}
+
+void BatchRegexOffload::search()
+{
+    Profile profile(mpsePerfStats);
+
+    for ( auto* req : busy )
+    {
+        if ( req->offload )
+            searcher.add(req->packet->context->searches);
+    }
+
+    searcher.search();
+
+    for ( auto* req : busy )
+    {
+        if ( !req->offload )
+            continue;
+
+        req->packet->context->searches.items.clear();
+        req->offload = false;
+    }
+
+    pc.mpse_batches++;
+    pc.mpse_batch_packets += pending;
+
+    if ( pending > pc.mpse_batch_max )
+        pc.mpse_batch_max = pending;
+
+    pending = 0;
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+namespace
+{
+// reports each occurrence of one byte with the buffer as the user
+class TestMpse : public Mpse
+{
+public:
+    TestMpse(uint8_t c) : Mpse("test"), c(c) { }
+
+    int add_pattern(const uint8_t*, unsigned, const PatternDescriptor&, void*) override
+    { return 0; }
+
+    int prep_patterns(SnortConfig*) override
+    { return 0; }
+
+protected:
+    int _search(const uint8_t* buf, int len, MpseMatch mf, void* context, int*) override
+    {
+        int n = 0;
+
+        for ( int i = 0; i < len; ++i )
         {
-            if (c->searches.can_fallback())
+            if ( buf[i] == c )
             {
-                c->searches.search_sync();
-                pc.offload_fallback++;
+                mf((void*)buf, nullptr, i, context, nullptr);
+                ++n;
             }
-            pc.offload_failures++;
         }
+        return n;
+    }
 
-        c->searches.items.clear();
-        req->offload = false;
+private:
+    uint8_t c;
+};
 
-#ifdef REG_TEST
+struct TestHit
+{
+    const void* buf;
+    int index;
+
+    bool operator<(const TestHit& rhs) const
+    { return buf != rhs.buf ? buf < rhs.buf : index < rhs.index; }
+
+    bool operator==(const TestHit& rhs) const
+    { return buf == rhs.buf and index == rhs.index; }
+};
+
+int test_match(void* user, void*, int index, void* context, void*)
+{
+    ((std::vector<TestHit>*)context)->push_back({ user, index });
+    return 0;
+}
+
+struct TestPacket
+{
+    MpseBatch batch;
+    std::vector<TestHit> hits;
+};
+}
+
+static void add_search(TestPacket& tp, const char* s, MpseGroup* g)
+{
+    MpseBatchKey<> key((const uint8_t*)s, strlen(s));
+    auto it = tp.batch.items.find(key);
+
+    if ( it == tp.batch.items.end() )
+        tp.batch.items.emplace(key, MpseBatchItem(g));
+    else
+        it->second.so.push_back(g);
+}
+
+static std::vector<std::vector<int>> item_matches(TestPacket* tps, unsigned n)
+{
+    std::vector<std::vector<int>> all;
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        std::vector<int> m;
+
+        for ( const auto& item : tps[i].batch.items )
+            m.emplace_back(item.second.matches);
+
+        all.emplace_back(m);
+    }
+    return all;
+}
+
+TEST_CASE("batched and unbatched searches match the same", "[BatchSearcher]")
+{
+    TestMpse mpse_a('a'), mpse_b('b');
+    MpseGroup grp_a(&mpse_a), grp_b(&mpse_b);
+
+    static const char* bufs[] = { "abba", "banana", "cabbage", "bb", "xyz" };
+    const unsigned num_packets = 3;
+    TestPacket tps[num_packets];
+
+    for ( unsigned i = 0; i < num_packets; ++i )
+    {
+        tps[i].batch.mf = test_match;
+        tps[i].batch.context = &tps[i].hits;
+
+        add_search(tps[i], bufs[i], &grp_a);
+        add_search(tps[i], bufs[i], &grp_b);
+        add_search(tps[i], bufs[i + 1], &grp_b);
+        add_search(tps[i], bufs[i + 2], &grp_a);
+    }
+
+    // one packet at a time as without batching
+    for ( auto& tp : tps )
+        tp.batch.search();
+
+    auto unbatched_matches = item_matches(tps, num_packets);
+    std::vector<TestHit> unbatched[num_packets];
+
+    for ( unsigned i = 0; i < num_packets; ++i )
+    {
+        unbatched[i].swap(tps[i].hits);
+        std::sort(unbatched[i].begin(), unbatched[i].end());
+        CHECK(!unbatched[i].empty());
+    }
+
+    BatchSearcher searcher;
+
+    // twice to cover the reused containers
+    for ( unsigned round = 0; round < 2; ++round )
+    {
+        for ( auto& tp : tps )
+            searcher.add(tp.batch);
+
+        searcher.search();
+
+        CHECK(item_matches(tps, num_packets) == unbatched_matches);
+
+        for ( unsigned i = 0; i < num_packets; ++i )
         {
-            std::unique_lock<std::mutex> lock(req->sync_mutex);
-            req->sync_cond.notify_one();
+            std::sort(tps[i].hits.begin(), tps[i].hits.end());
+            CHECK(tps[i].hits == unbatched[i]);
+            tps[i].hits.clear();
         }
-#endif
     }
-    ModuleManager::accumulate_module("search_engine");
-    ModuleManager::accumulate_module("detection");
 
-    // FIXIT-M break this over-coupling. In reality we shouldn't be evaluating latency in offload.
-    PacketLatency::tterm();
-    RuleLatency::tterm();
+    // the groups don't own the test engines
+    grp_a.normal_mpse = grp_b.normal_mpse = nullptr;
 }
 
+#endif
@@ -25,16 +25,29 @@
 // There are two flavors: MPSE and thread.  The MpseRegexOffload interfaces to
 // an MPSE that is capable of regex offload such as the RXP whereas
 // ThreadRegexOffload implements the regex search in auxiliary threads w/o
-// requiring extra MPSE instances.  presently all offload is per packet thread;
-// packet threads do not share offload resources.
+// requiring extra MPSE instances.  ThreadRegexOffload threads are per packet
+// thread; PooledRegexOffload instead submits to a pool of threads shared by
+// all packet threads which take work from other packet threads' queues when
+// their own are empty.
+//
+// BatchRegexOffload does no searching until it has accumulated a batch of
+// packets or the oldest has waited long enough.  Then each MPSE is run over
+// the buffers from all packets in turn to keep its tables in cache and
+// amortize the per call setup.
 
+#include <chrono>
 #include <condition_variable>
 #include <list>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace snort
 {
 class Flow;
+class Mpse;
+class MpseBatchItem;
+struct MpseBatch;
 struct Packet;
 struct SnortConfig;
 }
@@ -51,6 +64,9 @@ public:
     virtual void put(snort::Packet*) = 0;
     virtual bool get(snort::Packet*&) = 0;
 
+    // start any pending searches now; used when processing must wait
+    virtual void flush() { }
+
     unsigned available() const
     { return idle.size(); }
 
@@ -91,5 +107,55 @@ private:
     static void worker(RegexRequest*, const snort::SnortConfig*, unsigned id);
 };
 
+class PooledRegexOffload : public RegexOffload
+{
+public:
+    PooledRegexOffload(unsigned max, unsigned threads);
+    ~PooledRegexOffload() override;
+
+    void put(snort::Packet*) override;
+    bool get(snort::Packet*&) override;
+};
+
+// BatchSearcher collects the buffers of several MpseBatches per MPSE and then
+// runs each MPSE over its buffers back to back.  Engines have no multi-buffer
+// entry point so each buffer is still one Mpse::search() call.  The containers
+// keep their capacity from one batch to the next.
+class BatchSearcher
+{
+public:
+    void add(snort::MpseBatch&);
+    void search();
+
+private:
+    struct Search
+    {
+        snort::MpseBatch* batch;
+        const uint8_t* buf;
+        unsigned len;
+        snort::MpseBatchItem* item;
+    };
+    std::unordered_map<snort::Mpse*, std::vector<Search>> engines;
+};
+
+class BatchRegexOffload : public RegexOffload
+{
+public:
+    BatchRegexOffload(unsigned max, unsigned max_usec);
+
+    void put(snort::Packet*) override;
+    bool get(snort::Packet*&) override;
+    void flush() override;
+
+private:
+    void search();
+
+private:
+    std::chrono::microseconds max_latency;
+    std::chrono::steady_clock::time_point oldest;
+    BatchSearcher searcher;
+    unsigned pending = 0;
+};
+
 #endif
 
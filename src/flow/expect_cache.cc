@@ -98,6 +98,8 @@ FlowData* ExpectFlow::get_flow_data(unsigned id)
 
 struct ExpectNode
 {
+    const FlowKey* key = nullptr;
+    TimerWheel::Timer timer;
     time_t expires = 0;
     bool reversed_key = false;
     int direction = 0;
@@ -134,10 +136,35 @@ void ExpectCache::prune_lru()
     ExpectNode* node = static_cast<ExpectNode*>( hash_table->lru_first() );
     assert(node);
     node->clear(free_list);
-    hash_table->release();
+    release(node);
     ++prunes;
 }
 
+void ExpectCache::release(ExpectNode* node)
+{
+    if ( node->timer.is_scheduled() )
+        TimerWheel::get_thread_wheel()->cancel(&node->timer);
+
+    hash_table->release_node(node->key);
+}
+
+// expires is pushed out as expects are added so it is rechecked here
+bool ExpectCache::expire(TimerWheel::Timer* t, uint64_t now)
+{
+    ExpectNode* node = static_cast<ExpectNode*>(t->user);
+
+    if ( (uint64_t)node->expires >= now )
+    {
+        TimerWheel::get_thread_wheel()->schedule(t, node->expires + 1);
+        return false;
+    }
+
+    node->clear(free_list);
+    release(node);
+    ++timeouts;
+    return true;
+}
+
 ExpectNode* ExpectCache::find_node_by_packet(Packet* p, FlowKey &key)
 {
     if (!hash_table->get_num_nodes())
@@ -198,7 +225,7 @@ ExpectNode* ExpectCache::find_node_by_packet(Packet* p, FlowKey &key)
     {
         if (node->head)
             node->clear(free_list);
-        hash_table->release_node(&key);
+        release(node);
         return nullptr;
     }
     /* Make sure the packet direction is correct */
@@ -217,7 +244,7 @@ ExpectNode* ExpectCache::find_node_by_packet(Packet* p, FlowKey &key)
     return node;
 }
 
-bool ExpectCache::process_expected(ExpectNode* node, FlowKey& key, Packet* p, Flow* lws)
+bool ExpectCache::process_expected(ExpectNode* node, Packet* p, Flow* lws)
 {
     ExpectFlow* head;
     FlowData* fd;
@@ -253,7 +280,7 @@ bool ExpectCache::process_expected(ExpectNode* node, FlowKey& key, Packet* p, Fl
     }
 
     if (!node->count)
-        hash_table->release_node(&key);
+        release(node);
 
     return ignoring;
 }
@@ -267,8 +294,14 @@ ExpectCache::ExpectCache(uint32_t max)
     // -size forces use of abs(size) ie w/o bumping up
     hash_table = new ZHash(-MAX_HASH, sizeof(FlowKey));
     nodes = new ExpectNode[max];
+    num_nodes = max;
+
     for (unsigned i = 0; i < max; ++i)
-        hash_table->push(nodes + i);
+    {
+        nodes[i].key = (FlowKey*)hash_table->push(nodes + i);
+        nodes[i].timer.handler = this;
+        nodes[i].timer.user = nodes + i;
+    }
 
     /* Preallocate a pool of ExpectFlows big enough to handle the worst case
         requirement (max number of nodes * max flows per node) and add them all
@@ -290,6 +323,11 @@ ExpectCache::ExpectCache(uint32_t max)
 
 ExpectCache::~ExpectCache()
 {
+    for (unsigned i = 0; i < num_nodes; ++i)
+    {
+        if ( nodes[i].timer.is_scheduled() )
+            TimerWheel::get_thread_wheel()->cancel(&nodes[i].timer);
+    }
     delete hash_table;
     delete[] nodes;
     delete[] pool;
@@ -429,6 +467,9 @@ int ExpectCache::add_flow(const Packet *ctrlPkt, PktType type, IpProtocol ip_pro
     }
     last->add_flow_data(fd);
     node->expires = packet_time() + MAX_WAIT;
+
+    if ( !node->timer.is_scheduled() )
+        TimerWheel::get_thread_wheel()->schedule(&node->timer, node->expires + 1);
     ++expects;
     if ( new_expect_flow )
     {
@@ -455,6 +496,6 @@ bool ExpectCache::check(Packet* p, Flow* lws)
     if (!node)
         return false;
 
-    return process_expected(node, key, p, lws);
+    return process_expected(node, p, lws);
 }
 
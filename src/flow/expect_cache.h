@@ -63,6 +63,7 @@
 #include <vector>
 #include "flow/flow_key.h"
 #include "target_based/snort_protocols.h"
+#include "time/timer_wheel.h"
 
 struct ExpectNode;
 
@@ -86,11 +87,11 @@ struct SO_PUBLIC ExpectFlow
 };
 }
 
-class ExpectCache
+class ExpectCache : public TimerWheel::Handler
 {
 public:
     ExpectCache(uint32_t max);
-    ~ExpectCache();
+    ~ExpectCache() override;
 
     ExpectCache(const ExpectCache&) = delete;
     ExpectCache& operator=(const ExpectCache&) = delete;
@@ -107,26 +108,31 @@ public:
     unsigned long get_realized() { return realized; }
     unsigned long get_prunes() { return prunes; }
     unsigned long get_overflows() { return overflows; }
+    unsigned long get_timeouts() { return timeouts; }
     void reset_stats() 
     {
         expects = 0;
         realized = 0;
         prunes = 0;
         overflows = 0;
+        timeouts = 0;
     }
 
 private:
     void prune_lru();
+    void release(ExpectNode*);
+    bool expire(TimerWheel::Timer*, uint64_t now) override;
 
     ExpectNode* get_node(snort::FlowKey&, bool&);
     snort::ExpectFlow* get_flow(ExpectNode*, uint32_t, int16_t);
     bool set_data(ExpectNode*, snort::ExpectFlow*&, snort::FlowData*);
     ExpectNode* find_node_by_packet(snort::Packet*, snort::FlowKey&);
-    bool process_expected(ExpectNode*, snort::FlowKey&, snort::Packet*, snort::Flow*);
+    bool process_expected(ExpectNode*, snort::Packet*, snort::Flow*);
 
 private:
     class ZHash* hash_table;
     ExpectNode* nodes;
+    uint32_t num_nodes;
     snort::ExpectFlow* pool;
     snort::ExpectFlow* free_list;
 
@@ -134,6 +140,7 @@ private:
     unsigned long realized = 0;
     unsigned long prunes = 0;
     unsigned long overflows = 0;
+    unsigned long timeouts = 0;
 };
 
 #endif
@@ -43,6 +43,7 @@
 #include "protocols/layer.h"
 #include "sfip/sf_ip.h"
 #include "target_based/snort_protocols.h"
+#include "time/timer_wheel.h"
 
 #define SSNFLAG_SEEN_CLIENT         0x00000001
 #define SSNFLAG_SEEN_SENDER         0x00000001
@@ -407,6 +408,7 @@ public:  // FIXIT-M privatize if possible
 
     DeferredTrust deferred_trust;
     std::shared_ptr<std::string> service;
+    TimerWheel::Timer timer;  // idle timeout when the flow cache has a wheel
 
     // Anything before this comment is not zeroed during construction
     const FlowKey* key;
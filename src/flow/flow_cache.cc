@@ -26,7 +26,6 @@
 
 #include "detection/detection_engine.h"
 #include "hash/hash_defs.h"
-#include "hash/zhash.h"
 #include "helpers/flag_context.h"
 #include "ips_options/ips_flowbits.h"
 #include "main/snort_debug.h"
@@ -39,6 +38,7 @@
 
 #include "flow.h"
 #include "flow_key.h"
+#include "flow_table.h"
 #include "flow_uni_list.h"
 #include "ha.h"
 #include "session.h"
@@ -60,7 +60,7 @@ extern THREAD_LOCAL const snort::Trace* stream_trace;
 
 FlowCache::FlowCache(const FlowCacheConfig& cfg) : config(cfg)
 {
-    hash_table = new ZHash(config.max_flows, sizeof(FlowKey));
+    hash_table = FlowTable::create(config.table_type, config.max_flows);
     uni_flows = new FlowUniList;
     uni_ip_flows = new FlowUniList;
     flags = 0x0;
@@ -105,11 +105,29 @@ Flow* FlowCache::find(const FlowKey* key)
 
         if ( flow->last_data_seen < t )
             flow->last_data_seen = t;
+
+        // idle deadlines are checked lazily on expiry but a hard expiration
+        // may have been set earlier than the scheduled deadline
+        if ( flow->is_hard_expiration() and flow->expire_time < flow->timer.deadline )
+            TimerWheel::get_thread_wheel()->schedule(&flow->timer, flow->expire_time);
     }
 
     return flow;
 }
 
+unsigned FlowCache::prefetch(const FlowKey* key)
+{
+    unsigned hash = hash_table->get_hash(key);
+    hash_table->prefetch_bucket(hash);
+    return hash;
+}
+
+void FlowCache::prefetch_node(unsigned hash)
+{ hash_table->prefetch_node(hash); }
+
+Flow* FlowCache::peek(const FlowKey* key, unsigned hash)
+{ return (Flow*)hash_table->peek(key, hash); }
+
 // always prepend
 void FlowCache::link_uni(Flow* flow)
 {
@@ -184,13 +202,33 @@ Flow* FlowCache::allocate(const FlowKey* key)
 
     flow->last_data_seen = timestamp;
 
+    schedule(flow);
+
     return flow;
 }
 
+void FlowCache::schedule(Flow* flow)
+{
+    uint64_t deadline;
+
+    if ( flow->is_hard_expiration() )
+        deadline = flow->expire_time;
+    else
+        deadline = flow->last_data_seen +
+            config.proto[to_utype(flow->key->pkt_type)].nominal_timeout;
+
+    flow->timer.handler = this;
+    flow->timer.user = flow;
+    TimerWheel::get_thread_wheel()->schedule(&flow->timer, deadline);
+}
+
 void FlowCache::remove(Flow* flow)
 {
     unlink_uni(flow);
 
+    if ( flow->timer.is_scheduled() )
+        TimerWheel::get_thread_wheel()->cancel(&flow->timer);
+
     hash_table->release_node(flow->key);
 }
 
@@ -383,49 +421,42 @@ bool FlowCache::prune_one(PruneReason reason, bool do_cleanup)
     return true;
 }
 
-unsigned FlowCache::timeout(unsigned num_flows, time_t thetime)
+// idle deadlines are rechecked on expiry since last_data_seen moves per
+// packet; flows that saw traffic are just rescheduled
+bool FlowCache::expire(TimerWheel::Timer* t, uint64_t now)
 {
-    ActiveSuspendContext act_susp(Active::ASP_TIMEOUT);
-
-    unsigned retired = 0;
+    Flow* flow = (Flow*)t->user;
+    schedule(flow);
 
-    {
-        PacketTracerSuspend pt_susp;
-
-        auto flow = static_cast<Flow*>(hash_table->lru_current());
-
-        if ( !flow )
-            flow = static_cast<Flow*>(hash_table->lru_first());
+    if ( flow->timer.deadline > now )
+        return false;
 
-        while ( flow and (retired < num_flows) )
-        {
-            if ( flow->is_hard_expiration() )
-            {
-                if ( flow->expire_time > (uint64_t) thetime )
-                    break;
-            }
-            else if ( flow->last_data_seen + config.proto[to_utype(flow->key->pkt_type)].nominal_timeout > thetime )
-                break;
+    TimerWheel* wheel = TimerWheel::get_thread_wheel();
 
-            if ( HighAvailabilityManager::in_standby(flow) or
-                    flow->is_suspended() )
-            {
-                flow = static_cast<Flow*>(hash_table->lru_next());
-                continue;
-            }
+    if ( HighAvailabilityManager::in_standby(flow) or flow->is_suspended() )
+    {
+        wheel->schedule(&flow->timer, now + 1);
+        return false;
+    }
 
-            flow->ssn_state.session_flags |= SSNFLAG_TIMEDOUT;
-            if ( release(flow, PruneReason::IDLE) )
-                ++retired;
+    ActiveSuspendContext act_susp(Active::ASP_TIMEOUT);
+    bool retired;
 
-            flow = static_cast<Flow*>(hash_table->lru_current());
-        }
+    {
+        PacketTracerSuspend pt_susp;
+        flow->ssn_state.session_flags |= SSNFLAG_TIMEDOUT;
+        retired = release(flow, PruneReason::IDLE);
     }
 
-    if ( PacketTracer::is_active() and retired )
-        PacketTracer::log("Flow: Timed out %u flows\n", retired);
+    // kept flows are checked again next time
+    if ( !retired )
+        wheel->schedule(&flow->timer, now + 1);
 
-    return retired;
+    else if ( PacketTracer::is_active() )
+        PacketTracer::log("Flow: Timed out idle flow\n");
+
+    // the release was attempted either way
+    return true;
 }
 
 unsigned FlowCache::delete_active_flows(unsigned mode, unsigned num_to_delete, unsigned &deleted)
@@ -445,6 +476,9 @@ unsigned FlowCache::delete_active_flows(unsigned mode, unsigned num_to_delete, u
         // we have a winner...
         unlink_uni(flow);
 
+        if ( flow->timer.is_scheduled() )
+            TimerWheel::get_thread_wheel()->cancel(&flow->timer);
+
         if ( flow->was_blocked() )
             delete_stats.update(FlowDeleteState::BLOCKED);
         else if ( flow->is_suspended() )
@@ -23,13 +23,14 @@
 #define FLOW_CACHE_H
 
 // there is a FlowCache instance for each protocol.
-// Flows are stored in a ZHash instance by FlowKey.
+// Flows are stored in a FlowTable instance by FlowKey.
 
 #include <ctime>
 #include <type_traits>
 
 #include "framework/counts.h"
 #include "main/thread.h"
+#include "time/timer_wheel.h"
 
 #include "flow_config.h"
 #include "prune_stats.h"
@@ -40,18 +41,24 @@ class Flow;
 struct FlowKey;
 }
 
+class FlowTable;
 class FlowUniList;
 
-class FlowCache
+class FlowCache : public TimerWheel::Handler
 {
 public:
     FlowCache(const FlowCacheConfig&);
-    ~FlowCache();
+    ~FlowCache() override;
 
     FlowCache(const FlowCache&) = delete;
     FlowCache& operator=(const FlowCache&) = delete;
 
     snort::Flow* find(const snort::FlowKey*);
+
+    // batch lookup support; see FlowTable
+    unsigned prefetch(const snort::FlowKey*);
+    void prefetch_node(unsigned hash);
+    snort::Flow* peek(const snort::FlowKey*, unsigned hash);
     snort::Flow* allocate(const snort::FlowKey*);
 
     bool release(snort::Flow*, PruneReason = PruneReason::NONE, bool do_cleanup = true);
@@ -59,7 +66,6 @@ public:
     unsigned prune_stale(uint32_t thetime, const snort::Flow* save_me);
     unsigned prune_excess(const snort::Flow* save_me);
     bool prune_one(PruneReason, bool do_cleanup);
-    unsigned timeout(unsigned num_flows, time_t cur_time);
     unsigned delete_flows(unsigned num_to_delete);
 
     unsigned purge();
@@ -106,6 +112,8 @@ private:
     void link_uni(snort::Flow*);
     void remove(snort::Flow*);
     void retire(snort::Flow*);
+    void schedule(snort::Flow*);
+    bool expire(TimerWheel::Timer*, uint64_t now) override;
     unsigned prune_unis(PktType);
     unsigned delete_active_flows
         (unsigned mode, unsigned num_to_delete, unsigned &deleted);
@@ -116,7 +124,7 @@ private:
     FlowCacheConfig config;
     uint32_t flags;
 
-    class ZHash* hash_table;
+    FlowTable* hash_table;
     unsigned flows_allocated = 0;
     FlowUniList* uni_flows;
     FlowUniList* uni_ip_flows;
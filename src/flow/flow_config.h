@@ -23,6 +23,8 @@
 
 #include "framework/decode_data.h"
 
+#include "flow_table.h"
+
 // configured by the stream module
 struct FlowTypeConfig
 {
@@ -34,6 +36,7 @@ struct FlowCacheConfig
 {
     unsigned max_flows = 0;
     unsigned pruning_timeout = 0;
+    FlowTableType table_type = FlowTableType::ZHASH;
     FlowTypeConfig proto[to_utype(PktType::MAX)];
 };
 
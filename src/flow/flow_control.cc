@@ -95,6 +95,15 @@ unsigned FlowControl::get_flows_allocated() const
 Flow* FlowControl::find_flow(const FlowKey* key)
 { return cache->find(key); }
 
+unsigned FlowControl::prefetch_flow(const FlowKey* key)
+{ return cache->prefetch(key); }
+
+void FlowControl::prefetch_flow_node(unsigned hash)
+{ cache->prefetch_node(hash); }
+
+Flow* FlowControl::peek_flow(const FlowKey* key, unsigned hash)
+{ return cache->peek(key, hash); }
+
 Flow* FlowControl::new_flow(const FlowKey* key)
 { return cache->allocate(key); }
 
@@ -117,11 +126,6 @@ unsigned FlowControl::delete_flows(unsigned num_to_delete)
 bool FlowControl::prune_one(PruneReason reason, bool do_cleanup)
 { return cache->prune_one(reason, do_cleanup); }
 
-void FlowControl::timeout_flows(unsigned max, time_t cur_time)
-{
-    cache->timeout(max, cur_time);
-}
-
 Flow* FlowControl::stale_flow_cleanup(FlowCache* cache, Flow* flow, Packet* p)
 {
     if ( p->pkth->flags & DAQ_PKT_FLAG_NEW_FLOW )
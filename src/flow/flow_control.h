@@ -60,6 +60,9 @@ public:
 
     bool process(PktType, snort::Packet*, bool* new_flow = nullptr);
     snort::Flow* find_flow(const snort::FlowKey*);
+    unsigned prefetch_flow(const snort::FlowKey*);
+    void prefetch_flow_node(unsigned hash);
+    snort::Flow* peek_flow(const snort::FlowKey*, unsigned hash);
     snort::Flow* new_flow(const snort::FlowKey*);
     void release_flow(const snort::FlowKey*);
     void release_flow(snort::Flow*, PruneReason);
@@ -67,7 +70,6 @@ public:
     unsigned delete_flows(unsigned num_to_delete);
     bool prune_one(PruneReason, bool do_cleanup);
     snort::Flow* stale_flow_cleanup(FlowCache*, snort::Flow*, snort::Packet*);
-    void timeout_flows(unsigned int, time_t cur_time);
     void check_expected_flow(snort::Flow*, snort::Packet*);
     bool is_expected(snort::Packet*);
 
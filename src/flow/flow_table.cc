@@ -0,0 +1,615 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// flow_table.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "flow_table.h"
+
+#include <cassert>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "hash/zhash.h"
+
+#include "flow_key.h"
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// zhash
+//-------------------------------------------------------------------------
+
+class ZHashFlowTable : public FlowTable
+{
+public:
+    ZHashFlowTable(unsigned rows) : hash(rows, sizeof(FlowKey)) { }
+
+    void* push(void* p) override
+    { return hash.push(p); }
+
+    void* pop() override
+    { return hash.pop(); }
+
+    void* get(const FlowKey* key) override
+    { return hash.get(key); }
+
+    void* get_user_data(const FlowKey* key) override
+    { return hash.get_user_data(key); }
+
+    unsigned get_hash(const FlowKey* key) override
+    { return hash.get_hash(key); }
+
+    void prefetch_bucket(unsigned h) override
+    { hash.prefetch_row(h); }
+
+    void prefetch_node(unsigned h) override
+    { hash.prefetch_node(h); }
+
+    void* peek(const FlowKey* key, unsigned h) override
+    { return hash.peek_user_data(key, h); }
+
+    void release_node(const FlowKey* key) override
+    { hash.release_node(key); }
+
+    void* remove() override
+    { return hash.remove(); }
+
+    void* lru_first() override
+    { return hash.lru_first(); }
+
+    void* lru_next() override
+    { return hash.lru_next(); }
+
+    void* lru_current() override
+    { return hash.lru_current(); }
+
+    void lru_touch() override
+    { hash.lru_touch(); }
+
+    unsigned get_num_nodes() override
+    { return hash.get_num_nodes(); }
+
+private:
+    ZHash hash;
+};
+
+//-------------------------------------------------------------------------
+// swiss
+//
+// control bytes are grouped by 16 and hold either a 7 bit tag from the
+// hash of the key in the corresponding slot or one of the special values
+// below, both of which have the high bit set.  lookups probe a group at a
+// time, comparing all 16 tags in parallel, and stop at the first group
+// with an empty slot.  a group that has never been full can't have been
+// probed past so erased slots in such a group are marked empty instead of
+// deleted.
+//
+// the table is sized from max_flows at init so live nodes never fill more
+// than half of it and it never grows.  deleted slots are cleared by moving
+// the nodes to a spare table of the same size, also allocated at init, a
+// few groups per insert; lookups check both tables until the nodes are
+// moved and the old table is then cleared the same way to be the spare.
+//-------------------------------------------------------------------------
+
+#define CTRL_EMPTY   0x80
+#define CTRL_DELETED 0xfe
+#define GROUP_SIZE   16
+
+// groups moved to the spare table per insert while clearing deleted slots
+#define MIGRATE_GROUPS 4
+
+#ifdef __SSE2__
+static inline unsigned match_tag(const uint8_t* g, uint8_t tag)
+{
+    __m128i c = _mm_loadu_si128((const __m128i*)g);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8((char)tag)));
+}
+
+static inline unsigned match_free(const uint8_t* g)
+{ return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)g)); }
+
+#else
+static inline unsigned match_tag(const uint8_t* g, uint8_t tag)
+{
+    unsigned m = 0;
+
+    for ( unsigned i = 0; i < GROUP_SIZE; ++i )
+        m |= (unsigned)(g[i] == tag) << i;
+
+    return m;
+}
+
+static inline unsigned match_free(const uint8_t* g)
+{
+    unsigned m = 0;
+
+    for ( unsigned i = 0; i < GROUP_SIZE; ++i )
+        m |= (unsigned)(g[i] >> 7) << i;
+
+    return m;
+}
+#endif
+
+static inline unsigned match_empty(const uint8_t* g)
+{ return match_tag(g, CTRL_EMPTY); }
+
+class SwissFlowTable : public FlowTable
+{
+public:
+    SwissFlowTable(unsigned max_flows);
+    ~SwissFlowTable() override;
+
+    void* push(void*) override;
+    void* pop() override;
+
+    void* get(const FlowKey*) override;
+    void* get_user_data(const FlowKey*) override;
+
+    unsigned get_hash(const FlowKey* key) override
+    { return hash_ops.do_hash((const unsigned char*)key, sizeof(*key)); }
+
+    void prefetch_bucket(unsigned hash) override;
+    void prefetch_node(unsigned hash) override;
+    void* peek(const FlowKey*, unsigned hash) override;
+
+    void release_node(const FlowKey*) override;
+    void* remove() override;
+
+    void* lru_first() override;
+    void* lru_next() override;
+    void* lru_current() override;
+    void lru_touch() override;
+
+    unsigned get_num_nodes() override
+    { return num_nodes; }
+
+private:
+    struct Node
+    {
+        FlowKey key;
+        void* data;
+        Node* prev;  // toward mru
+        Node* next;  // toward lru; also links the free list
+        unsigned hash;
+        unsigned slot;
+    };
+
+    static Node* get_node(const FlowKey* key)
+    { return (Node*)((const char*)key - offsetof(Node, key)); }
+
+    struct Group;
+
+    Node* find(const FlowKey*, unsigned hash);
+    Node* find(const Group*, const FlowKey*, unsigned hash);
+    void insert(Node*, unsigned hash);
+    void erase(Node*);
+
+    void start_migration();
+    void migrate(unsigned max_groups);
+
+    void lru_insert(Node*);
+    void lru_remove(Node*);
+    void lru_touch(Node*);
+
+private:
+    FlowHashKeyOps hash_ops;
+
+    // the control bytes and node pointers of a group are kept together so
+    // a hit usually costs one miss for the group and one for the node
+    struct Group
+    {
+        uint8_t ctrl[GROUP_SIZE];
+        Node* slots[GROUP_SIZE];
+    };
+
+    Group* groups = nullptr;
+    Group* spare = nullptr;       // the next groups when not migrating
+    Group* old_groups = nullptr;  // the previous groups while migrating
+    unsigned migrate_next = 0;
+
+    unsigned num_groups = 0;
+    unsigned num_nodes = 0;
+    unsigned num_deleted = 0;     // in groups only
+
+    Node* free_list = nullptr;
+    Node* head = nullptr;
+    Node* tail = nullptr;
+    Node* cursor = nullptr;
+};
+
+SwissFlowTable::SwissFlowTable(unsigned max_flows) : hash_ops(max_flows)
+{
+    // keep the load factor of live nodes at or below 1/2 so there is room
+    // for deleted slots between migrations
+    num_groups = 1;
+
+    while ( num_groups * GROUP_SIZE / 2 < max_flows )
+        num_groups <<= 1;
+
+    groups = new Group[num_groups];
+    spare = new Group[num_groups];
+
+    for ( unsigned g = 0; g < num_groups; ++g )
+    {
+        memset(groups[g].ctrl, CTRL_EMPTY, sizeof(groups[g].ctrl));
+        memset(spare[g].ctrl, CTRL_EMPTY, sizeof(spare[g].ctrl));
+    }
+}
+
+SwissFlowTable::~SwissFlowTable()
+{
+    for ( Group* tab : { groups, old_groups } )
+    {
+        if ( !tab )
+            continue;
+
+        for ( unsigned g = 0; g < num_groups; ++g )
+        {
+            for ( unsigned i = 0; i < GROUP_SIZE; ++i )
+            {
+                if ( !(tab[g].ctrl[i] & CTRL_EMPTY) )
+                    delete tab[g].slots[i];
+            }
+        }
+    }
+
+    while ( Node* n = free_list )
+    {
+        free_list = n->next;
+        delete n;
+    }
+
+    delete[] groups;
+    delete[] spare;
+    delete[] old_groups;
+}
+
+void SwissFlowTable::start_migration()
+{
+    assert(!old_groups);
+
+    old_groups = groups;
+    groups = spare;
+    spare = nullptr;
+
+    migrate_next = 0;
+    num_deleted = 0;
+}
+
+// the nodes are moved out of the old groups and then the old groups are
+// cleared so they are ready to be the spare
+void SwissFlowTable::migrate(unsigned max_groups)
+{
+    assert(old_groups);
+
+    for ( unsigned n = 0; n < max_groups and migrate_next < 2 * num_groups; ++n )
+    {
+        if ( migrate_next >= num_groups )
+        {
+            Group& grp = old_groups[migrate_next++ - num_groups];
+            memset(grp.ctrl, CTRL_EMPTY, sizeof(grp.ctrl));
+            continue;
+        }
+
+        Group& grp = old_groups[migrate_next++];
+
+        for ( unsigned i = 0; i < GROUP_SIZE; ++i )
+        {
+            if ( !(grp.ctrl[i] & CTRL_EMPTY) )
+                insert(grp.slots[i], grp.slots[i]->hash);
+        }
+        // probes for nodes not yet moved must still continue past a group
+        // that was full so lookups in the old groups are no longer than
+        // they were before
+        memset(grp.ctrl, match_empty(grp.ctrl) ? CTRL_EMPTY : CTRL_DELETED, sizeof(grp.ctrl));
+    }
+
+    if ( migrate_next == 2 * num_groups )
+    {
+        spare = old_groups;
+        old_groups = nullptr;
+    }
+}
+
+SwissFlowTable::Node* SwissFlowTable::find(const FlowKey* key, unsigned hash)
+{
+    if ( Node* n = find(groups, key, hash) )
+        return n;
+
+    if ( old_groups and migrate_next < num_groups )
+        return find(old_groups, key, hash);
+
+    return nullptr;
+}
+
+SwissFlowTable::Node* SwissFlowTable::find(const Group* tab, const FlowKey* key, unsigned hash)
+{
+    uint8_t tag = hash & 0x7f;
+    unsigned mask = num_groups - 1;
+    unsigned g = (hash >> 7) & mask;
+
+    for ( unsigned i = 1; ; ++i )
+    {
+        const Group& grp = tab[g];
+
+        for ( unsigned m = match_tag(grp.ctrl, tag); m; m &= m - 1 )
+        {
+            Node* n = grp.slots[__builtin_ctz(m)];
+
+            if ( FlowKey::is_equal(&n->key, key, sizeof(*key)) )
+                return n;
+        }
+
+        if ( match_empty(grp.ctrl) or i > num_groups )
+            return nullptr;
+
+        // triangular probing visits every group when the count is a power of 2
+        g = (g + i) & mask;
+    }
+}
+
+void SwissFlowTable::insert(Node* n, unsigned hash)
+{
+    unsigned mask = num_groups - 1;
+    unsigned g = (hash >> 7) & mask;
+
+    for ( unsigned i = 1; ; ++i )
+    {
+        Group& grp = groups[g];
+        unsigned m = match_free(grp.ctrl);
+
+        if ( m )
+        {
+            unsigned slot = __builtin_ctz(m);
+
+            if ( grp.ctrl[slot] == CTRL_DELETED )
+                --num_deleted;
+
+            grp.ctrl[slot] = hash & 0x7f;
+            grp.slots[slot] = n;
+            n->hash = hash;
+            n->slot = g * GROUP_SIZE + slot;
+            return;
+        }
+        g = (g + i) & mask;
+    }
+}
+
+void SwissFlowTable::erase(Node* n)
+{
+    unsigned i = n->slot % GROUP_SIZE;
+    Group* grp = &groups[n->slot / GROUP_SIZE];
+
+    // a node not yet migrated is still in the old groups
+    if ( (grp->ctrl[i] & CTRL_EMPTY) or grp->slots[i] != n )
+    {
+        assert(old_groups);
+        grp = &old_groups[n->slot / GROUP_SIZE];
+        grp->ctrl[i] = match_empty(grp->ctrl) ? CTRL_EMPTY : CTRL_DELETED;
+        return;
+    }
+
+    if ( match_empty(grp->ctrl) )
+        grp->ctrl[i] = CTRL_EMPTY;
+    else
+    {
+        grp->ctrl[i] = CTRL_DELETED;
+        ++num_deleted;
+    }
+}
+
+void SwissFlowTable::lru_insert(Node* n)
+{
+    n->prev = nullptr;
+    n->next = head;
+
+    if ( head )
+        head->prev = n;
+    else
+        tail = n;
+
+    head = n;
+}
+
+void SwissFlowTable::lru_remove(Node* n)
+{
+    if ( cursor == n )
+        cursor = n->prev;
+
+    if ( n->prev )
+        n->prev->next = n->next;
+    else
+        head = n->next;
+
+    if ( n->next )
+        n->next->prev = n->prev;
+    else
+        tail = n->prev;
+}
+
+void SwissFlowTable::lru_touch(Node* n)
+{
+    if ( cursor == n )
+        cursor = n->prev;
+
+    if ( n != head )
+    {
+        lru_remove(n);
+        lru_insert(n);
+    }
+}
+
+void* SwissFlowTable::push(void* p)
+{
+    Node* n = new Node;
+    n->data = p;
+    n->next = free_list;
+    free_list = n;
+    return &n->key;
+}
+
+void* SwissFlowTable::pop()
+{
+    Node* n = free_list;
+
+    if ( !n )
+        return nullptr;
+
+    free_list = n->next;
+    void* p = n->data;
+    delete n;
+    return p;
+}
+
+void* SwissFlowTable::get(const FlowKey* key)
+{
+    unsigned hash = hash_ops.do_hash((const unsigned char*)key, sizeof(*key));
+
+    if ( Node* n = find(key, hash) )
+    {
+        lru_touch(n);
+        return n->data;
+    }
+
+    Node* n = free_list;
+
+    if ( !n )
+        return nullptr;
+
+    // live nodes fit in half the table so only deleted slots can fill it;
+    // those are cleared a few groups per insert instead of all at once
+    if ( old_groups )
+        migrate(MIGRATE_GROUPS);
+
+    else if ( (num_nodes + num_deleted + 1) * 8 > num_groups * GROUP_SIZE * 7 )
+        start_migration();
+
+    free_list = n->next;
+    memcpy(&n->key, key, sizeof(n->key));
+
+    insert(n, hash);
+    lru_insert(n);
+    ++num_nodes;
+
+    return n->data;
+}
+
+void* SwissFlowTable::get_user_data(const FlowKey* key)
+{
+    Node* n = find(key, hash_ops.do_hash((const unsigned char*)key, sizeof(*key)));
+
+    if ( !n )
+        return nullptr;
+
+    lru_touch(n);
+    return n->data;
+}
+
+void SwissFlowTable::prefetch_bucket(unsigned hash)
+{
+    const char* g = (const char*)&groups[(hash >> 7) & (num_groups - 1)];
+
+    for ( unsigned i = 0; i < sizeof(Group); i += 64 )
+        __builtin_prefetch(g + i);
+}
+
+void SwissFlowTable::prefetch_node(unsigned hash)
+{
+    // just the first group; anything else is probed on lookup
+    const Group& grp = groups[(hash >> 7) & (num_groups - 1)];
+
+    for ( unsigned m = match_tag(grp.ctrl, hash & 0x7f); m; m &= m - 1 )
+        __builtin_prefetch(grp.slots[__builtin_ctz(m)]);
+}
+
+void* SwissFlowTable::peek(const FlowKey* key, unsigned hash)
+{
+    Node* n = find(key, hash);
+    return n ? n->data : nullptr;
+}
+
+void SwissFlowTable::release_node(const FlowKey* key)
+{
+    Node* n = find(key, hash_ops.do_hash((const unsigned char*)key, sizeof(*key)));
+
+    if ( !n )
+        return;
+
+    erase(n);
+    lru_remove(n);
+    --num_nodes;
+
+    n->next = free_list;
+    free_list = n;
+}
+
+void* SwissFlowTable::remove()
+{
+    Node* n = cursor;
+    assert(n);
+
+    erase(n);
+    lru_remove(n);
+    --num_nodes;
+
+    void* p = n->data;
+    delete n;
+    return p;
+}
+
+void* SwissFlowTable::lru_first()
+{
+    cursor = tail;
+    return cursor ? cursor->data : nullptr;
+}
+
+void* SwissFlowTable::lru_next()
+{
+    if ( cursor )
+        cursor = cursor->prev;
+
+    return cursor ? cursor->data : nullptr;
+}
+
+void* SwissFlowTable::lru_current()
+{ return cursor ? cursor->data : nullptr; }
+
+void SwissFlowTable::lru_touch()
+{
+    assert(cursor);
+    lru_touch(cursor);
+}
+
+//-------------------------------------------------------------------------
+// factory
+//-------------------------------------------------------------------------
+
+FlowTable* FlowTable::create(FlowTableType type, unsigned max_flows)
+{
+    if ( type == FlowTableType::SWISS )
+        return new SwissFlowTable(max_flows);
+
+    return new ZHashFlowTable(max_flows);
+}
+
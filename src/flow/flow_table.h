@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// flow_table.h
+
+#ifndef FLOW_TABLE_H
+#define FLOW_TABLE_H
+
+// FlowTable indexes the flows in a FlowCache by FlowKey.  Flows are
+// preallocated onto a free list with push() and taken from it by get() so
+// the table owns the key storage for each flow.  Active flows are also
+// kept in LRU order for pruning.
+//
+// ZHash is the original implementation.  The swiss table is an open
+// addressing alternative that probes 16 slots at once using a 7 bit tag
+// per slot so most lookups touch a single cache line of metadata and one
+// node.
+
+namespace snort
+{
+struct FlowKey;
+}
+
+enum class FlowTableType { ZHASH, SWISS };
+
+class FlowTable
+{
+public:
+    static FlowTable* create(FlowTableType, unsigned max_flows);
+    virtual ~FlowTable() = default;
+
+    // add user data to the free list and return its key storage
+    virtual void* push(void*) = 0;
+
+    // remove from the free list; returns nullptr if empty
+    virtual void* pop() = 0;
+
+    // find or insert using a free node; nullptr if none are free
+    virtual void* get(const snort::FlowKey*) = 0;
+
+    // find only; both find and get make the node most recently used
+    virtual void* get_user_data(const snort::FlowKey*) = 0;
+
+    // batch lookups hash each key and prefetch its bucket, then prefetch
+    // the nodes once the buckets are cached, then peek at the user data
+    // so it can be prefetched too.  peek does not change the lru order.
+    virtual unsigned get_hash(const snort::FlowKey*) = 0;
+    virtual void prefetch_bucket(unsigned hash) = 0;
+    virtual void prefetch_node(unsigned hash) = 0;
+    virtual void* peek(const snort::FlowKey*, unsigned hash) = 0;
+
+    // return the node with the given key to the free list
+    virtual void release_node(const snort::FlowKey*) = 0;
+
+    // delete the current LRU node and return its user data
+    virtual void* remove() = 0;
+
+    // iterate from least recently used
+    virtual void* lru_first() = 0;
+    virtual void* lru_next() = 0;
+    virtual void* lru_current() = 0;
+
+    // make the current node most recently used
+    virtual void lru_touch() = 0;
+
+    virtual unsigned get_num_nodes() = 0;
+};
+
+#endif
+
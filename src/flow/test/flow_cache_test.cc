@@ -77,6 +77,7 @@ Flow::Flow()
 Flow::~Flow() = default;
 DetectionEngine::DetectionEngine() = default;
 ExpectCache::~ExpectCache() = default;
+bool ExpectCache::expire(TimerWheel::Timer*, uint64_t) { return false; }
 DetectionEngine::~DetectionEngine() = default;
 void Flow::init(PktType) { }
 void Flow::term() { }
@@ -99,7 +100,7 @@ ExpectCache::ExpectCache(uint32_t) { }
 bool ExpectCache::check(Packet*, Flow*) { return true; }
 bool ExpectCache::is_expected(Packet*) { return true; }
 Flow* HighAvailabilityManager::import(Packet&, FlowKey&) { return nullptr; }
-bool HighAvailabilityManager::in_standby(Flow*) { return true; }
+bool HighAvailabilityManager::in_standby(Flow*) { return false; }
 SfIpRet SfIp::set(void const*, int) { return SFIP_SUCCESS; }
 void snort::trace_vprintf(const char*, TraceLevel, const char*, const Packet*, const char*, va_list) {}
 uint8_t snort::TraceApi::get_constraints_generation() { return 0; }
@@ -136,7 +137,13 @@ int ExpectCache::add_flow(const Packet*, PktType, IpProtocol, const SfIp*, uint1
     return 1;
 }
 
-TEST_GROUP(flow_prune) { };
+TEST_GROUP(flow_prune)
+{
+    void teardown() override
+    {
+        TimerWheel::thread_term();
+    }
+};
 
 // No flows in the flow cache, pruning should not happen
 TEST(flow_prune, empty_cache_prune_flows)
@@ -269,6 +276,71 @@ TEST(flow_prune, prune_all_blocked_flows)
     delete cache;
 }
 
+// Same as prune_flows with the swiss table
+TEST(flow_prune, prune_flows_swiss)
+{
+    FlowCacheConfig fcg;
+    fcg.max_flows = 3;
+    fcg.table_type = FlowTableType::SWISS;
+    FlowCache *cache = new FlowCache(fcg);
+    int port = 1;
+
+    for ( unsigned i = 0; i < fcg.max_flows; i++ )
+    {
+        FlowKey flow_key;
+        memset(&flow_key, 0, sizeof(FlowKey));
+        flow_key.port_l = port++;
+        flow_key.pkt_type = PktType::TCP;
+        cache->allocate(&flow_key);
+    }
+
+    CHECK(cache->get_count() == fcg.max_flows);
+    CHECK(cache->delete_flows(1) == 1);
+    CHECK(cache->get_count() == fcg.max_flows-1);
+    cache->purge();
+    CHECK(cache->get_flows_allocated() == 0);
+    delete cache;
+}
+
+// Time out 3 flows with the swiss table timer wheel, one of them refreshed
+TEST(flow_prune, timeout_flows_swiss)
+{
+    FlowCacheConfig fcg;
+    fcg.max_flows = 3;
+    fcg.table_type = FlowTableType::SWISS;
+    fcg.proto[to_utype(PktType::TCP)].nominal_timeout = 10;
+    FlowCache *cache = new FlowCache(fcg);
+    Flow* flows[3];
+
+    for ( unsigned i = 0; i < fcg.max_flows; i++ )
+    {
+        FlowKey flow_key;
+        memset(&flow_key, 0, sizeof(FlowKey));
+        flow_key.port_l = i + 1;
+        flow_key.pkt_type = PktType::TCP;
+        flows[i] = cache->allocate(&flow_key);
+    }
+
+    // packet time is stuck at 0 so fake a later packet
+    flows[1]->last_data_seen = 8;
+
+    TimerWheel* wheel = TimerWheel::get_thread_wheel();
+    CHECK(wheel->run(9, 3, 8) == 0);
+    CHECK(cache->get_count() == 3);
+
+    // the refreshed flow is only rescheduled so it doesn't use up the budget
+    CHECK(wheel->run(10, 2, 8) == 2);
+    CHECK(cache->get_count() == 1);
+    wheel->run(17, 3, 8);
+    CHECK(cache->get_count() == 1);
+    wheel->run(18, 3, 8);
+    CHECK(cache->get_count() == 0);
+
+    cache->purge();
+    CHECK(cache->get_flows_allocated() == 0);
+    delete cache;
+}
+
 int main(int argc, char** argv)
 {
     return CommandLineTestRunner::RunAllTests(argc, argv);
@@ -74,13 +74,17 @@ Flow::~Flow() = default;
 DetectionEngine::DetectionEngine() = default;
 DetectionEngine::~DetectionEngine() = default;
 ExpectCache::~ExpectCache() = default;
+bool ExpectCache::expire(TimerWheel::Timer*, uint64_t) { return false; }
 unsigned FlowCache::purge() { return 1; }
 Flow* FlowCache::find(const FlowKey*) { return nullptr; }
 Flow* FlowCache::allocate(const FlowKey*) { return nullptr; }
+unsigned FlowCache::prefetch(const FlowKey*) { return 0; }
+void FlowCache::prefetch_node(unsigned) { }
+Flow* FlowCache::peek(const FlowKey*, unsigned) { return nullptr; }
 void FlowCache::push(Flow*) { }
+bool FlowCache::expire(TimerWheel::Timer*, uint64_t) { return false; }
 bool FlowCache::prune_one(PruneReason, bool) { return true; }
 unsigned FlowCache::delete_flows(unsigned) { return 0; }
-unsigned FlowCache::timeout(unsigned, time_t) { return 1; }
 void Flow::init(PktType) { }
 void DataBus::publish(const char*, const uint8_t*, unsigned, Flow*) { }
 void DataBus::publish(const char*, Packet*, Flow*) { }
@@ -0,0 +1,541 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// flow_table_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <chrono>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "flow/flow_key.h"
+#include "flow/flow_table.h"
+#include "main/snort_config.h"
+#include "sfip/sf_ip.h"
+#include "time/timer_wheel.h"
+
+#include "catch/catch.hpp"
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// stubs
+//-------------------------------------------------------------------------
+
+SfIpRet SfIp::set(void const*, int) { return SFIP_SUCCESS; }
+const SnortConfig* SnortConfig::get_conf() { return nullptr; }
+
+//-------------------------------------------------------------------------
+// helpers
+//-------------------------------------------------------------------------
+
+static void make_key(FlowKey& key, unsigned id)
+{
+    memset(&key, 0, sizeof(key));
+    key.ip_l[3] = id;
+    key.ip_h[3] = ~id;
+    key.port_l = id & 0xffff;
+    key.port_h = 80;
+    key.pkt_type = PktType::TCP;
+    key.ip_protocol = 6;
+    key.version = 4;
+}
+
+struct Item
+{
+    unsigned id;
+    const FlowKey* key;
+    TimerWheel::Timer timer;
+};
+
+static void fill(FlowTable* ft, std::vector<Item>& items)
+{
+    unsigned id = 0;
+
+    for ( auto& it : items )
+    {
+        it.id = id++;
+        it.key = (const FlowKey*)ft->push(&it);
+    }
+}
+
+static const FlowTableType types[] = { FlowTableType::ZHASH, FlowTableType::SWISS };
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+TEST_CASE("flow table basic", "[flow_table]")
+{
+    for ( auto type : types )
+    {
+        FlowTable* ft = FlowTable::create(type, 8);
+        std::vector<Item> items(3);
+        fill(ft, items);
+
+        FlowKey k1, k2, k3, k4;
+        make_key(k1, 1);
+        make_key(k2, 2);
+        make_key(k3, 3);
+        make_key(k4, 4);
+
+        CHECK(ft->get_user_data(&k1) == nullptr);
+
+        auto i1 = (Item*)ft->get(&k1);
+        auto i2 = (Item*)ft->get(&k2);
+        auto i3 = (Item*)ft->get(&k3);
+        REQUIRE(i1);
+        REQUIRE(i2);
+        REQUIRE(i3);
+        CHECK(ft->get_num_nodes() == 3);
+
+        // free list is exhausted
+        CHECK(ft->get(&k4) == nullptr);
+        CHECK(ft->get(&k2) == i2);
+
+        // lru order is now 1, 3, 2
+        CHECK(ft->lru_first() == i1);
+        CHECK(ft->lru_next() == i3);
+        CHECK(ft->lru_next() == i2);
+        CHECK(ft->lru_next() == nullptr);
+
+        CHECK(ft->get_user_data(&k1) == i1);
+        CHECK(ft->lru_first() == i3);
+
+        // touch moves the cursor toward mru
+        ft->lru_touch();
+        CHECK(ft->lru_current() == i2);
+        CHECK(ft->lru_first() == i2);
+
+        ft->release_node(i2->key);
+        CHECK(ft->get_num_nodes() == 2);
+        CHECK(ft->get_user_data(&k2) == nullptr);
+        CHECK(ft->get(&k4) == i2);
+
+        CHECK(ft->lru_first() == i1);
+        CHECK(ft->remove() == i1);
+        CHECK(ft->get_num_nodes() == 2);
+        CHECK(ft->lru_first() == i3);
+
+        while ( ft->lru_first() )
+            ft->remove();
+
+        CHECK(ft->get_num_nodes() == 0);
+        CHECK(ft->pop() == nullptr);
+        delete ft;
+    }
+}
+
+TEST_CASE("flow table random", "[flow_table]")
+{
+    const unsigned num = 1000;
+
+    for ( auto type : types )
+    {
+        FlowTable* ft = FlowTable::create(type, num);
+        std::vector<Item> items(num);
+        std::unordered_map<unsigned, Item*> ref;
+        std::mt19937 rng(1);
+        fill(ft, items);
+
+        for ( unsigned i = 0; i < 100000; ++i )
+        {
+            unsigned id = rng() % (2 * num);
+            FlowKey key;
+            make_key(key, id);
+
+            auto p = ref.find(id);
+            Item* it = (Item*)ft->get_user_data(&key);
+
+            if ( p == ref.end() )
+            {
+                CHECK(it == nullptr);
+
+                if ( ref.size() < num )
+                {
+                    it = (Item*)ft->get(&key);
+                    REQUIRE(it);
+                    ref[id] = it;
+                }
+            }
+            else
+            {
+                CHECK(it == p->second);
+
+                if ( rng() & 1 )
+                {
+                    ft->release_node(it->key);
+                    ref.erase(p);
+                }
+            }
+            REQUIRE(ft->get_num_nodes() == ref.size());
+        }
+
+        while ( ft->lru_first() )
+            ft->remove();
+
+        while ( ft->pop() )
+            ;
+
+        delete ft;
+    }
+}
+
+static void release(
+    FlowTable* ft, std::unordered_map<unsigned, Item*>& ref, std::vector<unsigned>& live,
+    std::mt19937& rng)
+{
+    unsigned n = rng() % live.size();
+    FlowKey key;
+    make_key(key, live[n]);
+
+    ft->release_node(ref[live[n]]->key);
+    CHECK(ft->get_user_data(&key) == nullptr);
+
+    ref.erase(live[n]);
+    live[n] = live.back();
+    live.pop_back();
+}
+
+// keys are added a first group at a time so groups fill and erases leave
+// deleted slots that must eventually be cleared
+TEST_CASE("flow table collisions", "[flow_table]")
+{
+    const unsigned num = 256;
+
+    for ( auto type : types )
+    {
+        FlowTable* ft = FlowTable::create(type, num);
+        std::vector<Item> items(num);
+        std::unordered_map<unsigned, Item*> ref;
+        std::vector<unsigned> live;
+        std::mt19937 rng(1);
+        fill(ft, items);
+
+        unsigned next_id = 0;
+
+        for ( unsigned round = 0; round < 64; ++round )
+        {
+            // same first group for any table of up to 1024 groups
+            unsigned group = (round * 5) % 16;
+
+            while ( live.size() < num )
+            {
+                // some releases while the deleted slots are being cleared
+                if ( live.size() > num / 2 and !(rng() % 4) )
+                    release(ft, ref, live, rng);
+
+                FlowKey key;
+
+                do
+                    make_key(key, next_id++);
+                while ( ((ft->get_hash(&key) >> 7) & 0x3ff) != group );
+
+                Item* it = (Item*)ft->get(&key);
+                REQUIRE(it);
+
+                ref[next_id - 1] = it;
+                live.emplace_back(next_id - 1);
+            }
+
+            for ( auto id : live )
+            {
+                FlowKey key;
+                make_key(key, id);
+                REQUIRE(ft->get_user_data(&key) == ref[id]);
+            }
+
+            while ( live.size() > num / 2 )
+                release(ft, ref, live, rng);
+
+            REQUIRE(ft->get_num_nodes() == live.size());
+        }
+
+        while ( ft->lru_first() )
+            ft->remove();
+
+        while ( ft->pop() )
+            ;
+
+        delete ft;
+    }
+}
+
+TEST_CASE("flow table peek", "[flow_table]")
+{
+    const unsigned num = 64;
+
+    for ( auto type : types )
+    {
+        FlowTable* ft = FlowTable::create(type, num);
+        std::vector<Item> items(num);
+        std::vector<Item*> ref(num);
+        fill(ft, items);
+
+        for ( unsigned id = 0; id < num; ++id )
+        {
+            FlowKey key;
+            make_key(key, id);
+            ref[id] = (Item*)ft->get(&key);
+            REQUIRE(ref[id]);
+        }
+
+        for ( unsigned id = 0; id < 2 * num; ++id )
+        {
+            FlowKey key;
+            make_key(key, id);
+
+            unsigned hash = ft->get_hash(&key);
+            ft->prefetch_bucket(hash);
+            ft->prefetch_node(hash);
+
+            Item* it = (Item*)ft->peek(&key, hash);
+
+            if ( id < num )
+                CHECK(it == ref[id]);
+            else
+                CHECK(it == nullptr);
+        }
+
+        // peek doesn't touch so the first inserted is still lru
+        CHECK(ft->lru_first() == ref[0]);
+
+        while ( ft->lru_first() )
+            ft->remove();
+
+        while ( ft->pop() )
+            ;
+
+        delete ft;
+    }
+}
+
+//-------------------------------------------------------------------------
+// benchmark
+//
+// synthetic churn: each second a batch of packets arrives for a mix of new
+// and recent flows and idle flows time out.  the zhash run times out by
+// scanning the lru as FlowCache does and the swiss run uses a timer wheel.
+//-------------------------------------------------------------------------
+
+#ifdef BENCHMARK_TEST
+
+static const unsigned bench_flows = 1 << 20;
+static const unsigned bench_ops = bench_flows / 16;
+static const unsigned bench_seconds = 32;
+static const unsigned bench_timeout = 8;
+
+// one flow in 8 is new and the rest are uniform over the recent ones
+static const std::vector<unsigned>& get_ids()
+{
+    static std::vector<unsigned> ids;
+
+    if ( ids.empty() )
+    {
+        std::mt19937 rng(1);
+        unsigned next_id = 0;
+
+        for ( unsigned i = 0; i < bench_ops * bench_seconds; ++i )
+        {
+            if ( !(rng() % 8) or next_id < bench_ops )
+                ids.emplace_back(next_id++);
+            else
+                ids.emplace_back(next_id - 1 - rng() % bench_ops);
+        }
+    }
+    return ids;
+}
+
+static void churn(FlowTableType type)
+{
+    FlowTable* ft = FlowTable::create(type, bench_flows);
+    std::vector<Item> items(bench_flows);
+    std::vector<unsigned> seen(bench_flows);
+    TimerWheel wheel;
+    const std::vector<unsigned>& ids = get_ids();
+    unsigned n = 0;
+
+    fill(ft, items);
+
+    for ( unsigned now = 1; now <= bench_seconds; ++now )
+    {
+        for ( unsigned i = 0; i < bench_ops; ++i )
+        {
+            FlowKey key;
+            make_key(key, ids[n++]);
+
+            Item* it = (Item*)ft->get_user_data(&key);
+
+            if ( !it )
+            {
+                it = (Item*)ft->get(&key);
+
+                if ( !it )
+                {
+                    // full so prune the oldest
+                    Item* old = (Item*)ft->lru_first();
+                    if ( old->timer.is_scheduled() )
+                        wheel.cancel(&old->timer);
+                    ft->release_node(old->key);
+                    it = (Item*)ft->get(&key);
+                }
+                if ( type == FlowTableType::SWISS )
+                {
+                    it->timer.user = it;
+                    wheel.schedule(&it->timer, now + bench_timeout);
+                }
+            }
+            seen[it->id] = now;
+        }
+
+        if ( type == FlowTableType::SWISS )
+        {
+            while ( TimerWheel::Timer* t = wheel.expire(now) )
+            {
+                Item* it = (Item*)t->user;
+
+                if ( seen[it->id] + bench_timeout > now )
+                    wheel.schedule(t, seen[it->id] + bench_timeout);
+                else
+                    ft->release_node(it->key);
+            }
+        }
+        else
+        {
+            while ( Item* it = (Item*)ft->lru_first() )
+            {
+                if ( seen[it->id] + bench_timeout > now )
+                    break;
+
+                ft->release_node(it->key);
+            }
+        }
+    }
+
+    while ( ft->lru_first() )
+        ft->remove();
+
+    while ( ft->pop() )
+        ;
+
+    delete ft;
+}
+
+// replay packets in batches over a table much larger than the cache with
+// and without prefetching the whole batch up front.  a little work is done
+// per packet as the rest of processing would to give the prefetches time.
+
+static const unsigned bench_batch = 64;
+static const unsigned bench_pkts = 1 << 22;
+
+static uint64_t packet_work(const Item* it, uint64_t seed)
+{
+    for ( unsigned i = 0; i < 64; ++i )
+        seed = seed * 6364136223846793005ull + it->id;
+    return seed;
+}
+
+static double replay(FlowTableType type, bool prefetch)
+{
+    FlowTable* ft = FlowTable::create(type, bench_flows);
+    std::vector<Item> items(bench_flows);
+    std::vector<FlowKey> keys(bench_batch);
+    std::vector<unsigned> hashes(bench_batch);
+    std::mt19937 rng(1);
+    uint64_t sum = 0;
+
+    fill(ft, items);
+
+    for ( unsigned id = 0; id < bench_flows; ++id )
+    {
+        FlowKey key;
+        make_key(key, id);
+        ft->get(&key);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for ( unsigned n = 0; n < bench_pkts; n += bench_batch )
+    {
+        for ( unsigned i = 0; i < bench_batch; ++i )
+            make_key(keys[i], rng() % bench_flows);
+
+        if ( prefetch )
+        {
+            for ( unsigned i = 0; i < bench_batch; ++i )
+            {
+                hashes[i] = ft->get_hash(&keys[i]);
+                ft->prefetch_bucket(hashes[i]);
+            }
+            for ( unsigned i = 0; i < bench_batch; ++i )
+                ft->prefetch_node(hashes[i]);
+        }
+        for ( unsigned i = 0; i < bench_batch; ++i )
+        {
+            if ( prefetch and i + 1 < bench_batch )
+                __builtin_prefetch(ft->peek(&keys[i + 1], hashes[i + 1]));
+
+            sum = packet_work((Item*)ft->get_user_data(&keys[i]), sum);
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    CHECK(sum);
+
+    while ( ft->lru_first() )
+        ft->remove();
+
+    while ( ft->pop() )
+        ;
+
+    delete ft;
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / bench_pkts;
+}
+
+TEST_CASE("flow table batch prefetch", "[flow_table]")
+{
+    for ( auto type : types )
+    {
+        const char* name = type == FlowTableType::SWISS ? "swiss" : "zhash";
+        double base = replay(type, false);
+        double pre = replay(type, true);
+        WARN(name << " nsecs/packet: " << base << " without prefetch, " << pre << " with");
+    }
+}
+
+TEST_CASE("flow table churn", "[flow_table]")
+{
+    get_ids();
+
+    BENCHMARK("zhash")
+    {
+        churn(FlowTableType::ZHASH);
+    };
+
+    BENCHMARK("swiss")
+    {
+        churn(FlowTableType::SWISS);
+    };
+}
+
+#endif
+
@@ -304,6 +304,36 @@ void* XHash::get_user_data(const void* key)
     return ( hnode ) ? hnode->data : nullptr;
 }
 
+unsigned XHash::get_hash(const void* key)
+{
+    return hashkey_ops->do_hash((const unsigned char*)key, keysize);
+}
+
+void XHash::prefetch_row(unsigned hash) const
+{
+    __builtin_prefetch(&table[hash & (nrows - 1)]);
+}
+
+void XHash::prefetch_node(unsigned hash) const
+{
+    // the key follows the node so prefetch both without touching either
+    if ( const HashNode* hnode = table[hash & (nrows - 1)] )
+    {
+        __builtin_prefetch(hnode);
+        __builtin_prefetch((const char*)hnode + sizeof(HashNode) + keysize - 1);
+    }
+}
+
+void* XHash::peek_user_data(const void* key, unsigned hash)
+{
+    for (HashNode* hnode = table[hash & (nrows - 1)]; hnode; hnode = hnode->next )
+    {
+        if ( hashkey_ops->key_compare(hnode->key, key, keysize) )
+            return hnode->data;
+    }
+    return nullptr;
+}
+
 void XHash::release()
 {
     HashNode* node = lru_cache->get_current_node();
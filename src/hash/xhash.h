@@ -67,6 +67,13 @@ public:
     void clear_hash();
     bool full() const { return !fhead; }
 
+    // for batch lookups; hash the keys and prefetch their rows and then
+    // nodes ahead of use.  peek does not change the lru order.
+    unsigned get_hash(const void* key);
+    void prefetch_row(unsigned hash) const;
+    void prefetch_node(unsigned hash) const;
+    void* peek_user_data(const void* key, unsigned hash);
+
     // set max hash nodes, 0 == no limit
     void set_max_nodes(int max)
     { max_nodes = max; }
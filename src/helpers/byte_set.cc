@@ -0,0 +1,273 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// byte_set.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "byte_set.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BYTE_SET_X86
+#include <immintrin.h>
+#endif
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// set
+//--------------------------------------------------------------------------
+
+void ByteSet::clear()
+{
+    memset(lo_bits, 0, sizeof(lo_bits));
+    memset(hi_bits, 0, sizeof(hi_bits));
+}
+
+void ByteSet::add(uint8_t b)
+{
+    uint8_t* bits = b < 0x80 ? lo_bits : hi_bits;
+    bits[b & 0x0f] |= 1 << ((b >> 4) & 0x07);
+}
+
+unsigned ByteSet::count() const
+{
+    unsigned n = 0;
+
+    for ( unsigned i = 0; i < 16; ++i )
+        n += __builtin_popcount(lo_bits[i]) + __builtin_popcount(hi_bits[i]);
+
+    return n;
+}
+
+const uint8_t* ByteSet::find_scalar(const uint8_t* p, const uint8_t* end) const
+{
+    while ( p < end and !has(*p) )
+        ++p;
+
+    return p;
+}
+
+uint64_t ByteSet::match_scalar(const uint8_t* p, unsigned n) const
+{
+    uint64_t mask = 0;
+
+    for ( unsigned i = 0; i < n; ++i )
+        mask |= (uint64_t)has(p[i]) << i;
+
+    return mask;
+}
+
+uint64_t ByteSet::match(const uint8_t* p, unsigned n) const
+{
+    if ( n >= 64 )
+        return matcher(*this, p);
+
+    if ( !n )
+        return 0;
+
+    // matchers always read 64 bytes
+    alignas(64) uint8_t block[64] = { };
+    memcpy(block, p, n);
+
+    return matcher(*this, block) & ((1ULL << n) - 1);
+}
+
+//--------------------------------------------------------------------------
+// simd
+//
+// each byte is split into nibbles.  the low nibble selects a row from
+// lo_bits or hi_bits (based on the top bit of the byte) and the high nibble
+// selects the bit within that row.  both lookups are done with byte shuffles
+// so a whole vector is classified with a handful of instructions.
+//--------------------------------------------------------------------------
+
+#ifdef BYTE_SET_X86
+namespace snort
+{
+struct ByteSetSimd
+{
+    __attribute__((target("avx2")))
+    static const uint8_t* find_avx2(const ByteSet&, const uint8_t*, const uint8_t*);
+
+    __attribute__((target("avx512f,avx512bw")))
+    static const uint8_t* find_avx512(const ByteSet&, const uint8_t*, const uint8_t*);
+
+    __attribute__((target("avx2")))
+    static uint64_t match_avx2(const ByteSet&, const uint8_t*);
+
+    __attribute__((target("avx512f,avx512bw")))
+    static uint64_t match_avx512(const ByteSet&, const uint8_t*);
+};
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t classify_avx2(__m256i lo_tbl, __m256i hi_tbl, const uint8_t* p)
+{
+    const __m256i bit_tbl = _mm256_setr_epi8(
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+
+    __m256i x = _mm256_loadu_si256((const __m256i*)p);
+    __m256i lo = _mm256_and_si256(x, nibble);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+
+    __m256i row = _mm256_blendv_epi8(
+        _mm256_shuffle_epi8(lo_tbl, lo), _mm256_shuffle_epi8(hi_tbl, lo), x);
+
+    __m256i bit = _mm256_shuffle_epi8(bit_tbl, hi);
+    __m256i hit = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit);
+
+    return (uint32_t)_mm256_movemask_epi8(hit);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static inline uint64_t classify_avx512(__m512i lo_tbl, __m512i hi_tbl, const uint8_t* p)
+{
+    const __m512i bit_tbl = _mm512_set1_epi64(0x8040201008040201);
+    const __m512i nibble = _mm512_set1_epi8(0x0f);
+
+    __m512i x = _mm512_loadu_si512((const void*)p);
+    __m512i lo = _mm512_and_si512(x, nibble);
+    __m512i hi = _mm512_and_si512(_mm512_srli_epi16(x, 4), nibble);
+
+    __m512i row = _mm512_mask_blend_epi8(_mm512_movepi8_mask(x),
+        _mm512_shuffle_epi8(lo_tbl, lo), _mm512_shuffle_epi8(hi_tbl, lo));
+
+    __m512i bit = _mm512_shuffle_epi8(bit_tbl, hi);
+
+    return _mm512_test_epi8_mask(row, bit);
+}
+
+__attribute__((target("avx2")))
+const uint8_t* ByteSetSimd::find_avx2(const ByteSet& bs, const uint8_t* p, const uint8_t* end)
+{
+    const __m256i lo_tbl = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)bs.lo_bits));
+    const __m256i hi_tbl = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)bs.hi_bits));
+
+    while ( end - p >= 32 )
+    {
+        if ( uint32_t mask = classify_avx2(lo_tbl, hi_tbl, p) )
+            return p + __builtin_ctz(mask);
+
+        p += 32;
+    }
+    return bs.find_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+uint64_t ByteSetSimd::match_avx2(const ByteSet& bs, const uint8_t* p)
+{
+    const __m256i lo_tbl = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)bs.lo_bits));
+    const __m256i hi_tbl = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)bs.hi_bits));
+
+    return classify_avx2(lo_tbl, hi_tbl, p) |
+        ((uint64_t)classify_avx2(lo_tbl, hi_tbl, p + 32) << 32);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+const uint8_t* ByteSetSimd::find_avx512(const ByteSet& bs, const uint8_t* p, const uint8_t* end)
+{
+    alignas(64) uint8_t lo_rows[64];
+    alignas(64) uint8_t hi_rows[64];
+
+    for ( unsigned i = 0; i < 64; i += 16 )
+    {
+        memcpy(lo_rows + i, bs.lo_bits, 16);
+        memcpy(hi_rows + i, bs.hi_bits, 16);
+    }
+
+    const __m512i lo_tbl = _mm512_load_si512((const void*)lo_rows);
+    const __m512i hi_tbl = _mm512_load_si512((const void*)hi_rows);
+
+    while ( end - p >= 64 )
+    {
+        if ( uint64_t mask = classify_avx512(lo_tbl, hi_tbl, p) )
+            return p + __builtin_ctzll(mask);
+
+        p += 64;
+    }
+    return find_avx2(bs, p, end);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+uint64_t ByteSetSimd::match_avx512(const ByteSet& bs, const uint8_t* p)
+{
+    const __m512i lo_tbl = _mm512_broadcast_i32x4(_mm_load_si128((const __m128i*)bs.lo_bits));
+    const __m512i hi_tbl = _mm512_broadcast_i32x4(_mm_load_si128((const __m128i*)bs.hi_bits));
+
+    return classify_avx512(lo_tbl, hi_tbl, p);
+}
+#endif
+
+static const uint8_t* find_default(const ByteSet& bs, const uint8_t* p, const uint8_t* end)
+{ return bs.find_scalar(p, end); }
+
+static uint64_t match_default(const ByteSet& bs, const uint8_t* p)
+{ return bs.match_scalar(p, 64); }
+
+ByteSet::Finder ByteSet::select_finder()
+{
+#ifdef BYTE_SET_X86
+    __builtin_cpu_init();
+
+    if ( __builtin_cpu_supports("avx512bw") )
+        return ByteSetSimd::find_avx512;
+
+    if ( __builtin_cpu_supports("avx2") )
+        return ByteSetSimd::find_avx2;
+#endif
+    return find_default;
+}
+
+ByteSet::Matcher ByteSet::select_matcher()
+{
+#ifdef BYTE_SET_X86
+    __builtin_cpu_init();
+
+    if ( __builtin_cpu_supports("avx512bw") )
+        return ByteSetSimd::match_avx512;
+
+    if ( __builtin_cpu_supports("avx2") )
+        return ByteSetSimd::match_avx2;
+#endif
+    return match_default;
+}
+
+const ByteSet::Finder ByteSet::finder = ByteSet::select_finder();
+const ByteSet::Matcher ByteSet::matcher = ByteSet::select_matcher();
+
+bool ByteSet::has_simd()
+{ return finder != find_default; }
+
+const char* ByteSet::get_simd_name()
+{
+#ifdef BYTE_SET_X86
+    if ( finder == ByteSetSimd::find_avx512 )
+        return "avx512bw";
+
+    if ( finder == ByteSetSimd::find_avx2 )
+        return "avx2";
+#endif
+    return "none";
+}
+
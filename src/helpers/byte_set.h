@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// byte_set.h
+
+#ifndef BYTE_SET_H
+#define BYTE_SET_H
+
+// ByteSet finds the first byte in a buffer that is a member of an
+// arbitrary set of byte values, or returns a bit mask of all members in a
+// block of up to 64 bytes.  When the cpu supports it (determined at
+// runtime), 64 or 32 bytes are classified at a time with AVX-512BW or AVX2
+// nibble lookups; otherwise a simple table driven loop is used.  All
+// implementations return the same result.
+
+#include <cstdint>
+
+#include "main/snort_types.h"
+
+namespace snort
+{
+
+class SO_PUBLIC ByteSet
+{
+public:
+    ByteSet()
+    { clear(); }
+
+    void clear();
+    void add(uint8_t);
+
+    bool has(uint8_t b) const
+    { return (b < 0x80 ? lo_bits : hi_bits)[b & 0x0f] & (1 << ((b >> 4) & 0x07)); }
+
+    unsigned count() const;
+
+    // return the first member in [p, end) or end if none
+    const uint8_t* find(const uint8_t* p, const uint8_t* end) const
+    { return finder(*this, p, end); }
+
+    const uint8_t* find_scalar(const uint8_t* p, const uint8_t* end) const;
+
+    // bit i of the result is set if p[i] is a member, for i < n <= 64
+    uint64_t match(const uint8_t* p, unsigned n) const;
+    uint64_t match_scalar(const uint8_t* p, unsigned n) const;
+
+    // the implementation selected for this cpu
+    static bool has_simd();
+    static const char* get_simd_name();
+
+private:
+    using Finder = const uint8_t* (*)(const ByteSet&, const uint8_t*, const uint8_t*);
+    using Matcher = uint64_t (*)(const ByteSet&, const uint8_t*);
+
+    static Finder select_finder();
+    static Matcher select_matcher();
+    static const Finder finder;
+    static const Matcher matcher;
+
+    friend struct ByteSetSimd;
+
+    // bit h of lo_bits[l] is set if byte (h << 4 | l) is a member for h < 8
+    // bit h of hi_bits[l] is set if byte ((h + 8) << 4 | l) is a member
+    alignas(16) uint8_t lo_bits[16];
+    alignas(16) uint8_t hi_bits[16];
+};
+
+}
+#endif
+
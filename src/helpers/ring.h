@@ -21,6 +21,12 @@
 #define RING_H
 
 // Simple ring implementation
+// the slots are atomic so the writer may discard the oldest entry with get()
+// and reuse the slot while the reader is still loading it; that's only
+// possible for trivially copyable payloads like ints and pointers.
+
+#include <atomic>
+#include <type_traits>
 
 #include "ring_logic.h"
 
@@ -34,12 +40,6 @@ public:
     Ring<T>(const Ring<T>&) = delete;
     Ring<T>& operator=(const Ring<T>&) = delete;
 
-    T* read();
-    bool pop();
-
-    T* write();
-    bool push();
-
     T get(T);
     bool put(T);
 
@@ -48,14 +48,16 @@ public:
     bool empty();
 
 private:
+    static_assert(std::is_trivially_copyable<T>::value, "ring payloads are copied atomically");
+
     RingLogic logic;
-    T* store;
+    std::atomic<T>* store;
 };
 
 template <typename T>
 Ring<T>::Ring (int size) : logic(size)
 {
-    store = new T[size];
+    store = new std::atomic<T>[size];
 }
 
 template <typename T>
@@ -64,51 +66,36 @@ Ring<T>::~Ring ()
     delete[] store;
 }
 
+// the writer may also call get() to discard the oldest entry when full
 template <typename T>
-T* Ring<T>::read()
+T Ring<T>::get(T v)
 {
-    int ix = logic.read();
-    return (ix < 0) ? nullptr : store + ix;
-}
+    while ( true )
+    {
+        uint64_t pos;
+        int ix = logic.read(pos);
 
-template <typename T>
-T* Ring<T>::write()
-{
-    int ix = logic.write();
-    return (ix < 0) ? nullptr : store + ix;
-}
+        if ( ix < 0 )
+            return v;
 
-template <typename T>
-bool Ring<T>::push()
-{
-    return logic.push();
-}
+        // ordered by the index acquire; a stale value is dropped by pop(pos)
+        T t = store[ix].load(std::memory_order_relaxed);
 
-template <typename T>
-bool Ring<T>::pop()
-{
-    return logic.pop();
-}
-
-template <typename T>
-T Ring<T>::get(T v)
-{
-    T* p = read();
-    if ( !p )
-        return v;
-    v = *p;
-    pop();
-    return v;
+        if ( logic.pop(pos) )
+            return t;
+    }
 }
 
 template <typename T>
 bool Ring<T>::put(T v)
 {
-    T* p = write();
-    if ( !p )
+    int ix = logic.write();
+
+    if ( ix < 0 )
         return false;
-    *p = v;
-    push();
+
+    store[ix].store(v, std::memory_order_relaxed);
+    logic.push();
     return true;
 }
 
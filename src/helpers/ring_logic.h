@@ -21,6 +21,11 @@
 #define RING_LOGIC_H
 
 // Logic for simple ring implementation
+// safe for one writer and one reader thread.  the indices are free running
+// counters so pop(pos) can't mistake a recycled position for the one read.
+
+#include <atomic>
+#include <cstdint>
 
 class RingLogic
 {
@@ -31,72 +36,95 @@ public:
     int read();
     int write();
 
+    // return next available position or -1 and the read counter for pop(pos)
+    int read(uint64_t& pos);
+
     // return true if index advanced
     bool push();
     bool pop();
 
+    // return true if index advanced from pos; false if the entry at pos was
+    // already taken (eg discarded by the writer to make room)
+    bool pop(uint64_t pos);
+
     int count();
     bool full();
     bool empty();
 
-private:
-    int next(int ix)
-    { return ( ++ix < sz ) ? ix : 0; }
-
 private:
     int sz;
-    volatile int rx;
-    volatile int wx;
+    std::atomic<uint64_t> rx;
+    std::atomic<uint64_t> wx;
 };
 
 inline RingLogic::RingLogic(int size)
 {
     sz = size;
     rx = 0;
-    wx = 1;
+    wx = 0;
+}
+
+inline int RingLogic::read(uint64_t& pos)
+{
+    pos = rx.load(std::memory_order_acquire);
+
+    if ( pos == wx.load(std::memory_order_acquire) )
+        return -1;
+
+    return (int)(pos % sz);
 }
 
 inline int RingLogic::read()
 {
-    int nx = next(rx);
-    return ( nx == wx ) ? -1 : nx;
+    uint64_t pos;
+    return read(pos);
 }
 
 inline int RingLogic::write()
 {
-    int nx = next(wx);
-    return ( nx == rx ) ? -1 : wx;
+    uint64_t w = wx.load(std::memory_order_relaxed);
+
+    if ( w - rx.load(std::memory_order_acquire) >= (uint64_t)sz )
+        return -1;
+
+    return (int)(w % sz);
 }
 
 inline bool RingLogic::push()
 {
-    int nx = next(wx);
-    if ( nx == rx )
+    uint64_t w = wx.load(std::memory_order_relaxed);
+
+    if ( w - rx.load(std::memory_order_acquire) >= (uint64_t)sz )
         return false;
-    wx = nx;
+
+    wx.store(w + 1, std::memory_order_release);
     return true;
 }
 
+inline bool RingLogic::pop(uint64_t pos)
+{
+    return rx.compare_exchange_strong(pos, pos + 1, std::memory_order_acq_rel);
+}
+
 inline bool RingLogic::pop()
 {
-    int nx = next(rx);
-    if ( nx == wx )
+    uint64_t pos;
+
+    if ( read(pos) < 0 )
         return false;
-    rx = nx;
-    return true;
+
+    return pop(pos);
 }
 
 inline int RingLogic::count()
 {
-    int c = wx - rx - 1;
-    if ( c < 0 )
-        c += sz;
-    return c;
+    uint64_t r = rx.load(std::memory_order_acquire);
+    return (int)(wx.load(std::memory_order_acquire) - r);
 }
 
 inline bool RingLogic::full()
 {
-    return ( count() == sz );
+    return ( count() >= sz );
 }
 
 inline bool RingLogic::empty()
@@ -105,4 +133,3 @@ inline bool RingLogic::empty()
 }
 
 #endif
-
@@ -0,0 +1,152 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// byte_set_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "helpers/byte_set.h"
+
+using namespace snort;
+
+TEST_CASE("byte set members", "[byte_set]")
+{
+    ByteSet bs;
+    CHECK(bs.count() == 0);
+
+    bs.add(0x00);
+    bs.add('\r');
+    bs.add(0x7f);
+    bs.add(0x80);
+    bs.add(0xff);
+
+    CHECK(bs.count() == 5);
+
+    for ( unsigned b = 0; b < 256; ++b )
+    {
+        bool expected = (b == 0x00 or b == '\r' or b == 0x7f or b == 0x80 or b == 0xff);
+        CHECK(bs.has((uint8_t)b) == expected);
+    }
+}
+
+TEST_CASE("byte set find none", "[byte_set]")
+{
+    ByteSet bs;
+    bs.add('x');
+
+    uint8_t buf[200];
+    memset(buf, 'a', sizeof(buf));
+
+    for ( unsigned len = 0; len <= sizeof(buf); ++len )
+    {
+        CHECK(bs.find(buf, buf + len) == buf + len);
+
+        if ( len )
+        {
+            buf[len - 1] = 'x';
+            CHECK(bs.find(buf, buf + len) == buf + len - 1);
+            buf[len - 1] = 'a';
+        }
+    }
+}
+
+TEST_CASE("byte set find matches scalar", "[byte_set]")
+{
+    std::mt19937 gen(1234);
+    std::vector<uint8_t> buf(4096);
+
+    for ( unsigned trial = 0; trial < 64; ++trial )
+    {
+        ByteSet bs;
+        unsigned members = 1 + trial % 8;
+
+        for ( unsigned i = 0; i < members; ++i )
+            bs.add(gen() & 0xff);
+
+        for ( auto& b : buf )
+            b = gen() & 0xff;
+
+        const uint8_t* end = buf.data() + buf.size();
+        const uint8_t* p = buf.data();
+
+        while ( p < end )
+        {
+            const uint8_t* q = bs.find(p, end);
+            REQUIRE(q == bs.find_scalar(p, end));
+
+            if ( q == end )
+                break;
+
+            p = q + 1;
+        }
+    }
+}
+
+TEST_CASE("byte set match matches scalar", "[byte_set]")
+{
+    std::mt19937 gen(5678);
+    uint8_t buf[64];
+
+    for ( unsigned trial = 0; trial < 256; ++trial )
+    {
+        ByteSet bs;
+        unsigned members = 1 + trial % 16;
+
+        for ( unsigned i = 0; i < members; ++i )
+            bs.add(gen() & 0xff);
+
+        for ( auto& b : buf )
+            b = gen() & 0xff;
+
+        for ( unsigned n = 0; n <= sizeof(buf); ++n )
+            REQUIRE(bs.match(buf, n) == bs.match_scalar(buf, n));
+    }
+}
+
+#ifdef BENCHMARK_TEST
+TEST_CASE("byte set 64K", "[byte_set]")
+{
+    ByteSet bs;
+    bs.add('\r');
+    bs.add('\n');
+
+    std::vector<uint8_t> buf(1 << 16, 'a');
+    buf.back() = '\n';
+
+    const uint8_t* begin = buf.data();
+    const uint8_t* end = begin + buf.size();
+
+    BENCHMARK("scalar")
+    {
+        return bs.find_scalar(begin, end);
+    };
+
+    BENCHMARK(ByteSet::get_simd_name())
+    {
+        return bs.find(begin, end);
+    };
+}
+#endif
+
@@ -0,0 +1,156 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// ring_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "../ring.h"
+
+TEST_CASE("ring fill and drain", "[ring]")
+{
+    Ring<int> ring(4);
+    CHECK(ring.empty());
+
+    for ( int i = 1; i <= 4; ++i )
+        CHECK(ring.put(i));
+
+    CHECK(ring.full());
+    CHECK(!ring.put(5));
+    CHECK(ring.count() == 4);
+
+    for ( int i = 1; i <= 4; ++i )
+        CHECK(ring.get(0) == i);
+
+    CHECK(ring.empty());
+    CHECK(ring.get(0) == 0);
+}
+
+TEST_CASE("ring wraps", "[ring]")
+{
+    Ring<int> ring(3);
+
+    for ( int i = 0; i < 10; ++i )
+    {
+        CHECK(ring.put(i));
+        CHECK(ring.put(i + 100));
+        CHECK(ring.get(-1) == i);
+        CHECK(ring.get(-1) == i + 100);
+    }
+    CHECK(ring.empty());
+}
+
+TEST_CASE("ring discard oldest", "[ring]")
+{
+    Ring<int> ring(2);
+
+    CHECK(ring.put(1));
+    CHECK(ring.put(2));
+    CHECK(!ring.put(3));
+
+    // writer makes room
+    CHECK(ring.get(0) == 1);
+    CHECK(ring.put(3));
+
+    CHECK(ring.get(0) == 2);
+    CHECK(ring.get(0) == 3);
+}
+
+TEST_CASE("ring threads", "[ring]")
+{
+    const int max = 100000;
+    Ring<int> ring(64);
+    int64_t sum = 0;
+    bool in_order = true;
+
+    std::thread reader([&]()
+    {
+        int n = 0;
+
+        while ( n < max )
+        {
+            int v = ring.get(-1);
+
+            if ( v < 0 )
+                continue;
+
+            if ( v != n )
+                in_order = false;
+
+            sum += v;
+            ++n;
+        }
+    });
+
+    for ( int i = 0; i < max; )
+    {
+        if ( ring.put(i) )
+            ++i;
+    }
+
+    reader.join();
+    CHECK(in_order);
+    CHECK(sum == (int64_t)max * (max - 1) / 2);
+}
+
+TEST_CASE("ring discard oldest with a reader", "[ring]")
+{
+    const int max = 100000;
+    Ring<int*> ring(8);
+    std::vector<int> data(max);
+    std::atomic<bool> done { false };
+    int last = -1;
+    bool in_order = true;
+
+    std::thread reader([&]()
+    {
+        while ( !done or !ring.empty() )
+        {
+            int* p = ring.get(nullptr);
+
+            if ( !p )
+                continue;
+
+            int v = (int)(p - data.data());
+
+            if ( v <= last )
+                in_order = false;
+
+            last = v;
+        }
+    });
+
+    // the writer always makes room so the reader races for the oldest
+    for ( int i = 0; i < max; ++i )
+    {
+        while ( !ring.put(&data[i]) )
+            ring.get(nullptr);
+    }
+
+    done = true;
+    reader.join();
+    CHECK(in_order);
+    CHECK(last == max - 1);
+}
@@ -0,0 +1,393 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// async_writer.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "async_writer.h"
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "helpers/ring.h"
+#include "log/log_file.h"
+#include "log/messages.h"
+#include "main/snort_config.h"
+#include "utils/util.h"
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// data
+//--------------------------------------------------------------------------
+
+struct LogRecord
+{
+    FILE* file;
+    LogFile* log;
+    size_t len;
+    uint8_t data[1];
+};
+
+// records are allocated and freed by the packet thread so per thread
+// memory accounting balances; the writer hands written records back in
+// done, which has room for everything the writer takes
+struct LogRing
+{
+    LogRing(unsigned size) : ring(size), done(2 * size), done_size(2 * size) { }
+
+    Ring<LogRecord*> ring;
+    Ring<LogRecord*> done;
+    unsigned done_size;
+
+    // queued and not yet written and flushed
+    std::atomic<unsigned> pending { 0 };
+};
+
+THREAD_LOCAL AsyncWriterStats snort::async_writer_stats;
+
+const PegInfo snort::async_writer_pegs[] =
+{
+    { CountType::SUM, "async_records", "log records queued for the writer thread" },
+    { CountType::SUM, "async_bytes", "log bytes queued for the writer thread" },
+    { CountType::MAX, "async_queue_max", "maximum log records queued by a packet thread" },
+    { CountType::SUM, "async_blocks", "log records that waited for space in a full queue" },
+    { CountType::SUM, "async_drops", "log records dropped because a queue was full" },
+    { CountType::END, nullptr, nullptr }
+};
+
+static std::vector<LogRing*> rings;
+static std::mutex rings_mutex;
+
+static std::thread* writer = nullptr;
+static std::mutex writer_mutex;
+static std::condition_variable writer_cond;
+static std::atomic<bool> writer_idle { false };
+static bool writer_go = false;
+
+static AsyncPolicy policy = ASYNC_BLOCK;
+static unsigned ring_size = 0;
+
+static THREAD_LOCAL LogRing* s_ring = nullptr;
+
+//--------------------------------------------------------------------------
+// writer thread
+//--------------------------------------------------------------------------
+
+static void write_batch(std::vector<LogRecord*>& recs)
+{
+    std::vector<FILE*> files;
+    std::vector<struct iovec> iov(recs.size());
+    unsigned i = 0;
+
+    while ( i < recs.size() )
+    {
+        LogRecord* rec = recs[i];
+
+        if ( rec->log )
+        {
+            // consecutive records for the same log file go in one write
+            unsigned j = i;
+
+            while ( j < recs.size() and recs[j]->log == rec->log )
+            {
+                iov[j].iov_base = recs[j]->data;
+                iov[j].iov_len = recs[j]->len;
+                ++j;
+            }
+            rec->log->write(&iov[i], j - i);
+            i = j;
+            continue;
+        }
+
+        if ( fwrite(rec->data, rec->len, 1, rec->file) != 1 )
+            ErrorMessage("async log writer failed to write: %s\n", get_error(errno));
+
+        if ( std::find(files.begin(), files.end(), rec->file) == files.end() )
+            files.emplace_back(rec->file);
+
+        ++i;
+    }
+
+    // everything must be written before sync() lets the owner close the files
+    LogFile::submit();
+
+    for ( auto* f : files )
+        fflush(f);
+}
+
+static unsigned drain()
+{
+    std::lock_guard<std::mutex> lock(rings_mutex);
+
+    std::vector<LogRecord*> recs;
+    std::vector<unsigned> done(rings.size(), 0);
+
+    for ( unsigned i = 0; i < rings.size(); ++i )
+    {
+        // bounded so a busy thread can't starve the others and so the
+        // records can all be handed back
+        unsigned room = rings[i]->done_size - rings[i]->done.count();
+        unsigned max = std::min(ring_size, room);
+
+        for ( unsigned n = 0; n < max; ++n )
+        {
+            LogRecord* rec = rings[i]->ring.get(nullptr);
+
+            if ( !rec )
+                break;
+
+            recs.emplace_back(rec);
+            ++done[i];
+        }
+    }
+
+    if ( recs.empty() )
+        return 0;
+
+    write_batch(recs);
+
+    // recs are in ring order
+    unsigned r = 0;
+
+    for ( unsigned i = 0; i < rings.size(); ++i )
+    {
+        for ( unsigned n = 0; n < done[i]; ++n )
+        {
+            bool ok = rings[i]->done.put(recs[r++]);
+            assert(ok);
+            UNUSED(ok);
+        }
+        rings[i]->pending -= done[i];
+    }
+
+    return recs.size();
+}
+
+static void run()
+{
+    while ( true )
+    {
+        if ( drain() )
+            continue;
+
+        std::unique_lock<std::mutex> lock(writer_mutex);
+
+        if ( !writer_go )
+            break;
+
+        writer_idle = true;
+        writer_cond.wait_for(lock, std::chrono::milliseconds(10));
+        writer_idle = false;
+    }
+    drain();
+}
+
+static void wake()
+{
+    if ( writer_idle.load(std::memory_order_relaxed) )
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        writer_cond.notify_one();
+    }
+}
+
+//--------------------------------------------------------------------------
+// packet threads
+//--------------------------------------------------------------------------
+
+static void reap()
+{
+    while ( LogRecord* rec = s_ring->done.get(nullptr) )
+        snort_free(rec);
+}
+
+static bool queue(
+    FILE* file, LogFile* log, const void* buf, size_t len, const void* more, size_t more_len)
+{
+    reap();
+
+    size_t size = len + more_len;
+    LogRecord* rec = (LogRecord*)snort_alloc(sizeof(LogRecord) + size);
+    rec->file = file;
+    rec->log = log;
+    rec->len = size;
+
+    memcpy(rec->data, buf, len);
+
+    if ( more_len )
+        memcpy(rec->data + len, more, more_len);
+
+    ++s_ring->pending;
+    bool blocked = false;
+
+    while ( !s_ring->ring.put(rec) )
+    {
+        if ( policy == ASYNC_DROP_NEWEST )
+        {
+            snort_free(rec);
+            --s_ring->pending;
+            async_writer_stats.drops++;
+            return true;
+        }
+
+        if ( policy == ASYNC_DROP_OLDEST )
+        {
+            // the writer may have taken it first; either way there is room
+            LogRecord* old = s_ring->ring.get(nullptr);
+
+            if ( old )
+            {
+                snort_free(old);
+                --s_ring->pending;
+                async_writer_stats.drops++;
+            }
+            continue;
+        }
+
+        if ( !blocked )
+        {
+            async_writer_stats.blocks++;
+            blocked = true;
+        }
+        // the writer may be waiting for room to hand records back
+        reap();
+        wake();
+        std::this_thread::yield();
+    }
+
+    async_writer_stats.records++;
+    async_writer_stats.bytes += size;
+
+    PegCount depth = s_ring->ring.count();
+
+    if ( depth > async_writer_stats.queue_max )
+        async_writer_stats.queue_max = depth;
+
+    wake();
+    return true;
+}
+
+//--------------------------------------------------------------------------
+// api
+//--------------------------------------------------------------------------
+
+void AsyncWriter::start(const SnortConfig* sc)
+{
+    if ( sc->async_output )
+        start((AsyncPolicy)sc->async_output_policy, sc->async_output_queue);
+}
+
+void AsyncWriter::start(AsyncPolicy p, unsigned queue)
+{
+    if ( writer )
+        return;
+
+    policy = p;
+    ring_size = queue;
+
+    writer_go = true;
+    writer = new std::thread(run);
+}
+
+void AsyncWriter::stop()
+{
+    if ( !writer )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        writer_go = false;
+        writer_cond.notify_one();
+    }
+
+    writer->join();
+    delete writer;
+    writer = nullptr;
+}
+
+void AsyncWriter::thread_init()
+{
+    if ( !writer )
+        return;
+
+    s_ring = new LogRing(ring_size);
+
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    rings.emplace_back(s_ring);
+}
+
+void AsyncWriter::thread_term()
+{
+    if ( !s_ring )
+        return;
+
+    sync();
+
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        rings.erase(std::find(rings.begin(), rings.end(), s_ring));
+    }
+
+    reap();
+    delete s_ring;
+    s_ring = nullptr;
+}
+
+bool AsyncWriter::active()
+{ return s_ring != nullptr; }
+
+bool AsyncWriter::write(FILE* file, const void* buf, size_t len, const void* more, size_t more_len)
+{
+    if ( !s_ring )
+        return false;
+
+    return queue(file, nullptr, buf, len, more, more_len);
+}
+
+bool AsyncWriter::write(LogFile* log, const void* buf, size_t len, const void* more, size_t more_len)
+{
+    if ( !s_ring )
+        return false;
+
+    return queue(nullptr, log, buf, len, more, more_len);
+}
+
+void AsyncWriter::sync()
+{
+    if ( !s_ring )
+        return;
+
+    while ( s_ring->pending )
+    {
+        reap();
+        wake();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
@@ -0,0 +1,90 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// async_writer.h
+
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+// AsyncWriter moves log file writes off the packet threads.  When enabled
+// with output.async, each packet thread queues copies of the bytes it would
+// have written in its own ring and a single writer thread writes and flushes
+// them.  Records from one packet thread are written in the order queued.
+// Callers must sync() before closing or rotating a file they have queued
+// writes for.  Writes to a LogFile are batched and the LogFile rotates
+// itself on the writer thread.
+
+#include <cstdio>
+
+#include "framework/counts.h"
+#include "main/snort_types.h"
+#include "main/thread.h"
+
+namespace snort
+{
+class LogFile;
+struct SnortConfig;
+
+enum AsyncPolicy
+{
+    ASYNC_BLOCK,
+    ASYNC_DROP_OLDEST,
+    ASYNC_DROP_NEWEST
+};
+
+struct AsyncWriterStats
+{
+    PegCount records;
+    PegCount bytes;
+    PegCount queue_max;
+    PegCount blocks;
+    PegCount drops;
+};
+
+extern THREAD_LOCAL AsyncWriterStats async_writer_stats;
+extern const PegInfo async_writer_pegs[];
+
+class SO_PUBLIC AsyncWriter
+{
+public:
+    // main thread
+    static void start(const SnortConfig*);
+    static void start(AsyncPolicy, unsigned queue);
+    static void stop();
+
+    // packet threads
+    static void thread_init();
+    static void thread_term();
+
+    // true if this thread's writes are queued
+    static bool active();
+
+    // queue len bytes from buf, followed by more_len bytes from more, for
+    // file; returns false if this thread is not async and the caller must
+    // write the data itself
+    static bool write(FILE*, const void* buf, size_t len,
+        const void* more = nullptr, size_t more_len = 0);
+
+    static bool write(LogFile*, const void* buf, size_t len,
+        const void* more = nullptr, size_t more_len = 0);
+
+    // wait until everything queued by this thread has been written
+    static void sync();
+};
+}
+
+#endif
@@ -0,0 +1,371 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// log_file.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "log_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include "log/messages.h"
+#include "utils/util.h"
+
+using namespace snort;
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+//--------------------------------------------------------------------------
+// io
+//--------------------------------------------------------------------------
+
+static bool pwrite_all(int fd, const struct iovec* iov, unsigned count, off_t off)
+{
+    std::vector<struct iovec> v(iov, iov + count);
+    unsigned i = 0;
+
+    while ( i < v.size() )
+    {
+        unsigned n = std::min((size_t)IOV_MAX, v.size() - i);
+        ssize_t len = pwritev(fd, &v[i], n, off);
+
+        if ( len < 0 and errno == EINTR )
+            continue;
+
+        if ( len <= 0 )
+            return false;
+
+        off += len;
+
+        while ( i < v.size() and (size_t)len >= v[i].iov_len )
+            len -= v[i++].iov_len;
+
+        if ( len )
+        {
+            v[i].iov_base = (uint8_t*)v[i].iov_base + len;
+            v[i].iov_len -= len;
+        }
+    }
+    return true;
+}
+
+#ifdef HAVE_LIBURING
+// only the writer thread uses the ring
+static struct io_uring uring;
+static bool uring_ok = false;
+static bool uring_tried = false;
+static unsigned uring_inflight = 0;
+
+static constexpr unsigned uring_depth = 64;
+
+// what is needed to finish a write the kernel cut short
+struct UringWrite
+{
+    int fd;
+    const struct iovec* iov;
+    unsigned count;
+    off_t off;
+    size_t len;
+};
+
+// the submission queue limits inflight writes and all are reaped together
+static UringWrite uring_writes[uring_depth];
+
+static bool uring_init()
+{
+    if ( !uring_tried )
+    {
+        uring_tried = true;
+        uring_ok = (io_uring_queue_init(uring_depth, &uring, 0) == 0);
+
+        if ( !uring_ok )
+            WarningMessage("io_uring is not available; log files will be written with pwritev\n");
+    }
+    return uring_ok;
+}
+
+static void uring_reap()
+{
+    if ( !uring_inflight )
+        return;
+
+    io_uring_submit_and_wait(&uring, uring_inflight);
+
+    while ( uring_inflight )
+    {
+        struct io_uring_cqe* cqe;
+
+        if ( io_uring_wait_cqe(&uring, &cqe) < 0 )
+        {
+            ErrorMessage("io_uring log write completion failed\n");
+            uring_inflight = 0;
+            break;
+        }
+
+        const UringWrite* w = (const UringWrite*)io_uring_cqe_get_data(cqe);
+        int res = cqe->res;
+
+        io_uring_cqe_seen(&uring, cqe);
+        --uring_inflight;
+
+        if ( res >= 0 and (size_t)res == w->len )
+            continue;
+
+        // write the rest, or all of it after an error, at the right offset
+        size_t done = res > 0 ? res : 0;
+        std::vector<struct iovec> rest(w->iov, w->iov + w->count);
+        unsigned i = 0;
+
+        while ( done >= rest[i].iov_len )
+            done -= rest[i++].iov_len;
+
+        rest[i].iov_base = (uint8_t*)rest[i].iov_base + done;
+        rest[i].iov_len -= done;
+
+        off_t off = w->off + (res > 0 ? res : 0);
+
+        if ( !pwrite_all(w->fd, &rest[i], rest.size() - i, off) )
+            ErrorMessage("log file write failed: %s\n", get_error(res < 0 ? -res : errno));
+    }
+}
+
+static bool uring_write(int fd, const struct iovec* iov, unsigned count, off_t off)
+{
+    if ( !uring_init() )
+        return false;
+
+    while ( count )
+    {
+        unsigned n = std::min(count, (unsigned)IOV_MAX);
+        size_t len = 0;
+
+        for ( unsigned i = 0; i < n; ++i )
+            len += iov[i].iov_len;
+
+        struct io_uring_sqe* sqe = io_uring_get_sqe(&uring);
+
+        if ( !sqe )
+        {
+            uring_reap();
+            sqe = io_uring_get_sqe(&uring);
+        }
+
+        // the iovecs must stay put until submit()
+        UringWrite* w = uring_writes + uring_inflight++;
+        *w = { fd, iov, n, off, len };
+
+        io_uring_prep_writev(sqe, fd, iov, n, off);
+        io_uring_sqe_set_data(sqe, w);
+
+        iov += n;
+        count -= n;
+        off += len;
+    }
+    return true;
+}
+#endif
+
+//--------------------------------------------------------------------------
+// log file
+//--------------------------------------------------------------------------
+
+LogFile::LogFile(const char* p, size_t max, bool ts, const uint8_t* hdr, unsigned hdr_len) :
+    path(p), header(hdr, hdr + hdr_len), limit(max), stamp(ts)
+{
+    last = time(nullptr);
+    name = make_name(last);
+    fd = create(name);
+
+    if ( fd < 0 )
+        FatalError("could not open log file %s: %s\n", name.c_str(), get_error(errno));
+
+    size = header.size();
+    prepare_next();
+}
+
+LogFile::~LogFile()
+{
+    submit();
+    finish();
+
+    if ( next_fd >= 0 )
+    {
+        close(next_fd);
+        unlink(next_name.c_str());
+    }
+}
+
+std::string LogFile::make_name(time_t t) const
+{
+    if ( !stamp )
+        return path;
+
+    return path + "." + std::to_string((uint32_t)t);
+}
+
+int LogFile::create(const std::string& file)
+{
+    int fdesc = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+
+    if ( fdesc < 0 )
+        return fdesc;
+
+#ifdef FALLOC_FL_KEEP_SIZE
+    // best effort; not all file systems support it
+    if ( limit )
+        (void)fallocate(fdesc, FALLOC_FL_KEEP_SIZE, 0, limit);
+#endif
+
+    if ( !header.empty() )
+    {
+        struct iovec iov = { header.data(), header.size() };
+
+        if ( !pwrite_all(fdesc, &iov, 1, 0) )
+            ErrorMessage("could not write header to %s: %s\n", file.c_str(), get_error(errno));
+    }
+    return fdesc;
+}
+
+void LogFile::prepare_next()
+{
+    if ( !limit )
+        return;
+
+    next_name = path + ".next";
+    next_fd = create(next_name);
+}
+
+void LogFile::finish()
+{
+    if ( fd < 0 )
+        return;
+
+    // release any preallocated space past the end
+    if ( ftruncate(fd, size) )
+        ErrorMessage("could not truncate %s: %s\n", name.c_str(), get_error(errno));
+
+    close(fd);
+    fd = -1;
+}
+
+void LogFile::rotate()
+{
+    time_t now = time(nullptr);
+
+    // don't roll over any sooner than resolution of filename discriminator
+    if ( stamp and now <= last )
+        return;
+
+    submit();
+    finish();
+
+    std::string new_name = make_name(now);
+
+    if ( next_fd >= 0 and !rename(next_name.c_str(), new_name.c_str()) )
+    {
+        fd = next_fd;
+        next_fd = -1;
+    }
+    else
+    {
+        if ( next_fd >= 0 )
+        {
+            close(next_fd);
+            unlink(next_name.c_str());
+            next_fd = -1;
+        }
+        fd = create(new_name);
+
+        if ( fd < 0 )
+            ErrorMessage("could not open log file %s: %s\n", new_name.c_str(), get_error(errno));
+    }
+
+    name = new_name;
+    last = now;
+    size = header.size();
+    ++rotations;
+
+    prepare_next();
+}
+
+void LogFile::put(const struct iovec* iov, unsigned count, size_t len)
+{
+    if ( fd < 0 )
+        return;
+
+#ifdef HAVE_LIBURING
+    if ( uring_write(fd, iov, count, size) )
+    {
+        size += len;
+        return;
+    }
+#endif
+
+    if ( !pwrite_all(fd, iov, count, size) )
+        ErrorMessage("could not write to %s: %s\n", name.c_str(), get_error(errno));
+
+    size += len;
+}
+
+void LogFile::write(const struct iovec* iov, unsigned count)
+{
+    unsigned i = 0;
+
+    while ( i < count )
+    {
+        if ( limit and size > header.size() and size + iov[i].iov_len > limit )
+            rotate();
+
+        // write as many records as fit with one call
+        size_t len = iov[i].iov_len;
+        unsigned j = i + 1;
+
+        while ( j < count and (!limit or size + len + iov[j].iov_len <= limit) )
+            len += iov[j++].iov_len;
+
+        put(iov + i, j - i, len);
+        i = j;
+    }
+}
+
+void LogFile::submit()
+{
+#ifdef HAVE_LIBURING
+    uring_reap();
+#endif
+}
+
+void LogFile::remove()
+{
+    submit();
+    finish();
+    unlink(name.c_str());
+}
@@ -0,0 +1,93 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// log_file.h
+
+#ifndef LOG_FILE_H
+#define LOG_FILE_H
+
+// LogFile is an append only log file written by the AsyncWriter thread
+// with pwritev or, when built with liburing, batched io_uring writes.  The
+// file rolls over when it reaches the size limit.  The next file is created
+// and preallocated ahead of time so rotation on the writer thread is just a
+// rename and a descriptor swap; the packet threads never wait for it.
+// Files are named <path>.<time> unless stamps are disabled.  An optional
+// header (eg for pcap) is written at the start of each file.
+
+#include <sys/uio.h>
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "main/snort_types.h"
+
+namespace snort
+{
+class SO_PUBLIC LogFile
+{
+public:
+    LogFile(const char* path, size_t limit, bool stamp,
+        const uint8_t* header = nullptr, unsigned header_len = 0);
+    ~LogFile();
+
+    bool is_open() const
+    { return fd >= 0; }
+
+    const std::string& get_name() const
+    { return name; }
+
+    unsigned get_rotations() const
+    { return rotations; }
+
+    // writer thread: write count records; rotates as needed between records
+    void write(const struct iovec*, unsigned count);
+
+    // writer thread: complete all writes started by write()
+    static void submit();
+
+    // remove the current file; used when nothing was logged
+    void remove();
+
+private:
+    std::string make_name(time_t) const;
+    int create(const std::string&);
+    void prepare_next();
+    void rotate();
+    void put(const struct iovec*, unsigned count, size_t len);
+    void finish();
+
+private:
+    std::string path;
+    std::string name;
+    std::string next_name;
+    std::vector<uint8_t> header;
+
+    size_t limit;
+    size_t size = 0;
+    time_t last = 0;
+
+    int fd = -1;
+    int next_fd = -1;
+
+    unsigned rotations = 0;
+    bool stamp;
+};
+}
+
+#endif
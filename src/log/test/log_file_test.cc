@@ -0,0 +1,306 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// log_file_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "log/async_writer.h"
+#include "log/log_file.h"
+#include "log/messages.h"
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+namespace snort
+{
+void ErrorMessage(const char*, ...) { }
+void WarningMessage(const char*, ...) { }
+[[noreturn]] void FatalError(const char*, ...) { abort(); }
+const char* get_error(int) { return ""; }
+}
+
+//--------------------------------------------------------------------------
+// helpers
+//--------------------------------------------------------------------------
+
+static std::string make_dir()
+{
+    char tmpl[] = "/tmp/log_file_test.XXXXXX";
+    const char* dir = mkdtemp(tmpl);
+    REQUIRE(dir);
+    return dir;
+}
+
+static off_t file_size(const std::string& name)
+{
+    struct stat sb;
+    return stat(name.c_str(), &sb) ? -1 : sb.st_size;
+}
+
+static void write_records(LogFile& lf, unsigned count, unsigned len)
+{
+    std::vector<uint8_t> buf(len, 'x');
+    std::vector<struct iovec> iov(count, { buf.data(), buf.size() });
+    lf.write(iov.data(), count);
+    LogFile::submit();
+}
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_CASE("log file header and size", "[LogFile]")
+{
+    std::string dir = make_dir();
+    std::string path = dir + "/log";
+    const uint8_t hdr[] = { 'H', 'D', 'R' };
+
+    {
+        LogFile lf(path.c_str(), 0, false, hdr, sizeof(hdr));
+        CHECK(lf.is_open());
+        CHECK(lf.get_name() == path);
+
+        write_records(lf, 10, 30);
+        CHECK(lf.get_rotations() == 0);
+    }
+    CHECK(file_size(path) == 303);
+
+    FILE* f = fopen(path.c_str(), "r");
+    REQUIRE(f);
+    char buf[3];
+    CHECK(fread(buf, 1, 3, f) == 3);
+    CHECK(!memcmp(buf, hdr, sizeof(hdr)));
+    fclose(f);
+
+    unlink(path.c_str());
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("log file rotation", "[LogFile]")
+{
+    std::string dir = make_dir();
+    std::string path = dir + "/log";
+    const uint8_t hdr[] = { 'H', 'D', 'R' };
+
+    {
+        // 3 records fit with the header
+        LogFile lf(path.c_str(), 100, false, hdr, sizeof(hdr));
+        CHECK(file_size(path + ".next") == 3);
+
+        write_records(lf, 10, 30);
+        CHECK(lf.get_rotations() == 3);
+    }
+    CHECK(file_size(path) == 33);
+    CHECK(file_size(path + ".next") < 0);
+
+    unlink(path.c_str());
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("log file stamp", "[LogFile]")
+{
+    std::string dir = make_dir();
+    std::string path = dir + "/log";
+    time_t now = time(nullptr);
+
+    LogFile lf(path.c_str(), 0, true);
+    std::string name = lf.get_name();
+
+    CHECK(name.compare(0, path.size() + 1, path + ".") == 0);
+    CHECK(std::stoul(name.substr(path.size() + 1)) >= (unsigned long)now);
+
+    lf.remove();
+    CHECK(file_size(name) < 0);
+
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("async log file", "[LogFile]")
+{
+    std::string dir = make_dir();
+    std::string path = dir + "/log";
+    char rec[100] = { };
+
+    AsyncWriter::start(ASYNC_BLOCK, 16);
+    AsyncWriter::thread_init();
+    CHECK(AsyncWriter::active());
+
+    {
+        LogFile lf(path.c_str(), 0, false);
+
+        for ( unsigned i = 0; i < 1000; ++i )
+            CHECK(AsyncWriter::write(&lf, rec, sizeof(rec)));
+
+        AsyncWriter::sync();
+        CHECK(file_size(path) == 100000);
+    }
+
+    AsyncWriter::thread_term();
+    AsyncWriter::stop();
+    CHECK(!AsyncWriter::active());
+    CHECK(async_writer_stats.records == 1000);
+
+    unlink(path.c_str());
+    rmdir(dir.c_str());
+}
+
+// a small queue so the writer often waits for the packet thread to take
+// back written records
+TEST_CASE("async policies", "[LogFile]")
+{
+    std::string dir = make_dir();
+    std::string path = dir + "/log";
+    const unsigned num = 20000;
+    char rec[50] = { };
+
+    for ( auto pol : { ASYNC_BLOCK, ASYNC_DROP_OLDEST, ASYNC_DROP_NEWEST } )
+    {
+        async_writer_stats = { };
+
+        AsyncWriter::start(pol, 4);
+        AsyncWriter::thread_init();
+
+        FILE* f = fopen(path.c_str(), "w");
+        REQUIRE(f);
+
+        for ( unsigned i = 0; i < num; ++i )
+            CHECK(AsyncWriter::write(f, rec, sizeof(rec) - 10, rec, 10));
+
+        AsyncWriter::sync();
+        fclose(f);
+
+        AsyncWriter::thread_term();
+        AsyncWriter::stop();
+
+        PegCount written = async_writer_stats.records;
+
+        if ( pol == ASYNC_DROP_OLDEST )
+            written -= async_writer_stats.drops;
+        else
+            CHECK(async_writer_stats.records + async_writer_stats.drops == num);
+
+        if ( pol == ASYNC_BLOCK )
+            CHECK(written == num);
+
+        CHECK(file_size(path) == (off_t)(written * sizeof(rec)));
+        unlink(path.c_str());
+    }
+    rmdir(dir.c_str());
+}
+
+//--------------------------------------------------------------------------
+// benchmark
+//--------------------------------------------------------------------------
+
+#ifdef BENCHMARK_TEST
+
+// p99 time to log one 1500 byte packet while the file is forced to roll
+// every 1 MB: stdio with rotation on the packet thread vs async log file
+static const unsigned bench_pkts = 200000;
+static const unsigned bench_len = 1500;
+static const size_t bench_limit = 1 << 20;
+
+typedef std::chrono::steady_clock Clock;
+
+static double p99(std::vector<Clock::duration>& lat)
+{
+    std::sort(lat.begin(), lat.end());
+    auto d = lat[lat.size() * 99 / 100];
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+TEST_CASE("log rotation latency", "[LogFile]")
+{
+    std::string dir = make_dir();
+    std::string path = dir + "/log";
+    std::vector<uint8_t> pkt(bench_len, 'x');
+    std::vector<Clock::duration> lat(bench_pkts);
+
+    {
+        FILE* f = fopen(path.c_str(), "w");
+        size_t size = 0;
+        unsigned n = 0;
+
+        for ( unsigned i = 0; i < bench_pkts; ++i )
+        {
+            auto start = Clock::now();
+
+            if ( size + bench_len > bench_limit )
+            {
+                fclose(f);
+                std::string roll = path + "." + std::to_string(n++);
+                rename(path.c_str(), roll.c_str());
+                unlink(roll.c_str());
+                f = fopen(path.c_str(), "w");
+                size = 0;
+            }
+            fwrite(pkt.data(), bench_len, 1, f);
+            fflush(f);
+            size += bench_len;
+
+            lat[i] = Clock::now() - start;
+        }
+        fclose(f);
+        unlink(path.c_str());
+        WARN("stdio p99 usec = " << p99(lat));
+    }
+
+    {
+        AsyncWriter::start(ASYNC_BLOCK, 4096);
+        AsyncWriter::thread_init();
+
+        // no stamps so each rotation replaces the last file
+        LogFile* lf = new LogFile(path.c_str(), bench_limit, false);
+
+        for ( unsigned i = 0; i < bench_pkts; ++i )
+        {
+            auto start = Clock::now();
+            AsyncWriter::write(lf, pkt.data(), bench_len);
+            lat[i] = Clock::now() - start;
+        }
+        AsyncWriter::sync();
+        CHECK(lf->get_rotations() > 0);
+        delete lf;
+
+        AsyncWriter::thread_term();
+        AsyncWriter::stop();
+        unlink(path.c_str());
+        WARN("async p99 usec = " << p99(lat));
+    }
+    rmdir(dir.c_str());
+}
+
+#endif
@@ -38,6 +38,7 @@
 
 #include "utils/util.h"
 
+#include "async_writer.h"
 #include "log.h"
 
 using namespace snort;
@@ -85,6 +86,9 @@ static void TextLog_Close(FILE* file)
 {
     if ( !file )
         return;
+
+    AsyncWriter::sync();
+
     if ( file != stdout )
         fclose(file);
 }
@@ -188,7 +192,10 @@ bool TextLog_Flush(TextLog* const txt)
     if ( txt->maxFile and txt->size + txt->pos > txt->maxFile )
         TextLog_Roll(txt);
 
-    ok = fwrite(txt->buf, txt->pos, 1, txt->file);
+    if ( AsyncWriter::write(txt->file, txt->buf, txt->pos) )
+        ok = 1;
+    else
+        ok = fwrite(txt->buf, txt->pos, 1, txt->file);
 
     if ( ok == 1 )
     {
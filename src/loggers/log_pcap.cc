@@ -27,6 +27,8 @@
 #include "detection/ips_context.h"
 #include "framework/logger.h"
 #include "framework/module.h"
+#include "log/async_writer.h"
+#include "log/log_file.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
 #include "packet_io/sfdaq.h"
@@ -58,6 +60,7 @@ struct LtdContext
 {
     char* file;
     pcap_dumper_t* dumpd;
+    LogFile* lfile;     // used instead of dumpd when output is async
     time_t lastTime;
     size_t size;
     int log_cnt;
@@ -125,17 +128,30 @@ static inline size_t SizeOf(const Packet* p)
 static void LogTcpdumpSingle(
     LtdConfig* data, Packet* p, const char*, Event*)
 {
+    if ( context.lfile )
+    {
+        // on disk header has 32 bit timestamps; the writer thread rotates
+        uint32_t sfhdr[PCAP_PKT_HDR_SZ / sizeof(uint32_t)] =
+        {
+            (uint32_t)p->pkth->ts.tv_sec, (uint32_t)p->pkth->ts.tv_usec,
+            p->pktlen, p->pkth->pktlen
+        };
+        AsyncWriter::write(context.lfile, sfhdr, sizeof(sfhdr), p->pkt, p->pktlen);
+        return;
+    }
+
     size_t dumpSize = SizeOf(p);
 
     if ( data->limit && (context.size + dumpSize > data->limit) )
         TcpdumpRollLogFile(data);
 
+    context.size += dumpSize;
+
     struct pcap_pkthdr pcaphdr;
     pcaphdr.ts = p->pkth->ts;
     pcaphdr.caplen = p->pktlen;
     pcaphdr.len = p->pkth->pktlen;
     pcap_dump((uint8_t*)context.dumpd, &pcaphdr, p->pkt);
-    context.size += dumpSize;
 
     if (!p->context->conf->line_buffered_logging())  // FIXIT-L misnomer
     {
@@ -150,7 +166,28 @@ static void LogTcpdumpStream(
 // (take original packet headers and append reassembled data)
 }
 
-static void TcpdumpInitLogFile(LtdConfig*, bool no_timestamp)
+static void TcpdumpInitAsyncFile(LtdConfig* data, pcap_t* pcap, bool no_timestamp)
+{
+    // capture the file header libpcap would write for each new file
+    char* hdr = nullptr;
+    size_t hdr_len = 0;
+
+    FILE* mem = open_memstream(&hdr, &hdr_len);
+    pcap_dumper_t* dumpd = mem ? pcap_dump_fopen(pcap, mem) : nullptr;
+
+    if ( !dumpd )
+        FatalError("%s: can't get pcap file header\n", S_NAME);
+
+    pcap_dump_close(dumpd);
+
+    string file;
+    get_instance_file(file, F_NAME);
+
+    context.lfile = new LogFile(file.c_str(), data->limit, !no_timestamp, (uint8_t*)hdr, hdr_len);
+    free(hdr);
+}
+
+static void TcpdumpInitLogFile(LtdConfig* data, bool no_timestamp)
 {
     string file;
     string filename = F_NAME;
@@ -180,6 +217,13 @@ static void TcpdumpInitLogFile(LtdConfig*, bool no_timestamp)
     if ( !pcap )
         FatalError("%s: can't get pcap context\n", S_NAME);
 
+    if ( AsyncWriter::active() )
+    {
+        TcpdumpInitAsyncFile(data, pcap, no_timestamp);
+        pcap_close(pcap);
+        return;
+    }
+
     context.dumpd = pcap ? pcap_dump_open(pcap, file.c_str()) : nullptr;
 
     if (context.dumpd == nullptr)
@@ -206,6 +250,7 @@ static void TcpdumpRollLogFile(LtdConfig* data)
     /* close the output file */
     if ( context.dumpd != nullptr )
     {
+        AsyncWriter::sync();
         pcap_dump_close(context.dumpd);
         context.dumpd = nullptr;
         context.size = 0;
@@ -274,10 +319,23 @@ void PcapLogger::open()
 
 void PcapLogger::close()
 {
+    if ( context.lfile )
+    {
+        AsyncWriter::sync();
+
+        if ( !context.log_cnt )
+            context.lfile->remove();
+
+        delete context.lfile;
+        context.lfile = nullptr;
+        return;
+    }
+
     SpoLogTcpdumpCleanup(nullptr);
 
     if ( context.dumpd )
     {
+        AsyncWriter::sync();
         pcap_dump_close(context.dumpd);
         context.dumpd = nullptr;
     }
@@ -287,7 +345,7 @@ void PcapLogger::close()
 
 void PcapLogger::log(Packet* p, const char* msg, Event* event)
 {
-    if(!context.dumpd)
+    if(!context.dumpd and !context.lfile)
         open();
 
     context.log_cnt++;
@@ -299,9 +357,9 @@ void PcapLogger::log(Packet* p, const char* msg, Event* event)
 
 void PcapLogger::reset()
 {
-    if(!context.dumpd)
+    if(!context.dumpd and !context.lfile)
         open();
-    else
+    else if ( context.dumpd )
         TcpdumpRollLogFile(config);
 }
 
@@ -36,6 +36,8 @@
 #include "events/event.h"
 #include "framework/logger.h"
 #include "framework/module.h"
+#include "log/async_writer.h"
+#include "log/log_file.h"
 #include "log/messages.h"
 #include "log/obfuscator.h"
 #include "log/unified2.h"
@@ -70,6 +72,7 @@ struct Unified2Config
 struct U2
 {
     FILE* stream;
+    LogFile* file;    // used instead of stream when output is async
     unsigned int current;
     int base_proto;
     uint32_t timestamp;
@@ -143,6 +146,13 @@ static void Unified2InitFile(Unified2Config* config)
 
 static inline void Unified2RotateFile(Unified2Config* config)
 {
+    // async files are rotated by the writer thread
+    if ( u2.file )
+    {
+        u2.current = 0;
+        return;
+    }
+
     fclose(u2.stream);
     u2.current = 0;
     Unified2InitFile(config);
@@ -431,6 +441,13 @@ static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config
 {
     size_t fwcount = 0;
 
+    if ( u2.file and buf )
+    {
+        AsyncWriter::write(u2.file, buf, buf_len);
+        u2.current += buf_len;
+        return;
+    }
+
     /* Nothing to write or nothing to write to */
     if ((buf == nullptr) || (config == nullptr) || (u2.stream == nullptr))
         return;
@@ -874,15 +891,26 @@ void U2Logger::open()
     u2.base_proto = htonl(SFDAQ::get_base_protocol());
 
     write_pkt_buffer = new uint8_t[u2_buf_sz];
-    io_buffer = new char[u2_buf_sz];
 
-    Unified2InitFile(&config);
+    if ( AsyncWriter::active() )
+        u2.file = new LogFile(u2.filepath, config.limit, !config.nostamp);
+    else
+    {
+        io_buffer = new char[u2_buf_sz];
+        Unified2InitFile(&config);
+    }
 
     Stream::reg_xtra_data_log(AlertExtraData, &config);
 }
 
 void U2Logger::close()
 {
+    if ( u2.file )
+    {
+        AsyncWriter::sync();
+        delete u2.file;
+        u2.file = nullptr;
+    }
     if ( u2.stream )
         fclose(u2.stream);
 
@@ -45,6 +45,7 @@
 #include "managers/inspector_manager.h"
 #include "managers/module_manager.h"
 #include "managers/plugin_manager.h"
+#include "packet_io/flow_shard.h"
 #include "packet_io/sfdaq.h"
 #include "packet_io/sfdaq_config.h"
 #include "packet_io/sfdaq_instance.h"
@@ -1082,11 +1083,15 @@ static void main_loop()
             }
         }
 
-        if ( !exit_requested and (swine < max_pigs) and (src = Trough::get_next()) )
+        unsigned shard;
+        if ( !exit_requested and (swine < max_pigs) and (src = Trough::get_next(shard)) )
         {
             Pig* pig = get_lazy_pig(max_pigs);
             if (pig->prep(src))
                 ++swine;
+            // nobody will take this thread's share of the file
+            else if ( Trough::get_shard_count() > 1 )
+                FlowShard::skip(shard);
             continue;
         }
         service_check();
@@ -33,6 +33,7 @@
 #include "detection/detection_engine.h"
 #include "detection/ips_context.h"
 #include "detection/tag.h"
+#include "decompress/decomp_pool.h"
 #include "file_api/file_service.h"
 #include "filters/detection_filter.h"
 #include "filters/rate_filter.h"
@@ -43,6 +44,7 @@
 #include "framework/data_bus.h"
 #include "latency/packet_latency.h"
 #include "latency/rule_latency.h"
+#include "log/async_writer.h"
 #include "log/messages.h"
 #include "main/swapper.h"
 #include "main.h"
@@ -51,12 +53,17 @@
 #include "managers/ips_manager.h"
 #include "managers/event_manager.h"
 #include "managers/module_manager.h"
+#include "memory/huge_page_pool.h"
 #include "memory/memory_cap.h"
+#include "memory/memory_config.h"
 #include "packet_io/active.h"
+#include "packet_io/batch_prefetch.h"
+#include "packet_io/pcap_readahead.h"
 #include "packet_io/sfdaq.h"
 #include "packet_io/sfdaq_config.h"
 #include "packet_io/sfdaq_instance.h"
 #include "packet_io/sfdaq_module.h"
+#include "packet_io/trough.h"
 #include "packet_tracer/packet_tracer.h"
 #include "profiler/profiler.h"
 #include "pub_sub/daq_message_event.h"
@@ -65,6 +72,7 @@
 #include "stream/stream.h"
 #include "target_based/host_attributes.h"
 #include "time/packet_time.h"
+#include "time/timer_wheel.h"
 #include "trace/trace_api.h"
 #include "utils/stats.h"
 
@@ -583,13 +591,16 @@ void Analyzer::init_unprivileged()
     const unsigned max_contexts = 255;
 #endif
 
+    // context buffers and the encode buffer are carved from one per thread pool
+    const SnortConfig* sc = SnortConfig::get_conf();
+    memory::HugePagePool::thread_init(sc->memory->huge_pages,
+        (max_contexts + 1) * (IpsContext::buf_size + 64) + Codec::PKT_MAX);
+
     switcher = new ContextSwitcher;
 
     for ( unsigned i = 0; i < max_contexts; ++i )
         switcher->push(new IpsContext);
 
-    const SnortConfig* sc = SnortConfig::get_conf();
-
     // This should be called as soon as possible
     // to handle all trace log messages
     TraceApi::thread_init(sc->trace_config);
@@ -603,6 +614,7 @@ void Analyzer::init_unprivileged()
     InitTag();
     EventTrace_Init();
 
+    AsyncWriter::thread_init();
     EventManager::open_outputs();
     IpsManager::setup_options(sc);
     ActionManager::thread_init(sc);
@@ -654,11 +666,18 @@ void Analyzer::term()
     DetectionEngine::idle();
     InspectorManager::thread_stop(sc);
     InspectorManager::thread_term();
+    DecompPool::thread_term();
+    TimerWheel::thread_term();
+
+    if ( readahead )
+        daq_stats.pcap_bytes += readahead->get_bytes_read();
+
     ModuleManager::accumulate();
     ActionManager::thread_term();
 
     IpsManager::clear_options(sc);
     EventManager::close_outputs();
+    AsyncWriter::thread_term();
     CodecManager::thread_term();
     HighAvailabilityManager::thread_term();
     SideChannelManager::thread_term();
@@ -682,6 +701,7 @@ void Analyzer::term()
 
     Active::thread_term();
     delete switcher;
+    memory::HugePagePool::thread_term();
 
     sfthreshold_free();
     RateFilter_Cleanup();
@@ -707,6 +727,8 @@ Analyzer::~Analyzer()
     delete daq_instance;
     delete oops_handler;
     delete retry_queue;
+    delete batch_prefetch;
+    delete readahead;
 }
 
 void Analyzer::operator()(Swapper* ps, uint16_t run_num)
@@ -731,7 +753,31 @@ void Analyzer::operator()(Swapper* ps, uint16_t run_num)
     SnortConfig::get_conf()->thread_config->implement_thread_affinity(
         STHREAD_TYPE_PACKET, get_instance_id());
 
+    // Everything this thread allocates from here on should come from its local node.
+    if (SnortConfig::get_conf()->memory->numa_local)
+    {
+        ThreadConfig* tc = SnortConfig::get_conf()->thread_config;
+        int node = tc->get_numa_node(STHREAD_TYPE_PACKET, get_instance_id());
+        tc->implement_numa_membind(node);
+        memory::MemoryCap::thread_init(node);
+    }
+
     SFDAQ::set_local_instance(daq_instance);
+
+    const SFDAQConfig* dc = SnortConfig::get_conf()->daq_config;
+
+    if ( dc->batch_adaptive )
+    {
+        adaptive_batch = true;
+        batch_sizer.configure(dc->batch_min, daq_instance->get_batch_size(), dc->batch_latency);
+    }
+    if ( dc->batch_prefetch )
+        batch_prefetch = new BatchPrefetch(daq_instance->get_batch_size(), daq_instance->get_base_protocol());
+
+    // with --pcap-shard the file is read by FlowShard, not this thread's DAQ
+    if ( dc->pcap_readahead and SnortConfig::get_conf()->read_mode() and source != "-" and
+        Trough::get_shard_count() == 1 )
+        readahead = new PcapReadahead(source.c_str(), (size_t)dc->pcap_readahead << 20);
     set_state(State::INITIALIZED);
 
     Profiler::start();
@@ -826,11 +872,29 @@ void Analyzer::handle_uncompleted_commands()
     }
 }
 
+void Analyzer::update_batch_size(unsigned want, unsigned got, hr_duration elapsed)
+{
+    // the distribution is of what was received; empty receives are idle
+    if (got >= 128)
+        daq_stats.batch_dist[4]++;
+    else if (got >= 32)
+        daq_stats.batch_dist[3]++;
+    else if (got >= 8)
+        daq_stats.batch_dist[2]++;
+    else if (got >= 2)
+        daq_stats.batch_dist[1]++;
+    else if (got)
+        daq_stats.batch_dist[0]++;
+
+    batch_sizer.update(want, got, clock_usecs(TO_USECS(elapsed)));
+    daq_stats.batch_size = batch_sizer.get();
+}
+
 DAQ_RecvStatus Analyzer::process_messages()
 {
     // Max receive becomes the minimum of the configured batch size, the remaining exit_after
     // count (if requested), and the remaining pause_after count (if requested).
-    unsigned max_recv = daq_instance->get_batch_size();
+    unsigned max_recv = adaptive_batch ? batch_sizer.get() : daq_instance->get_batch_size();
     if (exit_after_cnt && exit_after_cnt < max_recv)
         max_recv = exit_after_cnt;
     if (pause_after_cnt && pause_after_cnt < max_recv)
@@ -842,14 +906,31 @@ DAQ_RecvStatus Analyzer::process_messages()
         rstat = daq_instance->receive_messages(max_recv);
     }
 
+    hr_time start = adaptive_batch ? SnortClock::now() : hr_time();
+
     // Preemptively service available onloads to potentially unblock processing the first message.
     // This conveniently handles servicing offloads in the no messages received case as well.
     DetectionEngine::onload();
 
+    // Size the batch by what the DAQ returned, not by what this thread processed below.
+    unsigned num;
+    const DAQ_Msg_h* msgs = daq_instance->get_batch(num);
+
+    if (batch_prefetch)
+        batch_prefetch->load(msgs, num);
+
+    if (readahead)
+        readahead->update(msgs, num);
+
     unsigned num_recv = 0;
+    unsigned idx = 0;
     DAQ_Msg_h msg;
     while ((msg = daq_instance->next_message()) != nullptr)
     {
+        // Warm the flow for the next message while this one is processed.
+        if (batch_prefetch)
+            batch_prefetch->touch(++idx);
+
         // Dispose of any messages to be skipped first.
         if (skip_cnt > 0)
         {
@@ -868,6 +949,9 @@ DAQ_RecvStatus Analyzer::process_messages()
         handle_uncompleted_commands();
     }
 
+    if (adaptive_batch)
+        update_batch_size(max_recv, num, SnortClock::now() - start);
+
     if (exit_after_cnt && (exit_after_cnt -= num_recv) == 0)
         stop();
     if (pause_after_cnt && (pause_after_cnt -= num_recv) == 0)
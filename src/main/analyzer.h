@@ -33,10 +33,14 @@
 #include <string>
 
 #include "main/snort_types.h"
+#include "packet_io/batch_sizer.h"
+#include "time/clock_defs.h"
 #include "thread.h"
 
+class BatchPrefetch;
 class ContextSwitcher;
 class OopsHandler;
+class PcapReadahead;
 class RetryQueue;
 class Swapper;
 
@@ -119,6 +123,7 @@ private:
     void handle_commands();
     void handle_uncompleted_commands();
     DAQ_RecvStatus process_messages();
+    void update_batch_size(unsigned want, unsigned got, hr_duration);
     void process_daq_msg(DAQ_Msg_h, bool retry);
     void process_daq_pkt_msg(DAQ_Msg_h, bool retry);
     void post_process_daq_pkt_msg(snort::Packet*);
@@ -142,11 +147,15 @@ private:
     unsigned id;
     bool exit_requested = false;
     bool idling = false;
+    bool adaptive_batch = false;
     uint64_t exit_after_cnt;
     uint64_t pause_after_cnt = 0;
     uint64_t skip_cnt = 0;
     std::string source;
     snort::SFDAQInstance* daq_instance;
+    BatchSizer batch_sizer;
+    BatchPrefetch* batch_prefetch = nullptr;
+    PcapReadahead* readahead = nullptr;
     RetryQueue* retry_queue = nullptr;
     OopsHandler* oops_handler = nullptr;
     ContextSwitcher* switcher = nullptr;
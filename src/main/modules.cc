@@ -43,6 +43,7 @@
 #include "host_tracker/host_tracker_module.h"
 #include "host_tracker/host_cache_module.h"
 #include "latency/latency_module.h"
+#include "log/async_writer.h"
 #include "log/messages.h"
 #include "managers/module_manager.h"
 #include "managers/plugin_manager.h"
@@ -157,6 +158,10 @@ static const Parameter search_engine_params[] =
     { "bleedover_warnings_enabled", Parameter::PT_BOOL, nullptr, "false",
       "print warning if a rule is demoted to any-any port group" },
 
+    { "build_threads", Parameter::PT_INT, "0:max32", "0",
+      "threads compiling search engines that support it (ac_bnfa, ac_full, hyperscan); "
+      "0 is one per packet thread on startup and one on reload" },
+
     { "enable_single_rule_group", Parameter::PT_BOOL, nullptr, "false",
       "put all rules into one group" },
 
@@ -193,6 +198,9 @@ static const Parameter search_engine_params[] =
     { "rule_db_dir", Parameter::PT_STRING, nullptr, nullptr,
       "deserialize rule databases from given directory" },
 
+    { "mpse_cache_dir", Parameter::PT_STRING, nullptr, nullptr,
+      "load compiled search engines from and add new ones to given directory" },
+
     { "show_fast_patterns", Parameter::PT_BOOL, nullptr, "false",
       "print fast pattern info for each rule" },
 
@@ -254,6 +262,9 @@ bool SearchEngineModule::set(const char*, Value& v, SnortConfig* sc)
         if ( v.get_bool() )
             fp->set_bleed_over_warnings();  // FIXIT-L these should take arg
     }
+    else if ( v.is("build_threads") )
+        fp->set_build_threads(v.get_uint32());
+
     else if ( v.is("enable_single_rule_group") )
     {
         if ( v.get_bool() )
@@ -296,6 +307,9 @@ bool SearchEngineModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("rule_db_dir") )
         fp->set_rule_db_dir(v.get_string());
 
+    else if ( v.is("mpse_cache_dir") )
+        fp->set_mpse_cache_dir(v.get_string());
+
     else if ( v.is("search_method") )
     {
         if ( !fp->set_search_method(v.get_string()) )
@@ -697,6 +711,15 @@ static const Parameter output_event_trace_params[] =
 
 static const Parameter output_params[] =
 {
+    { "async", Parameter::PT_BOOL, nullptr, "false",
+      "write log files from a separate thread instead of the packet threads" },
+
+    { "async_policy", Parameter::PT_ENUM, "block | drop_oldest | drop_newest", "block",
+      "what to do with a new log record when a packet thread's async queue is full" },
+
+    { "async_queue", Parameter::PT_INT, "2:max32", "4096",
+      "maximum log records each packet thread may queue for the async writer" },
+
     { "dump_chars_only", Parameter::PT_BOOL, nullptr, "false",
       "turns on character dumps (same as -C)" },
 
@@ -752,6 +775,12 @@ public:
     OutputModule() : Module("output", output_help, output_params) { }
     bool set(const char*, Value&, SnortConfig*) override;
 
+    const PegInfo* get_pegs() const override
+    { return async_writer_pegs; }
+
+    PegCount* get_counts() const override
+    { return (PegCount*)&async_writer_stats; }
+
     Usage get_usage() const override
     { return GLOBAL; }
 
@@ -764,7 +793,16 @@ public:
 
 bool OutputModule::set(const char*, Value& v, SnortConfig* sc)
 {
-    if ( v.is("dump_chars_only") )
+    if ( v.is("async") )
+        sc->async_output = v.get_bool();
+
+    else if ( v.is("async_policy") )
+        sc->async_output_policy = v.get_uint8();
+
+    else if ( v.is("async_queue") )
+        sc->async_output_queue = v.get_uint32();
+
+    else if ( v.is("dump_chars_only") )
         v.update_mask(sc->output_flags, OUTPUT_FLAG__CHAR_DATA);
 
     else if ( v.is("dump_payload") )
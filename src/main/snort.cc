@@ -41,6 +41,7 @@
 #include "helpers/process.h"
 #include "host_tracker/host_cache.h"
 #include "ips_options/ips_options.h"
+#include "log/async_writer.h"
 #include "log/log.h"
 #include "log/messages.h"
 #include "loggers/loggers.h"
@@ -73,6 +74,7 @@
 #include "trace/trace_api.h"
 #include "trace/trace_config.h"
 #include "trace/trace_logger.h"
+#include "utils/stats.h"
 #include "utils/util.h"
 
 #ifdef PIGLET
@@ -154,7 +156,11 @@ void Snort::init(int argc, char** argv)
     FileService::init();
 
     parser_init();
-    SnortConfig* sc = ParseSnortConf(snort_cmd_line_conf);
+    SnortConfig* sc;
+    {
+        BuildTimer t("config parse");
+        sc = ParseSnortConf(snort_cmd_line_conf);
+    }
 
     /* Set the global snort_conf that will be used during run time */
     SnortConfig::set_conf(sc);
@@ -428,6 +434,7 @@ void Snort::setup(int argc, char* argv[])
 
     host_cache.print_config();
 
+    AsyncWriter::start(sc);
     TimeStart();
 }
 
@@ -437,6 +444,7 @@ void Snort::cleanup()
 
     SFDAQ::term();
     FileService::close();
+    AsyncWriter::stop();
 
     if ( !SnortConfig::get_conf()->test_mode() )  // FIXIT-M ideally the check is in one place
         PrintStatistics();
@@ -465,7 +473,11 @@ SnortConfig* Snort::get_reload_config(const char* fname, const char* plugin_path
     trim_heap();
 
     parser_init();
-    SnortConfig* sc = ParseSnortConf(snort_cmd_line_conf, fname);
+    SnortConfig* sc;
+    {
+        BuildTimer t("config parse");
+        sc = ParseSnortConf(snort_cmd_line_conf, fname);
+    }
 
     if ( get_parse_errors() || ModuleManager::get_errors() || !sc->verify() )
     {
@@ -68,6 +68,7 @@
 #include "target_based/snort_protocols.h"
 #include "trace/trace_config.h"
 #include "utils/dnet_header.h"
+#include "utils/stats.h"
 #include "utils/util.h"
 #include "utils/util_cstring.h"
 
@@ -301,21 +302,25 @@ void SnortConfig::setup()
         thiszone = gmt2local(0);
 
     init_policies(this);
-    ParseRules(this);
 
-    // Allocate evalOrder before calling the OrderRuleLists
-    evalOrder = new int[Actions::get_max_types()]();
+    {
+        BuildTimer t("rule parse");
+        ParseRules(this);
 
-    OrderRuleLists(this);
+        // Allocate evalOrder before calling the OrderRuleLists
+        evalOrder = new int[Actions::get_max_types()]();
 
-    if ( rule_states )
-    {
-        rule_states->apply(this);
-        delete rule_states;
-        rule_states = nullptr;
-    }
+        OrderRuleLists(this);
 
-    ParseRulesFinish(this);
+        if ( rule_states )
+        {
+            rule_states->apply(this);
+            delete rule_states;
+            rule_states = nullptr;
+        }
+
+        ParseRulesFinish(this);
+    }
     ShowPolicyStats(this);
 
     /* Need to do this after dynamic detection stuff is initialized, too */
@@ -323,6 +328,7 @@ void SnortConfig::setup()
     ModuleManager::load_commands(policy_map->get_shell());
 
     fpCreateFastPacketDetection(this);
+    LogBuildTimes();
 }
 
 void SnortConfig::post_setup()
@@ -471,7 +477,7 @@ void SnortConfig::merge(const SnortConfig* cmd_line_conf)
 
     // Initialize the slotted state memory for threads
     assert(!state);
-    num_slots = offload_threads + ThreadConfig::get_instance_max();
+    num_slots = (offload_pool ? offload_pool : offload_threads) + ThreadConfig::get_instance_max();
     state = new std::vector<void*>[num_slots];
 }
 
@@ -206,6 +206,10 @@ public:
     uint32_t tagged_packet_limit = 256;
     uint16_t event_trace_max = 0;
 
+    bool async_output = false;
+    uint8_t async_output_policy = 0;     // AsyncPolicy
+    uint32_t async_output_queue = 4096;  // records per packet thread
+
     std::string log_dir;
 
     //------------------------------------------------------
@@ -227,6 +231,9 @@ public:
 
     unsigned offload_limit = 99999;  // disabled
     unsigned offload_threads = 0;    // disabled
+    unsigned offload_pool = 0;       // disabled
+    unsigned mpse_batch_size = 0;    // disabled
+    unsigned mpse_batch_latency = 1000;  // usec
 
     bool hyperscan_literals = false;
     bool pcre_to_regex = false;
@@ -513,6 +513,9 @@ static const Parameter s_params[] =
     { "--pcap-no-filter", Parameter::PT_IMPLIED, nullptr, nullptr,
       "reset to use no filter when getting pcaps from file or directory" },
 
+    { "--pcap-shard", Parameter::PT_IMPLIED, nullptr, nullptr,
+      "split each pcap across all packet threads by flow instead of reading whole pcaps per thread" },
+
     { "--pcap-show", Parameter::PT_IMPLIED, nullptr, nullptr,
       "print a line saying what pcap is currently being read" },
 
@@ -1084,6 +1087,9 @@ bool SnortModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( is(v, "--pcap-no-filter") )
         Trough::set_filter(nullptr);
 
+    else if ( is(v, "--pcap-shard") )
+        Trough::set_sharding(true);
+
     else if ( is(v, "--pcap-show") )
         sc->run_flags |= RUN_FLAG__PCAP_SHOW;
 
@@ -1192,8 +1198,9 @@ bool SnortModule::end(const char*, int, SnortConfig* sc)
 {
     cli_mode = false;
 
-    if ( sc->offload_threads and ThreadConfig::get_instance_max() != 1 )
-        ParseError("You can not enable experimental offload with more than one packet thread.");
+    if ( sc->offload_threads and !sc->offload_pool and ThreadConfig::get_instance_max() != 1 )
+        ParseError("You can not enable experimental offload with more than one packet thread "
+            "unless offload_pool is set.");
 
     if ( no_warn_flowbits )
     {
@@ -240,6 +240,74 @@ void ThreadConfig::implement_named_thread_affinity(const string& name)
         implement_thread_affinity(get_thread_type(), DEFAULT_THREAD_ID);
 }
 
+int ThreadConfig::get_numa_node(SThreadType type, unsigned id) const
+{
+    if ( !topology )
+        return -1;
+
+    TypeIdPair key { type, id };
+    auto iter = thread_affinity.find(key);
+
+    if ( iter == thread_affinity.end() )
+        return -1;
+
+    int num = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_NUMANODE);
+
+    if ( num < 2 )
+        return -1;
+
+    for ( int i = 0; i < num; ++i )
+    {
+        hwloc_obj_t node = hwloc_get_obj_by_type(topology, HWLOC_OBJ_NUMANODE, i);
+
+        if ( node and hwloc_bitmap_intersects(node->cpuset, iter->second->cpuset) )
+            return i;
+    }
+    return -1;
+}
+
+void ThreadConfig::implement_numa_affinity(int node)
+{
+    if ( node < 0 or !topology_support->cpubind->set_thisthread_cpubind )
+        return;
+
+    hwloc_obj_t obj = hwloc_get_obj_by_type(topology, HWLOC_OBJ_NUMANODE, node);
+
+    if ( !obj )
+        return;
+
+    hwloc_cpuset_t desired_cpuset = hwloc_bitmap_alloc();
+    hwloc_bitmap_and(desired_cpuset, obj->cpuset, process_cpuset);
+
+    if ( !hwloc_bitmap_iszero(desired_cpuset) and
+        hwloc_set_cpubind(topology, desired_cpuset, HWLOC_CPUBIND_THREAD) )
+    {
+        WarningMessage("Failed to bind thread to NUMA node %d: %s (%d)\n",
+            node, get_error(errno), errno);
+    }
+
+    hwloc_bitmap_free(desired_cpuset);
+}
+
+void ThreadConfig::implement_numa_membind(int node)
+{
+    if ( node < 0 or !topology_support->membind->set_thisthread_membind )
+        return;
+
+    hwloc_obj_t obj = hwloc_get_obj_by_type(topology, HWLOC_OBJ_NUMANODE, node);
+
+    if ( !obj )
+        return;
+
+    // not strict so this is preferred rather than required
+    if ( hwloc_set_membind(topology, obj->nodeset, HWLOC_MEMBIND_BIND,
+        HWLOC_MEMBIND_THREAD | HWLOC_MEMBIND_BYNODESET) )
+    {
+        WarningMessage("Failed to bind thread memory to NUMA node %d: %s (%d)\n",
+            node, get_error(errno), errno);
+    }
+}
+
 // watchdog stuff
 struct Watchdog
 {
@@ -368,6 +436,15 @@ TEST_CASE("Set and implement thread affinity", "[ThreadConfig]")
     }
 }
 
+TEST_CASE("NUMA node of unbound thread", "[ThreadConfig]")
+{
+    ThreadConfig tc;
+    CHECK(tc.get_numa_node(STHREAD_TYPE_PACKET, 0) == -1);
+
+    // harmless when there is no node
+    tc.implement_numa_affinity(-1);
+}
+
 TEST_CASE("Named thread affinity configured", "[ThreadConfig]")
 {
     if (topology_support->cpubind->set_thisthread_cpubind)
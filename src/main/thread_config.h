@@ -46,6 +46,12 @@ public:
     void implement_thread_affinity(SThreadType, unsigned id);
     void implement_named_thread_affinity(const std::string& name);
 
+    // NUMA node of the cpus bound to the given thread or -1 if the thread is
+    // not bound or there is only one node
+    int get_numa_node(SThreadType, unsigned id) const;
+    void implement_numa_affinity(int node);
+    void implement_numa_membind(int node);
+
     static constexpr unsigned int DEFAULT_THREAD_ID = 0;
 
 private:
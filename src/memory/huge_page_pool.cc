@@ -0,0 +1,197 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// huge_page_pool.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "huge_page_pool.h"
+
+#include <sys/mman.h>
+
+#include <cassert>
+
+#include "log/messages.h"
+#include "main/thread.h"
+
+#include "memory_cap.h"
+
+using namespace snort;
+
+namespace memory
+{
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define POOL_ALIGN 64
+
+struct Pool
+{
+    void* map = nullptr;
+    size_t map_size = 0;
+    uint8_t* base = nullptr;
+    size_t size = 0;
+    size_t used = 0;
+    MemoryConfig::HugePages mode = MemoryConfig::HUGE_OFF;
+};
+
+static THREAD_LOCAL Pool* pool = nullptr;
+
+static const char* mode_name(MemoryConfig::HugePages m)
+{
+    switch ( m )
+    {
+    case MemoryConfig::HUGE_EXPLICIT:
+        return "explicit";
+    case MemoryConfig::HUGE_TRANSPARENT:
+        return "transparent";
+    default:
+        break;
+    }
+    return "off";
+}
+
+static bool map_explicit(Pool& p, size_t size)
+{
+#ifdef MAP_HUGETLB
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_2MB
+    flags |= MAP_HUGE_2MB;
+#endif
+    // fails here rather than at fault time if the hugetlbfs pool is short
+    void* m = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+
+    if ( m == MAP_FAILED )
+        return false;
+
+    p.map = m;
+    p.map_size = p.size = size;
+    p.base = (uint8_t*)m;
+    p.mode = MemoryConfig::HUGE_EXPLICIT;
+    return true;
+#else
+    UNUSED(p);
+    UNUSED(size);
+    return false;
+#endif
+}
+
+// over map by a page so the pool can start on a huge page boundary; if
+// the kernel refuses the advice the pool just uses regular pages
+static bool map_transparent(Pool& p, size_t size)
+{
+    size_t map_size = size + HUGE_PAGE_SIZE;
+    void* m = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if ( m == MAP_FAILED )
+        return false;
+
+    uintptr_t start = ((uintptr_t)m + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+
+    p.map = m;
+    p.map_size = map_size;
+    p.base = (uint8_t*)start;
+    p.size = size;
+
+#ifdef MADV_HUGEPAGE
+    if ( !madvise(p.base, size, MADV_HUGEPAGE) )
+        p.mode = MemoryConfig::HUGE_TRANSPARENT;
+#endif
+
+    return true;
+}
+
+void HugePagePool::thread_init(MemoryConfig::HugePages mode, size_t size)
+{
+    assert(!pool);
+
+    if ( mode == MemoryConfig::HUGE_OFF or !size )
+        return;
+
+    size = (size + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+    Pool* p = new Pool;
+
+    if ( (mode != MemoryConfig::HUGE_EXPLICIT or !map_explicit(*p, size)) and
+        !map_transparent(*p, size) )
+    {
+        WarningMessage("memory: packet thread %u could not reserve %zu MB for buffers\n",
+            get_instance_id(), size >> 20);
+        delete p;
+        return;
+    }
+
+    pool = p;
+
+    if ( p->mode == mode )
+        LogMessage("memory: packet thread %u reserved %zu MB of %s huge pages\n",
+            get_instance_id(), size >> 20, mode_name(p->mode));
+
+    else if ( p->mode == MemoryConfig::HUGE_OFF )
+        WarningMessage("memory: packet thread %u reserved %zu MB of regular pages, "
+            "%s huge pages are not available\n", get_instance_id(), size >> 20, mode_name(mode));
+
+    else
+        WarningMessage("memory: packet thread %u reserved %zu MB of %s huge pages, "
+            "%s huge pages are not available\n", get_instance_id(), size >> 20,
+            mode_name(p->mode), mode_name(mode));
+
+    if ( p->mode != MemoryConfig::HUGE_OFF )
+        MemoryCap::get_mem_stats().huge_page_bytes = size;
+}
+
+void HugePagePool::thread_term()
+{
+    if ( !pool )
+        return;
+
+    munmap(pool->map, pool->map_size);
+    delete pool;
+    pool = nullptr;
+}
+
+uint8_t* HugePagePool::alloc(size_t n)
+{
+    if ( pool )
+    {
+        size_t used = (pool->used + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1);
+
+        if ( used + n <= pool->size )
+        {
+            pool->used = used + n;
+            return pool->base + used;
+        }
+    }
+    return new uint8_t[n];
+}
+
+void HugePagePool::dealloc(uint8_t* p)
+{
+    if ( pool and p >= pool->base and p < pool->base + pool->size )
+        return;
+
+    delete[] p;
+}
+
+MemoryConfig::HugePages HugePagePool::get_mode()
+{ return pool ? pool->mode : MemoryConfig::HUGE_OFF; }
+
+size_t HugePagePool::get_size()
+{ return pool ? pool->size : 0; }
+
+} // namespace memory
+
@@ -0,0 +1,57 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// huge_page_pool.h
+
+#ifndef HUGE_PAGE_POOL_H
+#define HUGE_PAGE_POOL_H
+
+// per packet thread pool for long lived buffers such as the ips context
+// and encode buffers.  the pool is one mapping which may be backed by 2MB
+// pages to reduce dTLB misses.  buffers are never returned to the pool;
+// the whole mapping is released at thread term.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "memory_config.h"
+
+namespace memory
+{
+
+class HugePagePool
+{
+public:
+    // reserve at least size bytes; falls back to transparent and then to
+    // regular pages if the requested mode is not available
+    static void thread_init(MemoryConfig::HugePages, size_t size);
+
+    // must be called after all pool buffers are released
+    static void thread_term();
+
+    // returns heap memory if there is no pool or it is exhausted
+    static uint8_t* alloc(size_t);
+    static void dealloc(uint8_t*);
+
+    static MemoryConfig::HugePages get_mode();
+    static size_t get_size();
+};
+
+} // namespace memory
+
+#endif
+
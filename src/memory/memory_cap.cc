@@ -25,6 +25,13 @@
 #include <malloc.h>
 #include <sys/resource.h>
 
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
 #include <cassert>
 #include <vector>
 
@@ -121,6 +128,197 @@ inline void free_space(size_t cap, Handler& handler)
 inline size_t calculate_threshold(size_t cap, size_t threshold)
 { return cap * threshold / 100; }
 
+// -----------------------------------------------------------------------------
+// numa
+//
+// with jemalloc each packet thread gets its own arena.  the arena's extent
+// hooks wrap the defaults, set a preferred policy for the thread's node on
+// each new extent, and keep track of the extents so the pages can be
+// sampled for the local and remote pegs.  arenas are kept for the life of
+// the process since memory may be freed into them after the thread exits.
+// -----------------------------------------------------------------------------
+
+#if defined(HAVE_JEMALLOC) && defined(__linux__)
+
+static const unsigned max_numa_nodes = 1024;
+static const unsigned max_extents = 4096;
+static const unsigned samples_per_extent = 16;
+
+struct Extent
+{
+    void* addr;
+    size_t size;
+};
+
+struct NumaArena
+{
+    extent_hooks_t hooks;  // must be first
+    extent_hooks_t* base;
+    unsigned index;
+    int node;
+
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    unsigned num = 0;
+    Extent extents[max_extents];
+
+    void acquire()
+    { while ( lock.test_and_set(std::memory_order_acquire) ); }
+
+    void release()
+    { lock.clear(std::memory_order_release); }
+};
+
+static std::vector<NumaArena*> numa_arenas;
+static THREAD_LOCAL NumaArena* numa_arena = nullptr;
+
+static void bind_extent(void* addr, size_t size, int node)
+{
+    unsigned long mask[max_numa_nodes / (8 * sizeof(unsigned long))] = { };
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+
+    // advisory; the default policy still applies if this fails
+    syscall(SYS_mbind, addr, size, MPOL_PREFERRED, mask, max_numa_nodes + 1, 0);
+}
+
+static void* numa_alloc(
+    extent_hooks_t* h, void* addr, size_t size, size_t align, bool* zero, bool* commit,
+    unsigned ind)
+{
+    NumaArena* a = (NumaArena*)h;
+    void* p = a->base->alloc(a->base, addr, size, align, zero, commit, ind);
+
+    if ( !p )
+        return nullptr;
+
+    bind_extent(p, size, a->node);
+
+    a->acquire();
+
+    if ( a->num < max_extents )
+        a->extents[a->num++] = { p, size };
+
+    a->release();
+    return p;
+}
+
+static void untrack(NumaArena* a, void* addr)
+{
+    a->acquire();
+
+    for ( unsigned i = 0; i < a->num; ++i )
+    {
+        if ( a->extents[i].addr == addr )
+        {
+            a->extents[i] = a->extents[--a->num];
+            break;
+        }
+    }
+    a->release();
+}
+
+static bool numa_dalloc(extent_hooks_t* h, void* addr, size_t size, bool committed, unsigned ind)
+{
+    NumaArena* a = (NumaArena*)h;
+
+    // true means jemalloc retains the extent for reuse
+    if ( a->base->dalloc and !a->base->dalloc(a->base, addr, size, committed, ind) )
+    {
+        untrack(a, addr);
+        return false;
+    }
+    return true;
+}
+
+static void numa_destroy(extent_hooks_t* h, void* addr, size_t size, bool committed, unsigned ind)
+{
+    NumaArena* a = (NumaArena*)h;
+    untrack(a, addr);
+
+    if ( a->base->destroy )
+        a->base->destroy(a->base, addr, size, committed, ind);
+}
+
+static NumaArena* create_numa_arena(int node)
+{
+    extent_hooks_t* base = nullptr;
+    size_t sz = sizeof(base);
+
+    // __STRDUMP_DISABLE__
+    if ( mallctl("arena.0.extent_hooks", (void*)&base, &sz, nullptr, 0) or !base )
+        return nullptr;
+
+    NumaArena* a = new NumaArena;
+    a->hooks = *base;
+    a->hooks.alloc = numa_alloc;
+    a->hooks.dalloc = numa_dalloc;
+    a->hooks.destroy = numa_destroy;
+    a->base = base;
+    a->node = node;
+
+    extent_hooks_t* hooks = &a->hooks;
+    sz = sizeof(a->index);
+
+    if ( mallctl("arenas.create", (void*)&a->index, &sz, (void*)&hooks, sizeof(hooks)) )
+    {
+        delete a;
+        return nullptr;
+    }
+    // __STRDUMP_ENABLE__
+
+    return a;
+}
+
+static void sample_numa_pages(NumaArena* a, MemoryCounts& mc)
+{
+    std::vector<Extent> snap;
+    snap.reserve(max_extents);
+
+    // no allocations while locked since the hooks take the lock
+    a->acquire();
+    snap.assign(a->extents, a->extents + a->num);
+    a->release();
+
+    const size_t page = sysconf(_SC_PAGESIZE);
+    std::vector<void*> pages;
+    std::vector<size_t> weights;
+
+    for ( const auto& e : snap )
+    {
+        unsigned n = e.size / page;
+
+        if ( n > samples_per_extent )
+            n = samples_per_extent;
+        else if ( !n )
+            n = 1;
+
+        size_t stride = e.size / n;
+
+        for ( unsigned i = 0; i < n; ++i )
+        {
+            pages.emplace_back((char*)e.addr + ((i * stride) & ~(page - 1)));
+            weights.emplace_back(stride);
+        }
+    }
+
+    std::vector<int> status(pages.size());
+    mc.numa_local = mc.numa_remote = 0;
+
+    if ( pages.empty() or
+        syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) )
+        return;
+
+    // pages not yet touched have a negative status
+    for ( unsigned i = 0; i < status.size(); ++i )
+    {
+        if ( status[i] == a->node )
+            mc.numa_local += weights[i];
+
+        else if ( status[i] >= 0 )
+            mc.numa_remote += weights[i];
+    }
+}
+#endif
+
 } // namespace
 
 // -----------------------------------------------------------------------------
@@ -128,6 +326,7 @@ inline size_t calculate_threshold(size_t cap, size_t threshold)
 // -----------------------------------------------------------------------------
 
 size_t MemoryCap::limit = 0;
+bool MemoryCap::numa_local = false;
 
 // -----------------------------------------------------------------------------
 // public interface
@@ -137,7 +336,13 @@ void MemoryCap::setup(const MemoryConfig& config, unsigned n)
 {
     assert(!is_packet_thread());
     limit = memory::calculate_threshold(config.cap, config.threshold);
+    numa_local = config.numa_local;
     pkt_mem_stats.resize(n);
+
+#if defined(HAVE_JEMALLOC) && defined(__linux__)
+    if ( numa_arenas.size() < n )
+        numa_arenas.resize(n, nullptr);
+#endif
 }
 
 void MemoryCap::cleanup()
@@ -164,6 +369,49 @@ void MemoryCap::free_space()
     memory::free_space(limit, prune_handler);
 }
 
+void MemoryCap::thread_init(int node)
+{
+    assert(is_packet_thread());
+
+#if defined(HAVE_JEMALLOC) && defined(__linux__)
+    if ( !numa_local or node < 0 or (unsigned)node >= max_numa_nodes )
+        return;
+
+    // reuse the arena from a previous run of this thread if still on the same node
+    NumaArena*& a = numa_arenas[get_instance_id()];
+
+    if ( !a or a->node != node )
+    {
+        a = create_numa_arena(node);
+
+        if ( !a )
+        {
+            WarningMessage("memory: failed to create NUMA arena for node %d\n", node);
+            return;
+        }
+    }
+
+    // __STRDUMP_DISABLE__
+    mallctl("thread.tcache.flush", nullptr, nullptr, nullptr, 0);
+
+    if ( mallctl("thread.arena", nullptr, nullptr, (void*)&a->index, sizeof(a->index)) )
+        WarningMessage("memory: failed to use NUMA arena for node %d\n", node);
+    else
+        numa_arena = a;
+    // __STRDUMP_ENABLE__
+#else
+    UNUSED(node);
+#endif
+}
+
+void MemoryCap::update_numa_counts()
+{
+#if defined(HAVE_JEMALLOC) && defined(__linux__)
+    if ( numa_arena )
+        sample_numa_pages(numa_arena, get_mem_stats());
+#endif
+}
+
 #ifdef ENABLE_MEMORY_OVERLOADS
 void MemoryCap::allocate(size_t n)
 {
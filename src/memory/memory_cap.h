@@ -40,6 +40,9 @@ struct MemoryCounts
     PegCount reap_attempts;
     PegCount reap_failures;
     PegCount max_in_use;
+    PegCount numa_local;
+    PegCount numa_remote;
+    PegCount huge_page_bytes;
 };
 
 class SO_PUBLIC MemoryCap
@@ -50,6 +53,12 @@ public:
 
     static void free_space();
 
+    // call from packet threads after pinning; node < 0 if unknown
+    static void thread_init(int node);
+
+    // sample where the thread's arena pages are for the numa pegs
+    static void update_numa_counts();
+
     // call from main thread
     static void print(bool verbose, bool print_all = true);
 
@@ -62,6 +71,7 @@ public:
 
 private:
     static size_t limit;
+    static bool numa_local;
 };
 
 } // namespace memory
@@ -25,8 +25,12 @@
 
 struct MemoryConfig
 {
+    enum HugePages { HUGE_OFF, HUGE_TRANSPARENT, HUGE_EXPLICIT };
+
     size_t cap = 0;
     unsigned threshold = 0;
+    bool numa_local = false;
+    HugePages huge_pages = HUGE_OFF;
 
     constexpr MemoryConfig() = default;
 };
@@ -25,6 +25,7 @@
 #include "memory_module.h"
 
 #include "main/snort_config.h"
+#include "main/thread.h"
 
 #include "memory_cap.h"
 #include "memory_config.h"
@@ -47,6 +48,12 @@ static const Parameter s_params[] =
     { "threshold", Parameter::PT_INT, "1:100", "100",
         "scale cap to account for heap overhead" },
 
+    { "numa_local", Parameter::PT_BOOL, nullptr, "false",
+        "allocate packet thread memory from the NUMA node of its pinned CPUs" },
+
+    { "huge_pages", Parameter::PT_ENUM, "off | transparent | explicit", "off",
+        "back packet thread encode and ips context buffers with 2MB huge pages" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -61,6 +68,9 @@ const PegInfo mem_pegs[] =
     { CountType::NOW, "reap_attempts", "attempts to reclaim memory" },
     { CountType::NOW, "reap_failures", "failures to reclaim memory" },
     { CountType::MAX, "max_in_use", "highest allocated - deallocated" },
+    { CountType::NOW, "numa_local", "sampled thread arena bytes on the local NUMA node" },
+    { CountType::NOW, "numa_remote", "sampled thread arena bytes on other NUMA nodes" },
+    { CountType::NOW, "huge_page_bytes", "packet and context buffer bytes backed by huge pages" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -82,6 +92,12 @@ bool MemoryModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("threshold") )
         sc->memory->threshold = v.get_uint8();
 
+    else if ( v.is("numa_local") )
+        sc->memory->numa_local = v.get_bool();
+
+    else if ( v.is("huge_pages") )
+        sc->memory->huge_pages = (MemoryConfig::HugePages)v.get_uint8();
+
     return true;
 }
 
@@ -97,6 +113,12 @@ bool MemoryModule::is_active()
 const PegInfo* MemoryModule::get_pegs() const
 { return mem_pegs; }
 
+void MemoryModule::prep_counts()
+{
+    if ( is_active() and is_packet_thread() )
+        memory::MemoryCap::update_numa_counts();
+}
+
 PegCount* MemoryModule::get_counts() const
 {
     if ( !is_active() )
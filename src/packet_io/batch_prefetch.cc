@@ -0,0 +1,238 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// batch_prefetch.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "batch_prefetch.h"
+
+#include <daq_dlt.h>
+
+#include "main/snort_config.h"
+#include "protocols/eth.h"
+#include "protocols/ipv4.h"
+#include "protocols/ipv6.h"
+#include "protocols/protocol_ids.h"
+#include "protocols/vlan.h"
+#include "sfip/sf_ip.h"
+#include "stream/stream.h"
+
+#include "sfdaq_module.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+BatchPrefetch::BatchPrefetch(unsigned max, int t) : slots(max), dlt(t)
+{ }
+
+bool BatchPrefetch::set_key(
+    FlowKey& key, int dlt, const DAQ_PktHdr_t& pkth, const uint8_t* data, uint32_t len)
+{
+    const uint8_t* end = data + len;
+    uint16_t vlan = 0;
+    ProtocolId type;
+
+    if ( dlt == DLT_EN10MB )
+    {
+        if ( len < sizeof(eth::EtherHdr) )
+            return false;
+
+        type = ((const eth::EtherHdr*)data)->ethertype();
+        data += sizeof(eth::EtherHdr);
+
+        if ( type == ProtocolId::ETHERTYPE_8021Q )
+        {
+            if ( data + sizeof(vlan::VlanTagHdr) > end )
+                return false;
+
+            const vlan::VlanTagHdr* vh = (const vlan::VlanTagHdr*)data;
+            vlan = vh->vid();
+            type = (ProtocolId)ntohs(vh->vth_proto);
+            data += sizeof(vlan::VlanTagHdr);
+        }
+    }
+    else if ( dlt == DLT_RAW and len )
+        type = (*data >> 4) == 6 ? ProtocolId::ETHERTYPE_IPV6 : ProtocolId::ETHERTYPE_IPV4;
+
+    else
+        return false;
+
+    SfIp src, dst;
+    IpProtocol proto;
+
+    if ( type == ProtocolId::ETHERTYPE_IPV4 )
+    {
+        const ip::IP4Hdr* ip4 = (const ip::IP4Hdr*)data;
+
+        if ( data + ip::IP4_HEADER_LEN > end or ip4->ver() != 4 or ip4->off_w_flags() & 0x3fff )
+            return false;
+
+        src.set(&ip4->ip_src, AF_INET);
+        dst.set(&ip4->ip_dst, AF_INET);
+        proto = ip4->proto();
+        data += ip4->hlen();
+    }
+    else if ( type == ProtocolId::ETHERTYPE_IPV6 )
+    {
+        const ip::IP6Hdr* ip6 = (const ip::IP6Hdr*)data;
+
+        if ( data + ip::IP6_HEADER_LEN > end or ip6->ver() != 6 )
+            return false;
+
+        src.set(&ip6->ip6_src, AF_INET6);
+        dst.set(&ip6->ip6_dst, AF_INET6);
+        proto = ip6->next();
+        data += ip::IP6_HEADER_LEN;
+    }
+    else
+        return false;
+
+    PktType pkt_type;
+
+    if ( proto == IpProtocol::TCP )
+        pkt_type = PktType::TCP;
+
+    else if ( proto == IpProtocol::UDP )
+        pkt_type = PktType::UDP;
+
+    else
+        return false;
+
+    // tcp and udp ports are in the same place
+    if ( data + 4 > end )
+        return false;
+
+    uint16_t sp = (data[0] << 8) | data[1];
+    uint16_t dp = (data[2] << 8) | data[3];
+
+    key.init(SnortConfig::get_conf(), pkt_type, proto, &src, sp, &dst, dp, vlan, 0, pkth);
+    return true;
+}
+
+void BatchPrefetch::load(const DAQ_Msg_h* msgs, unsigned num)
+{
+    count = num < slots.size() ? num : slots.size();
+
+    for ( unsigned i = 0; i < count; ++i )
+    {
+        Slot& s = slots[i];
+        s.valid = false;
+
+        if ( daq_msg_get_type(msgs[i]) != DAQ_MSG_TYPE_PACKET )
+            continue;
+
+        const DAQ_PktHdr_t* pkth = daq_msg_get_pkthdr(msgs[i]);
+
+        if ( !set_key(s.key, dlt, *pkth, daq_msg_get_data(msgs[i]), daq_msg_get_data_len(msgs[i])) )
+        {
+            daq_stats.prefetch_skips++;
+            continue;
+        }
+        if ( !Stream::prefetch_flow(&s.key, s.hash) )
+            continue;
+
+        s.valid = true;
+        daq_stats.prefetch_keys++;
+    }
+
+    // the buckets loaded above are needed to find the nodes
+    for ( unsigned i = 0; i < count; ++i )
+    {
+        if ( slots[i].valid )
+            Stream::prefetch_flow_node(slots[i].hash);
+    }
+}
+
+void BatchPrefetch::touch(unsigned idx)
+{
+    if ( idx >= count or !slots[idx].valid )
+        return;
+
+    if ( const Flow* flow = Stream::peek_flow(&slots[idx].key, slots[idx].hash) )
+    {
+        __builtin_prefetch(flow);
+        daq_stats.prefetch_flows++;
+    }
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static const uint8_t tcp4[] =
+{
+    // eth
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0x81, 0x00,
+    // vlan 10
+    0x00, 0x0a, 0x08, 0x00,
+    // ipv4 10.1.1.1 -> 10.2.2.2 tcp
+    0x45, 0, 0, 40, 0, 1, 0x40, 0, 64, 6, 0, 0,
+    10, 1, 1, 1, 10, 2, 2, 2,
+    // tcp 1234 -> 80
+    0x04, 0xd2, 0x00, 0x50
+};
+
+TEST_CASE("prefetch key ipv4 tcp with vlan", "[BatchPrefetch]")
+{
+    DAQ_PktHdr_t pkth = { };
+    FlowKey key;
+
+    REQUIRE(BatchPrefetch::set_key(key, DLT_EN10MB, pkth, tcp4, sizeof(tcp4)));
+    CHECK(key.pkt_type == PktType::TCP);
+    CHECK(key.ip_protocol == (uint8_t)IpProtocol::TCP);
+    CHECK(key.port_l == 1234);
+    CHECK(key.port_h == 80);
+}
+
+TEST_CASE("prefetch key skips", "[BatchPrefetch]")
+{
+    DAQ_PktHdr_t pkth = { };
+    FlowKey key;
+    uint8_t buf[sizeof(tcp4)];
+
+    SECTION("truncated")
+    {
+        CHECK(!BatchPrefetch::set_key(key, DLT_EN10MB, pkth, tcp4, sizeof(tcp4) - 1));
+    }
+    SECTION("fragment")
+    {
+        memcpy(buf, tcp4, sizeof(buf));
+        buf[24] = 0x20;  // more fragments
+        CHECK(!BatchPrefetch::set_key(key, DLT_EN10MB, pkth, buf, sizeof(buf)));
+    }
+    SECTION("icmp")
+    {
+        memcpy(buf, tcp4, sizeof(buf));
+        buf[27] = 1;
+        CHECK(!BatchPrefetch::set_key(key, DLT_EN10MB, pkth, buf, sizeof(buf)));
+    }
+    SECTION("raw ip")
+    {
+        CHECK(BatchPrefetch::set_key(key, DLT_RAW, pkth, tcp4 + 18, sizeof(tcp4) - 18));
+    }
+}
+
+#endif
+
@@ -0,0 +1,66 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// batch_prefetch.h
+
+#ifndef BATCH_PREFETCH_H
+#define BATCH_PREFETCH_H
+
+// BatchPrefetch overlaps flow lookup misses for a DAQ batch.  After a
+// receive, the Ethernet or raw IP headers of each packet are parsed just
+// enough to build the FlowKey that stream will look up.  The flow buckets
+// are prefetched for the whole batch, then the flow nodes, and then the
+// flow for the next packet is prefetched while the current one is
+// processed.  Anything that isn't plain IPv4 or IPv6 TCP or UDP (including
+// tunnels and fragments) is skipped; a wrong key only wastes a prefetch.
+
+#include <daq_common.h>
+
+#include <vector>
+
+#include "flow/flow_key.h"
+
+class BatchPrefetch
+{
+public:
+    BatchPrefetch(unsigned max, int dlt);
+
+    // build keys and prefetch buckets and nodes for the received batch
+    void load(const DAQ_Msg_h*, unsigned num);
+
+    // prefetch the flow for the given batch index
+    void touch(unsigned idx);
+
+    // returns true if a key was built; exposed for testing
+    static bool set_key(
+        snort::FlowKey&, int dlt, const DAQ_PktHdr_t&, const uint8_t* data, uint32_t len);
+
+private:
+    struct Slot
+    {
+        snort::FlowKey key;
+        unsigned hash;
+        bool valid;
+    };
+
+    std::vector<Slot> slots;
+    unsigned count = 0;
+    int dlt;
+};
+
+#endif
+
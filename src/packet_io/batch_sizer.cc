@@ -0,0 +1,144 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// batch_sizer.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "batch_sizer.h"
+
+#include <algorithm>
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+void BatchSizer::configure(unsigned lo, unsigned hi, unsigned latency_usecs)
+{
+    max = hi ? hi : 1;
+    min = std::min(std::max(lo, 1u), max);
+    latency = (uint64_t)latency_usecs * 1000;
+    size = min;
+    cost = 0;
+}
+
+void BatchSizer::update(unsigned want, unsigned got, uint64_t usecs)
+{
+    if ( got )
+    {
+        uint64_t per = usecs * 1000 / got;
+        cost = cost ? cost - (cost >> COST_SHIFT) + per : per << COST_SHIFT;
+    }
+
+    // want may have been cut short by exit or pause counts
+    if ( got >= want and want == size )
+        size = std::min(size * 2, max);
+
+    else if ( got < size / 4 )
+        size = std::max(std::max(size / 2, got), min);
+
+    uint64_t per = get_cost();
+
+    if ( latency and per )
+    {
+        uint64_t cap = latency / per;
+
+        if ( cap < size )
+            size = std::max((unsigned)cap, min);
+    }
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+TEST_CASE("batch sizer grows when full", "[BatchSizer]")
+{
+    BatchSizer bs;
+    bs.configure(1, 64, 0);
+    CHECK(bs.get() == 1);
+
+    for ( unsigned i = 0; i < 10; ++i )
+        bs.update(bs.get(), bs.get(), bs.get());
+
+    CHECK(bs.get() == 64);
+    CHECK(bs.get_cost() == 1000);
+}
+
+TEST_CASE("batch sizer shrinks when idle", "[BatchSizer]")
+{
+    BatchSizer bs;
+    bs.configure(4, 64, 0);
+
+    for ( unsigned i = 0; i < 10; ++i )
+        bs.update(bs.get(), bs.get(), 0);
+
+    REQUIRE(bs.get() == 64);
+
+    bs.update(64, 32, 0);
+    CHECK(bs.get() == 64);
+
+    bs.update(64, 2, 0);
+    CHECK(bs.get() == 32);
+
+    for ( unsigned i = 0; i < 10; ++i )
+        bs.update(bs.get(), 0, 0);
+
+    CHECK(bs.get() == 4);
+}
+
+TEST_CASE("batch sizer latency bound", "[BatchSizer]")
+{
+    BatchSizer bs;
+    bs.configure(2, 256, 100);
+
+    // 10 usecs per message caps the batch at 10 messages
+    for ( unsigned i = 0; i < 20; ++i )
+        bs.update(bs.get(), bs.get(), 10 * bs.get());
+
+    CHECK(bs.get() == 10);
+
+    // cheaper messages allow larger batches
+    for ( unsigned i = 0; i < 100; ++i )
+        bs.update(bs.get(), bs.get(), bs.get());
+
+    CHECK(bs.get() > 10);
+    CHECK(bs.get() <= 100);
+
+    // but never below the minimum
+    for ( unsigned i = 0; i < 50; ++i )
+        bs.update(bs.get(), bs.get(), 1000 * bs.get());
+
+    CHECK(bs.get() == 2);
+}
+
+TEST_CASE("batch sizer bounds", "[BatchSizer]")
+{
+    BatchSizer bs;
+    bs.configure(100, 8, 0);
+    CHECK(bs.get() == 8);
+
+    bs.configure(0, 0, 0);
+    CHECK(bs.get() == 1);
+}
+
+#endif
+
@@ -0,0 +1,57 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// batch_sizer.h
+
+#ifndef BATCH_SIZER_H
+#define BATCH_SIZER_H
+
+// BatchSizer picks the number of messages to request from the DAQ on each
+// receive.  A full batch means the queue is backing up so the size grows
+// to amortize per-batch overhead; a mostly empty batch shrinks it.  The
+// size is capped so the estimated time to process a batch stays within
+// the configured latency bound.
+
+#include <cstdint>
+
+class BatchSizer
+{
+public:
+    void configure(unsigned min, unsigned max, unsigned latency_usecs);
+
+    unsigned get() const
+    { return size; }
+
+    // requested, received, and usecs spent processing the received batch
+    void update(unsigned want, unsigned got, uint64_t usecs);
+
+    // estimated processing cost per message in nsecs
+    uint64_t get_cost() const
+    { return cost >> COST_SHIFT; }
+
+private:
+    static constexpr unsigned COST_SHIFT = 3;  // ewma weight is 1/8
+
+    unsigned min = 1;
+    unsigned max = 1;
+    unsigned size = 1;
+    uint64_t latency = 0;   // nsecs; 0 is unbounded
+    uint64_t cost = 0;      // nsecs scaled by 2^COST_SHIFT
+};
+
+#endif
+
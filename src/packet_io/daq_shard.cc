@@ -0,0 +1,327 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// daq_shard.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "daq_shard.h"
+
+#include <pcap.h>
+
+#include <atomic>
+#include <cstring>
+#include <string>
+
+#include "flow_shard.h"
+
+#define DAQ_MOD_VERSION 1
+#define DAQ_TYPE (DAQ_TYPE_FILE_CAPABLE | DAQ_TYPE_MULTI_INSTANCE)
+
+#define SHARD_DEFAULT_POOL_SIZE 256
+#define SHARD_DEFAULT_SNAPLEN 65535
+#define SHARD_DEFAULT_TIMEOUT 1000
+
+#define SET_ERROR(modinst, ...)    daq_base_api.set_errbuf(modinst, __VA_ARGS__)
+
+struct ShardContext
+{
+    DAQ_ModuleInstance_h modinst;
+    ShardQueue* queue;
+
+    bpf_program fcode;
+    bool filtering;
+
+    unsigned timeout;
+    unsigned outstanding;
+    std::atomic<bool> interrupted;
+
+    DAQ_Stats_t stats;
+};
+
+static DAQ_BaseAPI_t daq_base_api;
+
+//-------------------------------------------------------------------------
+// daq
+//-------------------------------------------------------------------------
+
+static int shard_daq_module_load(const DAQ_BaseAPI_t* base_api)
+{
+    if (base_api->api_version != DAQ_BASE_API_VERSION || base_api->api_size != sizeof(DAQ_BaseAPI_t))
+        return DAQ_ERROR;
+
+    daq_base_api = *base_api;
+
+    return DAQ_SUCCESS;
+}
+
+static int shard_daq_instantiate(const DAQ_ModuleConfig_h modcfg, DAQ_ModuleInstance_h modinst, void** ctxt_ptr)
+{
+    unsigned pool_size = daq_base_api.config_get_msg_pool_size(modcfg);
+    int snaplen = daq_base_api.config_get_snaplen(modcfg);
+    std::string why;
+
+    ShardQueue* q = FlowShard::claim(modinst, pool_size ? pool_size : SHARD_DEFAULT_POOL_SIZE,
+        snaplen > 0 ? snaplen : SHARD_DEFAULT_SNAPLEN, why);
+
+    if (!q)
+    {
+        SET_ERROR(modinst, "%s: %s", SHARD_DAQ_NAME, why.c_str());
+        return DAQ_ERROR;
+    }
+
+    ShardContext* sc = new ShardContext();
+    sc->modinst = modinst;
+    sc->queue = q;
+
+    unsigned timeout = daq_base_api.config_get_timeout(modcfg);
+    sc->timeout = timeout ? timeout : SHARD_DEFAULT_TIMEOUT;
+
+    *ctxt_ptr = sc;
+
+    return DAQ_SUCCESS;
+}
+
+static void shard_daq_destroy(void* handle)
+{
+    ShardContext* sc = (ShardContext*) handle;
+
+    if (sc->filtering)
+        pcap_freecode(&sc->fcode);
+
+    FlowShard::release(sc->queue);
+    delete sc;
+}
+
+static int shard_daq_set_filter(void* handle, const char* filter)
+{
+    ShardContext* sc = (ShardContext*) handle;
+    pcap_t* dead = pcap_open_dead(sc->queue->get_dlt(), sc->queue->get_snaplen());
+
+    if (!dead)
+    {
+        SET_ERROR(sc->modinst, "%s: Could not allocate a dead PCAP handle!", SHARD_DAQ_NAME);
+        return DAQ_ERROR_NOMEM;
+    }
+
+    bpf_program fcode;
+
+    if (pcap_compile(dead, &fcode, filter, 1, PCAP_NETMASK_UNKNOWN) < 0)
+    {
+        SET_ERROR(sc->modinst, "%s: pcap_compile: %s", SHARD_DAQ_NAME, pcap_geterr(dead));
+        pcap_close(dead);
+        return DAQ_ERROR;
+    }
+    pcap_close(dead);
+
+    if (sc->filtering)
+        pcap_freecode(&sc->fcode);
+
+    sc->fcode = fcode;
+    sc->filtering = true;
+
+    return DAQ_SUCCESS;
+}
+
+static int shard_daq_start(void*)
+{
+    return DAQ_SUCCESS;
+}
+
+static int shard_daq_interrupt(void* handle)
+{
+    ShardContext* sc = (ShardContext*) handle;
+    sc->interrupted = true;
+    sc->queue->interrupt();
+    return DAQ_SUCCESS;
+}
+
+// let the reader skip this queue from now on
+static int shard_daq_stop(void* handle)
+{
+    ShardContext* sc = (ShardContext*) handle;
+    sc->queue->close();
+    return DAQ_SUCCESS;
+}
+
+static int shard_daq_get_stats(void* handle, DAQ_Stats_t* stats)
+{
+    ShardContext* sc = (ShardContext*) handle;
+    memcpy(stats, &sc->stats, sizeof(DAQ_Stats_t));
+    return DAQ_SUCCESS;
+}
+
+static void shard_daq_reset_stats(void* handle)
+{
+    ShardContext* sc = (ShardContext*) handle;
+    memset(&sc->stats, 0, sizeof(sc->stats));
+}
+
+static int shard_daq_get_snaplen(void* handle)
+{
+    ShardContext* sc = (ShardContext*) handle;
+    return sc->queue->get_snaplen();
+}
+
+static uint32_t shard_daq_get_capabilities(void*)
+{
+    return DAQ_CAPA_BLOCK | DAQ_CAPA_REPLACE | DAQ_CAPA_INTERRUPT | DAQ_CAPA_UNPRIV_START
+        | DAQ_CAPA_BPF;
+}
+
+static int shard_daq_get_datalink_type(void* handle)
+{
+    ShardContext* sc = (ShardContext*) handle;
+    return sc->queue->get_dlt();
+}
+
+static bool shard_daq_filter(ShardContext* sc, const ShardRecord* rec)
+{
+    pcap_pkthdr ph;
+    ph.ts = rec->hdr.ts;
+    ph.caplen = rec->msg.data_len;
+    ph.len = rec->hdr.pktlen;
+
+    return pcap_offline_filter(&sc->fcode, &ph, rec->msg.data) != 0;
+}
+
+static unsigned shard_daq_msg_receive(void* handle, const unsigned max_recv, const DAQ_Msg_t* msgs[], DAQ_RecvStatus* rstat)
+{
+    ShardContext* sc = (ShardContext*) handle;
+    ShardQueue* q = sc->queue;
+    DAQ_RecvStatus status = DAQ_RSTAT_OK;
+    unsigned idx = 0;
+
+    while (idx < max_recv)
+    {
+        /* Check to see if the receive has been canceled.  If so, reset it and return appropriately. */
+        if (sc->interrupted)
+        {
+            sc->interrupted = false;
+            status = DAQ_RSTAT_INTERRUPTED;
+            break;
+        }
+
+        ShardRecord* rec = q->pop();
+
+        if (!rec)
+        {
+            /* Return whatever has been received so far before waiting on the reader. */
+            if (idx)
+                break;
+
+            if (q->drained())
+            {
+                if (*q->get_error())
+                {
+                    SET_ERROR(sc->modinst, "%s: %s", SHARD_DAQ_NAME, q->get_error());
+                    status = DAQ_RSTAT_ERROR;
+                }
+                else
+                    status = DAQ_RSTAT_EOF;
+                break;
+            }
+
+            if (!q->wait(sc->timeout))
+            {
+                status = DAQ_RSTAT_TIMEOUT;
+                break;
+            }
+            continue;
+        }
+
+        if (sc->filtering && !shard_daq_filter(sc, rec))
+        {
+            sc->stats.packets_filtered++;
+            q->release(rec);
+            continue;
+        }
+
+        sc->stats.packets_received++;
+        sc->outstanding++;
+        msgs[idx++] = &rec->msg;
+    }
+
+    *rstat = status;
+
+    return idx;
+}
+
+static int shard_daq_msg_finalize(void* handle, const DAQ_Msg_t* msg, DAQ_Verdict verdict)
+{
+    ShardContext* sc = (ShardContext*) handle;
+    ShardRecord* rec = (ShardRecord*) msg->priv;
+
+    if (verdict >= MAX_DAQ_VERDICT)
+        verdict = DAQ_VERDICT_PASS;
+    sc->stats.verdicts[verdict]++;
+
+    /* Hand the record back to the reader for reuse. */
+    sc->outstanding--;
+    sc->queue->release(rec);
+
+    return DAQ_SUCCESS;
+}
+
+static int shard_daq_get_msg_pool_info(void* handle, DAQ_MsgPoolInfo_t* info)
+{
+    ShardContext* sc = (ShardContext*) handle;
+    ShardQueue* q = sc->queue;
+
+    info->size = q->get_size();
+    info->available = q->get_size() - sc->outstanding;
+    info->mem_size = q->get_size() * (sizeof(ShardRecord) + q->get_snaplen());
+
+    return DAQ_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+
+const DAQ_ModuleAPI_t shard_daq_module_data =
+{
+    /* .api_version = */ DAQ_MODULE_API_VERSION,
+    /* .api_size = */ sizeof(DAQ_ModuleAPI_t),
+    /* .module_version = */ DAQ_MOD_VERSION,
+    /* .name = */ SHARD_DAQ_NAME,
+    /* .type = */ DAQ_TYPE,
+    /* .load = */ shard_daq_module_load,
+    /* .unload = */ nullptr,
+    /* .get_variable_descs = */ nullptr,
+    /* .instantiate = */ shard_daq_instantiate,
+    /* .destroy = */ shard_daq_destroy,
+    /* .set_filter = */ shard_daq_set_filter,
+    /* .start = */ shard_daq_start,
+    /* .inject = */ nullptr,
+    /* .inject_relative = */ nullptr,
+    /* .interrupt = */ shard_daq_interrupt,
+    /* .stop = */ shard_daq_stop,
+    /* .ioctl = */ nullptr,
+    /* .get_stats = */ shard_daq_get_stats,
+    /* .reset_stats = */ shard_daq_reset_stats,
+    /* .get_snaplen = */ shard_daq_get_snaplen,
+    /* .get_capabilities = */ shard_daq_get_capabilities,
+    /* .get_datalink_type = */ shard_daq_get_datalink_type,
+    /* .config_load = */ nullptr,
+    /* .config_swap = */ nullptr,
+    /* .config_free = */ nullptr,
+    /* .msg_receive = */ shard_daq_msg_receive,
+    /* .msg_finalize = */ shard_daq_msg_finalize,
+    /* .get_msg_pool_info = */ shard_daq_get_msg_pool_info,
+};
+
@@ -0,0 +1,34 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// daq_shard.h
+
+#ifndef DAQ_SHARD_H
+#define DAQ_SHARD_H
+
+// The shard DAQ module is built into snort.  With --pcap-shard it replaces
+// the pcap module so each packet thread receives the packets FlowShard
+// reads from the file and dispatches to its queue.
+
+#include <daq_module_api.h>
+
+#define SHARD_DAQ_NAME "shard"
+
+extern const DAQ_ModuleAPI_t shard_daq_module_data;
+
+#endif
+
@@ -0,0 +1,676 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// flow_shard.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "flow_shard.h"
+
+#include <daq_dlt.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#include "main/snort_config.h"
+#include "protocols/eth.h"
+#include "protocols/ipv4.h"
+#include "protocols/ipv6.h"
+#include "protocols/protocol_ids.h"
+#include "protocols/vlan.h"
+
+#include "pcap_readahead.h"
+#include "sfdaq_config.h"
+
+#ifdef UNIT_TEST
+#include <thread>
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+// the reader rechecks for a departed consumer this often while blocked
+#define READER_WAIT_MSEC 10
+
+//--------------------------------------------------------------------------
+// queue
+//--------------------------------------------------------------------------
+
+ShardQueue::ShardQueue(unsigned n, unsigned len, DAQ_ModuleInstance_h owner, int t) :
+    full(n), free(n), size(n), snaplen(len), dlt(t)
+{
+    records = new ShardRecord[n]();
+    buffers = new uint8_t[(size_t)n * len];
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        ShardRecord& rec = records[i];
+
+        rec.hdr.ingress_index = DAQ_PKTHDR_UNKNOWN;
+        rec.hdr.ingress_group = DAQ_PKTHDR_UNKNOWN;
+        rec.hdr.egress_index = DAQ_PKTHDR_UNKNOWN;
+        rec.hdr.egress_group = DAQ_PKTHDR_UNKNOWN;
+
+        rec.msg.type = DAQ_MSG_TYPE_PACKET;
+        rec.msg.hdr_len = sizeof(rec.hdr);
+        rec.msg.hdr = &rec.hdr;
+        rec.msg.data = buffers + (size_t)i * len;
+        rec.msg.owner = owner;
+        rec.msg.priv = &rec;
+
+        free.put(&rec);
+    }
+}
+
+ShardQueue::~ShardQueue()
+{
+    delete[] records;
+    delete[] buffers;
+}
+
+// the rings are lock free and the mutex only guards sleeping.  the fences
+// order each ring update against the waiter count so a waiter either sees
+// the update when it checks or is notified after it blocks.
+void ShardQueue::wake()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if ( waiters.load(std::memory_order_relaxed) )
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cond.notify_all();
+    }
+}
+
+ShardRecord* ShardQueue::reserve()
+{
+    while ( !closed )
+    {
+        if ( ShardRecord* rec = free.get(nullptr) )
+            return rec;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        ++waiters;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if ( free.empty() and !closed )
+            cond.wait_for(lock, std::chrono::milliseconds(READER_WAIT_MSEC));
+
+        --waiters;
+    }
+    return nullptr;
+}
+
+void ShardQueue::push(ShardRecord* rec)
+{
+    // there are only as many records as slots so this can't fail
+    full.put(rec);
+    wake();
+}
+
+void ShardQueue::finish(const char* s)
+{
+    if ( s )
+        error = s;
+
+    finished.store(true, std::memory_order_release);
+    wake();
+}
+
+ShardRecord* ShardQueue::pop()
+{ return full.get(nullptr); }
+
+void ShardQueue::release(ShardRecord* rec)
+{
+    free.put(rec);
+    wake();
+}
+
+bool ShardQueue::wait(unsigned msec)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    ++waiters;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    bool ready = cond.wait_for(lock, std::chrono::milliseconds(msec),
+        [this]() { return !full.empty() or finished or poked; });
+
+    --waiters;
+    poked = false;
+    return ready;
+}
+
+// everything pushed before finish() is visible once finished is seen
+bool ShardQueue::drained()
+{ return finished.load(std::memory_order_acquire) and full.empty(); }
+
+void ShardQueue::interrupt()
+{
+    poked = true;
+    wake();
+}
+
+void ShardQueue::close()
+{
+    closed = true;
+    wake();
+}
+
+//--------------------------------------------------------------------------
+// dispatcher
+//--------------------------------------------------------------------------
+
+// the file whose shards are being handed out; main thread only
+static FlowShard* opening = nullptr;
+
+FlowShard::FlowShard(const char* f, unsigned n) : file(f), queues(n, nullptr)
+{
+    char errbuf[PCAP_ERRBUF_SIZE] = "";
+
+    if ( !(pcap = pcap_open_offline(f, errbuf)) )
+    {
+        error = errbuf;
+        return;
+    }
+    dlt = pcap_datalink(pcap);
+
+    const SFDAQConfig* dc = SnortConfig::get_conf()->daq_config;
+
+    if ( dc->pcap_readahead )
+        readahead = new PcapReadahead(f, (size_t)dc->pcap_readahead << 20);
+}
+
+FlowShard::~FlowShard()
+{
+    if ( reader )
+    {
+        reader->join();
+        delete reader;
+    }
+    for ( auto* q : queues )
+        delete q;
+
+    delete readahead;
+
+    if ( pcap )
+        pcap_close(pcap);
+}
+
+void FlowShard::open(const char* file, unsigned count)
+{
+    // Trough hands out every shard of a file before the next file
+    assert(!opening);
+    opening = new FlowShard(file, count);
+}
+
+ShardQueue* FlowShard::claim(
+    DAQ_ModuleInstance_h owner, unsigned slots, unsigned snaplen, std::string& why)
+{
+    FlowShard* fs = opening;
+
+    if ( !fs )
+    {
+        why = "only used to read pcaps with --pcap-shard";
+        return nullptr;
+    }
+
+    ShardQueue* q = nullptr;
+
+    if ( fs->pcap )
+    {
+        q = new ShardQueue(slots, snaplen, owner, fs->dlt);
+        q->shard = fs;
+        fs->queues[fs->next] = q;
+
+        std::lock_guard<std::mutex> lock(fs->mutex);
+        fs->users++;
+    }
+    else
+        why = fs->error;
+
+    fs->next++;
+    fs->resolved();
+    return q;
+}
+
+void FlowShard::skip(unsigned shard)
+{
+    FlowShard* fs = opening;
+
+    // the shard may have been claimed and then released by a failed setup
+    if ( fs and fs->next == shard )
+    {
+        fs->next++;
+        fs->resolved();
+    }
+}
+
+void FlowShard::abandon()
+{
+    if ( FlowShard* fs = opening )
+    {
+        fs->next = fs->queues.size();
+        fs->resolved();
+    }
+}
+
+// once every shard is claimed or skipped, start reading if anyone is
+// still there or clean up if not
+void FlowShard::resolved()
+{
+    if ( next < queues.size() )
+        return;
+
+    opening = nullptr;
+    bool done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        complete = true;
+        done = !users;
+
+        if ( !done )
+            reader = new std::thread(&FlowShard::read, this);
+    }
+    if ( done )
+        delete this;
+}
+
+void FlowShard::release(ShardQueue* q)
+{
+    FlowShard* fs = q->shard;
+    q->close();
+
+    bool done;
+    {
+        std::lock_guard<std::mutex> lock(fs->mutex);
+        done = !--fs->users and fs->complete;
+    }
+    if ( done )
+        delete fs;
+}
+
+void FlowShard::read()
+{
+    const unsigned n = queues.size();
+    int rval = PCAP_ERROR_BREAK;
+    pcap_pkthdr* ph;
+    const u_char* data;
+
+    // stop early if every consumer has left
+    while ( users and (rval = pcap_next_ex(pcap, &ph, &data)) == 1 )
+    {
+        if ( readahead )
+            readahead->skip_records(1);
+
+        ShardQueue* q = queues[hash(dlt, data, ph->caplen) % n];
+        ShardRecord* rec;
+
+        // nobody to take it if the shard was skipped or its consumer left
+        if ( !q or !(rec = q->reserve()) )
+            continue;
+
+        uint32_t len = ph->caplen < q->snaplen ? ph->caplen : q->snaplen;
+        memcpy(rec->msg.data, data, len);
+
+        rec->msg.data_len = len;
+        rec->hdr.ts = ph->ts;
+        rec->hdr.pktlen = ph->len;
+
+        q->push(rec);
+    }
+
+    const char* err = (rval == PCAP_ERROR) ? pcap_geterr(pcap) : nullptr;
+
+    for ( auto* q : queues )
+    {
+        if ( q )
+            q->finish(err);
+    }
+}
+
+static inline uint32_t fold(const uint32_t* a, unsigned n)
+{
+    uint32_t x = 0;
+
+    for ( unsigned i = 0; i < n; ++i )
+        x ^= a[i];
+
+    return x;
+}
+
+// murmur3 finalizer
+static inline uint64_t mix(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+// mix the first part before folding in the second so overlapping bits of
+// the two can't cancel (eg address and port both counting up)
+static inline uint32_t mix(uint64_t a, uint64_t b)
+{ return (uint32_t)mix(mix(a) ^ b); }
+
+static inline uint64_t mac(const uint8_t* m)
+{
+    uint64_t x = 0;
+
+    for ( unsigned i = 0; i < 6; ++i )
+        x = (x << 8) | m[i];
+
+    return x;
+}
+
+// spread non-ip frames by station pair instead of piling them on one shard
+static uint32_t l2_hash(const eth::EtherHdr* eh)
+{
+    uint64_t a = mac(eh->ether_src);
+    uint64_t b = mac(eh->ether_dst);
+
+    if ( a > b )
+        std::swap(a, b);
+
+    return mix(a, b);
+}
+
+uint32_t FlowShard::hash(int dlt, const uint8_t* data, uint32_t len)
+{
+    const uint8_t* end = data + len;
+    ProtocolId type;
+    uint32_t l2 = 0;
+
+    if ( dlt == DLT_EN10MB )
+    {
+        if ( len < sizeof(eth::EtherHdr) )
+            return 0;
+
+        const eth::EtherHdr* eh = (const eth::EtherHdr*)data;
+        type = eh->ethertype();
+        l2 = l2_hash(eh);
+        data += sizeof(eth::EtherHdr);
+
+        while ( type == ProtocolId::ETHERTYPE_8021Q or type == ProtocolId::ETHERTYPE_8021AD )
+        {
+            if ( data + sizeof(vlan::VlanTagHdr) > end )
+                return l2;
+
+            type = (ProtocolId)ntohs(((const vlan::VlanTagHdr*)data)->vth_proto);
+            data += sizeof(vlan::VlanTagHdr);
+        }
+    }
+    else if ( dlt == DLT_RAW and len )
+        type = (*data >> 4) == 6 ? ProtocolId::ETHERTYPE_IPV6 : ProtocolId::ETHERTYPE_IPV4;
+
+    else
+        return 0;
+
+    uint32_t a, b;
+    uint8_t proto;
+    bool frag;
+
+    if ( type == ProtocolId::ETHERTYPE_IPV4 )
+    {
+        const ip::IP4Hdr* ip4 = (const ip::IP4Hdr*)data;
+
+        if ( data + ip::IP4_HEADER_LEN > end or ip4->ver() != 4 )
+            return l2;
+
+        a = ip4->get_src();
+        b = ip4->get_dst();
+        proto = (uint8_t)ip4->proto();
+        frag = ip4->off_w_flags() & 0x3fff;
+        data += ip4->hlen();
+    }
+    else if ( type == ProtocolId::ETHERTYPE_IPV6 )
+    {
+        const ip::IP6Hdr* ip6 = (const ip::IP6Hdr*)data;
+
+        if ( data + ip::IP6_HEADER_LEN > end or ip6->ver() != 6 )
+            return l2;
+
+        a = fold(ip6->get_src()->u6_addr32, 4);
+        b = fold(ip6->get_dst()->u6_addr32, 4);
+        proto = (uint8_t)ip6->next();
+        frag = proto == (uint8_t)IpProtocol::FRAGMENT;
+        data += ip::IP6_HEADER_LEN;
+    }
+    else
+        return l2;
+
+    uint16_t sp = 0, dp = 0;
+
+    if ( frag )
+        proto = 0;
+
+    // tcp and udp ports are in the same place
+    else if ( (proto == (uint8_t)IpProtocol::TCP or proto == (uint8_t)IpProtocol::UDP) and
+        data + 4 <= end )
+    {
+        sp = (data[0] << 8) | data[1];
+        dp = (data[2] << 8) | data[3];
+    }
+
+    // order the endpoints so both directions hash the same
+    if ( a > b or (a == b and sp > dp) )
+    {
+        std::swap(a, b);
+        std::swap(sp, dp);
+    }
+
+    return mix((uint64_t)a << 32 | b, (uint64_t)sp << 24 | (uint64_t)dp << 8 | proto);
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static const uint8_t tcp4[] =
+{
+    // eth
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0x08, 0x00,
+    // ipv4 10.1.1.1 -> 10.2.2.2 tcp
+    0x45, 0, 0, 40, 0, 1, 0x40, 0, 64, 6, 0, 0,
+    10, 1, 1, 1, 10, 2, 2, 2,
+    // tcp 1234 -> 80
+    0x04, 0xd2, 0x00, 0x50
+};
+
+static const uint8_t tcp4_reply[] =
+{
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0x08, 0x00,
+    0x45, 0, 0, 40, 0, 2, 0x40, 0, 64, 6, 0, 0,
+    10, 2, 2, 2, 10, 1, 1, 1,
+    0x00, 0x50, 0x04, 0xd2
+};
+
+TEST_CASE("flow shard symmetric", "[FlowShard]")
+{
+    uint32_t h1 = FlowShard::hash(DLT_EN10MB, tcp4, sizeof(tcp4));
+    uint32_t h2 = FlowShard::hash(DLT_EN10MB, tcp4_reply, sizeof(tcp4_reply));
+
+    CHECK(h1 != 0);
+    CHECK(h1 == h2);
+}
+
+TEST_CASE("flow shard ports", "[FlowShard]")
+{
+    uint8_t pkt[sizeof(tcp4)];
+    memcpy(pkt, tcp4, sizeof(pkt));
+    pkt[sizeof(pkt) - 1] = 81;
+
+    CHECK(FlowShard::hash(DLT_EN10MB, tcp4, sizeof(tcp4)) !=
+        FlowShard::hash(DLT_EN10MB, pkt, sizeof(pkt)));
+}
+
+TEST_CASE("flow shard fragments", "[FlowShard]")
+{
+    // first fragment has ports, later ones don't; both must match
+    uint8_t first[sizeof(tcp4)];
+    memcpy(first, tcp4, sizeof(first));
+    first[20] = 0x20;
+
+    uint8_t next[sizeof(tcp4)];
+    memcpy(next, tcp4, sizeof(next));
+    next[20] = 0x00;
+    next[21] = 0x10;
+    next[34] = next[35] = next[36] = next[37] = 0xff;
+
+    CHECK(FlowShard::hash(DLT_EN10MB, first, sizeof(first)) ==
+        FlowShard::hash(DLT_EN10MB, next, sizeof(next)));
+}
+
+TEST_CASE("flow shard raw", "[FlowShard]")
+{
+    const uint8_t* ip = tcp4 + 14;
+    uint32_t len = sizeof(tcp4) - 14;
+
+    CHECK(FlowShard::hash(DLT_RAW, ip, len) == FlowShard::hash(DLT_EN10MB, tcp4, sizeof(tcp4)));
+    CHECK(FlowShard::hash(DLT_EN10MB, tcp4, 10) == 0);
+    CHECK(FlowShard::hash(DLT_RAW, ip, 10) == 0);
+}
+
+TEST_CASE("flow shard spread", "[FlowShard]")
+{
+    const unsigned shards = 4;
+    unsigned counts[shards] = { };
+    uint8_t pkt[sizeof(tcp4)];
+    memcpy(pkt, tcp4, sizeof(pkt));
+
+    for ( unsigned sp = 0; sp < 4000; ++sp )
+    {
+        pkt[34] = sp >> 8;
+        pkt[35] = sp & 0xff;
+        counts[FlowShard::hash(DLT_EN10MB, pkt, sizeof(pkt)) % shards]++;
+    }
+    for ( auto c : counts )
+        CHECK((c > 800 and c < 1200));
+}
+
+TEST_CASE("flow shard non-ip", "[FlowShard]")
+{
+    // arp request and reply between the same stations
+    uint8_t req[sizeof(tcp4)];
+    memcpy(req, tcp4, sizeof(req));
+    req[12] = 0x08;
+    req[13] = 0x06;
+
+    uint8_t rep[sizeof(req)];
+    memcpy(rep, req + 6, 6);
+    memcpy(rep + 6, req, 6);
+    memcpy(rep + 12, req + 12, sizeof(rep) - 12);
+
+    uint32_t h = FlowShard::hash(DLT_EN10MB, req, sizeof(req));
+    CHECK(h == FlowShard::hash(DLT_EN10MB, rep, sizeof(rep)));
+
+    const unsigned shards = 4;
+    unsigned counts[shards] = { };
+
+    for ( unsigned n = 0; n < 4000; ++n )
+    {
+        req[4] = n >> 8;
+        req[5] = n & 0xff;
+        counts[FlowShard::hash(DLT_EN10MB, req, sizeof(req)) % shards]++;
+    }
+    for ( auto c : counts )
+        CHECK((c > 800 and c < 1200));
+}
+
+TEST_CASE("shard queue order", "[FlowShard]")
+{
+    // fewer slots than records so both sides have to wait
+    ShardQueue q(4, 8, nullptr, DLT_RAW);
+    const unsigned max = 10000;
+
+    std::thread reader([&q, max]()
+    {
+        for ( unsigned i = 0; i < max; ++i )
+        {
+            ShardRecord* rec = q.reserve();
+            memcpy(rec->msg.data, &i, sizeof(i));
+            rec->msg.data_len = sizeof(i);
+            q.push(rec);
+        }
+        q.finish();
+    });
+
+    unsigned expect = 0;
+
+    while ( !q.drained() )
+    {
+        ShardRecord* rec = q.pop();
+
+        if ( !rec )
+        {
+            q.wait(100);
+            continue;
+        }
+        unsigned i;
+        memcpy(&i, rec->msg.data, sizeof(i));
+        CHECK(i == expect++);
+        CHECK(rec->msg.priv == rec);
+        q.release(rec);
+    }
+    reader.join();
+
+    CHECK(expect == max);
+    CHECK(!strcmp(q.get_error(), ""));
+}
+
+TEST_CASE("shard queue close", "[FlowShard]")
+{
+    ShardQueue q(2, 8, nullptr, DLT_RAW);
+
+    q.push(q.reserve());
+    q.push(q.reserve());
+
+    // a full queue holds the reader until the consumer leaves
+    std::thread reader([&q]() { CHECK(q.reserve() == nullptr); });
+    q.close();
+    reader.join();
+
+    CHECK(!q.drained());
+    q.finish("oops");
+    CHECK(!q.drained());
+
+    while ( ShardRecord* rec = q.pop() )
+        q.release(rec);
+
+    CHECK(q.drained());
+    CHECK(!strcmp(q.get_error(), "oops"));
+}
+
+TEST_CASE("shard queue interrupt", "[FlowShard]")
+{
+    ShardQueue q(2, 8, nullptr, DLT_RAW);
+
+    CHECK(!q.wait(1));
+    q.interrupt();
+    CHECK(q.wait(1000));
+    CHECK(!q.wait(1));
+}
+
+#endif
+
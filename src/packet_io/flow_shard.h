@@ -0,0 +1,165 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// flow_shard.h
+
+#ifndef FLOW_SHARD_H
+#define FLOW_SHARD_H
+
+// FlowShard splits one capture across packet threads.  A single reader
+// thread per file hashes each record on its symmetric 5-tuple and copies it
+// into the bounded queue for that hash so each flow is processed in order
+// by exactly one thread.  The packet threads consume their queues through
+// the shard DAQ module (daq_shard.cc).  IP fragments hash on the addresses
+// only so all fragments of a datagram land in the same queue.  Other
+// ethernet frames hash on the station pair.
+//
+// Trough opens a FlowShard when it hands out the first shard of a file and
+// each shard DAQ instance claims the next queue when it is instantiated.
+// The reader starts once every queue is claimed or skipped, stops early if
+// all consumers are gone, and the last consumer to leave deletes the shard.
+
+#include <daq_common.h>
+#include <pcap.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "helpers/ring.h"
+
+class FlowShard;
+class PcapReadahead;
+
+// one DAQ message and its packet buffer
+struct ShardRecord
+{
+    DAQ_Msg_t msg;
+    DAQ_PktHdr_t hdr;
+};
+
+// single producer (the reader), single consumer (a packet thread)
+class ShardQueue
+{
+public:
+    ShardQueue(unsigned slots, unsigned snaplen, DAQ_ModuleInstance_h owner, int dlt);
+    ~ShardQueue();
+
+    ShardQueue(const ShardQueue&) = delete;
+    ShardQueue& operator=(const ShardQueue&) = delete;
+
+    // reader side; reserve() waits for a free slot and returns nullptr
+    // once the consumer has closed the queue
+    ShardRecord* reserve();
+    void push(ShardRecord*);
+    void finish(const char* error = nullptr);
+
+    // consumer side; pop() doesn't block, wait() does for up to msec and
+    // returns false if nothing arrived
+    ShardRecord* pop();
+    void release(ShardRecord*);
+    bool wait(unsigned msec);
+    bool drained();
+    void interrupt();
+    void close();
+
+    unsigned get_size() const
+    { return size; }
+
+    unsigned get_snaplen() const
+    { return snaplen; }
+
+    int get_dlt() const
+    { return dlt; }
+
+    const char* get_error() const
+    { return error.c_str(); }
+
+private:
+    friend class FlowShard;
+    void wake();
+
+    Ring<ShardRecord*> full;
+    Ring<ShardRecord*> free;
+    ShardRecord* records;
+    uint8_t* buffers;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::atomic<unsigned> waiters { 0 };
+    std::atomic<bool> finished { false };
+    std::atomic<bool> closed { false };
+    std::atomic<bool> poked { false };
+    std::string error;
+
+    FlowShard* shard = nullptr;
+    unsigned size;
+    unsigned snaplen;
+    int dlt;
+};
+
+class FlowShard
+{
+public:
+    // start sharding a file; called by Trough from the main thread
+    static void open(const char* file, unsigned count);
+
+    // claim the next queue of the file being sharded; returns nullptr and
+    // sets why if there is none
+    static ShardQueue* claim(
+        DAQ_ModuleInstance_h, unsigned slots, unsigned snaplen, std::string& why);
+
+    // give up the given shard of the file being sharded if it wasn't claimed
+    static void skip(unsigned shard);
+
+    // skip whatever is left of the file being sharded
+    static void abandon();
+
+    // the consumer is done with its queue
+    static void release(ShardQueue*);
+
+    // same hash for both directions; exposed for testing
+    static uint32_t hash(int dlt, const uint8_t* data, uint32_t len);
+
+private:
+    FlowShard(const char* file, unsigned count);
+    ~FlowShard();
+
+    void resolved();
+    void read();
+
+    std::string file;
+    std::vector<ShardQueue*> queues;
+    std::thread* reader = nullptr;
+    PcapReadahead* readahead = nullptr;
+    pcap_t* pcap = nullptr;
+    std::string error;
+
+    // users is changed under the mutex but read by the reader without it
+    std::mutex mutex;
+    std::atomic<unsigned> users { 0 };
+    unsigned next = 0;
+    bool complete = false;
+    int dlt = 0;
+};
+
+#endif
+
@@ -0,0 +1,357 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// pcap_readahead.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "pcap_readahead.h"
+
+#include <byteswap.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#ifdef UNIT_TEST
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "catch/snort_catch.h"
+#endif
+
+#define PCAP_HDR_LEN 24
+#define PCAP_REC_LEN 16
+
+#define PCAP_MAGIC 0xa1b2c3d4
+#define PCAP_NSEC_MAGIC 0xa1b23c4d
+
+// enhanced packet block header and trailing length, not counting options
+#define PCAPNG_MAGIC 0x0a0d0d0a
+#define PCAPNG_BYTE_ORDER 0x1a2b3c4d
+#define PCAPNG_REC_LEN 32
+
+// block types that carry one packet each
+#define PCAPNG_PB 2
+#define PCAPNG_SPB 3
+#define PCAPNG_EPB 6
+
+static const uint64_t page_mask = ~(uint64_t)(4096 - 1);
+
+PcapReadahead::PcapReadahead(const char* file, size_t w) : window(w)
+{
+    fd = open(file, O_RDONLY);
+
+    if ( fd < 0 )
+        return;
+
+    struct stat sb;
+
+    if ( fstat(fd, &sb) or !S_ISREG(sb.st_mode) )
+    {
+        close(fd);
+        fd = -1;
+        return;
+    }
+    size = sb.st_size;
+
+    uint32_t magic[3] = { };
+
+    if ( pread(fd, magic, sizeof(magic), 0) == sizeof(magic) and magic[0] == PCAPNG_MAGIC )
+    {
+        pcapng = true;
+        swapped = magic[2] != PCAPNG_BYTE_ORDER;
+        record_overhead = PCAPNG_REC_LEN;
+    }
+    else
+    {
+        swapped = magic[0] != PCAP_MAGIC and magic[0] != PCAP_NSEC_MAGIC;
+        pos = PCAP_HDR_LEN;
+    }
+
+    if ( !window or !size )
+        return;
+
+    void* m = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+    if ( m == MAP_FAILED )
+        return;
+
+    map = (uint8_t*)m;
+    madvise(map, size, MADV_SEQUENTIAL);
+    advance(0);
+}
+
+PcapReadahead::~PcapReadahead()
+{
+    if ( map )
+        munmap(map, size);
+
+    if ( fd >= 0 )
+        close(fd);
+}
+
+void PcapReadahead::update(const DAQ_Msg_h* msgs, unsigned num)
+{
+    if ( !map )
+    {
+        // can't see the records so this undercounts anything the DAQ truncated
+        uint64_t bytes = 0;
+
+        for ( unsigned i = 0; i < num; ++i )
+        {
+            if ( daq_msg_get_type(msgs[i]) == DAQ_MSG_TYPE_PACKET )
+                bytes += record_overhead + daq_msg_get_data_len(msgs[i]);
+        }
+        advance(bytes);
+        return;
+    }
+
+    unsigned pkts = 0;
+
+    for ( unsigned i = 0; i < num; ++i )
+    {
+        if ( daq_msg_get_type(msgs[i]) == DAQ_MSG_TYPE_PACKET )
+            pkts++;
+    }
+    skip_records(pkts);
+}
+
+uint32_t PcapReadahead::get32(uint64_t off) const
+{
+    uint32_t v;
+    memcpy(&v, map + off, sizeof(v));
+    return swapped ? bswap_32(v) : v;
+}
+
+// returns the offset just past the next packet record at off, skipping any
+// non-packet pcapng blocks, or off at the end of the file
+uint64_t PcapReadahead::next_record(uint64_t off) const
+{
+    if ( !pcapng )
+    {
+        if ( off + PCAP_REC_LEN > size )
+            return off;
+
+        // caplen follows the timestamp
+        return off + PCAP_REC_LEN + get32(off + 8);
+    }
+
+    uint64_t end = off;
+
+    while ( end + 8 <= size )
+    {
+        uint32_t type = get32(end);
+        uint32_t len = get32(end + 4);
+
+        if ( len < 12 )
+            break;
+
+        end += len;
+
+        if ( type == PCAPNG_EPB or type == PCAPNG_SPB or type == PCAPNG_PB )
+            return end;
+    }
+    return off;
+}
+
+// the pages at pos were just read by the DAQ so peeking at them is cheap
+void PcapReadahead::skip_records(unsigned num)
+{
+    uint64_t off = pos;
+
+    while ( num-- )
+    {
+        uint64_t next = next_record(off);
+
+        if ( next == off )
+            break;
+
+        off = next;
+    }
+    advance(off - pos);
+}
+
+void PcapReadahead::advance(uint64_t bytes)
+{
+    pos += bytes;
+
+    if ( !map )
+        return;
+
+    // request a half window at a time to keep the madvise calls infrequent
+    if ( ahead < size and ahead <= pos + window / 2 )
+    {
+        uint64_t start = ahead & page_mask;
+        uint64_t end = pos + window < size ? pos + window : size;
+
+        madvise(map + start, end - start, MADV_WILLNEED);
+        ahead = end;
+    }
+
+    if ( pos > behind + 2 * window )
+    {
+        uint64_t end = (pos - window) & page_mask;
+        posix_fadvise(fd, behind, end - behind, POSIX_FADV_DONTNEED);
+        behind = end;
+    }
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static std::string make_file(uint32_t magic, size_t size)
+{
+    char name[] = "/tmp/readahead_XXXXXX";
+    int fd = mkstemp(name);
+    REQUIRE(fd >= 0);
+
+    REQUIRE(ftruncate(fd, size) == 0);
+    REQUIRE(pwrite(fd, &magic, sizeof(magic), 0) == sizeof(magic));
+    close(fd);
+    return name;
+}
+
+TEST_CASE("readahead pcap window", "[PcapReadahead]")
+{
+    const size_t window = 64 * 1024;
+    std::string file = make_file(0xa1b2c3d4, 1024 * 1024);
+
+    PcapReadahead ra(file.c_str(), window, true);
+    CHECK(ra.get_bytes_read() == PCAP_HDR_LEN);
+    CHECK(ra.get_ahead() == PCAP_HDR_LEN + window);
+
+    // no new advice until half the window is consumed
+    ra.advance(window / 4);
+    CHECK(ra.get_ahead() == PCAP_HDR_LEN + window);
+
+    ra.advance(window / 4);
+    CHECK(ra.get_ahead() == PCAP_HDR_LEN + window / 2 + window);
+    CHECK(ra.get_behind() == 0);
+
+    ra.advance(2 * window);
+    CHECK(ra.get_behind() > 0);
+    CHECK(ra.get_behind() <= ra.get_bytes_read() - window);
+
+    ra.advance(2 * 1024 * 1024);
+    CHECK(ra.get_bytes_read() == 1024 * 1024);
+    CHECK(ra.get_ahead() == 1024 * 1024);
+
+    unlink(file.c_str());
+}
+
+TEST_CASE("readahead pcapng header", "[PcapReadahead]")
+{
+    std::string file = make_file(PCAPNG_MAGIC, 4096);
+
+    PcapReadahead ra(file.c_str(), 4096, false);
+    CHECK(ra.get_bytes_read() == 0);
+    CHECK(ra.get_ahead() == 4096);
+
+    ra.advance(100);
+    CHECK(ra.get_bytes_read() == 100);
+
+    unlink(file.c_str());
+}
+
+static std::string write_file(const std::vector<uint32_t>& words)
+{
+    char name[] = "/tmp/readahead_XXXXXX";
+    int fd = mkstemp(name);
+    REQUIRE(fd >= 0);
+
+    size_t len = words.size() * sizeof(uint32_t);
+    REQUIRE(write(fd, words.data(), len) == (ssize_t)len);
+    close(fd);
+    return name;
+}
+
+static void add_pcap_record(std::vector<uint32_t>& v, uint32_t caplen)
+{
+    // ts, caplen, wire len, then the data rounded up to words for the test
+    v.insert(v.end(), { 0, 0, caplen, caplen });
+    v.resize(v.size() + caplen / 4);
+}
+
+TEST_CASE("readahead pcap records", "[PcapReadahead]")
+{
+    std::vector<uint32_t> v = { PCAP_MAGIC, 0x00040002, 0, 0, 65535, 1 };
+    add_pcap_record(v, 60);
+    add_pcap_record(v, 1500);
+    add_pcap_record(v, 9000);
+
+    std::string file = write_file(v);
+    PcapReadahead ra(file.c_str(), 4096, false);
+
+    ra.skip_records(2);
+    CHECK(ra.get_bytes_read() == PCAP_HDR_LEN + 76 + 1516);
+
+    // stops at the end of the file
+    ra.skip_records(5);
+    CHECK(ra.get_bytes_read() == v.size() * sizeof(uint32_t));
+
+    unlink(file.c_str());
+}
+
+static void add_pcapng_block(std::vector<uint32_t>& v, uint32_t type, uint32_t body)
+{
+    uint32_t len = 12 + body;
+    v.insert(v.end(), { type, len });
+    v.resize(v.size() + body / 4);
+    v.push_back(len);
+}
+
+TEST_CASE("readahead pcapng records", "[PcapReadahead]")
+{
+    std::vector<uint32_t> v = { PCAPNG_MAGIC, 28, PCAPNG_BYTE_ORDER, 1, 0xffffffff, 0xffffffff, 28 };
+    add_pcapng_block(v, 1, 8);              // interface description
+    add_pcapng_block(v, PCAPNG_EPB, 20 + 60);
+    size_t second = v.size();
+    add_pcapng_block(v, 5, 16);             // interface statistics
+    add_pcapng_block(v, PCAPNG_EPB, 20 + 1500);
+
+    std::string file = write_file(v);
+    PcapReadahead ra(file.c_str(), 4096, false);
+
+    // the section and interface blocks are consumed with the first packet
+    ra.skip_records(1);
+    CHECK(ra.get_bytes_read() == second * sizeof(uint32_t));
+
+    ra.skip_records(1);
+    CHECK(ra.get_bytes_read() == v.size() * sizeof(uint32_t));
+
+    unlink(file.c_str());
+}
+
+TEST_CASE("readahead missing file", "[PcapReadahead]")
+{
+    PcapReadahead ra("/nonexistent/file.pcap", 4096, true);
+    ra.advance(10);
+    CHECK(ra.get_bytes_read() == 0);
+}
+
+#endif
+
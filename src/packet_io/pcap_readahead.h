@@ -0,0 +1,77 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// pcap_readahead.h
+
+#ifndef PCAP_READAHEAD_H
+#define PCAP_READAHEAD_H
+
+// PcapReadahead keeps the page cache ahead of the DAQ reading a capture
+// file.  The DAQ reads through its own stdio buffers so the position is
+// tracked by walking the record headers in the mapping, one record per
+// returned packet; the DAQ's data length can be shorter than the record's
+// caplen when it applies its own snaplen.  The file is mapped with MADV_SEQUENTIAL and each window
+// ahead of that position gets MADV_WILLNEED so the reads don't block on the
+// disk.  Pages more than a window behind are dropped so replaying large
+// capture sets doesn't evict everything else from the page cache.
+
+#include <daq_common.h>
+
+#include <cstddef>
+#include <cstdint>
+
+class PcapReadahead
+{
+public:
+    // window is in bytes and must be nonzero
+    PcapReadahead(const char* file, size_t window);
+    ~PcapReadahead();
+
+    // account for the messages returned by the last receive
+    void update(const DAQ_Msg_h*, unsigned num);
+
+    uint64_t get_bytes_read() const
+    { return pos < size ? pos : size; }
+
+    // exposed for testing
+    uint64_t get_ahead() const
+    { return ahead; }
+
+    uint64_t get_behind() const
+    { return behind; }
+
+    void advance(uint64_t bytes);
+    void skip_records(unsigned num);
+
+private:
+    uint32_t get32(uint64_t off) const;
+    uint64_t next_record(uint64_t off) const;
+
+    int fd = -1;
+    uint8_t* map = nullptr;
+    uint64_t size = 0;
+    uint64_t pos = 0;
+    uint64_t ahead = 0;
+    uint64_t behind = 0;
+    size_t window;
+    unsigned record_overhead = 16;
+    bool pcapng = false;
+    bool swapped = false;
+};
+
+#endif
+
@@ -32,7 +32,9 @@
 
 #include "log/messages.h"
 #include "main/snort_config.h"
+#include "packet_io/trough.h"
 
+#include "daq_shard.h"
 #include "sfdaq_config.h"
 #include "sfdaq_instance.h"
 #ifdef ENABLE_STATIC_DAQ
@@ -48,6 +50,13 @@ using namespace std;
 #define DAQ_DEFAULT "pcap"
 #endif
 
+// built in modules
+static DAQ_Module_h internal_daq_modules[] =
+{
+    &shard_daq_module_data,
+    nullptr
+};
+
 // common for all daq threads / instances
 static DAQ_Config_h daqcfg = nullptr;
 static DAQ_Mode default_daq_mode = DAQ_MODE_PASSIVE;
@@ -69,6 +78,7 @@ void SFDAQ::load(const SFDAQConfig* cfg)
 #ifdef ENABLE_STATIC_DAQ
     daq_load_static_modules(static_daq_modules);
 #endif
+    daq_load_static_modules(internal_daq_modules);
     int err = daq_load_dynamic_modules(dirs);
     if (err)
         FatalError("Could not load dynamic DAQ modules! (%d)\n", err);
@@ -253,11 +263,30 @@ bool SFDAQ::init(const SFDAQConfig* cfg, unsigned total_instances)
     if (total_instances > 1)
         daq_config_set_total_instances(daqcfg, total_instances);
 
+    /* With --pcap-shard, FlowShard reads the files and the shard module takes the place of
+        the terminal pcap module to feed each packet thread its share. */
+    bool sharding = Trough::get_shard_count() > 1 && SnortConfig::get_conf()->read_mode();
+
+    if (sharding)
+    {
+        for (SFDAQModuleConfig* dmc : cfg->module_configs)
+        {
+            DAQ_Module_h module = daq_find_module(dmc->name.c_str());
+            if (module && !(daq_module_get_type(module) & DAQ_TYPE_WRAPPER) && dmc->name != "pcap")
+            {
+                ParseError("--pcap-shard can't be used with the %s DAQ module\n", dmc->name.c_str());
+                daq_config_destroy(daqcfg);
+                daqcfg = nullptr;
+                return false;
+            }
+        }
+    }
+
     /* If no modules were specified, try to automatically configure with the default. */
     if (cfg->module_configs.empty())
     {
         SFDAQModuleConfig dmc;
-        dmc.name = DAQ_DEFAULT;
+        dmc.name = sharding ? SHARD_DAQ_NAME : DAQ_DEFAULT;
         if (!AddDaqModuleConfig(&dmc))
         {
             daq_config_destroy(daqcfg);
@@ -275,7 +304,7 @@ bool SFDAQ::init(const SFDAQConfig* cfg, unsigned total_instances)
         if (module && (daq_module_get_type(module) & DAQ_TYPE_WRAPPER))
         {
             SFDAQModuleConfig dmc;
-            dmc.name = "pcap";
+            dmc.name = sharding ? SHARD_DAQ_NAME : "pcap";
             dmc.mode = SFDAQModuleConfig::SFDAQ_MODE_READ_FILE;
             if (!AddDaqModuleConfig(&dmc))
             {
@@ -288,6 +317,14 @@ bool SFDAQ::init(const SFDAQConfig* cfg, unsigned total_instances)
 
     for (SFDAQModuleConfig* dmc : cfg->module_configs)
     {
+        SFDAQModuleConfig shard;
+
+        if (sharding && dmc->name == "pcap")
+        {
+            shard.name = SHARD_DAQ_NAME;
+            shard.mode = dmc->mode;
+            dmc = &shard;
+        }
         if (!AddDaqModuleConfig(dmc))
         {
             daq_config_destroy(daqcfg);
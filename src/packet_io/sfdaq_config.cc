@@ -66,6 +66,11 @@ void SFDAQModuleConfig::set_variable(const char* varkvp)
 SFDAQConfig::SFDAQConfig()
 {
     batch_size = BATCH_SIZE_UNSET;
+    batch_min = BATCH_MIN_DEFAULT;
+    batch_latency = BATCH_LATENCY_DEFAULT;
+    batch_adaptive = false;
+    batch_prefetch = false;
+    pcap_readahead = 0;
     mru_size = SNAPLEN_UNSET;
     timeout = TIMEOUT_DEFAULT;
 }
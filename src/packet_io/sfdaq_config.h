@@ -69,6 +69,11 @@ struct SFDAQConfig
     /* Instance configuration */
     std::vector<std::string> inputs;
     uint32_t batch_size;
+    uint32_t batch_min;
+    unsigned batch_latency;
+    bool batch_adaptive;
+    bool batch_prefetch;
+    unsigned pcap_readahead;
     int mru_size;
     unsigned int timeout;
     std::vector<SFDAQModuleConfig*> module_configs;
@@ -77,6 +82,8 @@ struct SFDAQConfig
     static constexpr uint32_t BATCH_SIZE_UNSET = 0;
     static constexpr int SNAPLEN_UNSET = -1;
     static constexpr uint32_t BATCH_SIZE_DEFAULT = 64;
+    static constexpr uint32_t BATCH_MIN_DEFAULT = 1;
+    static constexpr unsigned BATCH_LATENCY_DEFAULT = 1000;
     static constexpr int SNAPLEN_DEFAULT = 1518;
     static constexpr unsigned TIMEOUT_DEFAULT = 1000;
 };
@@ -56,6 +56,11 @@ public:
             return daq_msgs[curr_batch_idx++];
         return nullptr;
     }
+    const DAQ_Msg_h* get_batch(unsigned& num) const
+    {
+        num = curr_batch_size;
+        return daq_msgs;
+    }
     int finalize_message(DAQ_Msg_h msg, DAQ_Verdict verdict);
     const char* get_error();
 
@@ -78,6 +78,11 @@ static const Parameter s_params[] =
     { "inputs", Parameter::PT_LIST, input_list_param, nullptr, "input sources" },
     { "snaplen", Parameter::PT_INT, "0:65535", "1518", "set snap length (same as -s)" },
     { "batch_size", Parameter::PT_INT, "1:", "64", "set receive batch size (same as --daq-batch-size)" },
+    { "batch_adaptive", Parameter::PT_BOOL, nullptr, "false", "size each receive from recent load with batch_size as the maximum" },
+    { "batch_min", Parameter::PT_INT, "1:", "1", "minimum receive batch size in adaptive mode" },
+    { "batch_latency", Parameter::PT_INT, "0:max32", "1000", "maximum usecs to process a batch in adaptive mode (0 is unbounded)" },
+    { "batch_prefetch", Parameter::PT_BOOL, nullptr, "false", "prefetch flows for each received batch before processing" },
+    { "pcap_readahead", Parameter::PT_INT, "0:4096", "0", "MB of pcap file to prefetch ahead of the reader in read mode (0 to disable)" },
     { "modules", Parameter::PT_LIST, daq_module_param, nullptr, "DAQ modules to use" },
 
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
@@ -122,6 +127,26 @@ bool SFDAQModule::set(const char* fqn, Value& v, SnortConfig*)
     {
         config->set_batch_size(v.get_uint32());
     }
+    else if (!strcmp(fqn, "daq.batch_adaptive"))
+    {
+        config->batch_adaptive = v.get_bool();
+    }
+    else if (!strcmp(fqn, "daq.batch_min"))
+    {
+        config->batch_min = v.get_uint32();
+    }
+    else if (!strcmp(fqn, "daq.batch_latency"))
+    {
+        config->batch_latency = v.get_uint32();
+    }
+    else if (!strcmp(fqn, "daq.batch_prefetch"))
+    {
+        config->batch_prefetch = v.get_bool();
+    }
+    else if (!strcmp(fqn, "daq.pcap_readahead"))
+    {
+        config->pcap_readahead = v.get_uint32();
+    }
     else if (!strcmp(fqn, "daq.modules.name"))
     {
         module_config->name = v.get_string();
@@ -205,6 +230,16 @@ const PegInfo daq_names[] =
     { CountType::SUM, "sof_messages", "start of flow messages received from DAQ" },
     { CountType::SUM, "eof_messages", "end of flow messages received from DAQ" },
     { CountType::SUM, "other_messages", "messages received from DAQ with unrecognized message type" },
+    { CountType::NOW, "batch_size", "current adaptive receive batch size" },
+    { CountType::SUM, "batch_1", "adaptive receives that returned 1 message" },
+    { CountType::SUM, "batch_2_7", "adaptive receives that returned 2 to 7 messages" },
+    { CountType::SUM, "batch_8_31", "adaptive receives that returned 8 to 31 messages" },
+    { CountType::SUM, "batch_32_127", "adaptive receives that returned 32 to 127 messages" },
+    { CountType::SUM, "batch_128_up", "adaptive receives that returned 128 or more messages" },
+    { CountType::SUM, "prefetch_keys", "flow keys built and prefetched for batched packets" },
+    { CountType::SUM, "prefetch_skips", "batched packets with headers not parsed for prefetch" },
+    { CountType::SUM, "prefetch_flows", "existing flows prefetched for batched packets" },
+    { CountType::SUM, "pcap_bytes", "bytes of pcap files read with pcap_readahead enabled" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -78,6 +78,12 @@ struct DAQStats
     PegCount sof_messages;
     PegCount eof_messages;
     PegCount other_messages;
+    PegCount batch_size;
+    PegCount batch_dist[5];
+    PegCount prefetch_keys;
+    PegCount prefetch_skips;
+    PegCount prefetch_flows;
+    PegCount pcap_bytes;
 };
 
 extern THREAD_LOCAL DAQStats daq_stats;
@@ -63,6 +63,18 @@ TEST_CASE("parse sfdaq config", "[SFDAQModule]")
     Value batch_size(static_cast<double>(10));
     CHECK(sfdm.set("daq.batch_size", batch_size, &sc));
 
+    Value batch_adaptive(true);
+    CHECK(sfdm.set("daq.batch_adaptive", batch_adaptive, &sc));
+
+    Value batch_min(static_cast<double>(2));
+    CHECK(sfdm.set("daq.batch_min", batch_min, &sc));
+
+    Value batch_latency(static_cast<double>(500));
+    CHECK(sfdm.set("daq.batch_latency", batch_latency, &sc));
+
+    Value pcap_readahead(static_cast<double>(32));
+    CHECK(sfdm.set("daq.pcap_readahead", pcap_readahead, &sc));
+
     CHECK(sfdm.begin("daq.modules", 0, &sc));
 
     SECTION("empty module config")
@@ -107,6 +119,10 @@ TEST_CASE("parse sfdaq config", "[SFDAQModule]")
 
         CHECK((cfg->mru_size == 6666));
         CHECK((cfg->batch_size == 10));
+        CHECK(cfg->batch_adaptive);
+        CHECK((cfg->batch_min == 2));
+        CHECK((cfg->batch_latency == 500));
+        CHECK((cfg->pcap_readahead == 32));
 
         REQUIRE(cfg->module_configs.size() == 1);
         for (auto it : cfg->module_configs)
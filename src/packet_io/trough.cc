@@ -32,8 +32,11 @@
 #include "helpers/directory.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
+#include "main/thread_config.h"
 #include "utils/util.h"
 
+#include "flow_shard.h"
+
 using namespace snort;
 
 std::vector<struct Trough::PcapReadObject> Trough::pcap_object_list;
@@ -42,6 +45,10 @@ std::string Trough::pcap_filter = "*.*cap*";
 std::vector<std::string>::const_iterator Trough::pcap_queue_iter;
 
 unsigned Trough::pcap_loop_count = 0;
+bool Trough::pcap_shard = false;
+unsigned Trough::shard_count = 1;
+unsigned Trough::next_shard = 0;
+std::string Trough::shard_pcap;
 std::atomic<unsigned> Trough::file_count{0};
 
 bool Trough::add_pcaps_dir(const std::string& dirname, const std::string& filter)
@@ -229,12 +236,20 @@ void Trough::setup()
         pcap_queue_iter = pcap_queue.cbegin();
     }
     pcap_filter.clear();
+
+    shard_count = pcap_shard ? ThreadConfig::get_instance_max() : 1;
+
+    if (shard_count > 1 && std::find(pcap_queue.cbegin(), pcap_queue.cend(), "-") != pcap_queue.cend())
+        FatalError("--pcap-shard can't be used to read stdin\n");
 }
 
 void Trough::cleanup()
 {
     /* clean up pcap queues */
     pcap_queue.clear();
+    shard_pcap.clear();
+    next_shard = 0;
+    FlowShard::abandon();
 }
 
 const char* Trough::get_next()
@@ -258,8 +273,30 @@ const char* Trough::get_next()
     return pcap;
 }
 
+const char* Trough::get_next(unsigned& shard)
+{
+    if (next_shard)
+    {
+        shard = next_shard;
+        if (++next_shard == shard_count)
+            next_shard = 0;
+        return shard_pcap.c_str();
+    }
+
+    const char* pcap = get_next();
+    shard = 0;
+
+    if (pcap && shard_count > 1)
+    {
+        shard_pcap = pcap;
+        next_shard = 1;
+        FlowShard::open(pcap, shard_count);
+    }
+    return pcap;
+}
+
 bool Trough::has_next()
 {
-    return (!pcap_queue.empty() && pcap_queue_iter != pcap_queue.cend());
+    return next_shard || (!pcap_queue.empty() && pcap_queue_iter != pcap_queue.cend());
 }
 
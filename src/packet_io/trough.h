@@ -40,11 +40,23 @@ public:
     {
         pcap_loop_count = c;
     }
+    // split each source across all packet threads by flow
+    static void set_sharding(bool b)
+    {
+        pcap_shard = b;
+    }
     static void set_filter(const char *f);
     static void add_source(SourceType type, const char *list);
     static void setup();
     static bool has_next();
     static const char *get_next();
+    // in sharding mode each source is returned once per shard and the
+    // first one opens the FlowShard that reads it
+    static const char *get_next(unsigned& shard);
+    static unsigned get_shard_count()
+    {
+        return shard_count;
+    }
     static unsigned get_file_count()
     {
         return file_count;
@@ -81,6 +93,10 @@ private:
     static std::string pcap_filter;
 
     static unsigned pcap_loop_count;
+    static bool pcap_shard;
+    static unsigned shard_count;
+    static unsigned next_shard;
+    static std::string shard_pcap;
     static std::atomic<unsigned> file_count;
 };
 
@@ -24,6 +24,8 @@
 #include "packet_manager.h"
 
 #include <daq.h>
+
+#include <cstring>
 #include <mutex>
 
 #include "codecs/codec_module.h"
@@ -32,6 +34,7 @@
 #include "log/text_log.h"
 #include "main/snort_config.h"
 #include "main/snort_debug.h"
+#include "memory/huge_page_pool.h"
 #include "packet_io/active.h"
 #include "packet_io/sfdaq.h"
 #include "profiler/profiler_defs.h"
@@ -69,16 +72,18 @@ const std::array<const char*, PacketManager::stat_offset> PacketManager::stat_na
 };
 
 // Encoder Foo
-static THREAD_LOCAL std::array<uint8_t, Codec::PKT_MAX>* s_pkt;
+static THREAD_LOCAL uint8_t* s_pkt;
 
 void PacketManager::thread_init()
 {
-    s_pkt = new std::array<uint8_t, Codec::PKT_MAX>{ {0} };
+    s_pkt = memory::HugePagePool::alloc(Codec::PKT_MAX);
+    memset(s_pkt, 0, Codec::PKT_MAX);
 }
 
 void PacketManager::thread_term()
 {
-    delete s_pkt;
+    memory::HugePagePool::dealloc(s_pkt);
+    s_pkt = nullptr;
 }
 
 //-------------------------------------------------------------------------
@@ -492,7 +497,7 @@ const uint8_t* PacketManager::encode_response(
     TcpResponse type, EncodeFlags flags, const Packet* p, uint32_t& len,
     const uint8_t* const payload, uint32_t payload_len)
 {
-    Buffer buf(s_pkt->data(), s_pkt->size());
+    Buffer buf(s_pkt, Codec::PKT_MAX);
 
     switch (type)
     {
@@ -539,7 +544,7 @@ const uint8_t* PacketManager::encode_response(
 const uint8_t* PacketManager::encode_reject(UnreachResponse type,
     EncodeFlags flags, const Packet* p, uint32_t& len)
 {
-    Buffer buf(s_pkt->data(), s_pkt->size());
+    Buffer buf(s_pkt, Codec::PKT_MAX);
 
     if (p->is_ip4())
     {
@@ -90,6 +90,21 @@ public:
     {
         return bnfaPatternCount(obj);
     }
+
+    bool serialize(uint8_t*& buf, size_t& sz) const override
+    {
+        return bnfaSerialize(obj, buf, sz);
+    }
+
+    bool deserialize(const uint8_t* buf, size_t sz) override
+    {
+        return bnfaDeserialize(obj, buf, sz);
+    }
+
+    void get_hash(std::string& hash) override
+    {
+        bnfaGetHash(obj, hash);
+    }
 };
 
 //-------------------------------------------------------------------------
@@ -132,7 +147,7 @@ static const MpseApi bnfa_api =
         nullptr,
         nullptr
     },
-    MPSE_BASE,
+    MPSE_BASE | MPSE_MTBLD,
     nullptr,
     nullptr,
     nullptr,
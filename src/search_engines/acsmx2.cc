@@ -123,9 +123,19 @@
 
 #include "acsmx2.h"
 
+#include <sys/mman.h>
+
+#include <atomic>
 #include <cassert>
+#include <cstdlib>
 #include <list>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
 
+#include "hash/hashes.h"
+#include "helpers/byte_set.h"
 #include "log/messages.h"
 #include "utils/stats.h"
 #include "utils/util.h"
@@ -134,31 +144,41 @@ using namespace snort;
 
 #define printf LogMessage
 
-static int acsm2_total_memory = 0;
-static int acsm2_pattern_memory = 0;
-static int acsm2_matchlist_memory = 0;
-static int acsm2_transtable_memory = 0;
-static int acsm2_dfa_memory = 0;
-static int acsm2_dfa1_memory = 0;
-static int acsm2_dfa2_memory = 0;
-static int acsm2_dfa4_memory = 0;
-static int acsm2_failstate_memory = 0;
+// instances may be compiled in parallel so the totals are atomic
+static std::atomic<int> acsm2_total_memory { 0 };
+static std::atomic<int> acsm2_pattern_memory { 0 };
+static std::atomic<int> acsm2_matchlist_memory { 0 };
+static std::atomic<int> acsm2_transtable_memory { 0 };
+static std::atomic<int> acsm2_dfa_memory { 0 };
+static std::atomic<int> acsm2_dfa1_memory { 0 };
+static std::atomic<int> acsm2_dfa2_memory { 0 };
+static std::atomic<int> acsm2_dfa4_memory { 0 };
+static std::atomic<int> acsm2_failstate_memory { 0 };
 
 struct acsm_summary_t
 {
-    unsigned num_states;
-    unsigned num_transitions;
-    unsigned num_instances;
-    unsigned num_patterns;
-    unsigned num_characters;
-    unsigned num_match_states;
-    unsigned num_1byte_instances;
-    unsigned num_2byte_instances;
-    unsigned num_4byte_instances;
-    ACSM_STRUCT2 acsm;
+    std::atomic<unsigned> num_states;
+    std::atomic<unsigned> num_transitions;
+    std::atomic<unsigned> num_instances;
+    std::atomic<unsigned> num_patterns;
+    std::atomic<unsigned> num_characters;
+    std::atomic<unsigned> num_match_states;
+    std::atomic<unsigned> num_1byte_instances;
+    std::atomic<unsigned> num_2byte_instances;
+    std::atomic<unsigned> num_4byte_instances;
+    std::atomic<unsigned> num_root_skip_instances;
+    std::atomic<unsigned> num_huge_slabs;
+    ACSM_STRUCT2 acsm;  // last instance, guarded by summary_mutex
 };
 
 static acsm_summary_t summary;
+static std::mutex summary_mutex;
+
+static void set_summary_acsm(const ACSM_STRUCT2* acsm)
+{
+    std::lock_guard<std::mutex> lock(summary_mutex);
+    memcpy(&summary.acsm, acsm, sizeof(ACSM_STRUCT2));
+}
 
 void acsm_init_summary()
 {
@@ -171,6 +191,8 @@ void acsm_init_summary()
     summary.num_1byte_instances = 0;
     summary.num_2byte_instances = 0;
     summary.num_4byte_instances = 0;
+    summary.num_root_skip_instances = 0;
+    summary.num_huge_slabs = 0;
     memset(&summary.acsm, 0, sizeof(ACSM_STRUCT2));
     acsm2_total_memory = 0;
     acsm2_pattern_memory = 0;
@@ -236,9 +258,31 @@ static void* AC_MALLOC(int n, Acsm2MemoryType type)
     return p;
 }
 
-static void* AC_MALLOC_DFA(int n, int sizeofstate)
+// the dfa is one slab so large tables can be backed by huge pages instead
+// of rows scattered across the heap
+#define ACSM_HUGE_PAGE (2 * 1024 * 1024)
+#define ACSM_CACHE_LINE 64
+
+static void* AC_MALLOC_SLAB(size_t n, int sizeofstate)
 {
-    void* p = snort_calloc(n);
+    size_t align = (n >= ACSM_HUGE_PAGE) ? ACSM_HUGE_PAGE : ACSM_CACHE_LINE;
+
+    // huge page slabs are allocated in whole pages so the advice covers only owned memory
+    size_t len = (align == ACSM_HUGE_PAGE) ? (n + align - 1) & ~(align - 1) : n;
+    void* p;
+
+    if ( posix_memalign(&p, align, len) )
+        throw std::bad_alloc();
+
+#ifdef MADV_HUGEPAGE
+    if ( align == ACSM_HUGE_PAGE )
+    {
+        madvise(p, len, MADV_HUGEPAGE);
+        summary.num_huge_slabs++;
+    }
+#endif
+
+    memset(p, 0, n);
 
     switch (sizeofstate)
     {
@@ -288,7 +332,7 @@ static void AC_FREE(void* p, int n, Acsm2MemoryType type)
     }
 }
 
-static void AC_FREE_DFA(void* p, int n, int sizeofstate)
+static void AC_FREE_SLAB(void* p, size_t n, int sizeofstate)
 {
     if (p != nullptr)
     {
@@ -308,10 +352,26 @@ static void AC_FREE_DFA(void* p, int n, int sizeofstate)
 
         acsm2_dfa_memory -= n;
         acsm2_total_memory -= n;
-        snort_free(p);
+        free(p);
     }
 }
 
+static inline acstate_t get_row_state(const uint8_t* row, int sizeofstate, int i)
+{
+    switch ( sizeofstate )
+    {
+    case 1:
+        return row[i];
+    case 2:
+        return ((const uint16_t*)row)[i];
+    default:
+        return ((const acstate_t*)row)[i];
+    }
+}
+
+static inline acstate_t get_match_bit(int sizeofstate)
+{ return (acstate_t)1 << (8 * sizeofstate - 1); }
+
 
 // Get Next State-NFA, using direct index to speed up search
 
@@ -716,42 +776,17 @@ static void Convert_NFA_To_DFA(ACSM_STRUCT2* acsm)
 
 // Convert a row lists for the state table to a full vector format
 
-static int Conv_List_To_Full(ACSM_STRUCT2* acsm)
+static void Conv_List_To_Full(ACSM_STRUCT2* acsm)
 {
-    acstate_t k;
-    acstate_t* p;
-    acstate_t** NextState = acsm->acsmNextState;
+    size_t row_size = acsm->sizeofstate * acsm->acsmAlphabetSize;
 
-    for (k = 0; k < (acstate_t)acsm->acsmNumStates; k++)
-    {
-        p = (acstate_t*)AC_MALLOC_DFA(acsm->sizeofstate * (acsm->acsmAlphabetSize + 2),
-            acsm->sizeofstate);
-        if (p == nullptr)
-            return -1;
+    acsm->acsmSlabSize = row_size * acsm->acsmNumStates;
+    acsm->acsmSlab = AC_MALLOC_SLAB(acsm->acsmSlabSize, acsm->sizeofstate);
 
-        switch (acsm->sizeofstate)
-        {
-        case 1:
-            List_ConvToFull(acsm, k, (acstate_t*)((uint8_t*)p + 2));
-            *((uint8_t*)p) = 0;
-            *((uint8_t*)p + 1) = 0;
-            break;
-        case 2:
-            List_ConvToFull(acsm, k, (acstate_t*)((uint16_t*)p + 2));
-            *((uint16_t*)p) = 0;
-            *((uint16_t*)p + 1) = 0;
-            break;
-        default:
-            List_ConvToFull(acsm, k, (p + 2));
-            p[0] = 0;
-            p[1] = 0; /* no matches yet */
-            break;
-        }
+    uint8_t* row = (uint8_t*)acsm->acsmSlab;
 
-        NextState[k] = p; /* now we have a full format row vector  */
-    }
-
-    return 0;
+    for (acstate_t k = 0; k < (acstate_t)acsm->acsmNumStates; k++, row += row_size)
+        List_ConvToFull(acsm, k, (acstate_t*)row);
 }
 
 // Create a new AC full state machine
@@ -799,35 +834,42 @@ int acsmAddPattern2(
     return 0;
 }
 
-// Copy a boolean match flag int NextState table, for caching purposes.
+// Set the match bit in each transition to a state with matches so the search
+// loop only touches MatchList when there is something to report.
 
-static void acsmUpdateMatchStates(ACSM_STRUCT2* acsm)
+template<typename T>
+static void acsmSetMatchBits(T* p, size_t n, ACSM_PATTERN2** MatchList)
 {
-    acstate_t state;
-    acstate_t** NextState = acsm->acsmNextState;
-    ACSM_PATTERN2** MatchList = acsm->acsmMatchList;
+    const T match_bit = (T)1 << (8 * sizeof(T) - 1);
 
-    for (state = 0; state < (acstate_t)acsm->acsmNumStates; state++)
+    for (size_t i = 0; i < n; i++)
     {
-        acstate_t* p = NextState[state];
+        if (MatchList[p[i]])
+            p[i] |= match_bit;
+    }
+}
 
-        if (MatchList[state])
-        {
-            switch (acsm->sizeofstate)
-            {
-            case 1:
-                *((uint8_t*)p + 1) = 1;
-                break;
-            case 2:
-                *((uint16_t*)p + 1) = 1;
-                break;
-            default:
-                p[1] = 1;
-                break;
-            }
+static void acsmUpdateMatchStates(ACSM_STRUCT2* acsm)
+{
+    size_t n = (size_t)acsm->acsmNumStates * acsm->acsmAlphabetSize;
+
+    switch (acsm->sizeofstate)
+    {
+    case 1:
+        acsmSetMatchBits((uint8_t*)acsm->acsmSlab, n, acsm->acsmMatchList);
+        break;
+    case 2:
+        acsmSetMatchBits((uint16_t*)acsm->acsmSlab, n, acsm->acsmMatchList);
+        break;
+    default:
+        acsmSetMatchBits((acstate_t*)acsm->acsmSlab, n, acsm->acsmMatchList);
+        break;
+    }
 
+    for (int state = 0; state < acsm->acsmNumStates; state++)
+    {
+        if (acsm->acsmMatchList[state])
             summary.num_match_states++;
-        }
     }
 }
 
@@ -898,12 +940,13 @@ static inline int _acsmCompile2(ACSM_STRUCT2* acsm)
     /* Add the 0'th state */
     acsm->acsmNumStates++;
 
-    if (acsm->acsmNumStates < UINT8_MAX)
+    /* the high bit of each state is reserved for the match flag */
+    if (acsm->acsmNumStates <= (1 << 7))
     {
         acsm->sizeofstate = 1;
         summary.num_1byte_instances++;
     }
-    else if (acsm->acsmNumStates < UINT16_MAX)
+    else if (acsm->acsmNumStates <= (1 << 15))
     {
         acsm->sizeofstate = 2;
         summary.num_2byte_instances++;
@@ -919,11 +962,6 @@ static inline int _acsmCompile2(ACSM_STRUCT2* acsm)
         (acstate_t*)AC_MALLOC(sizeof(acstate_t) * acsm->acsmNumStates,
             ACSM2_MEMORY_TYPE__FAILSTATE);
 
-    /* Alloc a separate state transition table == in state 's' due to event 'k', transition to
-      'next' state */
-    acsm->acsmNextState =
-        (acstate_t**)AC_MALLOC_DFA(acsm->acsmNumStates * sizeof(acstate_t*), acsm->sizeofstate);
-
     Build_NFA(acsm);
     Convert_NFA_To_DFA(acsm);
 
@@ -931,8 +969,7 @@ static inline int _acsmCompile2(ACSM_STRUCT2* acsm)
     AC_FREE(acsm->acsmFailState, sizeof(acstate_t) * acsm->acsmNumStates, ACSM2_MEMORY_TYPE__FAILSTATE);
     acsm->acsmFailState = nullptr;
 
-    if ( Conv_List_To_Full(acsm) )
-        return -1;
+    Conv_List_To_Full(acsm);
 
     /* load boolean match flags into state table */
     acsmUpdateMatchStates(acsm);
@@ -945,15 +982,52 @@ static inline int _acsmCompile2(ACSM_STRUCT2* acsm)
     summary.num_transitions += acsm->acsmNumTrans;
     summary.num_instances++;
 
-    memcpy(&summary.acsm, acsm, sizeof(ACSM_STRUCT2));
+    set_summary_acsm(acsm);
 
     return 0;
 }
 
+// Root state skipping only pays off if the root state is mostly left in
+// place; with too many bytes in the set we just thrash between paths.
+#define ACSM_ROOT_SKIP_MAX 128
+
+static void acsmBuildRootSkip(ACSM_STRUCT2* acsm)
+{
+    if ( !ByteSet::has_simd() or acsm->acsmMatchList[0] )
+        return;
+
+    ByteSet* bs = new ByteSet;
+
+    // row 0 is first in the slab
+    const uint8_t* row = (const uint8_t*)acsm->acsmSlab;
+
+    for ( int i = 0; i < acsm->acsmAlphabetSize; i++ )
+    {
+        if ( get_row_state(row, acsm->sizeofstate, xlatcase[i]) )
+            bs->add((uint8_t)i);
+    }
+
+    if ( bs->count() > ACSM_ROOT_SKIP_MAX )
+    {
+        delete bs;
+        return;
+    }
+
+    acsm->acsmRootSkip = bs;
+    summary.num_root_skip_instances++;
+}
+
 int acsmCompile2(SnortConfig* sc, ACSM_STRUCT2* acsm)
 {
-    if ( int rval = _acsmCompile2(acsm) )
-        return rval;
+    // the dfa is already built if it was deserialized
+    if ( !acsm->acsmSlab )
+    {
+        if ( int rval = _acsmCompile2(acsm) )
+            return rval;
+    }
+
+    if ( !acsm->acsmRootSkip )
+        acsmBuildRootSkip(acsm);
 
     if ( acsm->agent )
         acsmBuildMatchStateTrees2(sc, acsm);
@@ -973,29 +1047,41 @@ void acsmx2_print_qinfo()
 *   Perf-Notes:
 *    1) replaced ConvertCaseEx with inline xlatcase - this improves performance 5-10%
 *    2) using 'nocase' improves performance again by 10-15%, since memcmp is not needed
-*    3)
+*    3) rows are packed in one slab indexed by state and the match flag is
+*       carried in the high bit of the next state so there is no row pointer
+*       or match flag load per byte
+*    4) in the root state, skip ahead with simd to the next byte that
+*       leaves the root state; the root state never has matches so this
+*       produces the same results as stepping through each byte
 */
+#define AC_ROW(s) ((s) << 8)
+
+#define AC_SKIP_ROOT \
+    if ( !state and RootSkip and !RootSkip->has(*T) ) \
+    { \
+        T = RootSkip->find(T + 1, Tend); \
+        if ( T == Tend ) \
+            break; \
+    }
+
 #define AC_SEARCH \
-    for (; T < Tend; T++ ) \
+    while ( T < Tend ) \
     { \
-        ps = NextState[ state ]; \
-        sindex = xlatcase[T[0]]; \
-        if (ps[1]) \
+        AC_SKIP_ROOT \
+        state = NextState[AC_ROW(state) + xlatcase[*T++]]; \
+        if ( state & MatchBit ) \
         { \
+            state ^= MatchBit; \
             mlist = MatchList[state]; \
-            if (mlist) \
+            index = T - Tx; \
+            nfound++; \
+            if (match (mlist->udata, mlist->rule_option_tree, index, context, \
+                mlist->neg_list) > 0) \
             { \
-                index = T - Tx; \
-                nfound++; \
-                if (match (mlist->udata, mlist->rule_option_tree, index, context, \
-                    mlist->neg_list) > 0) \
-                { \
-                    *current_state = state; \
-                    return nfound; \
-                } \
+                *current_state = state; \
+                return nfound; \
             } \
         } \
-        state = ps[2u + sindex]; \
     }
 
 int acsm_search_dfa_full(
@@ -1007,10 +1093,10 @@ int acsm_search_dfa_full(
     const uint8_t* Tend;
     const uint8_t* T;
     int index;
-    int sindex;
     int nfound = 0;
     acstate_t state;
     ACSM_PATTERN2** MatchList = acsm->acsmMatchList;
+    const ByteSet* RootSkip = acsm->acsmRootSkip;
 
     T = Tx;
     Tend = Tx + n;
@@ -1020,44 +1106,40 @@ int acsm_search_dfa_full(
 
     state = *current_state;
 
+    /* Check the start state for a pattern match; the rest are flagged */
+    mlist = MatchList[state];
+    if (mlist)
+    {
+        nfound++;
+        if (match(mlist->udata, mlist->rule_option_tree, 0, context, mlist->neg_list) > 0)
+            return nfound;
+    }
+
     switch (acsm->sizeofstate)
     {
     case 1:
     {
-        uint8_t* ps;
-        uint8_t** NextState = (uint8_t**)acsm->acsmNextState;
+        const uint8_t* NextState = (const uint8_t*)acsm->acsmSlab;
+        const acstate_t MatchBit = get_match_bit(1);
         AC_SEARCH
     }
     break;
     case 2:
     {
-        uint16_t* ps;
-        uint16_t** NextState = (uint16_t**)acsm->acsmNextState;
+        const uint16_t* NextState = (const uint16_t*)acsm->acsmSlab;
+        const acstate_t MatchBit = get_match_bit(2);
         AC_SEARCH
     }
     break;
     default:
     {
-        acstate_t* ps;
-        acstate_t** NextState = acsm->acsmNextState;
+        const acstate_t* NextState = (const acstate_t*)acsm->acsmSlab;
+        const acstate_t MatchBit = get_match_bit(4);
         AC_SEARCH
     }
     break;
     }
 
-    /* Check the last state for a pattern match */
-    mlist = MatchList[state];
-    if (mlist)
-    {
-        index = T - Tx;
-        nfound++;
-        if (match(mlist->udata, mlist->rule_option_tree, index, context, mlist->neg_list) > 0)
-        {
-            *current_state = state;
-            return nfound;
-        }
-    }
-
     *current_state = state;
     return nfound;
 }
@@ -1070,15 +1152,16 @@ int acsm_search_dfa_full(
 *   Perf-Notes:
 *    1) replaced ConvertCaseEx with inline xlatcase - this improves performance 5-10%
 *    2) using 'nocase' improves performance again by 10-15%, since memcmp is not needed
-*    3)
+*    3) see acsm_search_dfa_full
 */
 #define AC_SEARCH_ALL \
-    for (; T < Tend; T++ ) \
+    while ( T < Tend ) \
     { \
-        ps = NextState[ state ]; \
-        sindex = xlatcase[T[0]]; \
-        if (ps[1]) \
+        AC_SKIP_ROOT \
+        state = NextState[AC_ROW(state) + xlatcase[*T++]]; \
+        if ( state & MatchBit ) \
         { \
+            state ^= MatchBit; \
             for ( mlist = MatchList[state]; \
                 mlist!= nullptr; \
                 mlist = mlist->next ) \
@@ -1096,7 +1179,6 @@ int acsm_search_dfa_full(
                 } \
             } \
         } \
-        state = ps[2u + sindex]; \
     }
 
 int acsm_search_dfa_full_all(
@@ -1107,10 +1189,10 @@ int acsm_search_dfa_full_all(
     const uint8_t* Tend;
     const uint8_t* T;
     int index;
-    int sindex;
     int nfound = 0;
     acstate_t state;
     ACSM_PATTERN2** MatchList = acsm->acsmMatchList;
+    const ByteSet* RootSkip = acsm->acsmRootSkip;
 
     T = Tx;
     Tend = Tx + n;
@@ -1120,49 +1202,44 @@ int acsm_search_dfa_full_all(
 
     state = *current_state;
 
+    /* Check the start state for a pattern match; the rest are flagged */
+    for ( mlist = MatchList[state];
+        mlist!= nullptr;
+        mlist = mlist->next )
+    {
+        if ( mlist->nocase || (memcmp (mlist->casepatrn, T - mlist->n, mlist->n) == 0))
+        {
+            nfound++;
+            if (match(mlist->udata, mlist->rule_option_tree, 0, context, mlist->neg_list) > 0)
+                return nfound;
+        }
+    }
+
     switch (acsm->sizeofstate)
     {
     case 1:
     {
-        uint8_t* ps;
-        uint8_t** NextState = (uint8_t**)acsm->acsmNextState;
+        const uint8_t* NextState = (const uint8_t*)acsm->acsmSlab;
+        const acstate_t MatchBit = get_match_bit(1);
         AC_SEARCH_ALL
     }
     break;
     case 2:
     {
-        uint16_t* ps;
-        uint16_t** NextState = (uint16_t**)acsm->acsmNextState;
+        const uint16_t* NextState = (const uint16_t*)acsm->acsmSlab;
+        const acstate_t MatchBit = get_match_bit(2);
         AC_SEARCH_ALL
     }
     break;
     default:
     {
-        acstate_t* ps;
-        acstate_t** NextState = acsm->acsmNextState;
+        const acstate_t* NextState = (const acstate_t*)acsm->acsmSlab;
+        const acstate_t MatchBit = get_match_bit(4);
         AC_SEARCH_ALL
     }
     break;
     }
 
-    /* Check the last state for a pattern match */
-    for ( mlist = MatchList[state];
-        mlist!= nullptr;
-        mlist = mlist->next )
-    {
-        index = T - Tx;
-
-        if ( mlist->nocase || (memcmp (mlist->casepatrn, T - mlist->n, mlist->n) == 0))
-        {
-            nfound++;
-            if (match(mlist->udata, mlist->rule_option_tree, index, context, mlist->neg_list) > 0)
-            {
-                *current_state = state;
-                return nfound;
-            }
-        }
-    }
-
     *current_state = state;
     return nfound;
 }
@@ -1193,8 +1270,6 @@ void acsmFree2(ACSM_STRUCT2* acsm)
 
             AC_FREE(ilist, 0, ACSM2_MEMORY_TYPE__NONE);
         }
-
-        AC_FREE_DFA(acsm->acsmNextState[i], 0, 0);
     }
 
     for (plist = acsm->acsmPatterns; plist; )
@@ -1211,7 +1286,9 @@ void acsmFree2(ACSM_STRUCT2* acsm)
         plist = tmpPlist;
     }
 
-    AC_FREE_DFA(acsm->acsmNextState, 0, 0);
+    delete acsm->acsmRootSkip;
+
+    AC_FREE_SLAB(acsm->acsmSlab, acsm->acsmSlabSize, acsm->sizeofstate);
     AC_FREE(acsm->acsmFailState, 0, ACSM2_MEMORY_TYPE__NONE);
     AC_FREE(acsm->acsmMatchList, 0, ACSM2_MEMORY_TYPE__NONE);
     AC_FREE(acsm, 0, ACSM2_MEMORY_TYPE__NONE);
@@ -1222,6 +1299,262 @@ int acsmPatternCount2(ACSM_STRUCT2* acsm)
     return acsm->numPatterns;
 }
 
+//-------------------------------------------------------------------------
+// serialization
+//
+// only the dfa rows and match lists are stored.  the patterns must be added
+// before deserializing and match list entries are stored as indices into the
+// pattern list so that user data is bound to this instance.  the hash covers
+// the patterns in list order since that determines the state numbering.
+//-------------------------------------------------------------------------
+
+#define ACSM_DB_MAGIC   0x32464341  // "ACF2"
+#define ACSM_DB_VERSION 2
+
+struct AcsmDbHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_patterns;
+    uint32_t num_states;
+    uint32_t num_trans;
+    uint32_t num_matches;
+    uint32_t sizeofstate;
+    uint32_t alphabet_size;
+};
+
+static inline void put_u32(uint8_t*& p, uint32_t v)
+{ memcpy(p, &v, sizeof(v)); p += sizeof(v); }
+
+static inline uint32_t get_u32(const uint8_t*& p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return v;
+}
+
+bool acsmSerialize2(const ACSM_STRUCT2* acsm, uint8_t*& buf, size_t& sz)
+{
+    if ( !acsm->acsmSlab or !acsm->acsmMatchList )
+        return false;
+
+    // match list entries are copies that share the pattern buffers
+    std::unordered_map<const uint8_t*, uint32_t> pat_ids;
+    uint32_t id = 0;
+
+    for ( const ACSM_PATTERN2* p = acsm->acsmPatterns; p; p = p->next )
+        pat_ids[p->patrn] = id++;
+
+    uint32_t num_matches = 0;
+
+    for ( int i = 0; i < acsm->acsmNumStates; i++ )
+    {
+        for ( const ACSM_PATTERN2* m = acsm->acsmMatchList[i]; m; m = m->next )
+            num_matches++;
+    }
+
+    sz = sizeof(AcsmDbHeader) + acsm->acsmSlabSize +
+        (acsm->acsmNumStates + num_matches) * sizeof(uint32_t);
+
+    // caller releases with free()
+    buf = (uint8_t*)malloc(sz);
+
+    if ( !buf )
+        return false;
+
+    uint8_t* p = buf;
+
+    put_u32(p, ACSM_DB_MAGIC);
+    put_u32(p, ACSM_DB_VERSION);
+    put_u32(p, acsm->numPatterns);
+    put_u32(p, acsm->acsmNumStates);
+    put_u32(p, acsm->acsmNumTrans);
+    put_u32(p, num_matches);
+    put_u32(p, acsm->sizeofstate);
+    put_u32(p, acsm->acsmAlphabetSize);
+
+    memcpy(p, acsm->acsmSlab, acsm->acsmSlabSize);
+    p += acsm->acsmSlabSize;
+
+    for ( int i = 0; i < acsm->acsmNumStates; i++ )
+    {
+        uint8_t* cnt = p;
+        uint32_t n = 0;
+        p += sizeof(uint32_t);
+
+        for ( const ACSM_PATTERN2* m = acsm->acsmMatchList[i]; m; m = m->next, n++ )
+        {
+            auto it = pat_ids.find(m->patrn);
+
+            if ( it == pat_ids.end() )
+            {
+                free(buf);
+                buf = nullptr;
+                return false;
+            }
+            put_u32(p, it->second);
+        }
+        put_u32(cnt, n);
+    }
+
+    assert(p == buf + sz);
+    return true;
+}
+
+bool acsmDeserialize2(ACSM_STRUCT2* acsm, const uint8_t* buf, size_t sz)
+{
+    if ( acsm->acsmSlab or sz < sizeof(AcsmDbHeader) )
+        return false;
+
+    AcsmDbHeader hdr;
+    const uint8_t* p = buf;
+
+    hdr.magic = get_u32(p);
+    hdr.version = get_u32(p);
+    hdr.num_patterns = get_u32(p);
+    hdr.num_states = get_u32(p);
+    hdr.num_trans = get_u32(p);
+    hdr.num_matches = get_u32(p);
+    hdr.sizeofstate = get_u32(p);
+    hdr.alphabet_size = get_u32(p);
+
+    if ( hdr.magic != ACSM_DB_MAGIC or hdr.version != ACSM_DB_VERSION or
+        hdr.num_patterns != (uint32_t)acsm->numPatterns or
+        hdr.alphabet_size != (uint32_t)acsm->acsmAlphabetSize or !hdr.num_states or
+        (hdr.sizeofstate != 1 and hdr.sizeofstate != 2 and hdr.sizeofstate != 4) )
+        return false;
+
+    size_t slab_size = (size_t)hdr.sizeofstate * hdr.alphabet_size * hdr.num_states;
+    size_t expected = sizeof(AcsmDbHeader) + slab_size +
+        ((size_t)hdr.num_states + hdr.num_matches) * sizeof(uint32_t);
+
+    if ( sz != expected or hdr.alphabet_size != MAX_ALPHABET_SIZE )
+        return false;
+
+    // validate everything before allocating so a bad db leaves us untouched
+    const uint8_t* rows = p;
+    const uint8_t* matches = p + slab_size;
+    std::vector<bool> has_match(hdr.num_states);
+    uint32_t total = 0;
+
+    p = matches;
+
+    for ( uint32_t i = 0; i < hdr.num_states; i++ )
+    {
+        uint32_t n = get_u32(p);
+
+        if ( n > hdr.num_matches - total )
+            return false;
+
+        for ( uint32_t k = 0; k < n; k++ )
+        {
+            if ( get_u32(p) >= hdr.num_patterns )
+                return false;
+        }
+        has_match[i] = (n != 0);
+        total += n;
+    }
+
+    if ( total != hdr.num_matches )
+        return false;
+
+    const acstate_t match_bit = get_match_bit(hdr.sizeofstate);
+    size_t num_entries = (size_t)hdr.num_states * hdr.alphabet_size;
+
+    for ( size_t i = 0; i < num_entries; i++ )
+    {
+        acstate_t next = get_row_state(rows, hdr.sizeofstate, i);
+        bool flagged = (next & match_bit) != 0;
+        next &= ~match_bit;
+
+        if ( next >= hdr.num_states or flagged != has_match[next] )
+            return false;
+    }
+
+    std::vector<ACSM_PATTERN2*> pats;
+
+    for ( ACSM_PATTERN2* px = acsm->acsmPatterns; px; px = px->next )
+        pats.emplace_back(px);
+
+    acsm->acsmNumStates = acsm->acsmMaxStates = hdr.num_states;
+    acsm->acsmNumTrans = hdr.num_trans;
+    acsm->sizeofstate = hdr.sizeofstate;
+
+    acsm->acsmMatchList =
+        (ACSM_PATTERN2**)AC_MALLOC(sizeof(ACSM_PATTERN2*) * acsm->acsmNumStates,
+            ACSM2_MEMORY_TYPE__MATCHLIST);
+
+    acsm->acsmSlabSize = slab_size;
+    acsm->acsmSlab = AC_MALLOC_SLAB(slab_size, acsm->sizeofstate);
+    memcpy(acsm->acsmSlab, rows, slab_size);
+
+    p = matches;
+
+    for ( int i = 0; i < acsm->acsmNumStates; i++ )
+    {
+        // append to preserve the original list order
+        ACSM_PATTERN2** tail = &acsm->acsmMatchList[i];
+        uint32_t n = get_u32(p);
+
+        for ( uint32_t k = 0; k < n; k++ )
+        {
+            ACSM_PATTERN2* px = CopyMatchListEntry(pats[get_u32(p)]);
+            px->next = nullptr;
+            *tail = px;
+            tail = &px->next;
+        }
+
+        if ( acsm->acsmMatchList[i] )
+            summary.num_match_states++;
+    }
+
+    for ( const ACSM_PATTERN2* px = acsm->acsmPatterns; px; px = px->next )
+    {
+        summary.num_patterns++;
+        summary.num_characters += px->n;
+    }
+
+    switch ( acsm->sizeofstate )
+    {
+    case 1:
+        summary.num_1byte_instances++;
+        break;
+    case 2:
+        summary.num_2byte_instances++;
+        break;
+    default:
+        summary.num_4byte_instances++;
+        break;
+    }
+
+    summary.num_states += acsm->acsmNumStates;
+    summary.num_transitions += acsm->acsmNumTrans;
+    summary.num_instances++;
+
+    set_summary_acsm(acsm);
+
+    return true;
+}
+
+void acsmGetHash2(const ACSM_STRUCT2* acsm, std::string& hash)
+{
+    std::string str("ac_full");
+    str += (char)ACSM_DB_VERSION;
+    str += (char)sizeof(acstate_t);
+
+    for ( const ACSM_PATTERN2* p = acsm->acsmPatterns; p; p = p->next )
+    {
+        uint32_t flags[3] = { (uint32_t)p->n, (uint32_t)p->nocase, (uint32_t)p->negative };
+        str.append((const char*)flags, sizeof(flags));
+        str.append((const char*)p->casepatrn, p->n);
+    }
+
+    uint8_t buf[MD5_HASH_SIZE];
+    md5((const uint8_t*)str.c_str(), str.size(), buf);
+    hash.assign((const char*)buf, sizeof(buf));
+}
+
 static void Print_DFA_MatchList(ACSM_STRUCT2* acsm, int state)
 {
     ACSM_PATTERN2* mlist;
@@ -1236,28 +1569,24 @@ static void Print_DFA_MatchList(ACSM_STRUCT2* acsm, int state)
 
 static void Print_DFA(ACSM_STRUCT2* acsm)
 {
-    int k,i;
-    acstate_t* p, state, fmt;
-    acstate_t** NextState = acsm->acsmNextState;
+    const uint8_t* row = (const uint8_t*)acsm->acsmSlab;
+    size_t row_size = acsm->sizeofstate * acsm->acsmAlphabetSize;
+    acstate_t match_bit = get_match_bit(acsm->sizeofstate);
 
     printf("Print DFA - %d active states\n",acsm->acsmNumStates);
 
-    for (k=0; k<acsm->acsmNumStates; k++)
-    {
-        p   = NextState[k];
-
-        if ( !p )
-            continue;
-
-        fmt = *p++;
+    if ( !row )
+        return;
 
-        printf("state %3d, fmt=%d: ",k,fmt);
+    for (int k=0; k<acsm->acsmNumStates; k++, row += row_size)
+    {
+        printf("state %3d: ",k);
 
-        for ( i=0; i<acsm->acsmAlphabetSize; i++ )
+        for ( int i=0; i<acsm->acsmAlphabetSize; i++ )
         {
-            state = p[i];
+            acstate_t state = get_row_state(row, acsm->sizeofstate, i) & ~match_bit;
 
-            if ( state != 0 && state != ACSM_FAIL_STATE2 )
+            if ( state != 0 )
             {
                 if ( isascii(i) && isprint(i) )
                     printf("%3c->%-5d\t",i,state);
@@ -1315,6 +1644,12 @@ int acsmPrintSummaryInfo2()
     if ( summary.num_4byte_instances )
         LogCount("4 byte states", summary.num_4byte_instances);
 
+    if ( summary.num_root_skip_instances )
+    {
+        LogValue("root skip simd", ByteSet::get_simd_name());
+        LogCount("root skip instances", summary.num_root_skip_instances);
+    }
+
     double scale;
 
     if ( acsm2_total_memory < 1024*1024 )
@@ -1332,6 +1667,10 @@ int acsmPrintSummaryInfo2()
     LogStat("match list memory", acsm2_matchlist_memory/scale);
     LogStat("transition memory", acsm2_transtable_memory/scale);
     LogStat("fail state memory", acsm2_failstate_memory/scale);
+    LogStat("dfa memory", acsm2_dfa_memory/scale);
+
+    if ( summary.num_huge_slabs )
+        LogCount("huge page slabs", summary.num_huge_slabs);
 
 #if 0  // FIXIT-L clean up format; not all this should be printed all the time
     if (acsm2_dfa_memory > 0)
@@ -25,11 +25,13 @@
 // Version 2.0
 
 #include <cstdint>
+#include <string>
 
 #include "search_common.h"
 
 namespace snort
 {
+class ByteSet;
 struct SnortConfig;
 }
 
@@ -98,9 +100,19 @@ struct ACSM_STRUCT2
        after construction we convert to sparse or full format matrix and free
        the transition lists */
     trans_node_t** acsmTransTable;
-    acstate_t** acsmNextState;
+
+    /* full matrix dfa with one row of acsmAlphabetSize states per state
+       packed into a single aligned slab.  the high bit of each entry is set
+       if the next state has matches. */
+    void* acsmSlab;
+    size_t acsmSlabSize;
+
     const MpseAgent* agent;
 
+    /* bytes that leave the root state; used to skip runs of input that
+       don't when a simd implementation is available */
+    snort::ByteSet* acsmRootSkip;
+
     int acsmMaxStates;
     int acsmNumStates;
 
@@ -136,6 +148,10 @@ int acsm_search_dfa_full_all(
 void acsmFree2(ACSM_STRUCT2*);
 int acsmPatternCount2(ACSM_STRUCT2*);
 
+bool acsmSerialize2(const ACSM_STRUCT2*, uint8_t*& buf, size_t& sz);
+bool acsmDeserialize2(ACSM_STRUCT2*, const uint8_t* buf, size_t sz);
+void acsmGetHash2(const ACSM_STRUCT2*, std::string&);
+
 void acsmPrintInfo2(ACSM_STRUCT2* p);
 
 int acsmPrintDetailInfo2(ACSM_STRUCT2*);
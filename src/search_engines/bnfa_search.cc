@@ -146,8 +146,14 @@
 
 #include "bnfa_search.h"
 
+#include <cassert>
+#include <cstdlib>
 #include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
+#include "hash/hashes.h"
 #include "log/messages.h"
 #include "utils/stats.h"
 #include "utils/util.h"
@@ -1449,8 +1455,12 @@ static inline int _bnfaCompile(bnfa_struct_t* bnfa)
 
 int bnfaCompile(SnortConfig* sc, bnfa_struct_t* bnfa)
 {
-    if ( int rval = _bnfaCompile (bnfa) )
-        return rval;
+    // the nfa is already built if it was deserialized
+    if ( !bnfa->bnfaTransList )
+    {
+        if ( int rval = _bnfaCompile (bnfa) )
+            return rval;
+    }
 
     if ( bnfa->agent )
         bnfaBuildMatchStateTrees(sc, bnfa);
@@ -1636,8 +1646,316 @@ int bnfaPatternCount(bnfa_struct_t* p)
     return p->bnfaPatternCnt;
 }
 
+/*
+*   Serialization
+*
+*   Only the compacted sparse transition list and the match lists are
+*   stored.  The patterns must be added before deserializing and match list
+*   entries are stored as indices into the pattern list so that user data is
+*   bound to this instance.  The hash covers the patterns in list order since
+*   that determines the state numbering.
+*/
+#define BNFA_DB_MAGIC   0x32414e42  /* "BNA2" */
+#define BNFA_DB_VERSION 1
+
+struct bnfa_db_header_t
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_patterns;
+    uint32_t num_states;
+    uint32_t max_states;
+    uint32_t num_trans;
+    uint32_t num_words;
+    uint32_t num_matches;
+    uint32_t case_mode;
+    uint32_t force_full_zero;
+};
+
+static inline void _bnfa_put_u32(uint8_t*& p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+    p += sizeof(v);
+}
+
+static inline uint32_t _bnfa_get_u32(const uint8_t*& p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return v;
+}
+
+/*
+*  Walk the sparse array and return the number of words used, or 0 if the
+*  array is not well formed.  The fail state and every transition must index
+*  the state word that starts a row, never a word inside a row.
+*/
+static unsigned _bnfa_csparse_words(const bnfa_state_t* ps, unsigned nps, unsigned nstates)
+{
+    unsigned index = 0;
+
+    for ( unsigned k = 0; k < nstates; k++ )
+    {
+        if ( index + 2 > nps or ps[index] != k )
+            return 0;
+
+        bnfa_state_t cw = ps[index + 1];
+        unsigned nc;
+
+        if ( cw & BNFA_SPARSE_FULL_BIT )
+            nc = BNFA_MAX_ALPHABET_SIZE;
+        else
+            nc = (cw & BNFA_SPARSE_COUNT_BITS) >> BNFA_SPARSE_COUNT_SHIFT;
+
+        if ( index + 2 + nc > nps )
+            return 0;
+
+        index += 2 + nc;
+    }
+
+    /* rows are contiguous so their starts are known only now */
+    std::vector<bool> row_start(index, false);
+
+    for ( unsigned k = 0, i = 0; k < nstates; k++ )
+    {
+        row_start[i] = true;
+        bnfa_state_t cw = ps[i + 1];
+
+        if ( cw & BNFA_SPARSE_FULL_BIT )
+            i += 2 + BNFA_MAX_ALPHABET_SIZE;
+        else
+            i += 2 + ((cw & BNFA_SPARSE_COUNT_BITS) >> BNFA_SPARSE_COUNT_SHIFT);
+    }
+
+    for ( unsigned k = 0, i = 0; k < nstates; k++ )
+    {
+        bnfa_state_t cw = ps[i + 1];
+        unsigned nc;
+
+        if ( cw & BNFA_SPARSE_FULL_BIT )
+            nc = BNFA_MAX_ALPHABET_SIZE;
+        else
+            nc = (cw & BNFA_SPARSE_COUNT_BITS) >> BNFA_SPARSE_COUNT_SHIFT;
+
+        for ( unsigned t = 1; t < 2 + nc; t++ )
+        {
+            unsigned target = ps[i + t] & BNFA_SPARSE_MAX_STATE;
+
+            if ( target >= index or !row_start[target] )
+                return 0;
+        }
+        i += 2 + nc;
+    }
+    return index;
+}
+
+bool bnfaSerialize(const bnfa_struct_t* bnfa, uint8_t*& buf, size_t& sz)
+{
+    if ( !bnfa->bnfaTransList or !bnfa->bnfaMatchList )
+        return false;
+
+    unsigned nps = _bnfa_csparse_words(bnfa->bnfaTransList, BNFA_SPARSE_MAX_STATE,
+        bnfa->bnfaNumStates);
+
+    if ( !nps )
+        return false;
+
+    std::unordered_map<const void*, uint32_t> pat_ids;
+    uint32_t id = 0;
+
+    for ( const bnfa_pattern_t* p = bnfa->bnfaPatterns; p; p = p->next )
+        pat_ids[p] = id++;
+
+    uint32_t num_matches = 0;
+
+    for ( int i = 0; i < bnfa->bnfaNumStates; i++ )
+    {
+        for ( const bnfa_match_node_t* m = bnfa->bnfaMatchList[i]; m; m = m->next )
+            num_matches++;
+    }
+
+    sz = sizeof(bnfa_db_header_t) + nps * sizeof(bnfa_state_t) +
+        (bnfa->bnfaNumStates + num_matches) * sizeof(uint32_t);
+
+    /* caller releases with free() */
+    buf = (uint8_t*)malloc(sz);
+
+    if ( !buf )
+        return false;
+
+    uint8_t* p = buf;
+
+    _bnfa_put_u32(p, BNFA_DB_MAGIC);
+    _bnfa_put_u32(p, BNFA_DB_VERSION);
+    _bnfa_put_u32(p, bnfa->bnfaPatternCnt);
+    _bnfa_put_u32(p, bnfa->bnfaNumStates);
+    _bnfa_put_u32(p, bnfa->bnfaMaxStates);
+    _bnfa_put_u32(p, bnfa->bnfaNumTrans);
+    _bnfa_put_u32(p, nps);
+    _bnfa_put_u32(p, num_matches);
+    _bnfa_put_u32(p, bnfa->bnfaCaseMode);
+    _bnfa_put_u32(p, bnfa->bnfaForceFullZeroState);
+
+    memcpy(p, bnfa->bnfaTransList, nps * sizeof(bnfa_state_t));
+    p += nps * sizeof(bnfa_state_t);
+
+    for ( int i = 0; i < bnfa->bnfaNumStates; i++ )
+    {
+        uint8_t* cnt = p;
+        uint32_t n = 0;
+        p += sizeof(uint32_t);
+
+        for ( const bnfa_match_node_t* m = bnfa->bnfaMatchList[i]; m; m = m->next, n++ )
+        {
+            auto it = pat_ids.find(m->data);
+
+            if ( it == pat_ids.end() )
+            {
+                free(buf);
+                buf = nullptr;
+                return false;
+            }
+            _bnfa_put_u32(p, it->second);
+        }
+        _bnfa_put_u32(cnt, n);
+    }
+
+    assert(p == buf + sz);
+    return true;
+}
+
+bool bnfaDeserialize(bnfa_struct_t* bnfa, const uint8_t* buf, size_t sz)
+{
+    if ( bnfa->bnfaTransList or sz < sizeof(bnfa_db_header_t) )
+        return false;
+
+    bnfa_db_header_t hdr;
+    const uint8_t* p = buf;
+
+    hdr.magic = _bnfa_get_u32(p);
+    hdr.version = _bnfa_get_u32(p);
+    hdr.num_patterns = _bnfa_get_u32(p);
+    hdr.num_states = _bnfa_get_u32(p);
+    hdr.max_states = _bnfa_get_u32(p);
+    hdr.num_trans = _bnfa_get_u32(p);
+    hdr.num_words = _bnfa_get_u32(p);
+    hdr.num_matches = _bnfa_get_u32(p);
+    hdr.case_mode = _bnfa_get_u32(p);
+    hdr.force_full_zero = _bnfa_get_u32(p);
+
+    if ( hdr.magic != BNFA_DB_MAGIC or hdr.version != BNFA_DB_VERSION or
+        hdr.num_patterns != bnfa->bnfaPatternCnt or
+        hdr.case_mode != (uint32_t)bnfa->bnfaCaseMode or
+        hdr.force_full_zero != (uint32_t)bnfa->bnfaForceFullZeroState or
+        !hdr.num_states or hdr.num_states > BNFA_SPARSE_MAX_STATE or
+        !hdr.num_words or hdr.num_words > BNFA_SPARSE_MAX_STATE )
+        return false;
+
+    size_t expected = sizeof(bnfa_db_header_t) + (size_t)hdr.num_words * sizeof(bnfa_state_t) +
+        ((size_t)hdr.num_states + hdr.num_matches) * sizeof(uint32_t);
+
+    if ( sz != expected )
+        return false;
+
+    /* validate everything before allocating so a bad db leaves us untouched */
+    std::vector<bnfa_state_t> trans(hdr.num_words);
+    memcpy(trans.data(), p, hdr.num_words * sizeof(bnfa_state_t));
+    p += hdr.num_words * sizeof(bnfa_state_t);
+
+    if ( _bnfa_csparse_words(trans.data(), hdr.num_words, hdr.num_states) != hdr.num_words )
+        return false;
+
+    const uint8_t* matches = p;
+    uint32_t total = 0;
+
+    for ( uint32_t i = 0; i < hdr.num_states; i++ )
+    {
+        uint32_t n = _bnfa_get_u32(p);
+
+        if ( n > hdr.num_matches - total )
+            return false;
+
+        for ( uint32_t k = 0; k < n; k++ )
+        {
+            if ( _bnfa_get_u32(p) >= hdr.num_patterns )
+                return false;
+        }
+        total += n;
+    }
+
+    if ( total != hdr.num_matches )
+        return false;
+
+    std::vector<bnfa_pattern_t*> pats;
+
+    for ( bnfa_pattern_t* px = bnfa->bnfaPatterns; px; px = px->next )
+        pats.emplace_back(px);
+
+    bnfa->bnfaNumStates = hdr.num_states;
+    bnfa->bnfaMaxStates = hdr.max_states;
+    bnfa->bnfaNumTrans = hdr.num_trans;
+
+    bnfa->bnfaTransList = BNFA_MALLOC(hdr.num_words * sizeof(bnfa_state_t),
+        bnfa->nextstate_memory);
+    memcpy(bnfa->bnfaTransList, trans.data(), hdr.num_words * sizeof(bnfa_state_t));
+
+    bnfa->bnfaMatchList = (bnfa_match_node_t**)BNFA_MALLOC(sizeof(void*) * bnfa->bnfaNumStates,
+        bnfa->matchlist_memory);
+
+    p = matches;
+    unsigned cntMatchStates = 0;
+
+    for ( int i = 0; i < bnfa->bnfaNumStates; i++ )
+    {
+        /* append to preserve the original list order */
+        bnfa_match_node_t** tail = &bnfa->bnfaMatchList[i];
+        uint32_t n = _bnfa_get_u32(p);
+
+        for ( uint32_t k = 0; k < n; k++ )
+        {
+            bnfa_match_node_t* px = (bnfa_match_node_t*)BNFA_MALLOC(sizeof(bnfa_match_node_t),
+                bnfa->matchlist_memory);
+
+            px->data = pats[_bnfa_get_u32(p)];
+            *tail = px;
+            tail = &px->next;
+        }
+
+        if ( bnfa->bnfaMatchList[i] )
+            cntMatchStates++;
+    }
+
+    bnfa->bnfaMatchStates = cntMatchStates;
+
+    bnfaAccumInfo(bnfa);
+
+    return true;
+}
+
+void bnfaGetHash(const bnfa_struct_t* bnfa, std::string& hash)
+{
+    std::string str("ac_bnfa");
+    str += (char)BNFA_DB_VERSION;
+    str += (char)bnfa->bnfaCaseMode;
+    str += (char)bnfa->bnfaForceFullZeroState;
+
+    for ( const bnfa_pattern_t* p = bnfa->bnfaPatterns; p; p = p->next )
+    {
+        uint32_t flags[3] = { p->n, (uint32_t)p->nocase, (uint32_t)p->negative };
+        str.append((const char*)flags, sizeof(flags));
+        str.append((const char*)p->casepatrn, p->n);
+    }
+
+    uint8_t buf[MD5_HASH_SIZE];
+    md5((const uint8_t*)str.c_str(), str.size(), buf);
+    hash.assign((const char*)buf, sizeof(buf));
+}
+
+// instances may be compiled in parallel
 static bnfa_struct_t summary;
 static int summary_cnt = 0;
+static std::mutex summary_mutex;
 
 static void bnfaPrintInfoEx(bnfa_struct_t* p)
 {
@@ -1692,6 +2010,7 @@ void bnfaInitSummary()
 
 void bnfaAccumInfo(bnfa_struct_t* p)
 {
+    std::lock_guard<std::mutex> lock(summary_mutex);
     bnfa_struct_t* px = &summary;
 
     summary_cnt++;
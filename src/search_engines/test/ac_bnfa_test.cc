@@ -23,6 +23,8 @@
 #endif
 
 #include <cstring>
+#include <thread>
+#include <vector>
 
 #include "framework/base_api.h"
 #include "framework/counts.h"
@@ -205,6 +207,116 @@ TEST(mpse_bnfa_multi, single)
     CHECK(hits == 1);
 }
 
+TEST(mpse_bnfa_multi, serialize)
+{
+    Mpse::PatternDescriptor desc;
+
+    CHECK(bnfa1->add_pattern((const uint8_t*)"foo", 3, desc, s_user) == 0);
+    CHECK(bnfa1->add_pattern((const uint8_t*)"bar", 3, desc, s_user) == 0);
+    CHECK(bnfa1->prep_patterns(snort_conf) == 0);
+
+    uint8_t* buf = nullptr;
+    size_t len = 0;
+
+    CHECK(bnfa1->serialize(buf, len));
+    CHECK(buf and len);
+
+    // pattern sets must agree
+    CHECK(bnfa2->add_pattern((const uint8_t*)"foo", 3, desc, s_user) == 0);
+    CHECK(!bnfa2->deserialize(buf, len));
+
+    CHECK(bnfa2->add_pattern((const uint8_t*)"bar", 3, desc, s_user) == 0);
+    CHECK(!bnfa2->deserialize(buf, len - 1));
+
+    // a transition into the middle of a row (the control word of state 0)
+    const size_t first_trans = 10 * sizeof(uint32_t) + 2 * sizeof(uint32_t);
+    uint32_t word;
+    memcpy(&word, buf + first_trans, sizeof(word));
+
+    uint32_t bad = (word & 0xff000000) | 1;
+    memcpy(buf + first_trans, &bad, sizeof(bad));
+    CHECK(!bnfa2->deserialize(buf, len));
+
+    memcpy(buf + first_trans, &word, sizeof(word));
+    CHECK(bnfa2->deserialize(buf, len));
+    CHECK(bnfa2->prep_patterns(snort_conf) == 0);
+    free(buf);
+
+    int state = 0;
+    CHECK(bnfa1->search((const uint8_t*)"foo bar", 7, match, nullptr, &state) == 2);
+    CHECK(hits == 2);
+
+    state = 0;
+    CHECK(bnfa2->search((const uint8_t*)"foo bar", 7, match, nullptr, &state) == 2);
+    CHECK(hits == 4);
+}
+
+//-------------------------------------------------------------------------
+// parallel build tests
+//-------------------------------------------------------------------------
+
+static int count_match(
+    void* /*user*/, void* /*tree*/, int /*index*/, void* context, void* /*list*/)
+{
+    ++*(int*)context;
+    return 0;
+}
+
+TEST_GROUP(mpse_bnfa_parallel)
+{
+    const MpseApi* mpse_api = (const MpseApi*)se_ac_bnfa;
+};
+
+TEST(mpse_bnfa_parallel, flags)
+{
+    CHECK(mpse_api->flags == (MPSE_BASE | MPSE_MTBLD));
+}
+
+TEST(mpse_bnfa_parallel, build)
+{
+    const unsigned num = 8;
+    std::vector<Mpse*> engines(num);
+    std::vector<int> prep(num, -1);
+    std::vector<int> found(num, 0);
+    std::vector<std::thread> threads;
+
+    for ( unsigned i = 0; i < num; ++i )
+        engines[i] = mpse_api->ctor(snort_conf, nullptr, &s_agent);
+
+    for ( unsigned i = 0; i < num; ++i )
+    {
+        threads.emplace_back([&, i]()
+        {
+            Mpse::PatternDescriptor desc;
+            Mpse* e = engines[i];
+            char pat[16];
+
+            // i + 1 distinct patterns so each instance differs
+            for ( unsigned j = 0; j <= i; ++j )
+            {
+                int n = snprintf(pat, sizeof(pat), "pat%u", j);
+                e->add_pattern((const uint8_t*)pat, n, desc, s_user);
+            }
+            prep[i] = e->prep_patterns(snort_conf);
+
+            const char* text = "pat0 pat1 pat2 pat3 pat4 pat5 pat6 pat7";
+            int state = 0;
+            e->search((const uint8_t*)text, strlen(text), count_match, &found[i], &state);
+        });
+    }
+
+    for ( auto& t : threads )
+        t.join();
+
+    for ( unsigned i = 0; i < num; ++i )
+    {
+        CHECK(prep[i] == 0);
+        CHECK(engines[i]->get_pattern_count() == (int)i + 1);
+        CHECK(found[i] == (int)i + 1);
+        mpse_api->dtor(engines[i]);
+    }
+}
+
 //-------------------------------------------------------------------------
 // main
 //-------------------------------------------------------------------------
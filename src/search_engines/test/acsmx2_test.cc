@@ -0,0 +1,229 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// acsmx2_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "hash/hashes.h"
+#include "helpers/byte_set.h"
+#include "log/messages.h"
+#include "search_engines/acsmx2.h"
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// stubs
+//-------------------------------------------------------------------------
+
+namespace snort
+{
+void LogMessage(const char*, ...) { }
+void LogValue(const char*, const char*, FILE*) { }
+void LogCount(char const*, uint64_t, FILE*) { }
+void LogStat(const char*, double, FILE*) { }
+void md5(const unsigned char*, size_t, unsigned char*) { }
+}
+
+//-------------------------------------------------------------------------
+// helpers
+//-------------------------------------------------------------------------
+
+typedef std::vector<std::pair<uintptr_t, int>> Hits;
+
+static int save_hit(void* id, void*, int index, void* context, void*)
+{
+    Hits* hits = (Hits*)context;
+    hits->emplace_back((uintptr_t)id, index);
+    return 0;
+}
+
+static ACSM_STRUCT2* make_acsm(const std::vector<std::string>& pats)
+{
+    acsmx2_init_xlatcase();
+    ACSM_STRUCT2* acsm = acsmNew2(nullptr);
+    uintptr_t id = 1;
+
+    for ( const auto& p : pats )
+        acsmAddPattern2(acsm, (const uint8_t*)p.c_str(), p.size(), true, false, (void*)id++);
+
+    acsmCompile2(nullptr, acsm);
+    return acsm;
+}
+
+static Hits search(ACSM_STRUCT2* acsm, const std::string& s, bool all, bool skip)
+{
+    ByteSet* rs = acsm->acsmRootSkip;
+
+    if ( !skip )
+        acsm->acsmRootSkip = nullptr;
+
+    Hits hits;
+    int state = 0;
+
+    if ( all )
+        acsm_search_dfa_full_all(acsm, (const uint8_t*)s.c_str(), s.size(), save_hit, &hits, &state);
+    else
+        acsm_search_dfa_full(acsm, (const uint8_t*)s.c_str(), s.size(), save_hit, &hits, &state);
+
+    acsm->acsmRootSkip = rs;
+    return hits;
+}
+
+static std::string make_body(std::mt19937& rng, size_t len)
+{
+    static const char* alpha = "abcdefghijklmnopqrstuvwxyz0123456789 \r\n<>=/";
+    std::string s;
+
+    for ( size_t i = 0; i < len; ++i )
+        s += alpha[rng() % 43];
+
+    return s;
+}
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+TEST_CASE("root skip matches scalar", "[acsmx2]")
+{
+    std::mt19937 rng(2112);
+
+    for ( unsigned n = 0; n < 50; ++n )
+    {
+        std::vector<std::string> pats;
+
+        for ( unsigned i = 0; i < 1 + rng() % 20; ++i )
+        {
+            std::string p = make_body(rng, 1 + rng() % 6);
+
+            // keep the root set small so the skip path is exercised
+            for ( auto& c : p )
+                c = "xyz<>=\r\nQ"[c % 9];
+
+            pats.emplace_back(p);
+        }
+
+        ACSM_STRUCT2* acsm = make_acsm(pats);
+
+        if ( ByteSet::has_simd() )
+            CHECK(acsm->acsmRootSkip);
+
+        for ( unsigned i = 0; i < 10; ++i )
+        {
+            std::string s = make_body(rng, rng() % 2000);
+
+            CHECK(search(acsm, s, false, true) == search(acsm, s, false, false));
+            CHECK(search(acsm, s, true, true) == search(acsm, s, true, false));
+        }
+        acsmFree2(acsm);
+    }
+}
+
+TEST_CASE("slab matches reference", "[acsmx2]")
+{
+    std::mt19937 rng(6502);
+
+    for ( unsigned n : { 3, 60, 2000 } )
+    {
+        std::vector<std::string> pats;
+
+        for ( unsigned i = 0; i < n; ++i )
+            pats.emplace_back(make_body(rng, 2 + rng() % 6));
+
+        ACSM_STRUCT2* acsm = make_acsm(pats);
+
+        if ( acsm->acsmNumStates <= 128 )
+            CHECK(acsm->sizeofstate == 1);
+        else if ( acsm->acsmNumStates <= 32768 )
+            CHECK(acsm->sizeofstate == 2);
+
+        CHECK(acsm->acsmSlabSize == (size_t)acsm->acsmNumStates * 256 * acsm->sizeofstate);
+
+        std::string s = make_body(rng, 20000);
+        Hits expected;
+
+        for ( size_t end = 1; end <= s.size(); ++end )
+        {
+            for ( size_t i = 0; i < pats.size(); ++i )
+            {
+                size_t len = pats[i].size();
+
+                if ( len <= end and !s.compare(end - len, len, pats[i]) )
+                    expected.emplace_back(i + 1, end);
+            }
+        }
+
+        Hits hits = search(acsm, s, true, true);
+        std::sort(hits.begin(), hits.end(), [](const Hits::value_type& a, const Hits::value_type& b)
+            { return a.second < b.second or (a.second == b.second and a.first < b.first); });
+        std::sort(expected.begin(), expected.end(), [](const Hits::value_type& a, const Hits::value_type& b)
+            { return a.second < b.second or (a.second == b.second and a.first < b.first); });
+
+        CHECK(hits == expected);
+        acsmFree2(acsm);
+    }
+}
+
+TEST_CASE("root skip dense root", "[acsmx2]")
+{
+    std::vector<std::string> pats;
+
+    for ( int c = 0; c < 256; ++c )
+        pats.emplace_back(1, (char)c);
+
+    ACSM_STRUCT2* acsm = make_acsm(pats);
+    CHECK(!acsm->acsmRootSkip);
+    acsmFree2(acsm);
+}
+
+#ifdef BENCHMARK_TEST
+TEST_CASE("root skip 64K http body", "[acsmx2]")
+{
+    std::mt19937 rng(1234);
+    std::string body = make_body(rng, 65536);
+
+    for ( auto& c : body )
+        if ( c == '<' or c == '>' or c == '=' )
+            c = ' ';
+
+    ACSM_STRUCT2* acsm = make_acsm({ "<script", "<iframe", "=\"javascript:" });
+    REQUIRE(search(acsm, body, true, true) == search(acsm, body, true, false));
+
+    BENCHMARK("scalar")
+    {
+        return search(acsm, body, true, false).size();
+    };
+
+    BENCHMARK("root skip")
+    {
+        return search(acsm, body, true, true).size();
+    };
+
+    acsmFree2(acsm);
+}
+#endif
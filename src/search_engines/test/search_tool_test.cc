@@ -141,6 +141,46 @@ TEST(search_tool_full, search_all)
     CHECK(s_found == 6);
 }
 
+TEST(search_tool_full, serialize)
+{
+    uint8_t* buf = nullptr;
+    size_t len = 0;
+
+    CHECK(stool->mpsegrp->normal_mpse->serialize(buf, len));
+    CHECK(buf and len);
+
+    SearchTool copy;
+    copy.add("the", 3, 1);
+    copy.add("tuba", 4, 77);
+    copy.add("uba", 3, 78);
+    copy.add("away", 4, 2112);
+    copy.add("nothere", 7, 1000);
+
+    CHECK(copy.mpsegrp->normal_mpse->deserialize(buf, len));
+    free(buf);
+    copy.prep();
+
+    const char* datastr = "the the tuba ran away with the tuna";
+    const ExpectedMatch xm[] =
+    {
+        { 1, 3 },
+        { 1, 7 },
+        { 78, 12 },
+        { 77, 12 },
+        { 2112, 21 },
+        { 1, 30 },
+        { 0, 0 }
+    };
+
+    s_expect = xm;
+    s_found = 0;
+
+    int result = copy.find_all(datastr, strlen(datastr), check_mpse_match);
+
+    CHECK(result == 6);
+    CHECK(s_found == 6);
+}
+
 //-------------------------------------------------------------------------
 // main
 //-------------------------------------------------------------------------
@@ -36,7 +36,7 @@ unsigned DceContextData::udp_ips_id = 0;
 
 void DceContextData::init(DCE2_TransType trans)
 {
-    set_ips_id(trans, IpsContextData::get_ips_id());
+    set_ips_id(trans, IpsContextData::get_ips_id<DceContextData>());
 }
 
 unsigned DceContextData::get_ips_id(DCE2_TransType trans)
@@ -123,12 +123,11 @@ void DceContextData::set_current_ropts(DCE2_SsnData* sd)
 
     DceContextData* dcd = IpsContextData::get<DceContextData>(ips_id);
 
-    if ( !dcd->current_ropts )
-    {
-        dcd->current_ropts = new DCE2_Roptions;
-    }
+    if ( !dcd->ropts )
+        dcd->ropts = new DCE2_Roptions;
 
-    *(dcd->current_ropts) = sd->ropts;
+    *(dcd->ropts) = sd->ropts;
+    dcd->current_ropts = dcd->ropts;
     dcd->no_inspect = DCE2_SsnNoInspect(sd);
 }
 
@@ -154,10 +153,13 @@ void DceContextData::clear_current_ropts(const Packet* p, DCE2_TransType trans)
     clear_current_ropts(context, trans);
 }
 
+DceContextData::~DceContextData()
+{
+    delete ropts;
+}
+
 void DceContextData::clear()
 {
-    if ( current_ropts )
-        delete current_ropts;
     current_ropts = nullptr;
     no_inspect = false;
 }
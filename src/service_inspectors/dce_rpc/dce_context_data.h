@@ -29,6 +29,7 @@ struct DCE2_SsnData;
 class DceContextData : public snort::IpsContextData
 {
 public:
+    ~DceContextData() override;
     void clear() override;
 
     static unsigned smb_ips_id;
@@ -48,6 +49,10 @@ public:
     static void set_current_ropts(DCE2_SsnData* sd);
     static void clear_current_ropts(const snort::Packet* p, DCE2_TransType trans);
     static void clear_current_ropts(snort::IpsContext* context, DCE2_TransType trans);
+
+private:
+    // kept across clear() so the context can reuse it on the next packet
+    DCE2_Roptions* ropts = nullptr;
 };
 
 #endif
@@ -172,6 +172,12 @@ const StreamBuffer StreamSplitter::reassemble(
     return { nullptr, 0 };
 }
 
+const StreamBuffer StreamSplitter::reassemble_segments(
+    Flow*, unsigned, const StreamSegment*, unsigned, uint32_t, unsigned&)
+{
+    return { nullptr, 0 };
+}
+
 //--------------------------------------------------------------------------
 // unit tests
 //--------------------------------------------------------------------------
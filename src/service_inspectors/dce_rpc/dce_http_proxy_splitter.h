@@ -36,6 +36,10 @@ public:
     const snort::StreamBuffer reassemble(snort::Flow*, unsigned, unsigned,
         const uint8_t*, unsigned, uint32_t, unsigned&) override;
 
+    const snort::StreamBuffer reassemble_segments(snort::Flow*, unsigned,
+        const snort::StreamSegment*, unsigned, uint32_t, unsigned& consumed) override
+    { consumed = 0; return { nullptr, 0 }; }  // reassemble() drops client PDUs
+
     bool is_paf() override
     { return true; }
 
@@ -117,14 +117,10 @@ bool Http2HpackDecoder::decode_indexed_name(const uint8_t* encoded_header_buffer
         return false;
     }
 
-    // If this header will be added to the dynamic table and was from the dynamic table, we need to
-    // make a copy because the original table entry may be pruned and freed
+    // If this header will be added to the dynamic table and was from the dynamic table, refer to
+    // the decoded copy because the original table entry may be pruned and overwritten
     if (with_indexing and index > HpackIndexTable::STATIC_MAX_INDEX)
-    {
-        uint8_t* name_copy = new uint8_t[entry->name.length()];
-        memcpy(name_copy, entry->name.start(), entry->name.length());
-        name.set(entry->name.length(), name_copy, true);
-    }
+        name.set(entry->name.length(), decoded_header_buffer);
     else
         name.set(entry->name);
     return true;
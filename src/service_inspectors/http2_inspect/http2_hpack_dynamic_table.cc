@@ -24,28 +24,50 @@
 #include "http2_hpack_dynamic_table.h"
 #include "http2_module.h"
 
+#include <cassert>
 #include <cstring>
+#include <new>
 
 #include "http2_hpack_table.h"
 
 using namespace Http2Enums;
 
+struct HpackDynamicTable::DynamicEntry
+{
+    HpackTableEntry entry;
+    uint32_t offset = 0;
+};
+
+// Every entry takes at least one arena byte so that no two live entries share an offset
+static inline uint32_t arena_bytes(const HpackTableEntry& entry)
+{
+    const uint32_t length = entry.name.length() + entry.value.length();
+    return length > 0 ? length : 1;
+}
+
+// Fields may only be set once, so an entry is rebuilt in place whenever it moves
+static inline void set_entry(HpackTableEntry& entry, uint8_t* buf, uint32_t name_len,
+    uint32_t value_len)
+{
+    entry.~HpackTableEntry();
+    new (&entry) HpackTableEntry(name_len, buf, value_len, buf + name_len);
+}
+
 HpackDynamicTable::~HpackDynamicTable()
 {
-    for (std::vector<HpackTableEntry*>::iterator it = circular_buf.begin();
-        it != circular_buf.end(); ++it)
-    {
-        delete *it;
-    }
+    delete[] circular_buf;
+    delete[] arena;
 }
 
 bool HpackDynamicTable::add_entry(const Field& name, const Field& value)
 {
-    // The add only fails if the underlying circular array is out of space
+    // The add only fails if the entry ring is at its hard-coded limit
     if (num_entries >= ARRAY_CAPACITY)
         return false;
 
-    const uint32_t new_entry_size = name.length() + value.length() + RFC_ENTRY_OVERHEAD;
+    const uint32_t name_len = name.length();
+    const uint32_t value_len = value.length();
+    const uint32_t new_entry_size = name_len + value_len + RFC_ENTRY_OVERHEAD;
 
     // As per the RFC, attempting to add an entry that is larger than the max size of the table is
     // not an error, it causes the table to be cleared
@@ -55,16 +77,31 @@ bool HpackDynamicTable::add_entry(const Field& name, const Field& value)
         return true;
     }
 
-    // Create new entry. This is done before pruning because the entry referenced by the new name
-    // may be pruned.
-    HpackTableEntry* new_entry = new HpackTableEntry(name, value);
-
-    // If add entry would exceed max table size, evict old entries
+    // If add entry would exceed max table size, evict old entries. Evicted bytes stay intact until
+    // they are overwritten below, so the new name may still refer to a pruned entry.
     prune_to_size(max_size - new_entry_size);
 
+    if (num_entries == entry_capacity)
+        grow_entries();
+
+    const uint32_t size = (name_len + value_len > 0) ? name_len + value_len : 1;
+    uint32_t offset;
+    uint8_t* old_arena = nullptr;
+    if (!arena_alloc(size, offset))
+    {
+        old_arena = grow_arena(size);
+        arena_alloc(size, offset);
+    }
+
+    // The source may overlap the destination if it is a pruned entry
+    memmove(arena + offset, name.start(), name_len);
+    memmove(arena + offset + name_len, value.start(), value_len);
+    delete[] old_arena;
+
     // Add new entry to the front of the table (newest entry = lowest index)
-    start = (start + ARRAY_CAPACITY - 1) % ARRAY_CAPACITY;
-    circular_buf[start] = new_entry;
+    start = (start + entry_capacity - 1) & (entry_capacity - 1);
+    set_entry(circular_buf[start].entry, arena + offset, name_len, value_len);
+    circular_buf[start].offset = offset;
 
     num_entries++;
     if (num_entries > Http2Module::get_peg_counts(PEG_MAX_TABLE_ENTRIES))
@@ -81,8 +118,8 @@ const HpackTableEntry* HpackDynamicTable::get_entry(uint32_t virtual_index) cons
     if (dyn_index + 1 > num_entries)
         return nullptr;
 
-    const uint32_t arr_index = (start + dyn_index) % ARRAY_CAPACITY;
-    return circular_buf[arr_index];
+    const uint32_t arr_index = (start + dyn_index) & (entry_capacity - 1);
+    return &circular_buf[arr_index].entry;
 }
 
 /* This is called when adding a new entry and when receiving a dynamic table size update.
@@ -95,15 +132,104 @@ void HpackDynamicTable::prune_to_size(uint32_t new_max_size)
 {
     while (rfc_table_size > new_max_size)
     {
-        const uint32_t last_index = (start + num_entries - 1 + ARRAY_CAPACITY) % ARRAY_CAPACITY;
+        const uint32_t mask = entry_capacity - 1;
+        const uint32_t last_index = (start + num_entries - 1) & mask;
+        const HpackTableEntry& last = circular_buf[last_index].entry;
+        rfc_table_size -= last.name.length() + last.value.length() + RFC_ENTRY_OVERHEAD;
         num_entries--;
-        rfc_table_size -= circular_buf[last_index]->name.length() +
-            circular_buf[last_index]->value.length() + RFC_ENTRY_OVERHEAD;
-        delete circular_buf[last_index];
-        circular_buf[last_index] = nullptr;
+
+        if (num_entries == 0)
+        {
+            arena_head = arena_tail = 0;
+            arena_wrapped = false;
+        }
+        else
+        {
+            // Moving back to a lower offset means the oldest entries before the wrap are gone
+            const uint32_t next_offset = circular_buf[(last_index - 1) & mask].offset;
+            if (next_offset < arena_head)
+                arena_wrapped = false;
+            arena_head = next_offset;
+        }
     }
 }
 
+// Double the entry ring, keeping the newest entry at index 0
+void HpackDynamicTable::grow_entries()
+{
+    const uint32_t new_capacity = entry_capacity ? 2 * entry_capacity : INITIAL_ENTRY_CAPACITY;
+    assert(new_capacity <= ARRAY_CAPACITY);
+    DynamicEntry* new_buf = new DynamicEntry[new_capacity];
+
+    for (uint32_t k = 0; k < num_entries; k++)
+    {
+        const DynamicEntry& old = circular_buf[(start + k) & (entry_capacity - 1)];
+        set_entry(new_buf[k].entry, arena + old.offset, old.entry.name.length(),
+            old.entry.value.length());
+        new_buf[k].offset = old.offset;
+    }
+
+    delete[] circular_buf;
+    circular_buf = new_buf;
+    entry_capacity = new_capacity;
+    start = 0;
+}
+
+// Move the live entries, oldest first, to the start of a larger arena. The old arena is returned
+// so the caller can release it after copying a name that may still point into it.
+uint8_t* HpackDynamicTable::grow_arena(uint32_t needed)
+{
+    uint32_t new_size = arena_size ? 2 * arena_size : INITIAL_ARENA_SIZE;
+    while (new_size < 2 * needed)
+        new_size *= 2;
+    uint8_t* new_arena = new uint8_t[new_size];
+
+    uint32_t pos = 0;
+    for (uint32_t k = num_entries; k > 0; k--)
+    {
+        DynamicEntry& dyn = circular_buf[(start + k - 1) & (entry_capacity - 1)];
+        const uint32_t name_len = dyn.entry.name.length();
+        const uint32_t value_len = dyn.entry.value.length();
+        memcpy(new_arena + pos, arena + dyn.offset, name_len + value_len);
+        set_entry(dyn.entry, new_arena + pos, name_len, value_len);
+        dyn.offset = pos;
+        pos += arena_bytes(dyn.entry);
+    }
+
+    uint8_t* const old_arena = arena;
+    arena = new_arena;
+    arena_size = new_size;
+    arena_head = 0;
+    arena_tail = pos;
+    arena_wrapped = false;
+    return old_arena;
+}
+
+// Find contiguous room for size bytes after the newest entry, wrapping to the start of the arena
+// when the end is too short. An arena twice the max table size always has room.
+bool HpackDynamicTable::arena_alloc(uint32_t size, uint32_t& offset)
+{
+    if (!arena_wrapped)
+    {
+        if (arena_size - arena_tail >= size)
+            offset = arena_tail;
+        else if ((num_entries > 0) && (arena_head >= size))
+        {
+            offset = 0;
+            arena_wrapped = true;
+        }
+        else
+            return false;
+    }
+    else if (arena_head - arena_tail >= size)
+        offset = arena_tail;
+    else
+        return false;
+
+    arena_tail = offset + size;
+    return true;
+}
+
 void HpackDynamicTable::update_size(uint32_t new_size)
 {
     if (new_size < rfc_table_size)
@@ -25,16 +25,16 @@
 
 #include "http2_enum.h"
 
-#include <vector>
-
 struct HpackTableEntry;
 class Http2FlowData;
 
+// The dynamic table for one direction of a flow. Entry names and values are copied into a single
+// ring arena owned by the table so that adding an entry does not allocate. The arena and the
+// entry ring both start small and grow on demand.
 class HpackDynamicTable
 {
 public:
-    // FIXIT-P This array can be optimized to start smaller and grow on demand
-    HpackDynamicTable() : circular_buf(ARRAY_CAPACITY, nullptr) {}
+    HpackDynamicTable() = default;
     ~HpackDynamicTable();
     const HpackTableEntry* get_entry(uint32_t index) const;
     bool add_entry(const Field& name, const Field& value);
@@ -42,17 +42,34 @@ public:
     uint32_t get_max_size() { return max_size; }
 
 private:
+    struct DynamicEntry;
+
     const static uint32_t RFC_ENTRY_OVERHEAD = 32;
 
     const static uint32_t DEFAULT_MAX_SIZE = 4096;
     const static uint32_t ARRAY_CAPACITY = 512;
+    const static uint32_t INITIAL_ENTRY_CAPACITY = 16;
+    const static uint32_t INITIAL_ARENA_SIZE = 1024;
     uint32_t max_size = DEFAULT_MAX_SIZE;
 
     uint32_t start = 0;
     uint32_t num_entries = 0;
     uint32_t rfc_table_size = 0;
-    std::vector<HpackTableEntry*> circular_buf;
+    uint32_t entry_capacity = 0;
+    DynamicEntry* circular_buf = nullptr;
+
+    // Live bytes run from arena_head to arena_tail. Once wrapped, they run from arena_head to the
+    // end of the last entry placed before the wrap and then from the start of the arena to
+    // arena_tail.
+    uint8_t* arena = nullptr;
+    uint32_t arena_size = 0;
+    uint32_t arena_head = 0;
+    uint32_t arena_tail = 0;
+    bool arena_wrapped = false;
 
     void prune_to_size(uint32_t new_max_size);
+    void grow_entries();
+    uint8_t* grow_arena(uint32_t needed);
+    bool arena_alloc(uint32_t size, uint32_t& offset);
 };
 #endif
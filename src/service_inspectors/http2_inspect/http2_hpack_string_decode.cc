@@ -36,6 +36,65 @@ static const uint8_t HUFFMAN_FLAG = 0x80;
 static const uint8_t min_decode_len[HUFFMAN_LOOKUP_MAX + 1] =
     {5, 2, 2, 3, 5, 1, 1, 2, 2, 2, 2, 3, 3, 3, 4};
 
+// Multi-symbol table derived from huffman_decode. Indexed by the next FAST_BITS input bits at a
+// symbol boundary, each entry holds the one or two complete codes found there. Longer codes have
+// count 0 and go through huffman_decode one lookup at a time. Entries are kept to 4 bytes so the
+// whole table is 16K.
+static const uint8_t FAST_BITS = 12;
+
+struct alignas(4) HuffmanFastEntry
+{
+    uint8_t count;
+    uint8_t len : 4;        // total bits of the decoded codes
+    uint8_t last_len : 4;   // length of the final huffman_decode lookup for the last code
+    char symbol[2];
+};
+
+struct HuffmanFastTable
+{
+    HuffmanFastEntry entry[1 << FAST_BITS];
+};
+
+static HuffmanFastTable make_fast_table()
+{
+    HuffmanFastTable table;
+
+    for (uint32_t index = 0; index < (1 << FAST_BITS); index++)
+    {
+        HuffmanFastEntry& fast = table.entry[index];
+        fast = { };
+
+        while (fast.count < 2)
+        {
+            HuffmanState state = HUFFMAN_LOOKUP_1;
+            uint8_t used = fast.len;
+            HuffmanEntry result;
+
+            // Bits past FAST_BITS are zero here, so only accept lookups that do not depend on them
+            do
+            {
+                const uint8_t byte = (index << 8 >> (FAST_BITS - used)) & 0xff;
+                result = huffman_decode[state][byte];
+                if ((result.state == HUFFMAN_FAILURE) || (used + result.len > FAST_BITS))
+                    break;
+                used += result.len;
+                state = result.state;
+            }
+            while (state != HUFFMAN_MATCH);
+
+            if (state != HUFFMAN_MATCH)
+                break;
+
+            fast.symbol[fast.count++] = result.symbol;
+            fast.last_len = result.len;
+            fast.len = used;
+        }
+    }
+    return table;
+}
+
+static const HuffmanFastTable huffman_fast = make_fast_table();
+
 bool Http2HpackStringDecode::translate(const uint8_t* in_buff, const uint32_t in_len,
     uint32_t& bytes_consumed, uint8_t* out_buff, const uint32_t out_len, uint32_t& bytes_written,
     Http2EventGen* const events, Http2Infractions* const infractions, bool partial_header) const
@@ -96,62 +155,18 @@ bool Http2HpackStringDecode::get_string(const uint8_t* in_buff, const uint32_t e
     return true;
 }
 
-// return is tail/padding
-bool Http2HpackStringDecode::get_next_byte(const uint8_t* in_buff, const uint32_t last_byte,
-    uint32_t& bytes_consumed, uint8_t& cur_bit, uint8_t match_len, uint8_t& byte,
-    bool& another_search) const
-{
-    another_search = true;
-    cur_bit += match_len;
-
-    if (cur_bit >= 8) // done with current bit
-    {
-        bytes_consumed++;
-        cur_bit -= 8;
-    }
-
-    bool tail = false;
-    uint8_t msb, lsb = 0xff;
-    if (bytes_consumed == last_byte)
-    {
-        // bytes consumed must be bigger than 1 - int length is at least 1
-        msb = in_buff[bytes_consumed-1];
-        another_search = false;
-        tail = true;
-    }
-    else if ((bytes_consumed + 1) == last_byte)
-    {
-        if (cur_bit != 0)
-        {
-            msb = in_buff[bytes_consumed++];
-            tail = true;
-        }
-        else
-        {
-            byte = in_buff[bytes_consumed];
-            return false;
-        }
-    }
-    else
-    {
-        msb = in_buff[bytes_consumed];
-        lsb = in_buff[bytes_consumed+1];
-    }
-
-    const uint16_t tmp = (uint16_t)(msb << 8) | lsb;
-    byte = (tmp & (0xff00 >> cur_bit)) >> (8 - cur_bit);
-    return tail;
-}
-
 bool Http2HpackStringDecode::get_huffman_string(const uint8_t* in_buff, const uint32_t encoded_len,
     uint32_t& bytes_consumed, uint8_t* out_buff, const uint32_t out_len, uint32_t& bytes_written,
     Http2Infractions* const infractions) const
 {
-    const uint32_t last_encoded_byte = bytes_consumed + encoded_len;
+    const uint8_t* const start = in_buff + bytes_consumed;
+    const uint8_t* const end = start + encoded_len;
+    const uint8_t* in = start;
+    // Unconsumed input bits are the low bit_count bits of bits, most significant first
+    uint64_t bits = 0;
+    uint8_t bit_count = 0;
     uint8_t byte;
-    uint8_t cur_bit = 0;
     HuffmanEntry result = { 0, 0, HUFFMAN_LOOKUP_1 };
-    bool another_search = false;
     HuffmanState state = HUFFMAN_LOOKUP_1;
 
     // Check length
@@ -162,47 +177,63 @@ bool Http2HpackStringDecode::get_huffman_string(const uint8_t* in_buff, const ui
         return false;
     }
 
-    while (!get_next_byte(in_buff, last_encoded_byte, bytes_consumed, cur_bit, result.len, byte,
-        another_search))
+    while (true)
     {
-        result = huffman_decode[state][byte];
+        // Refill several bytes at a time to keep the loads off the per-symbol path
+        if (bit_count < 2 * 8)
+        {
+            while ((bit_count <= 64 - 8) && (in < end))
+            {
+                bits = (bits << 8) | *in++;
+                bit_count += 8;
+            }
+            if (bit_count < 8)
+                break;
+        }
+
+        if ((state == HUFFMAN_LOOKUP_1) && (bit_count >= FAST_BITS))
+        {
+            const HuffmanFastEntry& fast =
+                huffman_fast.entry[(bits >> (bit_count - FAST_BITS)) & ((1 << FAST_BITS) - 1)];
+            if (fast.count > 0)
+            {
+                out_buff[bytes_written++] = fast.symbol[0];
+                if (fast.count > 1)
+                    out_buff[bytes_written++] = fast.symbol[1];
+                bit_count -= fast.len;
+                result = { (uint8_t)fast.last_len, fast.symbol[fast.count - 1], HUFFMAN_MATCH };
+                continue;
+            }
+        }
 
-        switch (result.state) {
+        byte = bits >> (bit_count - 8);
+        result = huffman_decode[state][byte];
+        bit_count -= result.len;
 
-        case HUFFMAN_MATCH:
+        if (result.state == HUFFMAN_MATCH)
+        {
             out_buff[bytes_written++] = result.symbol;
             state = HUFFMAN_LOOKUP_1;
-            break;
-
-        case HUFFMAN_LOOKUP_2:
-        case HUFFMAN_LOOKUP_3:
-        case HUFFMAN_LOOKUP_4:
-        case HUFFMAN_LOOKUP_5:
-        case HUFFMAN_LOOKUP_6:
-        case HUFFMAN_LOOKUP_7:
-        case HUFFMAN_LOOKUP_8:
-        case HUFFMAN_LOOKUP_9:
-        case HUFFMAN_LOOKUP_10:
-        case HUFFMAN_LOOKUP_11:
-        case HUFFMAN_LOOKUP_12:
-        case HUFFMAN_LOOKUP_13:
-        case HUFFMAN_LOOKUP_14:
-        case HUFFMAN_LOOKUP_15:
+        }
+        else if (result.state <= HUFFMAN_LOOKUP_MAX)
             state = result.state;
-            break;
-
-        case HUFFMAN_FAILURE:
+        else
+        {
+            // Report the byte holding the start of the failed code
+            bytes_consumed += (8 * (in - start) - bit_count - result.len) / 8;
             *infractions += INF_HUFFMAN_DECODED_EOS;
             return false;
-
-        default:
-            break;
         }
     }
+    bytes_consumed += encoded_len;
+
+    // Fewer than 8 bits are left. Pad them with ones on the right.
+    const bool another_search = bit_count > 0;
+    byte = (bits << (8 - bit_count)) | ((1 << (8 - bit_count)) - 1);
 
     // Tail needs 1 last lookup in case the leftover is big enough for a match.
     // Make sure match length <= available length
-    uint8_t leftover_len = 8 - cur_bit;
+    uint8_t leftover_len = bit_count;
     uint8_t old_result_len = result.len;
     HuffmanState old_result_state = result.state;
 
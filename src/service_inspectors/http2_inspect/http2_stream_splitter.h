@@ -39,6 +39,9 @@ public:
         uint32_t* flush_offset) override;
     const snort::StreamBuffer reassemble(snort::Flow* flow, unsigned total, unsigned offset, const
         uint8_t* data, unsigned len, uint32_t flags, unsigned& copied) override;
+    const snort::StreamBuffer reassemble_segments(snort::Flow*, unsigned,
+        const snort::StreamSegment*, unsigned, uint32_t, unsigned& consumed) override
+    { consumed = 0; return { nullptr, 0 }; }  // reassemble() builds its own buffers
     bool finish(snort::Flow* flow) override;
     bool is_paf() override { return true; }
 
@@ -0,0 +1,306 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// http2_hpack_dynamic_table_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "../http2_enum.h"
+#include "../http2_hpack_dynamic_table.h"
+#include "../http2_hpack_string_decode.h"
+#include "../http2_hpack_table.h"
+#include "../http2_module.h"
+
+using namespace Http2Enums;
+
+namespace snort
+{
+// Stubs whose sole purpose is to make the test code link
+int DetectionEngine::queue_event(unsigned int, unsigned int) { return 0; }
+}
+
+THREAD_LOCAL PegCount Http2Module::peg_counts[PEG_COUNT__MAX] = { };
+
+static const uint32_t FIRST_DYNAMIC_INDEX = HpackIndexTable::STATIC_MAX_INDEX + 1;
+
+static std::string entry_name(const HpackTableEntry* entry)
+{ return std::string((const char*)entry->name.start(), entry->name.length()); }
+
+static std::string entry_value(const HpackTableEntry* entry)
+{ return std::string((const char*)entry->value.start(), entry->value.length()); }
+
+static bool add(HpackDynamicTable& table, const std::string& name, const std::string& value)
+{
+    const Field n(name.length(), (const uint8_t*)name.data());
+    const Field v(value.length(), (const uint8_t*)value.data());
+    return table.add_entry(n, v);
+}
+
+// Literal header fields with incremental indexing and Huffman coded strings, taken from the
+// HEADERS blocks in RFC 7541 appendix C.4 and C.6.1
+struct RecordedLine
+{
+    uint8_t name_index;     // static table name, or 0 when name is a Huffman string
+    std::vector<uint8_t> name;
+    std::vector<uint8_t> value;
+};
+
+static const std::vector<RecordedLine> recorded_requests =
+{
+    { 1, { }, { 0x8c, 0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff } },
+    { 24, { }, { 0x86, 0xa8, 0xeb, 0x10, 0x64, 0x9c, 0xbf } },
+    { 0, { 0x88, 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xa9, 0x7d, 0x7f },
+        { 0x89, 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xb8, 0xe8, 0xb4, 0xbf } },
+};
+
+static const std::vector<RecordedLine> recorded_response =
+{
+    { 8, { }, { 0x82, 0x64, 0x02 } },
+    { 24, { }, { 0x85, 0xae, 0xc3, 0x77, 0x1a, 0x4b } },
+    { 33, { }, { 0x96, 0xd0, 0x7a, 0xbe, 0x94, 0x10, 0x54, 0xd4, 0x44, 0xa8, 0x20, 0x05, 0x95,
+        0x04, 0x0b, 0x81, 0x66, 0xe0, 0x82, 0xa6, 0x2d, 0x1b, 0xff } },
+    { 46, { }, { 0x91, 0x9d, 0x29, 0xad, 0x17, 0x18, 0x63, 0xc7, 0x8f, 0x0b, 0x97, 0xc8, 0xe9,
+        0xae, 0x82, 0xae, 0x43, 0xd3 } },
+};
+
+
+// Decode each line as the HPACK decoder does and add it to the table
+static bool replay(HpackDynamicTable& table, const std::vector<RecordedLine>& lines)
+{
+    const Http2HpackStringDecode decode;
+    Http2EventGen events;
+    Http2Infractions infractions;
+    const HpackIndexTable index_table(nullptr);
+    uint8_t buf[2][64];
+    uint32_t consumed, written;
+
+    for (const RecordedLine& line : lines)
+    {
+        Field name;
+        if (line.name_index)
+            name.set(index_table.lookup(line.name_index)->name);
+        else
+        {
+            if (!decode.translate(line.name.data(), line.name.size(), consumed, buf[0],
+                sizeof(buf[0]), written, &events, &infractions, false))
+                return false;
+            name.set(written, buf[0]);
+        }
+
+        if (!decode.translate(line.value.data(), line.value.size(), consumed, buf[1],
+            sizeof(buf[1]), written, &events, &infractions, false))
+            return false;
+        const Field value(written, buf[1]);
+
+        if (!table.add_entry(name, value))
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE("hpack dynamic table rfc requests", "[http2_hpack_dynamic_table]")
+{
+    HpackDynamicTable table;
+    REQUIRE(replay(table, recorded_requests));
+
+    const HpackTableEntry* entry = table.get_entry(FIRST_DYNAMIC_INDEX);
+    REQUIRE(entry);
+    CHECK(entry_name(entry) == "custom-key");
+    CHECK(entry_value(entry) == "custom-value");
+
+    entry = table.get_entry(FIRST_DYNAMIC_INDEX + 1);
+    REQUIRE(entry);
+    CHECK(entry_name(entry) == "cache-control");
+    CHECK(entry_value(entry) == "no-cache");
+
+    entry = table.get_entry(FIRST_DYNAMIC_INDEX + 2);
+    REQUIRE(entry);
+    CHECK(entry_name(entry) == ":authority");
+    CHECK(entry_value(entry) == "www.example.com");
+
+    CHECK(table.get_entry(FIRST_DYNAMIC_INDEX + 3) == nullptr);
+}
+
+TEST_CASE("hpack dynamic table rfc response eviction", "[http2_hpack_dynamic_table]")
+{
+    HpackDynamicTable table;
+    table.update_size(200);
+    REQUIRE(replay(table, recorded_response));
+
+    // Adding location (63) evicts :status 302 (42) since 42 + 52 + 65 + 63 > 200
+    const HpackTableEntry* entry = table.get_entry(FIRST_DYNAMIC_INDEX);
+    REQUIRE(entry);
+    CHECK(entry_name(entry) == "location");
+    CHECK(entry_value(entry) == "https://www.example.com");
+
+    entry = table.get_entry(FIRST_DYNAMIC_INDEX + 1);
+    REQUIRE(entry);
+    CHECK(entry_name(entry) == "date");
+    CHECK(entry_value(entry) == "Mon, 21 Oct 2013 20:13:21 GMT");
+
+    entry = table.get_entry(FIRST_DYNAMIC_INDEX + 2);
+    REQUIRE(entry);
+    CHECK(entry_name(entry) == "cache-control");
+    CHECK(entry_value(entry) == "private");
+
+    CHECK(table.get_entry(FIRST_DYNAMIC_INDEX + 3) == nullptr);
+}
+
+TEST_CASE("hpack dynamic table entry limit", "[http2_hpack_dynamic_table]")
+{
+    HpackDynamicTable table;
+    table.update_size(512 * 33);
+
+    for ( unsigned i = 0; i < 512; i++ )
+        REQUIRE(add(table, "", "x"));
+
+    CHECK(!add(table, "", "x"));
+    CHECK(table.get_entry(FIRST_DYNAMIC_INDEX + 511) != nullptr);
+}
+
+TEST_CASE("hpack dynamic table oversized entry clears", "[http2_hpack_dynamic_table]")
+{
+    HpackDynamicTable table;
+    table.update_size(100);
+
+    REQUIRE(add(table, "a", "b"));
+    REQUIRE(add(table, std::string(40, 'n'), std::string(40, 'v')));
+    CHECK(table.get_entry(FIRST_DYNAMIC_INDEX) == nullptr);
+
+    REQUIRE(add(table, "", ""));
+    const HpackTableEntry* entry = table.get_entry(FIRST_DYNAMIC_INDEX);
+    REQUIRE(entry);
+    CHECK(entry->name.length() == 0);
+    CHECK(entry->value.length() == 0);
+}
+
+// Compare against a simple model through arena wraps, arena and ring growth, size updates, and
+// names that refer to the entry being evicted
+TEST_CASE("hpack dynamic table model", "[http2_hpack_dynamic_table]")
+{
+    std::mt19937 rng(2022);
+    HpackDynamicTable table;
+    std::deque<std::pair<std::string, std::string>> model;
+    uint32_t max_size = 4096;
+    uint32_t model_size = 0;
+
+    auto model_prune = [&](uint32_t limit)
+    {
+        while ( model_size > limit )
+        {
+            model_size -= model.back().first.size() + model.back().second.size() + 32;
+            model.pop_back();
+        }
+    };
+
+    for ( unsigned i = 0; i < 20000; i++ )
+    {
+        const unsigned op = rng() % 100;
+
+        if ( op == 0 )
+        {
+            max_size = rng() % 8192;
+            table.update_size(max_size);
+            model_prune(max_size);
+            continue;
+        }
+
+        std::string name;
+        const std::string value(rng() % (op < 5 ? 3000 : 100), 'a' + rng() % 26);
+
+        if ( !model.empty() and op < 40 )
+        {
+            // Reuse the name of the oldest entry straight from the table, as an indexed name would
+            const HpackTableEntry* oldest = table.get_entry(FIRST_DYNAMIC_INDEX + model.size() - 1);
+            REQUIRE(oldest);
+            name = model.back().first;
+            const Field n(oldest->name.length(), oldest->name.start());
+            const Field v(value.length(), (const uint8_t*)value.data());
+            REQUIRE(table.add_entry(n, v));
+        }
+        else
+        {
+            name = std::string(rng() % 20, 'A' + rng() % 26);
+            REQUIRE(add(table, name, value));
+        }
+
+        const uint32_t size = name.size() + value.size() + 32;
+        if ( size > max_size )
+        {
+            model.clear();
+            model_size = 0;
+        }
+        else
+        {
+            model_prune(max_size - size);
+            model.emplace_front(name, value);
+            model_size += size;
+        }
+
+        for ( unsigned k = 0; k < model.size(); k++ )
+        {
+            const HpackTableEntry* entry = table.get_entry(FIRST_DYNAMIC_INDEX + k);
+            REQUIRE(entry);
+            REQUIRE(entry_name(entry) == model[k].first);
+            REQUIRE(entry_value(entry) == model[k].second);
+        }
+        REQUIRE(table.get_entry(FIRST_DYNAMIC_INDEX + model.size()) == nullptr);
+    }
+}
+
+#ifdef BENCHMARK_TEST
+TEST_CASE("hpack dynamic table benchmark", "[http2_hpack_dynamic_table]")
+{
+    BENCHMARK("replay rfc requests and response")
+    {
+        HpackDynamicTable table;
+        replay(table, recorded_requests);
+        replay(table, recorded_response);
+        return table.get_entry(FIRST_DYNAMIC_INDEX);
+    };
+
+    HpackDynamicTable table;
+    BENCHMARK("replay into a full table")
+    {
+        replay(table, recorded_requests);
+        return replay(table, recorded_response);
+    };
+
+    const Http2HpackStringDecode decode;
+    Http2EventGen events;
+    Http2Infractions infractions;
+    uint8_t buf[64];
+    uint32_t consumed, written;
+    const std::vector<uint8_t>& date = recorded_response[2].value;
+
+    BENCHMARK("huffman decode date")
+    {
+        return decode.translate(date.data(), date.size(), consumed, buf, sizeof(buf), written,
+            &events, &infractions, false);
+    };
+}
+#endif
@@ -628,6 +628,22 @@ TEST(http2_hpack_string_decode_success, huffman_decoding_tail_lookup_unsucessful
     CHECK(bytes_written == 2);
 }
 
+TEST(http2_hpack_string_decode_success, huffman_10_bit_code_then_5_bit_code_at_end)
+{
+    // prepare buf to decode - Huffman ")t", the last code follows a 2 level code in the last byte
+    uint8_t buf[3] = {0x82, 0xFE, 0xD3};
+    // decode
+    uint32_t bytes_processed = 0, bytes_written = 0;
+    uint8_t res[3];
+    bool success = decode->translate(buf, 3, bytes_processed, res, 3, bytes_written, &events, &inf,
+        false);
+    // check results
+    CHECK(success == true);
+    CHECK(bytes_processed == 3);
+    CHECK(bytes_written == 2);
+    CHECK(memcmp(res, ")t", 2) == 0);
+}
+
 //
 // The following tests should trigger infractions/events
 //
@@ -23,6 +23,8 @@
 
 #include "http_api.h"
 
+#include "utils/js_normalizer.h"
+
 #include "http_context_data.h"
 #include "http_cursor_data.h"
 #include "http_inspect.h"
@@ -47,6 +49,11 @@ void HttpApi::http_init()
     HttpCursorData::init();
 }
 
+void HttpApi::http_tterm()
+{
+    JSNormalizer::thread_term();
+}
+
 const char* HttpApi::classic_buffer_names[] =
 {
     "http_client_body",
@@ -93,7 +100,7 @@ const InspectApi HttpApi::http_api =
     HttpApi::http_init,
     HttpApi::http_term,
     nullptr,
-    nullptr,
+    HttpApi::http_tterm,
     HttpApi::http_ctor,
     HttpApi::http_dtor,
     nullptr,
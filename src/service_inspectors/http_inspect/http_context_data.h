@@ -31,7 +31,7 @@ public:
     { current_section = nullptr; }
 
     static void init()
-    { ips_id = IpsContextData::get_ips_id(); }
+    { ips_id = IpsContextData::get_ips_id<HttpContextData>(); }
     static HttpMsgSection* get_snapshot(const snort::Packet* p);
     static HttpMsgSection* get_snapshot(const snort::Flow* flow,
         snort::IpsContext* context = nullptr);
@@ -23,6 +23,9 @@
 
 #include "http_cutter.h"
 
+#include "decompress/decomp_pool.h"
+#include "helpers/byte_set.h"
+
 #include "http_common.h"
 #include "http_enum.h"
 #include "http_flow_data.h"
@@ -30,6 +33,25 @@
 
 using namespace HttpEnums;
 
+// Most octets of start lines, header lines, and chunk options leave the cutter state unchanged.
+// Those runs are skipped with a vectorized search for the next CR or LF.
+static snort::ByteSet make_cr_lf_set()
+{
+    snort::ByteSet set;
+    set.add('\r');
+    set.add('\n');
+    return set;
+}
+
+static const snort::ByteSet cr_lf_set = make_cr_lf_set();
+
+static inline uint32_t next_cr_lf(const uint8_t* buffer, uint32_t k, uint32_t length)
+{
+    if (is_cr_lf[buffer[k]])
+        return k;
+    return cr_lf_set.find(buffer + k, buffer + length) - buffer;
+}
+
 ScanResult HttpStartCutter::cut(const uint8_t* buffer, uint32_t length,
     HttpInfractions* infractions, HttpEventGen* events, uint32_t, bool, HttpEnums::H2BodyState)
 {
@@ -87,6 +109,10 @@ ScanResult HttpStartCutter::cut(const uint8_t* buffer, uint32_t length,
                 break;
             }
         }
+        // Once validated, nothing before the next CR or LF matters
+        else if (num_crlf == 0 && (k = next_cr_lf(buffer, k, length)) == length)
+            break;
+
         if (buffer[k] == '\n')
         {
             num_crlf++;
@@ -196,6 +222,8 @@ ScanResult HttpHeaderCutter::cut(const uint8_t* buffer, uint32_t length,
         switch (state)
         {
         case ZERO:
+            if ((k = next_cr_lf(buffer, k, length)) == length)
+                break;
             if (buffer[k] == '\r')
             {
                 state = HALF;
@@ -288,20 +316,17 @@ HttpBodyCutter::HttpBodyCutter(bool accelerated_blocking_, ScriptFinder* finder_
     {
         if ((compression == CMP_GZIP) || (compression == CMP_DEFLATE))
         {
-            compress_stream = new z_stream;
-            compress_stream->zalloc = Z_NULL;
-            compress_stream->zfree = Z_NULL;
-            compress_stream->next_in = Z_NULL;
-            compress_stream->avail_in = 0;
             const int window_bits = (compression == CMP_GZIP) ?
                 GZIP_WINDOW_BITS : DEFLATE_WINDOW_BITS;
-            if (inflateInit2(compress_stream, window_bits) != Z_OK)
+            bool reused;
+            compress_stream = snort::DecompPool::get_inflate(window_bits, &reused);
+            if (compress_stream == nullptr)
             {
                 assert(false);
                 compression = CMP_NONE;
-                delete compress_stream;
-                compress_stream = nullptr;
             }
+            else
+                HttpModule::increment_peg_counts(reused ? PEG_INFLATE_REUSE : PEG_INFLATE_INIT);
         }
 
         static const uint8_t inspect_string[] = { '<', '/', 's', 'c', 'r', 'i', 'p', 't', '>' };
@@ -315,11 +340,7 @@ HttpBodyCutter::HttpBodyCutter(bool accelerated_blocking_, ScriptFinder* finder_
 
 HttpBodyCutter::~HttpBodyCutter()
 {
-    if (compress_stream != nullptr)
-    {
-        inflateEnd(compress_stream);
-        delete compress_stream;
-    }
+    snort::DecompPool::put_inflate(compress_stream);
 }
 
 ScanResult HttpBodyClCutter::cut(const uint8_t* buffer, uint32_t length, HttpInfractions*,
@@ -588,6 +609,8 @@ ScanResult HttpBodyChunkCutter::cut(const uint8_t* buffer, uint32_t length,
             break;
         case CHUNK_OPTIONS:
             // The RFC permits options to follow the chunk size. No one normally does this.
+            if ((k = next_cr_lf(buffer, k, length)) == static_cast<int32_t>(length))
+                break;
             if (buffer[k] == '\r')
             {
                 curr_state = CHUNK_HCRLF;
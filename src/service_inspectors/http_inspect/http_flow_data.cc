@@ -23,6 +23,7 @@
 
 #include "http_flow_data.h"
 
+#include "decompress/decomp_pool.h"
 #include "decompress/file_decomp.h"
 #include "main/snort_debug.h"
 #include "service_inspectors/http2_inspect/http2_flow_data.h"
@@ -118,11 +119,7 @@ HttpFlowData::~HttpFlowData()
         delete[] partial_detect_buffer[k];
         HttpTransaction::delete_transaction(transaction[k], nullptr);
         delete cutter[k];
-        if (compress_stream[k] != nullptr)
-        {
-            inflateEnd(compress_stream[k]);
-            delete compress_stream[k];
-        }
+        DecompPool::put_inflate(compress_stream[k]);
         delete mime_state[k];
         delete utf_state[k];
         if (fd_state[k] != nullptr)
@@ -159,12 +156,8 @@ void HttpFlowData::half_reset(SourceId source_id)
     compression[source_id] = CMP_NONE;
     gzip_state[source_id] = GZIP_TBD;
     gzip_header_bytes_processed[source_id] = 0;
-    if (compress_stream[source_id] != nullptr)
-    {
-        inflateEnd(compress_stream[source_id]);
-        delete compress_stream[source_id];
-        compress_stream[source_id] = nullptr;
-    }
+    DecompPool::put_inflate(compress_stream[source_id]);
+    compress_stream[source_id] = nullptr;
     delete mime_state[source_id];
     mime_state[source_id] = nullptr;
     delete utf_state[source_id];
@@ -199,12 +192,8 @@ void HttpFlowData::trailer_prep(SourceId source_id)
 {
     type_expected[source_id] = SEC_TRAILER;
     compression[source_id] = CMP_NONE;
-    if (compress_stream[source_id] != nullptr)
-    {
-        inflateEnd(compress_stream[source_id]);
-        delete compress_stream[source_id];
-        compress_stream[source_id] = nullptr;
-    }
+    DecompPool::put_inflate(compress_stream[source_id]);
+    compress_stream[source_id] = nullptr;
 }
 
 void HttpFlowData::garbage_collect()
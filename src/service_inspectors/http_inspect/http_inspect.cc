@@ -168,6 +168,7 @@ void HttpInspect::show(const SnortConfig*) const
     ConfigLogger::log_value("js_norm_max_tmpl_nest", params->js_norm_param.max_template_nesting);
     ConfigLogger::log_value("js_norm_max_bracket_depth", params->js_norm_param.max_bracket_depth);
     ConfigLogger::log_value("js_norm_max_scope_depth", params->js_norm_param.max_scope_depth);
+    ConfigLogger::log_flag("js_norm_prescan", params->js_norm_param.prescan);
     if (!js_norm_ident_ignore.empty())
         ConfigLogger::log_list("js_norm_ident_ignore", js_norm_ident_ignore.c_str());
     ConfigLogger::log_value("bad_characters", bad_chars.c_str());
@@ -25,6 +25,7 @@
 
 #include "main/snort_debug.h"
 #include "utils/js_normalizer.h"
+#include "utils/js_prescan.h"
 #include "utils/safec.h"
 #include "utils/util_jsnorm.h"
 
@@ -82,7 +83,8 @@ static inline JSTokenizer::JSRet js_normalize(JSNormalizer& ctx, const Packet* c
 
 HttpJsNorm::HttpJsNorm(const HttpParaList::UriParam& uri_param_, int64_t normalization_depth_,
     int32_t identifier_depth_, uint8_t max_template_nesting_, uint32_t max_bracket_depth_,
-    uint32_t max_scope_depth_, const std::unordered_set<std::string>& ignored_ids_) :
+    uint32_t max_scope_depth_, const std::unordered_set<std::string>& ignored_ids_,
+    bool prescan_) :
     uri_param(uri_param_),
     detection_depth(UINT64_MAX),
     normalization_depth(normalization_depth_),
@@ -91,6 +93,7 @@ HttpJsNorm::HttpJsNorm(const HttpParaList::UriParam& uri_param_, int64_t normali
     max_bracket_depth(max_bracket_depth_),
     max_scope_depth(max_scope_depth_),
     ignored_ids(ignored_ids_),
+    prescan(prescan_),
     mpse_otag(nullptr),
     mpse_attr(nullptr),
     mpse_type(nullptr)
@@ -304,6 +307,19 @@ void HttpJsNorm::do_inline(const Field& input, Field& output,
             // script found
             if (!script_external)
                 HttpModule::increment_peg_counts(PEG_JS_INLINE);
+
+            const char* script_end = (prescan && !script_external) ?
+                js_prescan(ptr, end - ptr, std::min(max_bracket_depth, max_scope_depth)) : nullptr;
+
+            if (script_end)
+            {
+                trace_logf(2, http_trace, TRACE_JS_PROC, current_packet,
+                    "plain script bypassed, %zd bytes\n", script_end - ptr);
+
+                HttpModule::increment_peg_counts(PEG_JS_BYPASS_BYTES, script_end - ptr);
+                ptr = script_end;
+                continue;
+            }
         }
 
         auto& js_ctx = ssn->acquire_js_ctx(identifier_depth, normalization_depth,
@@ -109,6 +109,9 @@ const Parameter HttpModule::http_params[] =
     { "js_norm_ident_ignore", Parameter::PT_LIST, js_norm_ident_ignore_param, nullptr,
       "list of JavaScript ignored identifiers which will not be normalized" },
 
+    { "js_norm_prescan", Parameter::PT_BOOL, nullptr, "false",
+      "pass inline scripts without obfuscation indicators over enhanced JavaScript normalizer" },
+
     { "max_javascript_whitespaces", Parameter::PT_INT, "1:65535", "200",
       "maximum consecutive whitespaces allowed within the JavaScript obfuscated data" },
 
@@ -297,6 +300,10 @@ bool HttpModule::set(const char*, Value& val, SnortConfig*)
     {
         params->js_norm_param.ignored_ids.insert(val.get_string());
     }
+    else if (val.is("js_norm_prescan"))
+    {
+        params->js_norm_param.prescan = val.get_bool();
+    }
     else if (val.is("max_javascript_whitespaces"))
     {
         params->js_norm_param.max_javascript_whitespaces = val.get_uint16();
@@ -467,6 +474,8 @@ bool HttpModule::end(const char* fqn, int, SnortConfig*)
         params->uri_param.utf8_bare_byte = false;
     }
 
+    params->uri_param.set_uri_sets();
+
     if (params->uri_param.iis_unicode)
     {
         params->uri_param.unicode_map = new uint8_t[65536];
@@ -481,7 +490,8 @@ bool HttpModule::end(const char* fqn, int, SnortConfig*)
     params->js_norm_param.js_norm = new HttpJsNorm(params->uri_param,
         params->js_norm_param.js_norm_bytes_depth, params->js_norm_param.js_identifier_depth,
         params->js_norm_param.max_template_nesting, params->js_norm_param.max_bracket_depth,
-        params->js_norm_param.max_scope_depth, params->js_norm_param.ignored_ids);
+        params->js_norm_param.max_scope_depth, params->js_norm_param.ignored_ids,
+        params->js_norm_param.prescan);
 
     params->script_detection_handle = script_detection_handle;
 
@@ -565,5 +575,23 @@ HttpParaList::UriParam::UriParam() :
     CHAR_EIGHTBIT,  CHAR_EIGHTBIT,  CHAR_EIGHTBIT,  CHAR_EIGHTBIT,  CHAR_EIGHTBIT,  CHAR_EIGHTBIT,  CHAR_EIGHTBIT,  CHAR_EIGHTBIT,
     CHAR_EIGHTBIT,  CHAR_EIGHTBIT,  CHAR_EIGHTBIT,  CHAR_EIGHTBIT,  CHAR_EIGHTBIT,  CHAR_EIGHTBIT,  CHAR_EIGHTBIT,  CHAR_EIGHTBIT
   }
-{}
+{
+    set_uri_sets();
+}
+
+void HttpParaList::UriParam::set_uri_sets()
+{
+    norm_set.clear();
+    path_set.clear();
+    bad_set.clear();
+    for (unsigned k = 0; k < 256; k++)
+    {
+        if ((uri_char[k] == CHAR_PERCENT) || (uri_char[k] == CHAR_SUBSTIT))
+            norm_set.add(k);
+        else if (uri_char[k] == CHAR_PATH)
+            path_set.add(k);
+        if (bad_characters[k])
+            bad_set.add(k);
+    }
+}
 
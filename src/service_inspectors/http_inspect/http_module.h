@@ -25,6 +25,7 @@
 #include <unordered_set>
 
 #include "framework/module.h"
+#include "helpers/byte_set.h"
 #include "helpers/literal_search.h"
 #include "mime/file_mime_config.h"
 #include "profiler/profiler.h"
@@ -74,6 +75,7 @@ public:
         uint32_t max_bracket_depth = 256;
         uint32_t max_scope_depth = 256;
         std::unordered_set<std::string> ignored_ids;
+        bool prescan = false;
         int max_javascript_whitespaces = 200;
         class HttpJsNorm* js_norm = nullptr;
     };
@@ -101,6 +103,13 @@ public:
         std::bitset<256> unreserved_char;
         HttpEnums::CharAction uri_char[256];
 
+        // uri_char and bad_characters as byte sets so URI components can be classified 64
+        // octets at a time. Must be rebuilt when either of them changes.
+        snort::ByteSet norm_set;    // CHAR_PERCENT and CHAR_SUBSTIT
+        snort::ByteSet path_set;    // CHAR_PATH
+        snort::ByteSet bad_set;     // bad_characters
+        void set_uri_sets();
+
         static const std::bitset<256> default_unreserved_char;
     };
     UriParam uri_param;
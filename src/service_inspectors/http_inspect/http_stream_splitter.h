@@ -42,6 +42,9 @@ public:
         uint32_t* flush_offset) override;
     const snort::StreamBuffer reassemble(snort::Flow* flow, unsigned total, unsigned, const
         uint8_t* data, unsigned len, uint32_t flags, unsigned& copied) override;
+    const snort::StreamBuffer reassemble_segments(snort::Flow*, unsigned,
+        const snort::StreamSegment*, unsigned, uint32_t, unsigned& consumed) override
+    { consumed = 0; return { nullptr, 0 }; }  // reassemble() builds its own buffers
     bool finish(snort::Flow* flow) override;
     void prep_partial_flush(snort::Flow* flow, uint32_t num_flush);
     bool is_paf() override { return true; }
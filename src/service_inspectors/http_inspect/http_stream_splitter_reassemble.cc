@@ -21,6 +21,7 @@
 #include "config.h"
 #endif
 
+#include "decompress/decomp_pool.h"
 #include "protocols/packet.h"
 
 #include "http_inspect.h"
@@ -194,6 +195,8 @@ void HttpStreamSplitter::decompress_copy(uint8_t* buffer, uint32_t& offset, cons
 
         if ((ret_val == Z_OK) || (ret_val == Z_STREAM_END))
         {
+            HttpModule::increment_peg_counts(PEG_INFLATED_BYTES,
+                MAX_OCTETS - compress_stream->avail_out - offset);
             offset = MAX_OCTETS - compress_stream->avail_out;
             if (compress_stream->avail_in > 0)
             {
@@ -217,8 +220,7 @@ void HttpStreamSplitter::decompress_copy(uint8_t* buffer, uint32_t& offset, cons
                     events->create_event(EVENT_GZIP_OVERRUN);
                 }
                 compression = CMP_NONE;
-                inflateEnd(compress_stream);
-                delete compress_stream;
+                DecompPool::put_inflate(compress_stream);
                 compress_stream = nullptr;
                 // FIXIT-E - Will need to clear gzip header processing state here when we implement
                 // processing multiple gzip members in a message section
@@ -246,8 +248,7 @@ void HttpStreamSplitter::decompress_copy(uint8_t* buffer, uint32_t& offset, cons
             *infractions += INF_GZIP_FAILURE;
             events->create_event(EVENT_GZIP_FAILURE);
             compression = CMP_NONE;
-            inflateEnd(compress_stream);
-            delete compress_stream;
+            DecompPool::put_inflate(compress_stream);
             compress_stream = nullptr;
             // Since we failed to uncompress the data, fall through
         }
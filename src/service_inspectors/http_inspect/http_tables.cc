@@ -382,6 +382,14 @@ const PegInfo HttpModule::peg_names[PEG_COUNT_MAX+1] =
     { CountType::SUM, "js_identifiers", "total number of unique JavaScript identifiers processed" },
     { CountType::SUM, "js_identifier_overflows", "total number of unique JavaScript identifier "
         "limit overflows" },
+    { CountType::SUM, "inflate_inits", "total gzip and deflate decompression contexts "
+        "initialized" },
+    { CountType::SUM, "inflate_reuses", "total gzip and deflate decompression contexts reused "
+        "from the thread pool" },
+    { CountType::SUM, "inflated_bytes", "total bytes produced by gzip and deflate "
+        "decompression" },
+    { CountType::SUM, "js_bypassed_bytes", "total number of inline JavaScript bytes passed "
+        "over normalization by the pre-scan" },
     { CountType::END, nullptr, nullptr }
 };
 
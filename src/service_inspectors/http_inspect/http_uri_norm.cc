@@ -23,6 +23,7 @@
 
 #include "http_uri_norm.h"
 
+#include <cstring>
 #include <sstream>
 
 #include "http_enum.h"
@@ -54,66 +55,56 @@ void UriNormalizer::normalize(const Field& input, Field& result, bool do_path, u
 bool UriNormalizer::need_norm(const Field& uri_component, bool do_path,
     const HttpParaList::UriParam& uri_param, HttpInfractions* infractions, HttpEventGen* events)
 {
-    bool need_it;
-    if (do_path && uri_param.simplify_path)
-        need_it = need_norm_path(uri_component, uri_param);
-    else
-        need_it = need_norm_no_path(uri_component, uri_param);
-
-    if (!need_it)
+    // Single pass over the component classifying up to 64 octets at a time. Path simplification
+    // is needed wherever two path characters are adjacent: //, /., ./, and .. all qualify while a
+    // lone slash or period does not.
+    const bool simplify = do_path && uri_param.simplify_path;
+    const bool check_bad = uri_param.bad_characters.any();
+    const uint8_t* buf = uri_component.start();
+    int32_t remaining = uri_component.length();
+    uint64_t prev_path = 0;
+    uint64_t bad = 0;
+
+    while (remaining > 0)
     {
-        // Since we are not going to normalize we need to check for bad characters now
-        detect_bad_char(uri_component, uri_param, infractions, events);
-    }
+        const uint8_t* block = buf;
+        uint64_t valid = ~0ULL;
+        alignas(64) uint8_t tail[64];
 
-    return need_it;
-}
+        // The final partial block is copied once rather than by each set
+        if (remaining < 64)
+        {
+            memcpy(tail, buf, remaining);
+            memset(tail + remaining, 0, sizeof(tail) - remaining);
+            block = tail;
+            valid = (1ULL << remaining) - 1;
+        }
 
-bool UriNormalizer::need_norm_no_path(const Field& uri_component,
-    const HttpParaList::UriParam& uri_param)
-{
-    for (int32_t k = 0; k < uri_component.length(); k++)
-    {
-        if ((uri_param.uri_char[uri_component.start()[k]] == CHAR_PERCENT) ||
-            (uri_param.uri_char[uri_component.start()[k]] == CHAR_SUBSTIT))
+        if ((uri_param.norm_set.match(block, 64) & valid) != 0)
             return true;
-    }
-    return false;
-}
 
-bool UriNormalizer::need_norm_path(const Field& uri_component,
-    const HttpParaList::UriParam& uri_param)
-{
-    const int32_t length = uri_component.length();
-    const uint8_t* const buf = uri_component.start();
-    for (int32_t k = 0; k < length; k++)
-    {
-        switch (uri_param.uri_char[buf[k]])
+        if (simplify)
         {
-        case CHAR_NORMAL:
-        case CHAR_EIGHTBIT:
-            continue;
-        case CHAR_PERCENT:
-        case CHAR_SUBSTIT:
-            return true;
-        case CHAR_PATH:
-            if (buf[k] == '/')
-            {
-                // slash is safe if not preceded by another slash
-                if ((k == 0) || (buf[k-1] != '/'))
-                    continue;
+            const uint64_t path = uri_param.path_set.match(block, 64) & valid;
+            if ((path & (path >> 1)) || (prev_path & path & 1))
                 return true;
-            }
-            else
-            {
-                // period is safe if not preceded or followed by another path character
-                if (((k == 0) || (uri_param.uri_char[buf[k-1]] != CHAR_PATH))          &&
-                    ((k == length-1) || (uri_param.uri_char[buf[k+1]] != CHAR_PATH)))
-                    continue;
-                return true;
-            }
+            prev_path = path >> 63;
         }
+
+        if (check_bad)
+            bad |= uri_param.bad_set.match(block, 64) & valid;
+
+        buf += 64;
+        remaining -= 64;
     }
+
+    // Since we are not going to normalize we need to check for bad characters now
+    if (bad != 0)
+    {
+        *infractions += INF_URI_BAD_CHAR;
+        events->create_event(EVENT_NON_RFC_CHAR);
+    }
+
     return false;
 }
 
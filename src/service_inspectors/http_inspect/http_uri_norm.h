@@ -47,10 +47,6 @@ public:
     static void load_unicode_map(uint8_t map[65536], const char* filename, int code_page);
 
 private:
-    static bool need_norm_path(const Field& uri_component,
-        const HttpParaList::UriParam& uri_param);
-    static bool need_norm_no_path(const Field& uri_component,
-        const HttpParaList::UriParam& uri_param);
     static int32_t norm_char_clean(const Field& input, uint8_t* out_buf,
         const HttpParaList::UriParam& uri_param, HttpInfractions* infractions,
         HttpEventGen* events);
@@ -0,0 +1,259 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// http_cutter_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "decompress/decomp_pool.h"
+#include "service_inspectors/http_inspect/http_cutter.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "catch/catch.hpp"
+
+using namespace snort;
+using namespace HttpEnums;
+
+// Stubs whose sole purpose is to make the test code link
+namespace snort
+{
+int DetectionEngine::queue_event(unsigned, unsigned) { return 0; }
+const char* SnortStrnStr(const char*, int, const char*) { return nullptr; }
+z_stream* DecompPool::get_inflate(int, bool*) { return nullptr; }
+void DecompPool::put_inflate(z_stream*) { }
+}
+THREAD_LOCAL PegCount HttpModule::peg_counts[PEG_COUNT_MAX] = { };
+
+// Result of presenting a message to a cutter in segments of the given size
+struct CutResult
+{
+    ScanResult result = SCAN_NOT_FOUND;
+    uint32_t flush_offset = 0;
+    uint32_t num_head_lines = 0;
+    uint64_t infractions[3] = { };
+    uint64_t events[4] = { };
+};
+
+static CutResult cut_segments(HttpCutter* cutter, const std::string& msg, uint32_t segment,
+    uint32_t flow_target = 0)
+{
+    CutResult cr;
+    HttpInfractions infractions;
+    HttpEventGen events;
+    const uint8_t* data = (const uint8_t*)msg.data();
+    uint32_t offset = 0;
+
+    while (offset < msg.length())
+    {
+        const uint32_t length = std::min(segment, (uint32_t)msg.length() - offset);
+        cr.result = cutter->cut(data + offset, length, &infractions, &events, flow_target,
+            false, H2_BODY_NOT_COMPLETE);
+        if ((cr.result != SCAN_NOT_FOUND) && (cr.result != SCAN_NOT_FOUND_ACCELERATE))
+        {
+            cr.flush_offset = offset + cutter->get_num_flush();
+            break;
+        }
+        offset += length;
+    }
+
+    cr.num_head_lines = cutter->get_num_head_lines();
+    cr.infractions[0] = infractions.get_raw();
+    cr.infractions[1] = infractions.get_raw2();
+    cr.infractions[2] = infractions.get_raw3();
+    cr.events[0] = events.get_raw();
+    cr.events[1] = events.get_raw2();
+    cr.events[2] = events.get_raw3();
+    cr.events[3] = events.get_raw4();
+    return cr;
+}
+
+static void check_same(const CutResult& lhs, const CutResult& rhs)
+{
+    CHECK(lhs.result == rhs.result);
+    CHECK(lhs.flush_offset == rhs.flush_offset);
+    CHECK(lhs.num_head_lines == rhs.num_head_lines);
+    CHECK(memcmp(lhs.infractions, rhs.infractions, sizeof(lhs.infractions)) == 0);
+    CHECK(memcmp(lhs.events, rhs.events, sizeof(lhs.events)) == 0);
+}
+
+// Cutting must not depend on where the message is split into segments
+template <typename Make>
+static CutResult check_all_segmentations(Make make, const std::string& msg,
+    uint32_t flow_target = 0)
+{
+    std::unique_ptr<HttpCutter> whole(make());
+    const CutResult expected = cut_segments(whole.get(), msg, msg.length(), flow_target);
+
+    for (uint32_t segment = 1; segment < msg.length(); segment++)
+    {
+        std::unique_ptr<HttpCutter> cutter(make());
+        check_same(cut_segments(cutter.get(), msg, segment, flow_target), expected);
+    }
+    return expected;
+}
+
+static HttpCutter* make_request() { return new HttpRequestCutter; }
+static HttpCutter* make_status() { return new HttpStatusCutter; }
+static HttpCutter* make_header() { return new HttpHeaderCutter; }
+static HttpCutter* make_chunk()
+{ return new HttpBodyChunkCutter(0xFFFFFFFF, false, nullptr, CMP_NONE); }
+
+static const std::string long_line(std::string(200, 'a'));
+
+TEST_CASE("http start cutter request line", "[http_start_cutter]")
+{
+    const std::string msg = "GET /" + long_line + " HTTP/1.1\r\nHost: x\r\n";
+    const CutResult cr = check_all_segmentations(make_request, msg);
+    CHECK(cr.result == SCAN_FOUND);
+    CHECK(cr.flush_offset == msg.find('\n') + 1);
+    CHECK(cr.infractions[0] == 0);
+}
+
+TEST_CASE("http start cutter request line bare lf", "[http_start_cutter]")
+{
+    const std::string msg = "POST /" + long_line + " HTTP/1.1\nHost: x\r\n";
+    const CutResult cr = check_all_segmentations(make_request, msg);
+    CHECK(cr.result == SCAN_FOUND);
+    CHECK(cr.flush_offset == msg.find('\n') + 1);
+    CHECK(cr.infractions[0] != 0);
+}
+
+TEST_CASE("http start cutter request line bare cr", "[http_start_cutter]")
+{
+    const std::string msg = "GET /" + long_line + "\rx HTTP/1.1\r\n";
+    std::unique_ptr<HttpCutter> cutter(make_request());
+    const CutResult cr = cut_segments(cutter.get(), msg, msg.length());
+    CHECK(cr.result == SCAN_FOUND);
+    CHECK(cr.flush_offset == msg.find('\r') + 1);
+    CHECK(cr.infractions[0] != 0);
+}
+
+TEST_CASE("http start cutter status line", "[http_start_cutter]")
+{
+    const std::string msg = "HTTP/1.1 200 " + long_line + "\r\nServer: x\r\n";
+    const CutResult cr = check_all_segmentations(make_status, msg);
+    CHECK(cr.result == SCAN_FOUND);
+    CHECK(cr.flush_offset == msg.find('\n') + 1);
+}
+
+TEST_CASE("http start cutter not http", "[http_start_cutter]")
+{
+    const CutResult cr = check_all_segmentations(make_request, "\x16\x03\x01" + long_line);
+    CHECK(cr.result == SCAN_ABORT);
+}
+
+TEST_CASE("http header cutter header block", "[http_header_cutter]")
+{
+    const std::string msg = "Host: example.com\r\nUser-Agent: " + long_line +
+        "\r\nCookie: " + long_line + long_line + "\r\n\r\nbody";
+    const CutResult cr = check_all_segmentations(make_header, msg);
+    CHECK(cr.result == SCAN_FOUND);
+    CHECK(cr.flush_offset == msg.length() - 4);
+    CHECK(cr.num_head_lines == 3);
+    CHECK(cr.infractions[0] == 0);
+}
+
+TEST_CASE("http header cutter bare line ends", "[http_header_cutter]")
+{
+    const std::string msg = "Host: example.com\nAccept: " + long_line + "\r\rVia: " +
+        long_line + "\n\r\nbody";
+    const CutResult cr = check_all_segmentations(make_header, msg);
+    CHECK(cr.result == SCAN_FOUND);
+    CHECK(cr.flush_offset == msg.length() - 4);
+    CHECK(cr.infractions[0] != 0);
+}
+
+TEST_CASE("http header cutter no headers", "[http_header_cutter]")
+{
+    const CutResult cr = check_all_segmentations(make_header, "\r\nbody");
+    CHECK(cr.result == SCAN_FOUND);
+    CHECK(cr.flush_offset == 2);
+    CHECK(cr.num_head_lines == 0);
+}
+
+TEST_CASE("http header cutter incomplete", "[http_header_cutter]")
+{
+    std::unique_ptr<HttpCutter> cutter(make_header());
+    const CutResult cr = cut_segments(cutter.get(), "Host: " + long_line + "\r\nVia: x", 1000);
+    CHECK(cr.result == SCAN_NOT_FOUND);
+}
+
+TEST_CASE("http chunk cutter chunk options", "[http_chunk_cutter]")
+{
+    const std::string msg = "5;name=" + long_line + "\r\nhello\r\n3 ; " + long_line +
+        "\r\nabc\r\n0\r\n\r\n";
+    const CutResult cr = check_all_segmentations(make_chunk, msg, 65535);
+    CHECK(cr.result == SCAN_FOUND);
+    // trailers are a separate section
+    CHECK(cr.flush_offset == msg.length() - 2);
+    CHECK((cr.infractions[0] | cr.infractions[1] | cr.infractions[2]) != 0);
+}
+
+TEST_CASE("http chunk cutter chunk options bare lf", "[http_chunk_cutter]")
+{
+    const std::string msg = "5;" + long_line + "\nhello\r\n0;" + long_line + "\r\n\r\n";
+    const CutResult cr = check_all_segmentations(make_chunk, msg, 65535);
+    CHECK(cr.result == SCAN_FOUND);
+    CHECK(cr.flush_offset == msg.length() - 2);
+}
+
+#ifdef BENCHMARK_TEST
+TEST_CASE("http cutter benchmark", "[http_cutter]")
+{
+    std::string uri = "/" + std::string(1000, 'u');
+    const std::string request = "GET " + uri + " HTTP/1.1\r\n";
+
+    std::string headers;
+    for (unsigned i = 0; i < 16; i++)
+        headers += "X-Header-" + std::to_string(i) + ": " + std::string(60, 'v') + "\r\n";
+    headers += "\r\n";
+
+    std::string chunks;
+    for (unsigned i = 0; i < 16; i++)
+        chunks += "1000;ext=" + std::string(40, 'e') + "\r\n" + std::string(0x1000, 'c') + "\r\n";
+    chunks += "0\r\n\r\n";
+
+    BENCHMARK("start line 1K")
+    {
+        HttpRequestCutter cutter;
+        return cut_segments(&cutter, request, request.length()).flush_offset;
+    };
+
+    BENCHMARK("header block 1K")
+    {
+        HttpHeaderCutter cutter;
+        return cut_segments(&cutter, headers, headers.length()).flush_offset;
+    };
+
+    BENCHMARK("header block 1K in 100 byte segments")
+    {
+        HttpHeaderCutter cutter;
+        return cut_segments(&cutter, headers, 100).flush_offset;
+    };
+
+    BENCHMARK("chunked body 64K")
+    {
+        HttpBodyChunkCutter cutter(0xFFFFFFFF, false, nullptr, CMP_NONE);
+        return cut_segments(&cutter, chunks, chunks.length(), 65535).flush_offset;
+    };
+}
+#endif
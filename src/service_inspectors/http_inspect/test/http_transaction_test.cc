@@ -23,6 +23,7 @@
 #include "config.h"
 #endif
 
+#include "decompress/decomp_pool.h"
 #include "service_inspectors/http_inspect/http_common.h"
 #include "service_inspectors/http_inspect/http_enum.h"
 #include "service_inspectors/http_inspect/http_flow_data.h"
@@ -48,6 +49,7 @@ int DetectionEngine::queue_event(unsigned int, unsigned int) { return 0; }
 fd_status_t File_Decomp_StopFree(fd_session_t*) { return File_Decomp_OK; }
 uint32_t str_to_hash(const uint8_t *, size_t) { return 0; }
 FlowData* Flow::get_flow_data(uint32_t) const { return nullptr; }
+void DecompPool::put_inflate(z_stream*) { }
 }
 
 unsigned Http2FlowData::inspector_id = 0;
@@ -59,11 +59,13 @@ void show_stats(PegCount*, const PegInfo*, const IndexVec&, const char*, FILE*)
 
 HttpJsNorm::HttpJsNorm(const HttpParaList::UriParam& uri_param_, int64_t normalization_depth_,
     int32_t identifier_depth_, uint8_t max_template_nesting_, uint32_t max_bracket_depth_,
-    uint32_t max_scope_depth_, const std::unordered_set<std::string>& ignored_ids_) :
+    uint32_t max_scope_depth_, const std::unordered_set<std::string>& ignored_ids_,
+    bool prescan_) :
     uri_param(uri_param_), normalization_depth(normalization_depth_),
     identifier_depth(identifier_depth_), max_template_nesting(max_template_nesting_),
     max_bracket_depth(max_bracket_depth_), max_scope_depth(max_scope_depth_),
-    ignored_ids(ignored_ids_), mpse_otag(nullptr), mpse_attr(nullptr), mpse_type(nullptr) {}
+    ignored_ids(ignored_ids_), prescan(prescan_), mpse_otag(nullptr), mpse_attr(nullptr),
+    mpse_type(nullptr) {}
 HttpJsNorm::~HttpJsNorm() = default;
 void HttpJsNorm::configure() {}
 int64_t Parameter::get_int(char const*) { return 0; }
@@ -85,6 +87,63 @@ TEST(http_inspect_uri_norm, normalize)
     CHECK(memcmp(result.start(), "/uri/to/normalize", 17) == 0);
 }
 
+TEST_GROUP(http_inspect_need_norm)
+{
+    HttpParaList::UriParam uri_param;
+    HttpInfractions infractions;
+    HttpEventGen events;
+
+    bool need_norm(const char* uri, bool do_path)
+    {
+        const Field input(strlen(uri), (const uint8_t*)uri);
+        return UriNormalizer::need_norm(input, do_path, uri_param, &infractions, &events);
+    }
+};
+
+TEST(http_inspect_need_norm, already_normal)
+{
+    CHECK(!need_norm("/index.html", true));
+    CHECK(!need_norm("/static/js/vendor/jquery-3.6.0.min.js", true));
+    CHECK(!need_norm("/a/b/c/d/e/f/g/h/i/j/k/l/m/n/o/p/q/r/s/t/u/v/w/x/y/z/a/b/c/d/e/f/g.h", true));
+    CHECK(!need_norm("q=a/b//c&r=../s", false));
+    CHECK(!need_norm("/caf\xc3\xa9/menu", true));
+    CHECK(infractions.none_found());
+}
+
+TEST(http_inspect_need_norm, needs_norm)
+{
+    CHECK(need_norm("/uri/to/%6eormalize", true));
+    CHECK(need_norm("q=a+b", false));
+    CHECK(need_norm("/uri//to", true));
+    CHECK(need_norm("/uri/./to", true));
+    CHECK(need_norm("/uri/../to", true));
+    CHECK(need_norm("/uri/to/.", true));
+    CHECK(need_norm("./uri", true));
+}
+
+TEST(http_inspect_need_norm, block_boundary)
+{
+    // 63 octets then a second slash that straddles the first 64 octet block
+    std::string uri(63, 'a');
+    uri[0] = '/';
+    uri[62] = '/';
+    CHECK(!need_norm(uri.c_str(), true));
+    uri += "/x";
+    CHECK(need_norm(uri.c_str(), true));
+    uri = std::string(200, 'a') + "%41";
+    CHECK(need_norm(uri.c_str(), false));
+}
+
+TEST(http_inspect_need_norm, bad_char)
+{
+    uri_param.bad_characters[' '] = true;
+    uri_param.set_uri_sets();
+    CHECK(!need_norm("/no/bad/chars", true));
+    CHECK(infractions.none_found());
+    CHECK(!need_norm((std::string(100, 'a') + " b").c_str(), false));
+    CHECK(!infractions.none_found());
+}
+
 TEST_GROUP(http_double_decode_test)
 {
     uint8_t buffer[1000];
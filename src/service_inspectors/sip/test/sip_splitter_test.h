@@ -27,6 +27,8 @@
 //stubs to avoid link errors
 const snort::StreamBuffer snort::StreamSplitter::reassemble(snort::Flow*, unsigned int, unsigned int,
     unsigned char const*, unsigned int, unsigned int, unsigned int &) { return {}; }
+const snort::StreamBuffer snort::StreamSplitter::reassemble_segments(snort::Flow*, unsigned int,
+    snort::StreamSegment const*, unsigned int, unsigned int, unsigned int &) { return {}; }
 unsigned snort::StreamSplitter::max(snort::Flow *) { return 0; }
 
 const uint8_t line_feed = '\n';
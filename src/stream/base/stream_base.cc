@@ -67,6 +67,7 @@ const PegInfo base_pegs[] =
     { CountType::SUM, "expected_realized", "number of expected flows realized" },
     { CountType::SUM, "expected_pruned", "number of expected flows pruned" },
     { CountType::SUM, "expected_overflows", "number of expected cache overflows" },
+    { CountType::SUM, "expected_timeouts", "number of expected flows timed out" },
     { CountType::SUM, "reload_tuning_idle", "number of times stream resource tuner called while idle" },
     { CountType::SUM, "reload_tuning_packets", "number of times stream resource tuner called while processing packets" },
     { CountType::SUM, "reload_total_adds", "number of flows added by config reloads" },
@@ -104,6 +105,7 @@ void base_prep()
         stream_base_stats.expected_realized = exp_cache->get_realized();
         stream_base_stats.expected_pruned = exp_cache->get_prunes();
         stream_base_stats.expected_overflows = exp_cache->get_overflows();
+        stream_base_stats.expected_timeouts = exp_cache->get_timeouts();
     }
 }
 
@@ -91,6 +91,9 @@ static const Parameter s_params[] =
     { "pruning_timeout", Parameter::PT_INT, "1:max32", "30",
       "minimum inactive time before being eligible for pruning" },
 
+    { "flow_table", Parameter::PT_ENUM, "zhash | swiss", "zhash",
+      "flow cache index implementation" },
+
     { "held_packet_timeout", Parameter::PT_INT, "1:max32", "1000",
       "timeout in milliseconds for held packets" },
 
@@ -186,6 +189,11 @@ bool StreamModule::set(const char* fqn, Value& v, SnortConfig* c)
         config.flow_cache_cfg.pruning_timeout = v.get_uint32();
         return true;
     }
+    else if ( v.is("flow_table") )
+    {
+        config.flow_cache_cfg.table_type = (FlowTableType)v.get_uint8();
+        return true;
+    }
     else if ( v.is("held_packet_timeout") )
     {
         config.held_packet_timeout = v.get_uint32();
@@ -217,7 +225,16 @@ bool StreamModule::set(const char* fqn, Value& v, SnortConfig* c)
 
 bool StreamModule::end(const char* fqn, int, SnortConfig* sc)
 {
-    if ( Snort::is_reloading() && strcmp(fqn, MOD_NAME) == 0 )
+    if ( strcmp(fqn, MOD_NAME) )
+        return true;
+
+    if ( !Snort::is_reloading() )
+        table_type = config.flow_cache_cfg.table_type;
+
+    else if ( config.flow_cache_cfg.table_type != table_type )
+        ReloadError("Changing stream.flow_table requires a restart.\n");
+
+    if ( Snort::is_reloading() )
     {
         StreamReloadResourceManager* reload_resource_manager = new StreamReloadResourceManager;
         if (reload_resource_manager->initialize(config))
@@ -349,6 +366,8 @@ void StreamModuleConfig::show() const
     ConfigLogger::log_value("max_flows", flow_cache_cfg.max_flows);
     ConfigLogger::log_value("max_aux_ip", SnortConfig::get_conf()->max_aux_ip);
     ConfigLogger::log_value("pruning_timeout", flow_cache_cfg.pruning_timeout);
+    ConfigLogger::log_value("flow_table",
+        flow_cache_cfg.table_type == FlowTableType::SWISS ? "swiss" : "zhash");
 
     for (int i = to_utype(PktType::IP); i < to_utype(PktType::PDU); ++i)
     {
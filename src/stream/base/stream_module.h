@@ -66,6 +66,7 @@ struct BaseStats
      PegCount expected_realized;
      PegCount expected_pruned;
      PegCount expected_overflows;
+     PegCount expected_timeouts;
      PegCount reload_tuning_idle;
      PegCount reload_tuning_packets;
      PegCount reload_total_adds;
@@ -169,6 +170,7 @@ public:
 
 private:
     StreamModuleConfig config;
+    FlowTableType table_type = FlowTableType::ZHASH;  // as started
 };
 
 extern void base_prep();
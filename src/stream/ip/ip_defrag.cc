@@ -100,6 +100,7 @@ using namespace snort;
 #define FRAG_BAD            0x00000008
 #define FRAG_NO_BSD_VULN    0x00000010
 #define FRAG_DROP_FRAGMENTS 0x00000020
+#define FRAG_TIMED_OUT      0x00000040
 
 /* return values for insert() */
 #define FRAG_INSERT_OK          0
@@ -266,6 +267,12 @@ static inline bool frag_timed_out(
     return false;
 }
 
+// first whole second at which frag_timed_out() is true
+static inline uint64_t frag_deadline(const FragTracker* ft)
+{
+    return ft->frag_time.tv_sec + ft->engine->frag_timeout + (ft->frag_time.tv_usec ? 1 : 0);
+}
+
 /**
  * Check to see if we've got the first or last fragment on a FragTracker and
  * set the appropriate frag_flags
@@ -817,12 +824,53 @@ static void delete_tracker(FragTracker* ft)
 
 static void release_tracker(FragTracker* ft)
 {
+    if ( ft->timer.is_scheduled() )
+        TimerWheel::get_thread_wheel()->cancel(&ft->timer);
+
     delete_tracker(ft);
     ft->engine = nullptr;
 
     ip_stats.trackers_released++;
 }
 
+// frees the fragments of an abandoned datagram without waiting for
+// another fragment on the flow; the tracker is left for expired() to reset
+class FragTimeout : public TimerWheel::Handler
+{
+public:
+    bool expire(TimerWheel::Timer* t, uint64_t now) override
+    {
+        FragTracker* ft = (FragTracker*)t->user;
+        uint64_t deadline = frag_deadline(ft);
+
+        if ( deadline > now )
+        {
+            TimerWheel::get_thread_wheel()->schedule(t, deadline);
+            return false;
+        }
+
+        if ( !ft->fraglist )
+            return false;
+
+        delete_tracker(ft);
+        ft->frag_flags |= FRAG_TIMED_OUT;
+        ip_stats.frag_timeouts++;
+        return true;
+    }
+};
+
+static FragTimeout frag_timeout_handler;
+
+static void schedule_tracker(FragTracker* ft)
+{
+    if ( ft->timer.is_scheduled() )
+        return;
+
+    ft->timer.handler = &frag_timeout_handler;
+    ft->timer.user = ft;
+    TimerWheel::get_thread_wheel()->schedule(&ft->timer, frag_deadline(ft));
+}
+
 //-------------------------------------------------------------------------
 // Defrag methods
 //-------------------------------------------------------------------------
@@ -917,7 +965,8 @@ void Defrag::process(Packet* p, FragTracker* ft)
 
     if (!ft->engine )
     {
-        new_tracker(p, ft);
+        if ( new_tracker(p, ft) )
+            schedule_tracker(ft);
         return;
     }
     else if (expired(p, ft, fe) )
@@ -937,6 +986,7 @@ void Defrag::process(Packet* p, FragTracker* ft)
     // Update frag time when we get a frag associated with this tracker
     ft->frag_time.tv_sec = p->pkth->ts.tv_sec;
     ft->frag_time.tv_usec = p->pkth->ts.tv_usec;
+    schedule_tracker(ft);
 
     //don't forward fragments to engine if some previous fragment was dropped
     if ( ft->frag_flags & FRAG_DROP_FRAGMENTS )
@@ -1759,7 +1809,8 @@ int Defrag::new_tracker(Packet* p, FragTracker* ft)
         return 0;
     }
 
-    memset(ft, 0, sizeof(*ft));
+    assert(!ft->timer.is_scheduled());
+    *ft = FragTracker();
 
     if ( p->is_ip4() )
     {
@@ -2003,6 +2054,13 @@ int Defrag::dup_frag_node( FragTracker* ft, Fragment* left, Fragment** retFrag)
  */
 inline int Defrag::expired(Packet* p, FragTracker* ft, FragEngine* fe)
 {
+    // already cleared and counted by the timer
+    if ( ft->frag_flags & FRAG_TIMED_OUT )
+    {
+        ft->frag_flags &= ~FRAG_TIMED_OUT;
+        return true;
+    }
+
     /*
      * Check the FragTracker that was passed in first
      */
@@ -133,7 +133,10 @@ IpSession::IpSession(Flow* f) : Session(f)
 { }
 
 IpSession::~IpSession()
-{ }
+{
+    if ( tracker.timer.is_scheduled() )
+        TimerWheel::get_thread_wheel()->cancel(&tracker.timer);
+}
 
 void IpSession::clear()
 {
@@ -151,7 +154,11 @@ void IpSession::clear()
 bool IpSession::setup(Packet* p)
 {
     SESSION_STATS_ADD(ip_stats)
-    memset(&tracker, 0, sizeof(tracker));
+
+    if ( tracker.timer.is_scheduled() )
+        TimerWheel::get_thread_wheel()->cancel(&tracker.timer);
+
+    tracker = FragTracker();
 
     StreamIpConfig* pc = get_ip_cfg(flow->ssn_server);
     flow->set_default_session_timeout(pc->session_timeout, false);
@@ -21,6 +21,7 @@
 #define IP_SESSION_H
 
 #include "stream/ip/ip_module.h"
+#include "time/timer_wheel.h"
 
 struct Fragment;
 struct FragEngine;
@@ -70,6 +71,8 @@ struct FragTracker
 
     // Count of IP fragment overlap for each packet id.
     uint32_t overlap_count;
+
+    TimerWheel::Timer timer;  /* frees the fraglist after frag_timeout */
 };
 
 class IpSession : public Session
@@ -41,8 +41,10 @@
 #include "stream/base/stream_module.h"
 #include "target_based/host_attributes.h"
 #include "target_based/snort_protocols.h"
+#include "time/timer_wheel.h"
 #include "utils/util.h"
 
+#include "tcp/tcp_segment_node.h"
 #include "tcp/tcp_session.h"
 #include "tcp/tcp_stream_session.h"
 #include "tcp/tcp_stream_tracker.h"
@@ -50,6 +52,8 @@
 using namespace snort;
 
 #define IDLE_PRUNE_MAX 400
+#define IDLE_VISIT_MAX 4000
+#define PKT_VISIT_MAX 16
 
 // this should not be publicly accessible
 extern THREAD_LOCAL class FlowControl* flow_con;
@@ -73,6 +77,21 @@ static std::mutex stream_xtra_mutex;
 Flow* Stream::get_flow(const FlowKey* key)
 { return flow_con->find_flow(key); }
 
+bool Stream::prefetch_flow(const FlowKey* key, unsigned& hash)
+{
+    if ( !flow_con )
+        return false;
+
+    hash = flow_con->prefetch_flow(key);
+    return true;
+}
+
+void Stream::prefetch_flow_node(unsigned hash)
+{ flow_con->prefetch_flow_node(hash); }
+
+Flow* Stream::peek_flow(const FlowKey* key, unsigned hash)
+{ return flow_con->peek_flow(key, hash); }
+
 Flow* Stream::new_flow(const FlowKey* key)
 { return flow_con->new_flow(key); }
 
@@ -367,13 +386,16 @@ void Stream::handle_timeouts(bool idle)
     timeval cur_time;
     packet_gettimeofday(&cur_time);
 
-    // FIXIT-M batch here or loop vs looping over idle?
+    // flows, expected flows, and defrag trackers share the thread wheel
     if (flow_con)
     {
+        TimerWheel* wheel = TimerWheel::get_thread_wheel();
+
+        // flows are rescheduled lazily so the visits are bounded too
         if (idle)
-            flow_con->timeout_flows(IDLE_PRUNE_MAX, cur_time.tv_sec);
+            wheel->run(cur_time.tv_sec, IDLE_PRUNE_MAX, IDLE_VISIT_MAX);
         else
-            flow_con->timeout_flows(1, cur_time.tv_sec);
+            wheel->run(cur_time.tv_sec, 1, PKT_VISIT_MAX);
     }
 
     int max_remove = idle ? -1 : 1;       // -1 = all eligible
@@ -385,6 +407,10 @@ bool Stream::prune_flows()
     if ( !flow_con )
         return false;
 
+    // idle segment memory goes before any flows
+    if ( TcpSegmentNode::reap() )
+        return true;
+
     return flow_con->prune_one(PruneReason::MEMCAP, false);
 }
 
@@ -84,6 +84,14 @@ public:
     // pointer to flow session object if found, otherwise null.
     static Flow* get_flow(const FlowKey*);
 
+    // Batch lookups prefetch the bucket for each key up front, returning
+    // false if there is no flow cache, then prefetch the flow nodes, and
+    // finally peek at the flows so they can be prefetched before the
+    // packets are processed.  Peeking does not change flow LRU order.
+    static bool prefetch_flow(const FlowKey*, unsigned& hash);
+    static void prefetch_flow_node(unsigned hash);
+    static Flow* peek_flow(const FlowKey*, unsigned hash);
+
     // Allocates a flow session object from the flow cache table for the protocol
     // type of the specified key.  If no cache exists for that protocol type null is
     // returned.  If a flow already exists for the key a pointer to that session
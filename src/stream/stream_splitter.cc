@@ -72,6 +72,22 @@ const StreamBuffer StreamSplitter::reassemble(
     return { nullptr, 0 };
 }
 
+const StreamBuffer StreamSplitter::reassemble_segments(
+    Flow*, unsigned total, const StreamSegment* segs, unsigned count,
+    uint32_t flags, unsigned& consumed)
+{
+    consumed = 0;
+
+    if ( count != 1 or segs[0].length != total or total > Packet::max_dsize )
+        return { nullptr, 0 };
+
+    if ( (flags & PKT_PDU_FULL) != PKT_PDU_FULL )
+        return { nullptr, 0 };
+
+    consumed = total;
+    return { segs[0].data, total };
+}
+
 //--------------------------------------------------------------------------
 // atom splitter
 //--------------------------------------------------------------------------
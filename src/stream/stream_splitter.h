@@ -33,6 +33,13 @@ struct StreamBuffer
     unsigned length;
 };
 
+// one in order piece of a scatter-gather flush
+struct StreamSegment
+{
+    const uint8_t* data;
+    unsigned length;
+};
+
 //-------------------------------------------------------------------------
 
 class SO_PUBLIC StreamSplitter
@@ -80,6 +87,23 @@ public:
         unsigned& copied       // actual data copied (1 <= copied <= len)
         );
 
+    // optional scatter-gather alternative to reassemble() used when
+    // stream_tcp.scatter_gather is set.  return the PDU without copying
+    // and set consumed to total, or return a null buffer to decline and
+    // have the data copied with reassemble() as usual.  the default only
+    // takes a PDU contained in one segment and declines if count > 1; the
+    // tcp reassembler only offers such PDUs until a splitter can use more.
+    // splitters that override
+    // reassemble() to transform the data must override this to decline.
+    virtual const StreamBuffer reassemble_segments(
+        Flow*,
+        unsigned total,              // total amount to flush
+        const StreamSegment* segs,   // in order data covering total
+        unsigned count,              // number of segments
+        uint32_t flags,              // packet flags indicating pdu head and/or tail
+        unsigned& consumed           // 0 or total
+        );
+
     virtual bool is_paf() { return false; }
     virtual unsigned max(Flow* = nullptr);
     virtual void go_away() { delete this; }
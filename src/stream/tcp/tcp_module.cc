@@ -115,6 +115,11 @@ const PegInfo tcp_pegs[] =
     { CountType::MAX, "max_segs", "maximum number of segments queued in any flow" },
     { CountType::MAX, "max_bytes", "maximum number of bytes queued in any flow" },
     { CountType::SUM, "zero_len_tcp_opt", "number of zero length tcp options" },
+    { CountType::SUM, "slab_hits", "segments stored in a recycled slab node" },
+    { CountType::SUM, "slab_misses", "segments stored in a node allocated from the heap" },
+    { CountType::NOW, "slab_bytes_held", "segment memory held idle in slab free lists" },
+    { CountType::SUM, "in_place_flushes", "PDUs inspected in place in the queued segments" },
+    { CountType::SUM, "copy_bytes_avoided", "reassembled bytes that did not have to be copied" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -209,6 +214,10 @@ static const Parameter s_params[] =
     { "require_3whs", Parameter::PT_INT, "-1:max31", "-1",
       "don't track midstream sessions after given seconds from start up; -1 tracks all" },
 
+    { "scatter_gather", Parameter::PT_BOOL, nullptr, "false",
+      "inspect a PDU in place when it lies within one queued segment and the splitter allows; "
+      "PDUs spanning segments and http, http2, and dce proxy PDUs are still copied" },
+
     { "show_rebuilt_packets", Parameter::PT_BOOL, nullptr, "false",
       "enable cmg like output of reassembled packets" },
 
@@ -345,6 +354,13 @@ bool StreamTcpModule::set(const char*, Value& v, SnortConfig*)
     {
         config->hs_timeout = v.get_int32();
     }
+    else if ( v.is("scatter_gather") )
+    {
+        if ( v.get_bool() )
+            config->flags |= STREAM_CONFIG_SCATTER_GATHER;
+        else
+            config->flags &= ~STREAM_CONFIG_SCATTER_GATHER;
+    }
     else if ( v.is("show_rebuilt_packets") )
     {
         if ( v.get_bool() )
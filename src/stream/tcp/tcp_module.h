@@ -113,6 +113,11 @@ struct TcpStats
     PegCount max_segs;
     PegCount max_bytes;
     PegCount zero_len_tcp_opt;
+    PegCount slab_hits;
+    PegCount slab_misses;
+    PegCount slab_bytes_held;
+    PegCount in_place_flushes;
+    PegCount copy_bytes_avoided;
 };
 
 extern THREAD_LOCAL struct TcpStats tcpStats;
@@ -28,6 +28,7 @@
 #include "detection/detection_engine.h"
 #include "log/log.h"
 #include "main/analyzer.h"
+#include "main/snort_config.h"
 #include "memory/memory_cap.h"
 #include "packet_io/active.h"
 #include "profiler/profiler.h"
@@ -415,8 +416,72 @@ void TcpReassembler::show_rebuilt_packet(const TcpReassemblerState& trs, Packet*
     }
 }
 
+bool TcpReassembler::is_flush_gap(TcpReassemblerState& trs, TcpSegmentNode& tsn, uint32_t to_seq)
+{
+    /* Check for a gap/missing packet */
+    // FIXIT-L FIN may be in to_seq causing bogus gap counts.
+    if ( tsn.is_packet_missing(to_seq) or trs.paf_state.paf == StreamSplitter::SKIP )
+    {
+        // FIXIT-H // assert(false); find when this scenario happens
+        // FIXIT-L this is suboptimal - better to exclude fin from to_seq
+        if ( !trs.tracker->is_fin_seq_set() or
+            SEQ_LEQ(to_seq, trs.tracker->get_fin_final_seq()) )
+        {
+            trs.tracker->set_tf_flags(TF_MISSING_PKT);
+        }
+        return true;
+    }
+    return false;
+}
+
+// offer a PDU contained in the current segment to the splitter as it is;
+// returns the bytes flushed or 0 if the data must be copied
+int TcpReassembler::flush_in_place(TcpReassemblerState& trs, uint32_t flush_len, Packet* pdu)
+{
+    // offloaded and batched searches can outlive the segments
+    const SnortConfig* sc = SnortConfig::get_conf();
+
+    if ( sc->offload_threads or sc->mpse_batch_size )
+        return 0;
+
+    // no splitter takes more than one segment so don't gather any
+    TcpSegmentNode* tsn = trs.sos.seglist.cur_rseg;
+
+    if ( tsn->c_len < flush_len )
+        return 0;
+
+    const StreamSegment seg = { tsn->payload(), flush_len };
+    uint32_t to_seq = tsn->c_seq + flush_len;
+
+    unsigned consumed = 0;
+    const StreamBuffer sb = trs.tracker->get_splitter()->reassemble_segments(
+        trs.sos.session->flow, flush_len, &seg, 1, PKT_PDU_FULL, consumed);
+
+    if ( !sb.data )
+        return 0;
+
+    assert(consumed == flush_len);
+    pdu->data = sb.data;
+    pdu->dsize = sb.length;
+
+    // advance past the flushed data just like the copy loop
+    update_skipped_bytes(flush_len, trs);
+    is_flush_gap(trs, *tsn, to_seq);
+
+    tcpStats.in_place_flushes++;
+    tcpStats.copy_bytes_avoided += flush_len;
+
+    return flush_len;
+}
+
 int TcpReassembler::flush_data_segments(TcpReassemblerState& trs, uint32_t flush_len, Packet* pdu)
 {
+    if ( trs.sos.session->tcp_config->flags & STREAM_CONFIG_SCATTER_GATHER )
+    {
+        if ( int flushed = flush_in_place(trs, flush_len, pdu) )
+            return flushed;
+    }
+
     uint32_t flags = PKT_PDU_HEAD;
     uint32_t to_seq = trs.sos.seglist.cur_rseg->c_seq + flush_len;
     uint32_t remaining_bytes = flush_len;
@@ -454,19 +519,8 @@ int TcpReassembler::flush_data_segments(TcpReassemblerState& trs, uint32_t flush
             update_next(trs, *tsn);
         }
 
-        /* Check for a gap/missing packet */
-        // FIXIT-L FIN may be in to_seq causing bogus gap counts.
-        if ( tsn->is_packet_missing(to_seq) or trs.paf_state.paf == StreamSplitter::SKIP )
-        {
-            // FIXIT-H // assert(false); find when this scenario happens
-            // FIXIT-L this is suboptimal - better to exclude fin from to_seq
-            if ( !trs.tracker->is_fin_seq_set() or
-                SEQ_LEQ(to_seq, trs.tracker->get_fin_final_seq()) )
-            {
-                trs.tracker->set_tf_flags(TF_MISSING_PKT);
-            }
+        if ( is_flush_gap(trs, *tsn, to_seq) )
             break;
-        }
 
         if ( sb.data || !trs.sos.seglist.cur_rseg )
             break;
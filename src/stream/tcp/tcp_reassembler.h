@@ -75,6 +75,8 @@ protected:
     void flush_queued_segments(
         TcpReassemblerState&, snort::Flow* flow, bool clear, snort::Packet*);
     int flush_data_segments(TcpReassemblerState&, uint32_t flush_len, snort::Packet* pdu);
+    int flush_in_place(TcpReassemblerState&, uint32_t flush_len, snort::Packet* pdu);
+    bool is_flush_gap(TcpReassemblerState&, TcpSegmentNode&, uint32_t to_seq);
     void prep_pdu(
         TcpReassemblerState&, snort::Flow*, snort::Packet*, uint32_t pkt_flags, snort::Packet*);
     snort::Packet* initialize_pdu(
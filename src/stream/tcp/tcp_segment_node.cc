@@ -32,36 +32,78 @@
 #include "segment_overlap_editor.h"
 #include "tcp_module.h"
 
-#define USE_RESERVE
-#ifdef USE_RESERVE
-static THREAD_LOCAL TcpSegmentNode* reserved = nullptr;
-static THREAD_LOCAL unsigned reserve_sz = 0;
-
-static constexpr unsigned num_res = 4096;
-static constexpr unsigned res_min = 1024;
-static constexpr unsigned res_max = 1460;
-#endif
+//-------------------------------------------------------------------------
+// segment slabs
+//
+// nodes are allocated with room for the smallest class that fits the
+// payload, which is at most about twice the payload above 128 bytes, and
+// are recycled through per-thread free lists so steady state reassembly
+// doesn't go to the heap.  all node memory comes from snort_alloc
+// so MemoryCap sees it, and idle nodes are released before any flows are
+// pruned when the thread is over its cap.
+//-------------------------------------------------------------------------
 
-void TcpSegmentNode::setup()
+struct SegSlab
 {
-#ifdef USE_RESERVE
-    reserved = nullptr;
-    reserve_sz = 0;
-#endif
+    TcpSegmentNode* free;
+    unsigned count;
+};
+
+static constexpr uint16_t slab_size[] = { 128, 576, 1500, 2048, 4096, 9000 };
+static constexpr unsigned slab_max[] = { 8192, 4096, 4096, 1024, 1024, 512 };  // idle nodes kept
+static constexpr unsigned num_slabs = sizeof(slab_size) / sizeof(slab_size[0]);
+
+static THREAD_LOCAL SegSlab slabs[num_slabs];
+
+static inline unsigned get_slab(uint16_t len)
+{
+    for ( unsigned i = 0; i < num_slabs; ++i )
+    {
+        if ( len <= slab_size[i] )
+            return i;
+    }
+    return num_slabs;
 }
 
-void TcpSegmentNode::clear()
+static unsigned release_slab(SegSlab& slab)
 {
-#ifdef USE_RESERVE
-    while ( reserved )
+    unsigned n = slab.count;
+
+    while ( slab.free )
     {
-        TcpSegmentNode* tsn = reserved;
-        reserved = reserved->next;
+        TcpSegmentNode* tsn = slab.free;
+        slab.free = tsn->next;
         tcpStats.mem_in_use -= tsn->size;
+        tcpStats.slab_bytes_held -= tsn->size;
         snort_free(tsn);
     }
-    reserve_sz = 0;
-#endif
+    slab.count = 0;
+    return n;
+}
+
+void TcpSegmentNode::setup()
+{
+    for ( auto& slab : slabs )
+    {
+        slab.free = nullptr;
+        slab.count = 0;
+    }
+}
+
+void TcpSegmentNode::clear()
+{
+    for ( auto& slab : slabs )
+        release_slab(slab);
+}
+
+bool TcpSegmentNode::reap()
+{
+    unsigned n = 0;
+
+    for ( auto& slab : slabs )
+        n += release_slab(slab);
+
+    return n > 0;
 }
 
 //-------------------------------------------------------------------------
@@ -72,21 +114,25 @@ TcpSegmentNode* TcpSegmentNode::create(
     const struct timeval& tv, const uint8_t* payload, uint16_t len)
 {
     TcpSegmentNode* tsn;
+    unsigned i = get_slab(len);
 
-#ifdef USE_RESERVE
-    if ( reserved and len > res_min and len <= res_max )
+    if ( i < num_slabs and slabs[i].free )
     {
-        tsn = reserved;
-        reserved = tsn->next;
-        --reserve_sz;
+        SegSlab& slab = slabs[i];
+        tsn = slab.free;
+        slab.free = tsn->next;
+        --slab.count;
+        tcpStats.slab_bytes_held -= tsn->size;
+        tcpStats.slab_hits++;
     }
     else
-#endif
     {
-        size_t size = sizeof(*tsn) + len;
+        uint16_t cap = ( i < num_slabs ) ? slab_size[i] : len;
+        size_t size = sizeof(*tsn) + cap;
         tsn = (TcpSegmentNode*)snort_alloc(size);
-        tsn->size = len;
-        tcpStats.mem_in_use += len;
+        tsn->size = cap;
+        tcpStats.mem_in_use += cap;
+        tcpStats.slab_misses++;
     }
     tsn->tv = tv;
     tsn->i_len = tsn->c_len = len;
@@ -112,15 +158,18 @@ TcpSegmentNode* TcpSegmentNode::init(TcpSegmentNode& tns)
 
 void TcpSegmentNode::term()
 {
-#ifdef USE_RESERVE
-    if ( size == res_max and reserve_sz < num_res )
+    // only slab sized nodes map back to a slab
+    unsigned i = get_slab(size);
+
+    if ( i < num_slabs and slabs[i].count < slab_max[i] )
     {
-        next = reserved;
-        reserved = this;
-        reserve_sz++;
+        SegSlab& slab = slabs[i];
+        next = slab.free;
+        slab.free = this;
+        slab.count++;
+        tcpStats.slab_bytes_held += size;
     }
     else
-#endif
     {
         tcpStats.mem_in_use -= size;
         snort_free(this);
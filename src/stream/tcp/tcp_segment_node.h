@@ -47,6 +47,7 @@ public:
 
     static void setup();
     static void clear();
+    static bool reap();  // release idle slab nodes; true if any
 
     bool is_retransmit(const uint8_t*, uint16_t size, uint32_t, uint16_t, bool*);
 
@@ -79,7 +80,7 @@ public:
     uint16_t i_len;             // initial length of the data segment
     uint16_t c_len;             // length of data remaining for reassembly
     uint16_t offset;
-    uint16_t size;              // actual allocated size (overlaps cause i_len to differ)
+    uint16_t size;              // allocated data size (slab class or i_len if larger)
     uint8_t data[1];
 };
 
@@ -54,6 +54,7 @@ void TcpStreamConfig::show() const
 
     ConfigLogger::log_flag("reassemble_async", !(flags & STREAM_CONFIG_NO_ASYNC_REASSEMBLY));
     ConfigLogger::log_limit("require_3whs", hs_timeout, -1, hs_timeout < 0 ? hs_timeout : -1);
+    ConfigLogger::log_flag("scatter_gather", (flags & STREAM_CONFIG_SCATTER_GATHER));
     ConfigLogger::log_value("session_timeout", session_timeout);
 
     str = "{ count = ";
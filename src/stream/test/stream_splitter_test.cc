@@ -153,6 +153,30 @@ TEST(other_splitter, stop_and_wait)
     CHECK(flushed == 2);
 }
 
+TEST(other_splitter, reassemble_segments)
+{
+    LogSplitter s(true);
+    const uint8_t data[8] = { };
+    unsigned consumed = 1;
+
+    // one segment with the whole pdu - in place
+    StreamSegment segs[2] = { { data, 5 }, { data + 5, 3 } };
+    StreamBuffer sb = s.reassemble_segments(nullptr, 5, segs, 1, PKT_PDU_FULL, consumed);
+    CHECK(sb.data == data);
+    CHECK(sb.length == 5);
+    CHECK(consumed == 5);
+
+    // split pdu - decline
+    sb = s.reassemble_segments(nullptr, 8, segs, 2, PKT_PDU_FULL, consumed);
+    CHECK(sb.data == nullptr);
+    CHECK(consumed == 0);
+
+    // partial pdu - decline
+    sb = s.reassemble_segments(nullptr, 5, segs, 1, PKT_PDU_HEAD, consumed);
+    CHECK(sb.data == nullptr);
+    CHECK(consumed == 0);
+}
+
 //-------------------------------------------------------------------------
 // main
 //-------------------------------------------------------------------------
@@ -0,0 +1,373 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// timer_wheel.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "timer_wheel.h"
+
+#include <cassert>
+
+#include "main/thread.h"
+
+#ifdef CATCH_TEST_BUILD
+#include <random>
+#include <vector>
+
+#include "catch/catch.hpp"
+#endif
+
+// level L holds timers whose deadline differs from the current time only
+// in the low (L + 1) * bits bits; each level is cascaded into the ones
+// below when the current time reaches the start of its slot.
+
+static const unsigned OVERFLOW_LEVEL = 4;
+static const unsigned EXPIRED_LEVEL = 5;
+
+static THREAD_LOCAL TimerWheel* s_wheel = nullptr;
+
+TimerWheel* TimerWheel::get_thread_wheel()
+{
+    if ( !s_wheel )
+        s_wheel = new TimerWheel;
+
+    return s_wheel;
+}
+
+void TimerWheel::thread_term()
+{
+    delete s_wheel;
+    s_wheel = nullptr;
+}
+
+TimerWheel::TimerWheel(uint64_t now) : current(now)
+{ static_assert(OVERFLOW_LEVEL == levels, "overflow must follow the wheel"); }
+
+void TimerWheel::link(Slot& s, Timer* t)
+{
+    t->prev = s.head.prev;
+    t->next = &s.head;
+    s.head.prev->next = t;
+    s.head.prev = t;
+}
+
+void TimerWheel::unlink(Timer* t)
+{
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+    t->prev = t->next = nullptr;
+}
+
+void TimerWheel::place(Timer* t)
+{
+    if ( t->deadline <= current )
+    {
+        t->level = EXPIRED_LEVEL;
+        link(expired, t);
+    }
+    else
+    {
+        unsigned lvl = 0;
+
+        while ( lvl < levels and (t->deadline >> (bits * (lvl + 1))) !=
+            (current >> (bits * (lvl + 1))) )
+            ++lvl;
+
+        t->level = lvl;
+
+        if ( lvl < levels )
+            link(wheel[lvl][(t->deadline >> (bits * lvl)) & mask], t);
+        else
+            link(overflow, t);
+    }
+    ++level_count[t->level];
+}
+
+void TimerWheel::schedule(Timer* t, uint64_t deadline)
+{
+    if ( t->is_scheduled() )
+        cancel(t);
+
+    t->deadline = deadline;
+    place(t);
+    ++count;
+}
+
+void TimerWheel::cancel(Timer* t)
+{
+    assert(t->is_scheduled());
+    --level_count[t->level];
+    unlink(t);
+    --count;
+}
+
+void TimerWheel::cascade(Slot& s)
+{
+    // detach first since overflow timers may go right back
+    Timer* t = s.head.next;
+    s.head.prev->next = nullptr;
+    s.head.prev = s.head.next = &s.head;
+
+    while ( t and t != &s.head )
+    {
+        Timer* next = t->next;
+        --level_count[t->level];
+        place(t);
+        t = next;
+    }
+}
+
+void TimerWheel::tick()
+{
+    ++current;
+
+    // find the highest level whose slot starts now and cascade down
+    unsigned top = 0;
+
+    while ( top + 1 < levels and !(current & ((1ULL << (bits * (top + 1))) - 1)) )
+        ++top;
+
+    if ( top + 1 == levels and !(current & ((1ULL << (bits * levels)) - 1)) )
+        cascade(overflow);
+
+    for ( unsigned lvl = top; lvl > 0; --lvl )
+        cascade(wheel[lvl][(current >> (bits * lvl)) & mask]);
+
+    cascade(wheel[0][current & mask]);
+}
+
+TimerWheel::Timer* TimerWheel::expire(uint64_t now)
+{
+    while ( current < now and expired.head.next == &expired.head )
+    {
+        if ( count == level_count[EXPIRED_LEVEL] )
+        {
+            // nothing pending so just catch up
+            current = now;
+            break;
+        }
+
+        // when the lowest levels are empty nothing can expire before the
+        // next cascade from above so skip straight to it
+        unsigned empty = 0;
+
+        while ( empty < levels and !level_count[empty] )
+            ++empty;
+
+        if ( empty == levels )
+        {
+            // only far timers are left so jump to the first of them
+            uint64_t next = now;
+
+            for ( Timer* t = overflow.head.next; t != &overflow.head; t = t->next )
+            {
+                if ( t->deadline < next )
+                    next = t->deadline;
+            }
+            current = next;
+            cascade(overflow);
+            continue;
+        }
+
+        if ( empty )
+        {
+            uint64_t end = current | ((1ULL << (bits * empty)) - 1);
+
+            if ( current < end )
+            {
+                current = (end < now) ? end : now;
+                continue;
+            }
+        }
+        tick();
+    }
+
+    if ( expired.head.next == &expired.head )
+        return nullptr;
+
+    Timer* t = expired.head.next;
+    cancel(t);
+    return t;
+}
+
+unsigned TimerWheel::run(uint64_t now, unsigned max, unsigned max_visits)
+{
+    unsigned n = 0;
+
+    for ( unsigned v = 0; n < max and v < max_visits; ++v )
+    {
+        Timer* t = expire(now);
+
+        if ( !t )
+            break;
+
+        assert(t->handler);
+
+        // rescheduled timers are due after now so each is seen at most once
+        if ( t->handler->expire(t, now) )
+            ++n;
+    }
+    return n;
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef CATCH_TEST_BUILD
+
+TEST_CASE("timer wheel basic", "[timer_wheel]")
+{
+    TimerWheel tw(100);
+    TimerWheel::Timer a, b, c;
+
+    tw.schedule(&a, 105);
+    tw.schedule(&b, 100 + 5000);
+    tw.schedule(&c, 99);
+    CHECK(tw.get_count() == 3);
+
+    CHECK(tw.expire(100) == &c);
+    CHECK(!c.is_scheduled());
+    CHECK(tw.expire(104) == nullptr);
+    CHECK(tw.expire(105) == &a);
+    CHECK(tw.expire(5099) == nullptr);
+    CHECK(tw.expire(6000) == &b);
+    CHECK(tw.get_count() == 0);
+}
+
+TEST_CASE("timer wheel reschedule and cancel", "[timer_wheel]")
+{
+    TimerWheel tw;
+    TimerWheel::Timer a, b;
+
+    tw.schedule(&a, 10);
+    tw.schedule(&b, 20);
+    tw.schedule(&a, 30);
+    tw.cancel(&b);
+    CHECK(tw.get_count() == 1);
+
+    CHECK(tw.expire(25) == nullptr);
+    CHECK(tw.expire(30) == &a);
+}
+
+TEST_CASE("timer wheel far start", "[timer_wheel]")
+{
+    // a wheel started at 0 must not crawl to the first deadline
+    TimerWheel tw;
+    TimerWheel::Timer a, b;
+
+    tw.schedule(&a, 1600000000);
+    tw.schedule(&b, 1600000000 + 300);
+
+    CHECK(tw.expire(1599999999) == nullptr);
+    CHECK(tw.get_time() == 1599999999);
+    CHECK(tw.expire(1600000000) == &a);
+    CHECK(tw.expire(1600000299) == nullptr);
+    CHECK(tw.expire(1600000300) == &b);
+}
+
+class TestHandler : public TimerWheel::Handler
+{
+public:
+    TestHandler(TimerWheel& tw) : wheel(tw) { }
+
+    bool expire(TimerWheel::Timer* t, uint64_t now) override
+    {
+        ++calls;
+
+        // reschedule once
+        if ( !t->user )
+        {
+            t->user = this;
+            wheel.schedule(t, now + 10);
+            return false;
+        }
+        return true;
+    }
+
+    TimerWheel& wheel;
+    unsigned calls = 0;
+};
+
+TEST_CASE("timer wheel run", "[timer_wheel]")
+{
+    TimerWheel tw;
+    TestHandler h(tw);
+    TimerWheel::Timer timers[5];
+
+    for ( auto& t : timers )
+    {
+        t.handler = &h;
+        tw.schedule(&t, 100);
+    }
+
+    // reschedules don't use up the expire budget but are visits
+    CHECK(tw.run(100, 3, 4) == 0);
+    CHECK(h.calls == 4);
+    CHECK(tw.run(100, 3, 4) == 0);
+    CHECK(h.calls == 5);
+    CHECK(tw.get_count() == 5);
+
+    CHECK(tw.run(110, 3, 10) == 3);
+    CHECK(tw.run(110, 3, 10) == 2);
+    CHECK(tw.run(110, 3, 10) == 0);
+    CHECK(tw.get_count() == 0);
+    CHECK(h.calls == 10);
+}
+
+TEST_CASE("timer wheel random", "[timer_wheel]")
+{
+    const unsigned num = 20000;
+    std::mt19937_64 rng(1);
+    std::vector<TimerWheel::Timer> timers(num);
+    TimerWheel tw(1000);
+
+    for ( auto& t : timers )
+    {
+        // cover every level and the overflow list
+        unsigned shift = rng() % 30;
+        tw.schedule(&t, 1000 + (rng() & ((1ULL << shift) - 1)));
+    }
+
+    uint64_t now = 1000;
+    unsigned seen = 0;
+
+    for ( unsigned i = 0; seen < num; ++i )
+    {
+        now += 1 + (rng() & ((1ULL << (rng() % 20)) - 1));
+
+        while ( TimerWheel::Timer* t = tw.expire(now) )
+        {
+            CHECK(t->deadline <= now);
+            ++seen;
+        }
+
+        // nothing due may be left behind
+        if ( !(i % 64) )
+        {
+            for ( auto& t : timers )
+                if ( t.is_scheduled() )
+                    CHECK(t.deadline > now);
+        }
+    }
+    CHECK(tw.get_count() == 0);
+}
+
+#endif
@@ -0,0 +1,127 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// timer_wheel.h
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+// TimerWheel is a hierarchical timing wheel.  Timers are intrusive so
+// scheduling, rescheduling, and canceling are O(1) and expiring is
+// O(expired) plus a bounded amount of cascading as time advances.  Time is
+// in arbitrary ticks; callers typically use packet time seconds.
+//
+// Each packet thread has a wheel shared by flows, expected flows, and
+// defrag trackers.  Those timers have handlers which are called from
+// Stream::handle_timeouts() via run() with a budget so the work done per
+// packet or idle callback is bounded.  Deadlines are rechecked lazily so a
+// handler may just reschedule; that is cheap and counts against a separate,
+// larger budget since all the active flows created in the same second come
+// due together.
+
+#include <cstdint>
+
+class TimerWheel
+{
+public:
+    struct Timer;
+
+    class Handler
+    {
+    public:
+        virtual ~Handler() = default;
+
+        // called with the timer unscheduled; may reschedule it after now.
+        // returns false if the timer was only rescheduled.
+        virtual bool expire(Timer*, uint64_t now) = 0;
+    };
+
+    struct Timer
+    {
+        Timer* prev = nullptr;
+        Timer* next = nullptr;
+        uint64_t deadline = 0;
+        Handler* handler = nullptr;
+        void* user = nullptr;
+        unsigned level = 0;
+
+        bool is_scheduled() const
+        { return next != nullptr; }
+    };
+
+    // timers are owned by the caller and are not touched on destruction
+    TimerWheel(uint64_t now = 0);
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // (re)schedule; deadlines at or before the current time expire on the
+    // next call to expire()
+    void schedule(Timer*, uint64_t deadline);
+    void cancel(Timer*);
+
+    // advance to now and return the next expired timer, if any; the timer
+    // is unscheduled before it is returned
+    Timer* expire(uint64_t now);
+
+    // call handlers until max timers have actually expired or max_visits
+    // handlers have been called; returns the number expired.  timers left
+    // due are handled by the next call.
+    unsigned run(uint64_t now, unsigned max, unsigned max_visits);
+
+    uint64_t get_time() const
+    { return current; }
+
+    unsigned get_count() const
+    { return count; }
+
+    // the packet thread wheel is created on first use
+    static TimerWheel* get_thread_wheel();
+    static void thread_term();
+
+private:
+    static const unsigned bits = 6;
+    static const unsigned slots = 1 << bits;
+    static const unsigned mask = slots - 1;
+    static const unsigned levels = 4;
+
+    struct Slot
+    {
+        Timer head;
+        Slot() { head.prev = head.next = &head; }
+    };
+
+    static void link(Slot&, Timer*);
+    static void unlink(Timer*);
+
+    void place(Timer*);
+    void cascade(Slot&);
+    void tick();
+
+private:
+    Slot wheel[levels][slots];
+    Slot overflow;
+    Slot expired;
+
+    // per level counts plus overflow and expired
+    unsigned level_count[levels + 2] = { };
+    uint64_t current;
+    unsigned count = 0;
+};
+
+#endif
+
@@ -56,8 +56,12 @@ public:
     size_t script_size()
     { return out.tellp(); }
 
+    // the scan buffer is taken from a per-thread pool only while normalizing
     static size_t size()
-    { return sizeof(JSNormalizer) + 16834; /* YY_BUF_SIZE */ }
+    { return sizeof(JSNormalizer); }
+
+    static void thread_term()
+    { JSTokenizer::thread_term(); }
 
     bool is_unescape_nesting_seen() const
     { return tokenizer.is_unescape_nesting_seen(); }
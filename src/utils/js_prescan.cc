@@ -0,0 +1,394 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// js_prescan.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "js_prescan.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <strings.h>
+
+// identifiers the normalizer handles specially or which evaluate or decode strings
+struct Trigger
+{
+    const char* name;
+    size_t len;
+};
+
+#define TRIGGER(s) { s, sizeof(s) - 1 }
+
+static const Trigger triggers[] =
+{
+    TRIGGER("atob"),
+    TRIGGER("decodeURI"),
+    TRIGGER("decodeURIComponent"),
+    TRIGGER("eval"),
+    TRIGGER("fromCharCode"),
+    TRIGGER("fromCodePoint"),
+    TRIGGER("unescape"),
+};
+
+static inline bool is_word(uint8_t c)
+{ return isalnum(c) or c == '_' or c == '$'; }
+
+// keywords after which a slash starts a regular expression, not a division
+static const Trigger expr_keywords[] =
+{
+    TRIGGER("await"),
+    TRIGGER("case"),
+    TRIGGER("delete"),
+    TRIGGER("do"),
+    TRIGGER("else"),
+    TRIGGER("in"),
+    TRIGGER("instanceof"),
+    TRIGGER("new"),
+    TRIGGER("of"),
+    TRIGGER("return"),
+    TRIGGER("throw"),
+    TRIGGER("typeof"),
+    TRIGGER("void"),
+    TRIGGER("yield"),
+};
+
+static bool is_expr_keyword(const char* word, size_t len)
+{
+    for ( const auto& k : expr_keywords )
+        if ( k.len == len and !memcmp(k.name, word, len) )
+            return true;
+
+    return false;
+}
+
+static bool is_trigger(const char* word, size_t len)
+{
+    // the shortest trigger has 4 characters, the longest one 18
+    if ( len < 4 or len > 18 )
+        return false;
+
+    for ( const auto& t : triggers )
+        if ( t.len == len and !memcmp(t.name, word, len) )
+            return true;
+
+    return false;
+}
+
+static inline bool match_nocase(const char* p, const char* const end, const char* s, size_t len)
+{ return (size_t)(end - p) >= len and !strncasecmp(p, s, len); }
+
+// true if a tag at p could make the normalizer leave the script or the comment
+static bool is_tag(const char* p, const char* const end)
+{
+    assert(*p == '<');
+
+    if ( end - p < 8 )
+        return true;
+
+    return p[1] == '!' or match_nocase(p + 1, end, "script", 6) or
+        match_nocase(p + 1, end, "/script", 7);
+}
+
+// escapes which stand for a single character the normalizer leaves as is; hex,
+// unicode and octal ones could spell anything and line continuations join lines
+static inline bool is_plain_escape(const char* p, const char* const end)
+{
+    if ( p == end )
+        return false;
+
+    if ( *p == '0' )
+        return p + 1 == end or !isdigit(p[1]);
+
+    return *p and strchr("nrtbfv'\"\\/", *p);
+}
+
+// returns a pointer to the closing quote, nullptr if the string is not plain
+// (words are checked too, since a string may name a property to call)
+static const char* skip_string(const char* p, const char* const end, char quote)
+{
+    while ( ++p < end )
+    {
+        if ( is_word(*p) )
+        {
+            const char* word = p;
+
+            while ( p + 1 < end and is_word(p[1]) )
+                ++p;
+
+            if ( is_trigger(word, p + 1 - word) )
+                return nullptr;
+
+            continue;
+        }
+
+        switch ( *p )
+        {
+        case '\\':
+            if ( !is_plain_escape(p + 1, end) )
+                return nullptr;
+            ++p;
+            break;
+
+        case '%':
+        case '\r':
+        case '\n':
+            return nullptr;
+
+        case '<':
+            if ( is_tag(p, end) )
+                return nullptr;
+            break;
+
+        default:
+            if ( *p == quote )
+                return p;
+            break;
+        }
+    }
+
+    return nullptr;
+}
+
+// returns a pointer to the closing slash, nullptr if the expression is not plain
+// (hex and unicode escapes are decoded by the normalizer, and a slash in a class
+// is where the normalizer and a browser would disagree on the end)
+static const char* skip_regex(const char* p, const char* const end)
+{
+    bool in_class = false;
+
+    while ( ++p < end )
+    {
+        switch ( *p )
+        {
+        case '\\':
+            if ( ++p == end or *p == 'x' or *p == 'u' or *p == '\r' or *p == '\n' )
+                return nullptr;
+            break;
+
+        case '\r':
+        case '\n':
+            return nullptr;
+
+        case '<':
+            if ( is_tag(p, end) )
+                return nullptr;
+            break;
+
+        case '[':
+            in_class = true;
+            break;
+
+        case ']':
+            in_class = false;
+            break;
+
+        case '/':
+            if ( in_class )
+                return nullptr;
+            return p;
+        }
+    }
+
+    return nullptr;
+}
+
+// returns a pointer to the last character of the comment, nullptr if it ends the script
+static const char* skip_comment(const char* p, const char* const end)
+{
+    const bool line = p[1] == '/';
+    p += 2;
+
+    for ( ; p < end; ++p )
+    {
+        if ( *p == '<' and is_tag(p, end) )
+            return nullptr;
+
+        if ( line and (*p == '\n' or *p == '\r') )
+            return p;
+
+        if ( !line and *p == '/' and p[-1] == '*' and p[-2] != '/' )
+            return p;
+    }
+
+    return nullptr;
+}
+
+namespace snort
+{
+const char* js_prescan(const char* src, size_t len, uint32_t max_depth)
+{
+    static const char close_tag[] = "</script>";
+    static const size_t close_tag_len = sizeof(close_tag) - 1;
+
+    char brackets[JS_PRESCAN_MAX_DEPTH];
+    uint32_t depth = 0;
+
+    // the previous significant token: 'a' for an identifier or a number, 'k' for
+    // a keyword that takes an expression, 'i' for an increment or a decrement,
+    // else its last character
+    char last = '\0';
+    bool plus_after_string = false;
+
+    const char* p = src;
+    const char* const end = src + len;
+
+    max_depth = std::min(max_depth, (uint32_t)JS_PRESCAN_MAX_DEPTH);
+
+    while ( p < end )
+    {
+        const char c = *p;
+
+        if ( is_word(c) )
+        {
+            const char* word = p;
+
+            while ( ++p < end and is_word(*p) );
+
+            if ( is_trigger(word, p - word) )
+                return nullptr;
+
+            // a property named like a keyword is still an operand
+            last = (last != '.' and is_expr_keyword(word, p - word)) ? 'k' : 'a';
+            continue;
+        }
+
+        switch ( c )
+        {
+        case ' ':
+        case '\t':
+        case '\v':
+        case '\f':
+        case '\r':
+        case '\n':
+            ++p;
+            continue;
+
+        case '\'':
+        case '"':
+            // the normalizer joins literals, so 'a' + 'b' differs but 'a' + b doesn't
+            if ( last == '+' and plus_after_string )
+                return nullptr;
+
+            if ( !(p = skip_string(p, end, c)) )
+                return nullptr;
+            break;
+
+        case '+':
+        case '-':
+            if ( last == c )
+            {
+                last = 'i';
+                ++p;
+                continue;
+            }
+
+            if ( c == '+' )
+                plus_after_string = last == '\'' or last == '"';
+            break;
+
+        case '/':
+            if ( end - p < 2 )
+                return nullptr;
+
+            if ( p[1] == '/' or p[1] == '*' )
+            {
+                if ( !(p = skip_comment(p, end)) )
+                    return nullptr;
+
+                ++p;
+                continue;
+            }
+
+            // as in the tokenizer, a division follows an operand and a regular
+            // expression follows anything else; a block and an object literal
+            // both end with a brace, and an increment may be postfix or prefix,
+            // so those stay ambiguous
+            if ( last == '}' or last == 'i' )
+                return nullptr;
+
+            if ( last == 'a' or last == ')' or last == ']' or last == '\'' or last == '"' )
+                break;
+
+            if ( !(p = skip_regex(p, end)) )
+                return nullptr;
+
+            // flags are scanned as an identifier, after which a slash divides
+            ++p;
+            last = 'a';
+            continue;
+
+        case '(':
+        case '[':
+        case '{':
+            if ( depth + 1 >= max_depth )
+                return nullptr;
+
+            brackets[depth++] = c;
+            break;
+
+        case ')':
+        case ']':
+        case '}':
+            if ( !depth )
+                return nullptr;
+
+            if ( brackets[--depth] != (c == ')' ? '(' : c - 2) )
+                return nullptr;
+            break;
+
+        case '<':
+            if ( !match_nocase(p, end, close_tag, close_tag_len) )
+            {
+                if ( is_tag(p, end) )
+                    return nullptr;
+                break;
+            }
+
+            return depth ? nullptr : p + close_tag_len;
+
+        case '.':
+        case ',':
+        case ';':
+        case ':':
+        case '?':
+        case '!':
+        case '=':
+        case '>':
+        case '*':
+        case '&':
+        case '|':
+        case '^':
+        case '~':
+            break;
+
+        default:
+            // escapes, templates, private names and anything unusual
+            return nullptr;
+        }
+
+        last = *p++;
+    }
+
+    return nullptr;
+}
+}
+
@@ -0,0 +1,43 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// js_prescan.h
+
+#ifndef JS_PRESCAN_H
+#define JS_PRESCAN_H
+
+// A quick check of an inline script, which decides whether the script can skip
+// the enhanced JavaScript normalizer. The script passes only if it has none of
+// the constructs the normalizer is there for (escapes, decoding and evaluating
+// functions, concatenation of string literals, template literals, escapes in
+// regular expressions, nested script tags) and nothing the normalizer would
+// alert on.
+
+#include <cstddef>
+#include <cstdint>
+
+#define JS_PRESCAN_MAX_DEPTH 256
+
+namespace snort
+{
+// src points right after the opening script tag, max_depth limits bracket nesting.
+// Returns a pointer past the closing script tag if the script is plain,
+// nullptr if it must be normalized or does not end within len bytes.
+const char* js_prescan(const char* src, size_t len, uint32_t max_depth);
+}
+
+#endif
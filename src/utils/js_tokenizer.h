@@ -171,6 +171,9 @@ public:
 
     bool is_unescape_nesting_seen() const;
     bool is_mixed_encoding_seen() const;
+
+    // frees the scan buffers pooled by the calling thread
+    static void thread_term();
 protected:
     [[noreturn]] void LexerError(const char* msg) override
     { snort::FatalError("%s", msg); }
@@ -178,6 +181,8 @@ protected:
 private:
     int yylex() override;
 
+    void acquire_buffer();
+    void release_buffer();
     void switch_to_initial();
     void switch_to_temporal(const std::string& data);
     JSRet eval_eof();
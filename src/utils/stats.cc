@@ -24,6 +24,7 @@
 #include "stats.h"
 
 #include <cassert>
+#include <string>
 
 #include "control/control.h"
 #include "detection/detection_engine.h"
@@ -146,6 +147,35 @@ void TimeStop()
     gettimeofday(&endtime, nullptr);
 }
 
+// phases are kept in the order first seen; setting one again replaces it
+static std::vector<std::pair<std::string, double>> build_times;
+
+void SetBuildTime(const char* phase, double seconds)
+{
+    for ( auto& bt : build_times )
+    {
+        if ( bt.first == phase )
+        {
+            bt.second = seconds;
+            return;
+        }
+    }
+    build_times.emplace_back(phase, seconds);
+}
+
+void LogBuildTimes()
+{
+    if ( build_times.empty() )
+        return;
+
+    LogLabel("build timing");
+
+    for ( const auto& bt : build_times )
+        LogMessage("%25.25s: %.3f\n", bt.first.c_str(), bt.second);
+
+    build_times.clear();
+}
+
 static void timing_stats()
 {
     struct timeval difftime;
@@ -180,6 +210,11 @@ static void timing_stats()
 
     if ( uint64_t mbps = 8 * num_byts / total_secs / 1024 / 1024 )
         LogMessage("%25.25s: " STDu64 "\n", "Mbits/sec", mbps);
+
+    uint64_t pcap_byts = (uint64_t)daq->get_global_count("pcap_bytes");
+
+    if ( uint64_t pcap_mbs = pcap_byts / total_secs / 1024 / 1024 )
+        LogMessage("%25.25s: " STDu64 "\n", "pcap MB/sec", pcap_mbs);
 }
 
 //-------------------------------------------------------------------------
@@ -220,6 +255,15 @@ const PegInfo pc_names[] =
     { CountType::SUM, "offload_fallback", "fast pattern offload search fallback attempts" },
     { CountType::SUM, "offload_failures", "fast pattern offload search failures" },
     { CountType::SUM, "offload_suspends", "fast pattern search suspends due to offload context chains" },
+    { CountType::SUM, "mpse_batches", "fast pattern searches combined across packets" },
+    { CountType::SUM, "mpse_batch_packets", "packets searched in combined batches" },
+    { CountType::MAX, "mpse_batch_max", "maximum packets in a combined batch" },
+    { CountType::SUM, "mpse_batch_timeouts", "combined batches searched early due to latency" },
+    { CountType::SUM, "offload_steals", "offloaded searches taken from another packet thread's queue" },
+    { CountType::MAX, "offload_queue_max", "maximum offloaded searches queued by a packet thread" },
+    { CountType::SUM, "offload_latency", "total microseconds from offload to completion" },
+    { CountType::MAX, "offload_latency_max", "maximum microseconds from offload to completion" },
+    { CountType::SUM, "context_data_allocs", "ips context data allocated on first use in a context instead of preallocated" },
     { CountType::SUM, "pcre_match_limit", "total number of times pcre hit the match limit" },
     { CountType::SUM, "pcre_recursion_limit", "total number of times pcre hit the recursion limit" },
     { CountType::SUM, "pcre_error", "total number of times pcre returns error" },
@@ -23,6 +23,7 @@
 // Provides facilities for displaying Snort exit stats
 
 #include <daq_common.h>
+#include <chrono>
 #include <vector>
 
 #include "framework/counts.h"
@@ -70,6 +71,15 @@ struct PacketCount
     PegCount offload_fallback;
     PegCount offload_failures;
     PegCount offload_suspends;
+    PegCount mpse_batches;
+    PegCount mpse_batch_packets;
+    PegCount mpse_batch_max;
+    PegCount mpse_batch_timeouts;
+    PegCount offload_steals;
+    PegCount offload_queue_max;
+    PegCount offload_latency;
+    PegCount offload_latency_max;
+    PegCount context_data_allocs;
     PegCount pcre_match_limit;
     PegCount pcre_recursion_limit;
     PegCount pcre_error;
@@ -125,4 +135,24 @@ void PrintStatistics();
 void TimeStart();
 void TimeStop();
 
+// startup and reload build phases are shown together by LogBuildTimes()
+void SetBuildTime(const char* phase, double seconds);
+void LogBuildTimes();
+
+class BuildTimer
+{
+public:
+    BuildTimer(const char* s) : phase(s), start(std::chrono::steady_clock::now()) { }
+
+    ~BuildTimer()
+    {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        SetBuildTime(phase, d.count());
+    }
+
+private:
+    const char* phase;
+    std::chrono::steady_clock::time_point start;
+};
+
 #endif
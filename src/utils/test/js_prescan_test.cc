@@ -0,0 +1,272 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2022-2022 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// js_prescan_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/catch.hpp"
+
+#include <cstring>
+#include <string>
+
+#include "utils/js_prescan.h"
+
+#define DEPTH 256
+
+static bool plain(const std::string& script, uint32_t depth = DEPTH)
+{
+    const char* end = snort::js_prescan(script.c_str(), script.size(), depth);
+
+    if (!end)
+        return false;
+
+    // the rest of the input is left untouched
+    CHECK(end == script.c_str() + script.find_last_of('>') + 1);
+    return true;
+}
+
+// excerpts of minified libraries as they appear inline on pages
+static const char* const minified_plain[] =
+{
+    // elasticlunr 0.9.5 (MIT), utils and event emitter
+    "!function(){function e(e){if(null===e||\"object\"!=typeof e)return e;var t=e.construct"
+    "or();for(var n in e)e.hasOwnProperty(n)&&(t[n]=e[n]);return t}var t=function(e){var n="
+    "new t.Index;return n.pipeline.add(t.trimmer,t.stopWordFilter,t.stemmer),e&&e.call(n,n)"
+    ",n};t.version=\"0.9.5\",lunr=t,t.utils={},t.utils.warn=function(e){return function(t){"
+    "e.console&&console.warn&&console.warn(t)}}(this),t.utils.toString=function(e){return v"
+    "oid 0===e||null===e?\"\":e.toString()},t.EventEmitter=function(){this.events={}},t.Eve"
+    "ntEmitter.prototype.addListener=function(){var e=Array.prototype.slice.call(arguments)"
+    ",t=e.pop(),n=e;if(\"function\"!=typeof t)throw new TypeError(\"last argument must be a"
+    " function\");n.forEach(function(e){this.hasHandler(e)||(this.events[e]=[]),this.events"
+    "[e].push(t)},this)},t.EventEmitter.prototype.removeListener=function(e,t){if(this.hasH"
+    "andler(e)){var n=this.events[e].indexOf(t);-1!==n&&(this.events[e].splice(n,1),0==this"
+    ".events[e].length&&delete this.events[e])}},t.EventEmitter.prototype.emit=function(e){"
+    "if(this.hasHandler(e)){var t=Array.prototype.slice.call(arguments,1);this.events[e].fo"
+    "rEach(function(e){e.apply(void 0,t)},this)}},t.EventEmitter.prototype.hasHandler=funct"
+    "ion(e){return e in this.events}}();",
+    // elasticlunr trimmer
+    "t.trimmer=function(e){if(null===e||void 0===e)throw new Error(\"token should not be un"
+    "defined\");return e.replace(/^\\W+/,\"\").replace(/\\W+$/,\"\")},t.Pipeline.registerFu"
+    "nction(t.trimmer,\"trimmer\");",
+    // elasticlunr stemmer expressions
+    "var p=/^(.+?)(ss|i)es$/,v=/^(.+?)([^s])s$/,g=/^(.+?)eed$/,m=/^(.+?)(ed|ing)$/,y=/.$/,S"
+    "=/(at|bl|iz)$/;",
+    // clipboard.js 2.0.4 (MIT) module wrapper
+    "!function(t,e){\"object\"==typeof exports&&\"object\"==typeof module?module.exports=e("
+    "):\"function\"==typeof define&&define.amd?define([],e):\"object\"==typeof exports?expo"
+    "rts.ClipboardJS=e():t.ClipboardJS=e()}(this,function(){return{}});",
+    // mark.js 8.11.1 (MIT) module wrapper
+    "!function(e,t){\"object\"==typeof exports&&\"undefined\"!=typeof module?module.exports"
+    "=t():\"function\"==typeof define&&define.amd?define(t):e.Mark=t()}(this,function(){ret"
+    "urn{}});",
+};
+
+static const char* const minified_obfuscated[] =
+{
+    // mark.js wildcards, unicode escapes in expressions
+    "function w(e){var t=\"withSpaces\"===this.opt.wildcards;return e.replace(/\\u0001/g,t?"
+    "\"[\\\\S\\\\s]?\":\"\\\\S?\").replace(/\\u0002/g,t?\"[\\\\S\\\\s]*?\":\"\\\\S*\")}",
+    // packed code
+    "eval(function(p,a,c,k,e,d){while(c--)if(k[c])p=p.replace(new RegExp('\\\\b'+c+'\\\\b',"
+    "'g'),k[c]);return p}('0.1(\\'2\\')',3,3,'console|log|hi'.split('|'),0,{}))",
+};
+
+TEST_CASE("plain scripts", "[JSPrescan]")
+{
+    SECTION("empty")
+    {
+        CHECK(plain("</script>"));
+    }
+    SECTION("statements")
+    {
+        CHECK(plain("var a = 1;\nfunction f(x) { return x[0] * a; }\nf([2]);</script>"));
+    }
+    SECTION("strings")
+    {
+        CHECK(plain("document.write('<b>bold</b>'); var s = \"a 'b' c\";</script>"));
+    }
+    SECTION("comments")
+    {
+        CHECK(plain("// a line comment\nvar a; /* a block\n comment */ var b;\r\n</script>"));
+        CHECK(plain("/**/ var a; /*/ still a comment */</script>"));
+    }
+    SECTION("operators")
+    {
+        CHECK(plain("for (i = 0; i<n; i++) { a += b ? c : -d, e >>= 1; }</script>"));
+        CHECK(plain("var f = (x) => x && !y || z ^ ~w;</script>"));
+    }
+    SECTION("escapes in strings")
+    {
+        CHECK(plain("var s = 'it\\'s', t = \"a\\\"b\\\\c\\n\\t\", z = '\\0';</script>"));
+    }
+    SECTION("strings and other operands")
+    {
+        CHECK(plain("var s = 'a' + b;</script>"));
+        CHECK(plain("var s = b + 'a' + c;</script>"));
+        CHECK(plain("n.className = 'x ' + (a ? 'y' : 'z');</script>"));
+    }
+    SECTION("regular expressions")
+    {
+        CHECK(plain("var r = /a/;</script>"));
+        CHECK(plain("s = s.replace(/^\\s+|[a-z]*$/gi, '');</script>"));
+        CHECK(plain("function f(s) { return /a\\/b/.test(s) ? 1 : 2; }</script>"));
+        CHECK(plain("x = [/a/, /b/g]; y = typeof /c/;</script>"));
+    }
+    SECTION("divisions")
+    {
+        CHECK(plain("var r = a / b;</script>"));
+        CHECK(plain("x = (a + 1) / 2 / b[0] /c;</script>"));
+        CHECK(plain("x = 'a'.length / 2; y /= 2;</script>"));
+        CHECK(plain("x = /a/g.lastIndex / 2;</script>"));
+        CHECK(plain("x = a.return / 2 / b.in;</script>"));
+        CHECK(plain("for (i = n - 1; i >= 0; i--) a[i] = b[i] / 2;</script>"));
+    }
+    SECTION("trigger-like identifiers")
+    {
+        CHECK(plain("evaluate(); my_unescape(); atobx = 1;</script>"));
+    }
+    SECTION("closing tag in upper case")
+    {
+        CHECK(plain("var a = 1;</SCRIPT>"));
+    }
+    SECTION("data after the script")
+    {
+        const std::string data = "var a;</script><p>text</p>";
+        const char* end = snort::js_prescan(data.c_str(), data.size(), DEPTH);
+        CHECK(end == data.c_str() + data.find("<p>"));
+    }
+}
+
+TEST_CASE("scripts to normalize", "[JSPrescan]")
+{
+    SECTION("no closing tag")
+    {
+        CHECK(!plain("var a = 1;"));
+        CHECK(!plain("var a = 1;</scr"));
+    }
+    SECTION("escapes")
+    {
+        CHECK(!plain("var s = '\\x41';</script>"));
+        CHECK(!plain("var s = '\\u0041';</script>"));
+        CHECK(!plain("var s = '\\101';</script>"));
+        CHECK(!plain("var s = '\\01';</script>"));
+        CHECK(!plain("var s = 'a\\\nb';</script>"));
+        CHECK(!plain("var \\u0061 = 1;</script>"));
+        CHECK(!plain("var s = '%41';</script>"));
+    }
+    SECTION("decoding and evaluating functions")
+    {
+        CHECK(!plain("eval(a);</script>"));
+        CHECK(!plain("unescape(a);</script>"));
+        CHECK(!plain("decodeURIComponent(a);</script>"));
+        CHECK(!plain("String.fromCharCode(65);</script>"));
+        CHECK(!plain("atob(a);</script>"));
+        CHECK(!plain("window['eval'](a);</script>"));
+    }
+    SECTION("string concatenation")
+    {
+        CHECK(!plain("var s = 'a' + 'b';</script>"));
+        CHECK(!plain("var s = b + 'a' + /* c */ 'd';</script>"));
+        CHECK(!plain("var s = \"a\"\n+\n\"b\";</script>"));
+    }
+    SECTION("template literals")
+    {
+        CHECK(!plain("var s = `a`;</script>"));
+    }
+    SECTION("regular expressions")
+    {
+        CHECK(!plain("var r = /\\x41/;</script>"));
+        CHECK(!plain("var r = /\\u0041/;</script>"));
+        CHECK(!plain("var r = /[/]/;</script>"));
+        CHECK(!plain("var r = /a\n/;</script>"));
+        CHECK(!plain("var r = /a</script>"));
+        CHECK(!plain("var r = /<script>/;</script>"));
+    }
+    SECTION("slash after a brace")
+    {
+        CHECK(!plain("if (a) {} /a/.test(s);</script>"));
+        CHECK(!plain("x = {} / 2;</script>"));
+    }
+    SECTION("slash after an increment")
+    {
+        CHECK(!plain("x = a++ / eval(b) / 1;</script>"));
+        CHECK(!plain("x = a-- /b/ 1;</script>"));
+    }
+    SECTION("division after a keyword property")
+    {
+        CHECK(!plain("x = a.return / 2 + eval(b) / 1;</script>"));
+    }
+    SECTION("tags")
+    {
+        CHECK(!plain("var s = '<script>';</script>"));
+        CHECK(!plain("var s = '</script>';</script>"));
+        CHECK(!plain("// </script>"));
+        CHECK(!plain("/* <script> */</script>"));
+        CHECK(!plain("<!-- var a;</script>"));
+    }
+    SECTION("unbalanced brackets")
+    {
+        CHECK(!plain("f(a;</script>"));
+        CHECK(!plain("f(a]);</script>"));
+        CHECK(!plain("a);</script>"));
+    }
+    SECTION("bracket depth")
+    {
+        CHECK(plain("f((a));</script>", 3));
+        CHECK(!plain("f(((a)));</script>", 3));
+    }
+    SECTION("unterminated constructs")
+    {
+        CHECK(!plain("var s = 'a\n';</script>"));
+        CHECK(!plain("/* var a;</script>"));
+    }
+    SECTION("unusual characters")
+    {
+        CHECK(!plain("var \xc3\xa9 = 1;</script>"));
+        CHECK(!plain("class A { #a; }</script>"));
+        CHECK(!plain("@decorator</script>"));
+    }
+}
+
+TEST_CASE("minified libraries", "[JSPrescan]")
+{
+    size_t total = 0;
+    size_t bypassed = 0;
+
+    for (const char* code : minified_plain)
+    {
+        const std::string script = std::string(code) + "</script>";
+        total += script.size();
+
+        if (plain(script))
+            bypassed += script.size();
+    }
+
+    for (const char* code : minified_obfuscated)
+    {
+        const std::string script = std::string(code) + "</script>";
+        total += script.size();
+
+        CHECK(!plain(script));
+    }
+
+    // the share js_bypassed_bytes would report for these scripts
+    CHECK(bypassed * 100 / total >= 80);
+}
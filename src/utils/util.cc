@@ -114,7 +114,11 @@ int DisplayBanner()
     LogMessage("           Using %s\n", SSLeay_version(SSLEAY_VERSION));
     LogMessage("           Using %s\n", pcap_lib_version());
     LogMessage("           Using PCRE version %s\n", pcre_version());
+#ifdef ZLIBNG_VERSION
+    LogMessage("           Using ZLIB version %s (zlib-ng %s)\n", zlib_version, zlibng_version());
+#else
     LogMessage("           Using ZLIB version %s\n", zlib_version);
+#endif
 #ifdef HAVE_FLATBUFFERS
     LogMessage("           Using %s\n", flatbuffers::flatbuffers_version_string);
 #endif